@@ -34,6 +34,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <sys/types.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
 
 #include "LavaRnd/sha1.h"
 #include "LavaRnd/cfg.h"
@@ -50,21 +53,37 @@
  * the default private configuration
  */
 static struct cfg_lavapool def_cfg = {
-    NULL,			/* chaos command line or driver line for lavapool */
+    0,				/* chaos sources, none until configured */
+    {
+	{NULL, LAVA_DEF_CHAOS_RATE}
+    },
     LAVA_DEF_FASTPOOL,		/* def fast pool filling level */
     LAVA_DEF_SLOWPOOL,		/* def slow filling level */
     LAVA_DEF_POOLSIZE,		/* size of lava pool */
     LAVA_DEF_FAST_CYCLE,	/* def fastest chan fill cycle */
     LAVA_DEF_SLOW_CYCLE,	/* def slowest chan fill cycle */
+    LAVA_DEF_FILL_HORIZON,	/* def seconds ahead to predict pool level */
     LAVA_DEF_MAXCLINETS,	/* max number if clients if > 0 */
     LAVA_DEF_TIMEOUT,		/* client timeout in secs if > 0.0 */
-    LAVA_DEF_USE_PREFIX		/* 0==>dont use system stuff as a URL content prefix */
+    LAVA_DEF_USE_PREFIX,	/* 0==>dont use system stuff as a URL content prefix */
+    LAVA_DEF_GATHER,		/* how pool data is shared among clients */
+    1,				/* client classes, just the default */
+    {
+	{"default", LAVA_DEF_WEIGHT, LAVA_CLASS_ANY, NULL, 0, 0}
+    }
 };
 struct cfg_lavapool cfg_lavapool;	/* current cfg.lavapool cfg */
 
 #define MAXLINE 1024		/* longest config line allowed */
 
 
+/*
+ * static functions
+ */
+static int parse_chaos(char *fld2, struct cfg_lavapool *cfg, int linenum);
+static int parse_class(char *fld2, struct cfg_lavapool *cfg, int linenum);
+
+
 /*
  * config_priv - load the standard configuration file for url
  *
@@ -86,6 +105,7 @@ config_priv(char *cfg_file, struct cfg_lavapool *config)
     char buf[MAXLINE + 1];	/* config file buffer */
     int linenum;	/* config line number */
     struct cfg_lavapool new;	/* new configuration to set */
+    int i;
 
     /*
      * firewall
@@ -193,10 +213,7 @@ config_priv(char *cfg_file, struct cfg_lavapool *config)
 	 * the job for as little as we need to do this.
 	 */
 	if (strcmp(fld1, "chaos") == 0) {
-	    new.chaos = strdup(fld2);
-
-	    if (new.chaos == NULL) {
-		warn("config_priv", "line %d: strdup malloc failed", linenum);
+	    if (parse_chaos(fld2, &new, linenum) < 0) {
 		fclose(f);
 		return -1;
 	    }
@@ -242,6 +259,15 @@ config_priv(char *cfg_file, struct cfg_lavapool *config)
 		fclose(f);
 		return -1;
 	    }
+	} else if (strcmp(fld1, "fill_horizon") == 0) {
+	    errno = 0;
+	    new.fill_horizon = strtod(fld2, NULL);
+	    if (errno == ERANGE || new.fill_horizon < 0.0) {
+		warn("config_priv",
+		     "line %d: fill_horizon must be >= 0.0", linenum);
+		fclose(f);
+		return -1;
+	    }
 	} else if (strcmp(fld1, "maxclients") == 0) {
 	    errno = 0;
 	    new.maxclients = strtol(fld2, NULL, 0);
@@ -268,6 +294,24 @@ config_priv(char *cfg_file, struct cfg_lavapool *config)
 		fclose(f);
 		return -1;
 	    }
+	} else if (strcmp(fld1, "gather") == 0) {
+	    if (strcmp(fld2, "fifo") == 0) {
+		new.gather = LAVA_GATHER_FIFO;
+	    } else if (strcmp(fld2, "smallest") == 0) {
+		new.gather = LAVA_GATHER_SMALLEST;
+	    } else if (strcmp(fld2, "proportional") == 0) {
+		new.gather = LAVA_GATHER_PROPORTIONAL;
+	    } else {
+		warn("config_priv", "line %d: gather must be fifo, smallest "
+				    "or proportional", linenum);
+		fclose(f);
+		return -1;
+	    }
+	} else if (strcmp(fld1, "class") == 0) {
+	    if (parse_class(fld2, &new, linenum) < 0) {
+		fclose(f);
+		return -1;
+	    }
 	} else {
 	    warn("config_priv", "line %d unknown name", linenum);
 	    fclose(f);
@@ -284,7 +328,7 @@ config_priv(char *cfg_file, struct cfg_lavapool *config)
     /*
      * must have a URL
      */
-    if (new.chaos == NULL) {
+    if (new.chaoscnt <= 0) {
 	warn("config_priv", "%s: missing chaos", cfg_file);
 	return -1;		/* no URL given */
     }
@@ -319,19 +363,302 @@ config_priv(char *cfg_file, struct cfg_lavapool *config)
 	warn("config_priv", "dup_cfg_lavapool failed!!");
 	return -1;
     }
-    dbg(1, "config_priv", "chaos: %s", config->chaos);
+    for (i=0; i < config->chaoscnt; ++i) {
+	dbg(1, "config_priv",
+	    "chaos[%d]: rate: %.3f  planes: %d  tiles: %.3f  batch: %d  %s",
+	    i, config->chaos[i].rate, config->chaos[i].planes,
+	    config->chaos[i].tiles, config->chaos[i].batch,
+	    config->chaos[i].cmd);
+    }
     dbg(1, "config_priv", "fastpool: %d  slowpool: %d",
 	config->fastpool, config->slowpool);
     dbg(1, "config_priv", "poolsize: %d", config->poolsize);
-    dbg(1, "config_priv", "fast_cycle: %.3f  slow_cycle: %.3f",
-	config->fast_cycle, config->slow_cycle);
+    dbg(1, "config_priv", "fast_cycle: %.3f  slow_cycle: %.3f  "
+	"fill_horizon: %.3f",
+	config->fast_cycle, config->slow_cycle, config->fill_horizon);
     dbg(1, "config_priv", "maxclients: %d  timeout: %.3f  prefix: %d",
 	config->maxclients, config->timeout, config->prefix);
-    free(new.chaos);
+    dbg(1, "config_priv", "gather: %d", config->gather);
+    for (i=0; i < config->classcnt; ++i) {
+	dbg(1, "config_priv", "class[%d]: %s  weight: %d  match: %d  port: %s",
+	    i, config->class[i].name, config->class[i].weight,
+	    config->class[i].match,
+	    (config->class[i].port ? config->class[i].port : "(none)"));
+    }
+    for (i=0; i < new.chaoscnt; ++i) {
+	free(new.chaos[i].cmd);
+    }
+    for (i=0; i < new.classcnt; ++i) {
+	if (new.class[i].port != NULL) {
+	    free(new.class[i].port);
+	}
+    }
     return 0;			/* success */
 }
 
 
+/*
+ * parse_chaos - parse the value of a chaos line
+ *
+ * A chaos line is of the form:
+ *
+ *	chaos=[:rate factor] [:planes n] [:tiles fract] [:batch k] command ...
+ *	chaos=[:rate factor] [:planes n] [:tiles fract] [:batch k] :driver ...
+ *
+ * Each chaos line adds a chaos source.  The rate factor scales the
+ * lavarnd rate used on frames from a driver source.  The planes and
+ * tiles values select the low order bit-planes and the fraction of the
+ * least flat tiles of a driver frame that are LavaRnd processed.
+ * See lavacam_extract().  The batch value is the number of driver
+ * frames LavaRnd processed together, 0 ==> enough frames to reach
+ * LAVA_CHAOS_BATCH_TARGET octets.
+ *
+ * given:
+ *	fld2		chaos line value
+ *	cfg		configuration being formed
+ *	linenum		config file line number
+ *
+ * returns:
+ *	0 ==> OK, -1 ==> error
+ */
+static int
+parse_chaos(char *fld2, struct cfg_lavapool *cfg, int linenum)
+{
+    struct lava_chaos *src;	/* chaos source being formed */
+    char *p;
+
+    /*
+     * firewall
+     */
+    if (cfg->chaoscnt >= LAVA_MAX_CHAOS) {
+	warn("config_priv", "line %d: more than %d chaos sources",
+	     linenum, LAVA_MAX_CHAOS);
+	return -1;
+    }
+    src = &cfg->chaos[cfg->chaoscnt];
+    src->cmd = NULL;
+    src->rate = LAVA_DEF_CHAOS_RATE;
+    src->planes = LAVA_DEF_CHAOS_PLANES;
+    src->tiles = LAVA_DEF_CHAOS_TILES;
+    src->batch = LAVA_DEF_CHAOS_BATCH;
+
+    /*
+     * parse the optional rate factor, bit-planes, tile fraction and batch
+     */
+    for (;;) {
+	if (strncmp(fld2, ":rate", 5) == 0 && isascii(fld2[5]) &&
+	    isspace(fld2[5])) {
+	    errno = 0;
+	    src->rate = strtod(fld2 + 5, &p);
+	    if (errno == ERANGE || p == fld2 + 5 || src->rate <= 0.0) {
+		warn("config_priv", "line %d: chaos rate must be > 0.0",
+		     linenum);
+		return -1;
+	    }
+	} else if (strncmp(fld2, ":planes", 7) == 0 && isascii(fld2[7]) &&
+		   isspace(fld2[7])) {
+	    errno = 0;
+	    src->planes = (int)strtol(fld2 + 7, &p, 0);
+	    if (errno == ERANGE || p == fld2 + 7 ||
+		src->planes < 1 || src->planes > LAVA_MAX_CHAOS_PLANES) {
+		warn("config_priv", "line %d: chaos planes must be 1 to %d",
+		     linenum, LAVA_MAX_CHAOS_PLANES);
+		return -1;
+	    }
+	} else if (strncmp(fld2, ":tiles", 6) == 0 && isascii(fld2[6]) &&
+		   isspace(fld2[6])) {
+	    errno = 0;
+	    src->tiles = strtod(fld2 + 6, &p);
+	    if (errno == ERANGE || p == fld2 + 6 ||
+		src->tiles <= 0.0 || src->tiles > 1.0) {
+		warn("config_priv", "line %d: chaos tiles must be > 0.0 "
+		     "and <= 1.0", linenum);
+		return -1;
+	    }
+	} else if (strncmp(fld2, ":batch", 6) == 0 && isascii(fld2[6]) &&
+		   isspace(fld2[6])) {
+	    errno = 0;
+	    src->batch = (int)strtol(fld2 + 6, &p, 0);
+	    if (errno == ERANGE || p == fld2 + 6 ||
+		src->batch < 0 || src->batch > LAVA_MAX_CHAOS_BATCH) {
+		warn("config_priv", "line %d: chaos batch must be 0 to %d",
+		     linenum, LAVA_MAX_CHAOS_BATCH);
+		return -1;
+	    }
+	} else {
+	    break;
+	}
+	fld2 = p + strspn(p, " \t");
+    }
+    if (*fld2 == '\0') {
+	warn("config_priv", "line %d: chaos needs a command or driver",
+	     linenum);
+	return -1;
+    }
+
+    /*
+     * save the command or driver line
+     */
+    src->cmd = strdup(fld2);
+    if (src->cmd == NULL) {
+	warn("config_priv", "line %d: strdup malloc failed", linenum);
+	return -1;
+    }
+    ++cfg->chaoscnt;
+    return 0;
+}
+
+
+/*
+ * parse_class - parse the value of a class line
+ *
+ * A class line is of the form:
+ *
+ *	class=name weight [match]
+ *
+ * where match is one of:
+ *
+ *	unix			clients on a Un*x domain socket
+ *	tcp			clients on a TCP/IP socket
+ *	addr a.b.c.d[/bits]	TCP/IP clients from an address or network
+ *	port host:port		clients on an additional listening port
+ *	port /socket/path	clients on an additional Un*x domain socket
+ *
+ * The default class may be given without a match to set its weight.
+ *
+ * given:
+ *	fld2		class line value, modified by this function
+ *	cfg		configuration being formed
+ *	linenum		config file line number
+ *
+ * returns:
+ *	0 ==> OK, <0 ==> error
+ */
+static int
+parse_class(char *fld2, struct cfg_lavapool *cfg, int linenum)
+{
+    struct lava_class *c;	/* class being formed */
+    char *name;		/* class name */
+    char *weight;	/* class weight */
+    char *match;	/* class match type */
+    char *arg;		/* class match argument */
+    char *p;
+    struct in_addr in;	/* class address */
+    long bits;		/* class network prefix length */
+    int i;
+
+    /*
+     * split the fields
+     */
+    name = strtok(fld2, " \t");
+    weight = strtok(NULL, " \t");
+    match = strtok(NULL, " \t");
+    arg = strtok(NULL, " \t");
+    if (name == NULL || weight == NULL || strtok(NULL, " \t") != NULL) {
+	warn("config_priv", "line %d: class must be: name weight [match]",
+	     linenum);
+	return -1;
+    }
+    if (strlen(name) > LAVA_CLASS_NAMELEN) {
+	warn("config_priv", "line %d: class name longer than %d",
+	     linenum, LAVA_CLASS_NAMELEN);
+	return -1;
+    }
+
+    /*
+     * find or add the class
+     */
+    for (i=0; i < cfg->classcnt; ++i) {
+	if (strcmp(cfg->class[i].name, name) == 0) {
+	    break;
+	}
+    }
+    if (i > 0 && i < cfg->classcnt) {
+	warn("config_priv", "line %d: class %s given more than once",
+	     linenum, name);
+	return -1;
+    }
+    if (i >= LAVA_MAX_CLASS) {
+	warn("config_priv", "line %d: more than %d classes",
+	     linenum, LAVA_MAX_CLASS);
+	return -1;
+    }
+    c = &cfg->class[i];
+
+    /*
+     * parse the weight
+     */
+    errno = 0;
+    c->weight = strtol(weight, &p, 0);
+    if (errno == ERANGE || *p != '\0' || c->weight < 1) {
+	warn("config_priv", "line %d: class weight must be > 0", linenum);
+	return -1;
+    }
+
+    /*
+     * the default class only has a weight
+     */
+    if (i == 0) {
+	if (match != NULL) {
+	    warn("config_priv", "line %d: the default class has no match",
+		 linenum);
+	    return -1;
+	}
+	return 0;
+    }
+
+    /*
+     * parse the match
+     */
+    strcpy(c->name, name);
+    c->port = NULL;
+    c->addr = 0;
+    c->mask = 0;
+    if (match == NULL) {
+	warn("config_priv", "line %d: class %s has no match", linenum, name);
+	return -1;
+    } else if (strcmp(match, "unix") == 0 && arg == NULL) {
+	c->match = LAVA_CLASS_UNIX;
+    } else if (strcmp(match, "tcp") == 0 && arg == NULL) {
+	c->match = LAVA_CLASS_TCP;
+    } else if (strcmp(match, "addr") == 0 && arg != NULL) {
+	c->match = LAVA_CLASS_ADDR;
+	bits = 32;
+	p = strchr(arg, '/');
+	if (p != NULL) {
+	    *p++ = '\0';
+	    errno = 0;
+	    bits = strtol(p, &p, 10);
+	    if (errno == ERANGE || *p != '\0' || bits < 0 || bits > 32) {
+		warn("config_priv", "line %d: class network bits must be "
+				    "0 thru 32", linenum);
+		return -1;
+	    }
+	}
+	if (inet_aton(arg, &in) == 0) {
+	    warn("config_priv", "line %d: bad class address: %s",
+		 linenum, arg);
+	    return -1;
+	}
+	c->mask = (bits == 0) ? 0 : (0xffffffffU << (32 - bits));
+	c->addr = ntohl(in.s_addr) & c->mask;
+    } else if (strcmp(match, "port") == 0 && arg != NULL) {
+	c->match = LAVA_CLASS_PORT;
+	c->port = strdup(arg);
+	if (c->port == NULL) {
+	    warn("config_priv", "line %d: strdup malloc failed", linenum);
+	    return -1;
+	}
+    } else {
+	warn("config_priv", "line %d: class match must be unix, tcp, "
+			    "addr a.b.c.d[/bits] or port host:port", linenum);
+	return -1;
+    }
+    ++cfg->classcnt;
+    return 0;
+}
+
+
 /*
  * dup_cfg_lavapool - duplicate a configuration
  *
@@ -347,13 +674,14 @@ config_priv(char *cfg_file, struct cfg_lavapool *config)
  * NOTE: Call free_cfg() when the configuration is no longer needed.
  *
  * NOTE: Even if this function returns NULL, it will copy all but the
- *       chaos element string, provided that this function was
+ *       chaos and class port strings, provided that this function was
  *       given non-NULL args.
  */
 struct cfg_lavapool *
 dup_cfg_lavapool(struct cfg_lavapool *cfg1, struct cfg_lavapool *cfg2)
 {
     struct cfg_lavapool new;	/* newly configuration */
+    int i;
 
     /* firewall */
     if (cfg1 == NULL || cfg2 == NULL) {
@@ -368,11 +696,25 @@ dup_cfg_lavapool(struct cfg_lavapool *cfg1, struct cfg_lavapool *cfg2)
     /*
      * duplicate strings
      */
-    new.chaos = (cfg1->chaos ? strdup(cfg1->chaos) : NULL);
+    for (i=0; i < cfg1->chaoscnt; ++i) {
+	new.chaos[i].cmd = (cfg1->chaos[i].cmd ?
+			    strdup(cfg1->chaos[i].cmd) : NULL);
+    }
+    for (i=0; i < cfg1->classcnt; ++i) {
+	new.class[i].port = (cfg1->class[i].port ?
+			     strdup(cfg1->class[i].port) : NULL);
+    }
 
     *cfg2 = new;
-    if (cfg1->chaos !=NULL && new.chaos == NULL) {
-	return NULL;
+    for (i=0; i < cfg1->chaoscnt; ++i) {
+	if (cfg1->chaos[i].cmd != NULL && new.chaos[i].cmd == NULL) {
+	    return NULL;
+	}
+    }
+    for (i=0; i < cfg1->classcnt; ++i) {
+	if (cfg1->class[i].port != NULL && new.class[i].port == NULL) {
+	    return NULL;
+	}
     }
 
     /*
@@ -396,6 +738,8 @@ dup_cfg_lavapool(struct cfg_lavapool *cfg1, struct cfg_lavapool *cfg2)
 void
 free_cfg_lavapool(struct cfg_lavapool *cfg)
 {
+    int i;
+
     /* firewall */
     if (cfg == NULL) {
 	return;
@@ -404,7 +748,16 @@ free_cfg_lavapool(struct cfg_lavapool *cfg)
     /*
      * free malloc-ed strings
      */
-    if (cfg->chaos !=NULL) {
-	free(cfg->chaos);
+    for (i=0; i < cfg->chaoscnt; ++i) {
+	if (cfg->chaos[i].cmd != NULL) {
+	    free(cfg->chaos[i].cmd);
+	    cfg->chaos[i].cmd = NULL;
+	}
+    }
+    for (i=0; i < cfg->classcnt; ++i) {
+	if (cfg->class[i].port != NULL) {
+	    free(cfg->class[i].port);
+	    cfg->class[i].port = NULL;
+	}
     }
 }
@@ -44,19 +44,78 @@
 #define LAVA_DEF_POOLSIZE (8*1024*1024)	  /* def random daemon pool size */
 #define LAVA_DEF_FAST_CYCLE (0.033333)	  /* def fastest chan fill cycle */
 #define LAVA_DEF_SLOW_CYCLE (20.0)	  /* def slowest chan fill cycle */
+#define LAVA_DEF_FILL_HORIZON (1.0)	  /* def drain prediction seconds */
 #define LAVA_DEF_MAXCLINETS (16)	  /* def max number of clients */
 #define LAVA_DEF_TIMEOUT (6.0)		  /* client timeout in seconds */
 #define LAVA_DEF_USE_PREFIX (1)	  	  /* def no system stuff prefix */
+#define LAVA_DEF_GATHER (LAVA_GATHER_FIFO) /* def gather policy */
+
+/*
+ * chaos sources - each source has its own chaos channel
+ */
+#define LAVA_MAX_CHAOS (8)		  /* max chaos sources */
+#define LAVA_DEF_CHAOS_RATE (1.0)	  /* def chaos source rate factor */
+#define LAVA_MAX_CHAOS_PLANES (8)	  /* bit-planes in an octet */
+#define LAVA_DEF_CHAOS_PLANES (8)	  /* def low bit-planes, 8 ==> all */
+#define LAVA_DEF_CHAOS_TILES (1.0)	  /* def fraction of tiles, 1 ==> all */
+#define LAVA_DEF_CHAOS_BATCH (1)	  /* def frames per lavarnd call */
+#define LAVA_MAX_CHAOS_BATCH (16)	  /* max frames per lavarnd call */
+#define LAVA_CHAOS_BATCH_AUTO (0)	  /* batch ==> frames to fill target */
+#define LAVA_CHAOS_BATCH_TARGET (128*1024) /* auto batch target octets */
+
+struct lava_chaos {
+    char *cmd;			/* chaos command line or driver line */
+    double rate;		/* lavarnd rate factor for driver frames */
+    int planes;			/* low bit-planes of driver frames to use */
+    double tiles;		/* fraction of driver frame tiles to use */
+    int batch;			/* driver frames per lavarnd call, 0 ==> auto */
+};
+
+/*
+ * gather policies - how pool data is shared among GATHERing clients
+ */
+#define LAVA_GATHER_FIFO (0)		  /* oldest request first */
+#define LAVA_GATHER_SMALLEST (1)	  /* smallest unfilled request first */
+#define LAVA_GATHER_PROPORTIONAL (2)	  /* in proportion to unfilled need */
+
+/*
+ * client classes - pool data is shared among classes by weight
+ *
+ * Class 0 is the default class of clients that match no other class.
+ */
+#define LAVA_MAX_CLASS (8)		  /* max classes, including default */
+#define LAVA_CLASS_NAMELEN (15)		  /* longest class name */
+#define LAVA_DEF_WEIGHT (1)		  /* def class weight */
+#define LAVA_CLASS_ANY (0)		  /* match: clients not in any class */
+#define LAVA_CLASS_UNIX (1)		  /* match: Un*x domain socket clients */
+#define LAVA_CLASS_TCP (2)		  /* match: TCP/IP clients */
+#define LAVA_CLASS_ADDR (3)		  /* match: TCP/IP clients by address */
+#define LAVA_CLASS_PORT (4)		  /* match: clients of a class port */
+
+struct lava_class {
+    char name[LAVA_CLASS_NAMELEN+1];	/* class name */
+    int weight;			/* share of the pool relative to other classes */
+    int match;			/* how clients are matched, LAVA_CLASS_* */
+    char *port;			/* LAVA_CLASS_PORT host:port or /socket/path */
+    u_int32_t addr;		/* LAVA_CLASS_ADDR address, host byte order */
+    u_int32_t mask;		/* LAVA_CLASS_ADDR netmask, host byte order */
+};
+
 struct cfg_lavapool {
-    char *chaos;		/* chaos source (command or driver) */
+    int chaoscnt;		/* number of chaos sources */
+    struct lava_chaos chaos[LAVA_MAX_CHAOS];	/* chaos sources */
     int32_t fastpool;		/* pool level below which pool fills fast */
     int32_t slowpool;		/* pool level above which pool fills slowly */
     int32_t poolsize;		/* size of lava pool */
     double fast_cycle;		/* fastest chan fill cycle in seconds */
     double slow_cycle;		/* slowest chan fill cycle in seconds */
+    double fill_horizon;	/* seconds ahead to predict pool level */
     int32_t maxclients;		/* max clients allowed, 0 => no limit */
     double timeout;		/* seconds to timeout if > 0.0 */
     int prefix;			/* 0==>no system stuff for URL content prefix */
+    int gather;			/* gather policy, LAVA_GATHER_* value */
+    int classcnt;		/* client classes, including the default */
+    struct lava_class class[LAVA_MAX_CLASS];	/* client classes */
 };
 
 
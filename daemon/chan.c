@@ -72,6 +72,38 @@ static int *chanindx = NULL;
 int32_t chanindx_len = 0;
 
 
+/*
+ * channel lists
+ *
+ * Each channel is on at most one list.  Channels handed out by mk_chan()
+ * or find_chan() go on the circular active list.  Once a channel is closed
+ * with nothing left to do (or HALTed), chan_cycle() takes it off the active
+ * list.  A closed channel goes on the free list for its type and current
+ * state, where find_chan() will find it.  TYPE_NONE channels made by
+ * alloc_chan() start on the TYPE_NONE ALLOCED free list for mk_chan().
+ *
+ * The pre-select, select mask and select processing loops walk just the
+ * active list, so the cost of a channel cycle depends on the number of
+ * channels in use, not the number that were ever allocated.
+ *
+ * NOTE: The lists are linked by channel index thru arrays that parallel
+ *       the chan array.  Indexes, unlike chan pointers, survive the chan
+ *       array being moved by realloc().
+ */
+#define ON_NO_LIST (0)		/* channel is not on any list */
+#define ON_ACTIVE (1)		/* channel is on the active list */
+#define ON_FREE (2)		/* channel is on a free list */
+
+static int32_t *link_next = NULL;	/* next channel on list or -1 */
+static int32_t *link_prev = NULL;	/* previous active channel or -1 */
+static u_int8_t *on_list = NULL;	/* ON_NO_LIST, ON_ACTIVE or ON_FREE */
+static int32_t active = -1;	/* first active channel or -1 */
+static int32_t active_cnt = 0;	/* channels on the active list */
+static int32_t free_head[LAST_TYPE + 1][LAST_STATE + 1];	/* free lists */
+static int32_t free_cnt[LAST_TYPE + 1][LAST_STATE + 1];	/* free list lens */
+int32_t open_clients = 0;	/* TYPE_CLIENT channels where CLIENT_IS_OPEN */
+
+
 /*
  * state name
  *
@@ -107,6 +139,11 @@ static double chan_cycle_timeout = 0.0;
  * static functions
  */
 static void alloc_chan(int32_t len);
+static void link_active(int32_t indx);
+static void unlink_active(int32_t indx);
+static void push_free(int32_t indx);
+static chan *pop_free(chantype type, chanstate curstate);
+static int chan_idle(int32_t indx);
 static void chan_indx_op(int32_t indx, chancycle cycle);
 static int chan_select(double timelen);
 
@@ -172,6 +209,7 @@ alloc_chan(int32_t len)
 {
     int start;	/* starting index to initialize */
     int i;
+    int j;
 
     /*
      * firewall
@@ -191,12 +229,32 @@ alloc_chan(int32_t len)
 	 * malloc the array
 	 */
 	ch = (chan *)malloc(len * sizeof(chan));
-	if (ch == NULL) {
+	link_next = (int32_t *)malloc(len * sizeof(int32_t));
+	link_prev = (int32_t *)malloc(len * sizeof(int32_t));
+	on_list = (u_int8_t *)malloc(len * sizeof(u_int8_t));
+	if (ch == NULL || link_next == NULL ||
+	    link_prev == NULL || on_list == NULL) {
 	    fatal(11, "alloc_chan", "unable to malloc %d channels", len);
 	    /*NOTREACHED*/
 	}
 	chanlen = len;
 	start = 0;
+	dbg(2, "alloc_chan", "channel: %d octets, client state: %d octets, "
+	    "chaos state: %d octets", (int)sizeof(chan),
+	    (int)sizeof(struct client_cold_s), (int)sizeof(struct chaos_cold_s));
+
+	/*
+	 * all lists start out empty
+	 */
+	active = -1;
+	active_cnt = 0;
+	open_clients = 0;
+	for (i = 0; i <= LAST_TYPE; ++i) {
+	    for (j = 0; j <= LAST_STATE; ++j) {
+		free_head[i][j] = -1;
+		free_cnt[i][j] = 0;
+	    }
+	}
 
 	/*
 	 * case: expand array
@@ -214,6 +272,14 @@ alloc_chan(int32_t len)
 	    /*NOTREACHED*/
 	}
 	ch = p;
+	link_next = (int32_t *)realloc(link_next, len * sizeof(int32_t));
+	link_prev = (int32_t *)realloc(link_prev, len * sizeof(int32_t));
+	on_list = (u_int8_t *)realloc(on_list, len * sizeof(u_int8_t));
+	if (link_next == NULL || link_prev == NULL || on_list == NULL) {
+	    fatal(11, "alloc_chan",
+		  "unable to malloc %d more channel links", len - chanlen);
+	    /*NOTREACHED*/
+	}
 	start = chanlen;
 	chanlen = len;
     }
@@ -221,43 +287,229 @@ alloc_chan(int32_t len)
     /*
      * initialize the new channels
      */
-    memset(ch + start, 0, len - start);
+    memset(ch + start, 0, (len - start) * sizeof(chan));
     for (i = start; i < chanlen; ++i) {
 	ch[i].common.indx = i;
 	ch[i].common.type = TYPE_NONE;
 	ch[i].common.curstate = ALLOCED;
 	ch[i].common.nxtstate = ALLOCED;
 	ch[i].common.fd = -1;
+	link_next[i] = -1;
+	link_prev[i] = -1;
+	on_list[i] = ON_NO_LIST;
+    }
+
+    /*
+     * place the new channels on the free list, lowest index on top
+     */
+    for (i = chanlen - 1; i >= start; --i) {
+	push_free(i);
     }
     return;
 }
 
 
 /*
- * mk_chan - make a channel of a given type
+ * link_active - add a channel to the end of the active list
  *
- * This function will look for an unused channel, set its type and
- * call the make function for that type.  If all channels are in use,
- * it will allocate another channel.
+ * given:
+ *      indx    channel index not on any list
+ */
+static void
+link_active(int32_t indx)
+{
+    int32_t last;	/* last channel on the active list */
+
+    /*
+     * firewall
+     */
+    if (indx < 0 || indx >= chanlen || on_list[indx] != ON_NO_LIST) {
+	fatal(10, "link_active", "chan[%d] cannot be made active", indx);
+	/*NOTREACHED*/
+    }
+
+    /*
+     * link in before the first, which is the end of the circle
+     */
+    if (active < 0) {
+	link_next[indx] = indx;
+	link_prev[indx] = indx;
+	active = indx;
+    } else {
+	last = link_prev[active];
+	link_next[indx] = active;
+	link_prev[indx] = last;
+	link_next[last] = indx;
+	link_prev[active] = indx;
+    }
+    on_list[indx] = ON_ACTIVE;
+    ++active_cnt;
+    return;
+}
+
+
+/*
+ * unlink_active - remove a channel from the active list
  *
- * We search for channels in a circular fashion.  We start from
- * beyond the last search position.  When we reach the end we
- * start back around from the beginning.
+ * given:
+ *      indx    channel index on the active list
+ */
+static void
+unlink_active(int32_t indx)
+{
+    /*
+     * firewall
+     */
+    if (indx < 0 || indx >= chanlen || on_list[indx] != ON_ACTIVE) {
+	fatal(10, "unlink_active", "chan[%d] is not active", indx);
+	/*NOTREACHED*/
+    }
+
+    /*
+     * unlink from the circle
+     */
+    if (link_next[indx] == indx) {
+	active = -1;
+    } else {
+	link_next[link_prev[indx]] = link_next[indx];
+	link_prev[link_next[indx]] = link_prev[indx];
+	if (active == indx) {
+	    active = link_next[indx];
+	}
+    }
+    link_next[indx] = -1;
+    link_prev[indx] = -1;
+    on_list[indx] = ON_NO_LIST;
+    --active_cnt;
+    return;
+}
+
+
+/*
+ * push_free - place a channel on the free list for its type and state
+ *
+ * given:
+ *      indx    channel index not on any list
+ */
+static void
+push_free(int32_t indx)
+{
+    int type;	/* channel type */
+    int state;	/* channel current state */
+
+    /*
+     * firewall
+     */
+    if (indx < 0 || indx >= chanlen || on_list[indx] != ON_NO_LIST) {
+	fatal(10, "push_free", "chan[%d] cannot be freed", indx);
+	/*NOTREACHED*/
+    }
+    type = (int)ch[indx].common.type;
+    state = (int)ch[indx].common.curstate;
+    if (!VALID_TYPE(type) || !VALID_STATE(state)) {
+	fatal(10, "push_free", "chan[%d] invalid type: %d or state: %d",
+	      indx, type, state);
+	/*NOTREACHED*/
+    }
+
+    /*
+     * push onto the free list
+     */
+    link_next[indx] = free_head[type][state];
+    link_prev[indx] = -1;
+    free_head[type][state] = indx;
+    ++free_cnt[type][state];
+    on_list[indx] = ON_FREE;
+    return;
+}
+
+
+/*
+ * pop_free - take a channel from a free list and make it active
+ *
+ * given:
+ *      type            type of channel to take
+ *      curstate        current state of channel to take
+ *
+ * returns:
+ *      active channel or NULL if that free list is empty
+ */
+static chan *
+pop_free(chantype type, chanstate curstate)
+{
+    int32_t indx;	/* channel index taken */
+
+    /*
+     * firewall
+     */
+    if (!VALID_TYPE(type) || !VALID_STATE(curstate) || chanlen <= 0) {
+	return NULL;
+    }
+
+    /*
+     * pop the top of the list
+     */
+    indx = free_head[type][curstate];
+    if (indx < 0) {
+	return NULL;
+    }
+    free_head[type][curstate] = link_next[indx];
+    --free_cnt[type][curstate];
+    link_next[indx] = -1;
+    on_list[indx] = ON_NO_LIST;
+    link_active(indx);
+    return &(ch[indx]);
+}
+
+
+/*
+ * chan_idle - determine if an active channel has nothing left to do
+ *
+ * A channel is idle when it is HALTed, or when it has no descriptor
+ * and is closed (or was never opened) with no operation pending.
+ *
+ * given:
+ *      indx    channel index
+ *
+ * returns:
+ *      TRUE ==> channel may come off the active list, FALSE ==> keep it
+ */
+static int
+chan_idle(int32_t indx)
+{
+    common *c = &(ch[indx].common);	/* channel to check */
+
+    if (c->curstate == HALT || c->nxtstate == HALT) {
+	return TRUE;
+    }
+    if (c->fd < 0 && c->nxtstate == ALLOCED &&
+	(c->curstate == CLOSE || c->curstate == ALLOCED)) {
+	return TRUE;
+    }
+    return FALSE;
+}
+
+
+/*
+ * mk_chan - make a channel of a given type
+ *
+ * This function will take an unused channel from the TYPE_NONE free
+ * list, set its type and call the make function for that type.  If all
+ * channels are in use, it will allocate another ALLOC_SET of channels.
  *
  * given:
  *      type    type of channel to make
  *
  * returns:
  *      pointer to the make channel or NULL if error
+ *
+ * NOTE: The channel returned is on the active list.
  */
 chan *
 mk_chan(chantype type)
 {
-    static int last_indx = 0;	/* last index searched */
-    int start;	/* starting index to look for new ones */
+    chan *c;	/* unused channel */
     chan *ret = NULL;	/* return channel that was made */
-    int i;
-    int j;
 
     /*
      * firewall
@@ -273,71 +525,33 @@ mk_chan(chantype type)
     }
 
     /*
-     * look for a TYPE_NONE channel
-     */
-    for (i = 0; i < chanlen; ++i) {
-
-	/* cycle thru channels starting with last index */
-	j = (i + last_indx) % chanlen;
-
-	/* cycle processing */
-	if (ch[j].common.type == TYPE_NONE) {
-	    /* found a channel, make it */
-	    switch ((int)type) {
-	    case TYPE_LISTENER:
-		ret = mk_listener(&(ch[j].listener));
-		break;
-	    case TYPE_CLIENT:
-		ret = mk_client(&(ch[j].client));
-		break;
-	    case TYPE_CHAOS:
-		ret = mk_chaos(&(ch[j].chaos));
-		break;
-	    }
-	    /* start next search beyond this spot */
-	    last_indx = (i + 1) % chanlen;
-	    return ret;
-	}
-    }
-
-    /*
-     * allocate more channels
+     * take a TYPE_NONE channel, allocating more channels if needed
      */
-    start = chanlen;
-    alloc_chan(chanlen + ALLOC_SET);
-    for (i = start; i < chanlen; ++i) {
-
-	/* cycle thru channels starting with last index */
-	j = (i + last_indx) % chanlen;
-
-	/* cycle processing */
-	if (ch[j].common.type == TYPE_NONE) {
-	    /* found a channel, make it */
-	    switch ((int)type) {
-	    case TYPE_LISTENER:
-		ret = mk_listener(&(ch[j].listener));
-		break;
-	    case TYPE_CLIENT:
-		ret = mk_client(&(ch[j].client));
-		break;
-	    case TYPE_CHAOS:
-		ret = mk_chaos(&(ch[j].chaos));
-		break;
-	    }
-	    /* start next search beyond this spot */
-	    last_indx = (i + 1) % chanlen;
-	    return ret;
+    c = pop_free(TYPE_NONE, ALLOCED);
+    if (c == NULL) {
+	alloc_chan(chanlen + ALLOC_SET);
+	c = pop_free(TYPE_NONE, ALLOCED);
+	if (c == NULL) {
+	    warn("mk_chan", "no unused channels, returning NULL");
+	    return NULL;
 	}
     }
 
     /*
-     * did not find a channel, advance start position for next time
+     * make it
      */
-    warn("mk_chan", "falling off end, returning NULL");
-    if (chanlen != 0) {
-	last_indx = (last_indx + 1) % chanlen;
+    switch ((int)type) {
+    case TYPE_LISTENER:
+	ret = mk_listener(&(c->listener));
+	break;
+    case TYPE_CLIENT:
+	ret = mk_client(&(c->client));
+	break;
+    case TYPE_CHAOS:
+	ret = mk_chaos(&(c->chaos));
+	break;
     }
-    return NULL;
+    return ret;
 }
 
 
@@ -346,6 +560,9 @@ mk_chan(chantype type)
  *
  * given:
  *      ch      channel pointer
+ *
+ * NOTE: A HALTed channel is dropped from the active list by the next
+ *       chan_cycle() and is never reused.
  */
 void
 halt_chan(chan *ch)
@@ -365,6 +582,9 @@ halt_chan(chan *ch)
 	ch->common.indx,
 	ch->common.curstate, STATE_NAME(ch->common.curstate),
 	ch->common.nxtstate, STATE_NAME(ch->common.nxtstate));
+    if (ch->common.type == TYPE_CLIENT && CLIENT_IS_OPEN(ch->common.curstate)) {
+	--open_clients;
+    }
     ch->common.curstate = HALT;
     ch->common.nxtstate = HALT;
     warn("halt_chan", "chan[%d]: forced into HALT state", ch->common.indx);
@@ -376,9 +596,9 @@ halt_chan(chan *ch)
 /*
  * find_chan - find a given channel type in a given current state
  *
- * We search for channels in a circular fashion.  We start from
- * beyond the last search position.  When we reach the end we
- * start back around from the beginning.
+ * We take the most recently freed channel from the free list for the
+ * type and state.  Only channels that are idle (see chan_idle()) are on
+ * a free list, so in practice the useful states are CLOSE and ALLOCED.
  *
  * given:
  *      type            type of channel to find
@@ -386,49 +606,69 @@ halt_chan(chan *ch)
  *
  * returns:
  *      channel with the given type and current state or NULL
+ *
+ * NOTE: The channel returned is on the active list.
  */
 chan *
 find_chan(chantype type, chanstate curstate)
 {
-    static int last_indx = 0;	/* last index searched */
-    int i;
-    int j;
+    return pop_free(type, curstate);
+}
+
+
+/*
+ * prealloc_client_chan - ensure new clients will not grow the chan array
+ *
+ * Make sure that at least cnt client channels may be opened by
+ * mk_open_client() without having to allocate more channels.  Unused,
+ * ALLOCED and CLOSEd client channels on a free list count as available.
+ * If there are too few, we expand the chan array once by enough channels.
+ *
+ * given:
+ *      keep    channel held by the caller, or NULL
+ *      cnt     number of client channels about to be opened
+ *
+ * returns:
+ *      where keep now resides, or NULL if keep was NULL
+ *
+ * NOTE: Growing the chan array may move it, which leaves any chan
+ *       pointer held by a caller dangling.  A caller that opens
+ *       several clients while holding a channel pointer (such as
+ *       accept_listener() with its listener) should call this
+ *       function first and use the returned channel from then on.
+ */
+chan *
+prealloc_client_chan(chan *keep, int cnt)
+{
+    int indx;	/* index of keep */
+    int avail;	/* channels available for new clients */
+    int more;	/* channels to add */
 
     /*
      * firewall
      */
-    if (chanlen <= 0) {
-	return NULL;
+    if (cnt <= 0) {
+	return keep;
     }
+    indx = ((keep == NULL) ? -1 : keep->common.indx);
 
     /*
-     * cycle thru all channels from beyond the point of the previous
-     * search, remembering where we stopped and advancing the next
-     * start position beyond it.
+     * count the channels that mk_open_client() could use
      */
-    for (i = 0; i < chanlen; ++i) {
-
-	/* cycle thru channels starting with last index */
-	j = (i + last_indx) % chanlen;
-
-	/* cycle processing */
-	if (ch[j].common.type == type && ch[j].common.curstate == curstate) {
-
-	    /* start next search beyond this spot */
-	    last_indx = (i + 1) % chanlen;
-
-	    /* found a channel, make it */
-	    return &(ch[j]);
-	}
-    }
+    avail = free_cnt[TYPE_NONE][ALLOCED] +
+	    free_cnt[TYPE_CLIENT][CLOSE] + free_cnt[TYPE_CLIENT][ALLOCED];
 
     /*
-     * did not find a channel, advance start position for next time
+     * allocate the rest in one step, rounded up to a whole ALLOC_SET
      */
-    if (chanlen != 0) {
-	last_indx = (last_indx + 1) % chanlen;
+    if (avail < cnt) {
+	more = ((cnt - avail + ALLOC_SET - 1) / ALLOC_SET) * ALLOC_SET;
+	dbg(3, "prealloc_client_chan",
+	    "%d available, need %d, growing from %d to %d channels",
+	    avail, cnt, chanlen, chanlen + more);
+	alloc_chan(chanlen + more);
     }
-    return NULL;
+    return ((indx < 0) ? NULL : &(ch[indx]));
 }
 
 
@@ -527,7 +767,6 @@ chan_indx_op(int32_t indx, chancycle cycle)
 static int
 chan_select(double timelen)
 {
-    static int last_desc = 0;	/* last descriptor index searched */
     int n;	/* highest-numbered descriptor set + 1 */
     fd_set rd;	/* read select mask */
     fd_set wr;	/* write select mask */
@@ -539,12 +778,12 @@ chan_select(double timelen)
     int ret;	/* select or call return */
     int action;	/* number of select based actions left */
     int too_many;	/* TRUE ==> too many client channels open */
-    int looped;	/* TRUE ==> we looped around descriptor end already */
+    int walk;	/* active channels to walk */
+    int cnt;	/* active channels walked */
     static int toggle = 0;	/* a value that alternates between 0 and 1 */
     double fill_speed;	/* 1.0 => fast fill, 0 => slow, -1.0 => none */
     double fill_odds;	/* odds that we may chaos read 1/2 the time */
     int i;
-    int j;
 
     /*
      * initialize select values
@@ -572,34 +811,16 @@ chan_select(double timelen)
      * determine if we have too many open client channels
      */
     too_many = FALSE;
-    if (cfg_lavapool.maxclients > 0) {
-	int cnt;	/* open client channel count */
-
-	for (i = 0, cnt = 0;
-	     i < chanlen && cnt < cfg_lavapool.maxclients;
-	     ++i) {
-	    if (ch[i].common.type == TYPE_CLIENT) {
-		switch ((int)ch[i].common.curstate) {
-		    /* TYPE_CLIENT channels in this state effectively open */
-		case OPEN:
-		case READ:
-		case GATHER:
-		case WRITE:
-		    ++cnt;
-		    break;
-		}
-	    }
-	    if (cnt >= cfg_lavapool.maxclients) {
-		too_many = TRUE;
-		break;
-	    }
-	}
+    if (cfg_lavapool.maxclients > 0 &&
+	open_clients >= cfg_lavapool.maxclients) {
+	too_many = TRUE;
     }
 
     /*
-     * look at each channel for I/O based select masking
+     * look at each active channel for I/O based select masking
      */
-    for (i = 0; i < chanlen; ++i) {
+    walk = active_cnt;
+    for (cnt = 0, i = active; cnt < walk && i >= 0; ++cnt, i = link_next[i]) {
 
 	/*
 	 * check for invalid states
@@ -731,7 +952,7 @@ chan_select(double timelen)
 	     */
 	    fill_speed = pool_rate_factor();
 	    /* fast_select - always read select unless full */
-	    if (ch[i].chaos.fast_select && fill_speed >= 0.0) {
+	    if (ch[i].chaos.cold->fast_select && fill_speed >= 0.0) {
 		dbg(3, "chan_select",
 		    "chan[%d]: fast select", ch[i].common.indx);
 		ret = chaos_select_mask(&(ch[i].chaos), &rd, &wr, &ex);
@@ -863,31 +1084,25 @@ chan_select(double timelen)
     }
 
     /*
-     * perform operation on all selected channels in a circular fashion
+     * perform operation on all selected channels
+     *
+     * We walk the active channels as they were when the masks were
+     * formed.  Clients accepted along the way are linked in beyond
+     * the end of the walk, so a new client that reuses the descriptor
+     * of a channel closed along the way is not mistaken for it.
      */
-    looped = FALSE;
-    for (i = 0, action = ret; i < chanindx_len && action > 0; ++i) {
-	int index;	/* channel index to operate on */
+    for (cnt = 0, i = active, action = ret;
+	 cnt < walk && i >= 0 && action > 0;
+	 ++cnt, i = link_next[i]) {
+	int fd;	/* descriptor of the channel */
 	chancycle cycle;	/* type of select cycle we are processing */
 
-	/* cycle thru descriptor index values starting with last one */
-	j = (i + last_desc) % chanindx_len;
-	if (j >= n) {
-	    if (looped) {
-		/* been here, done that, time to stop */
-		break;
-	    }
-	    /* advance so that 'j' loops around end and comes up 0 */
-	    i = ((chanindx_len - last_desc - 1) % chanindx_len);
-	    looped = TRUE;
-	    continue;
+	if (ch[i].common.type == TYPE_CHAOS) {
+	    fd = chaos_select_fd(&(ch[i].chaos));
+	} else {
+	    fd = ch[i].common.fd;
 	}
-
-	/*
-	 * ignore if it does not belong to a channel
-	 */
-	index = chanindx[j];
-	if (index < 0 || index >= chanlen) {
+	if (fd < 0 || fd >= n) {
 	    continue;
 	}
 
@@ -899,11 +1114,11 @@ chan_select(double timelen)
 	 * will process the execution over the write, and the write
 	 * over the read.
 	 */
-	if (FD_ISSET(j, &ex)) {
+	if (FD_ISSET(fd, &ex)) {
 	    cycle = CYCLE_SELECTEXECPT;
-	} else if (FD_ISSET(j, &wr)) {
+	} else if (FD_ISSET(fd, &wr)) {
 	    cycle = CYCLE_SELECTWRITE;
-	} else if (FD_ISSET(j, &rd)) {
+	} else if (FD_ISSET(fd, &rd)) {
 	    cycle = CYCLE_SELECTREAD;
 	} else {
 	    continue;
@@ -912,16 +1127,9 @@ chan_select(double timelen)
 	/*
 	 * We will perform a select based operation on the channel
 	 */
-	chan_indx_op(index, cycle);
+	chan_indx_op(i, cycle);
 	--action;
     }
-
-    /*
-     * advance start position for next time
-     */
-    if (chanindx_len != 0) {
-	last_desc = (last_desc + 1) % chanindx_len;
-    }
     dbg(1, "chan_select", "pool level: (%.3f) %u", pool_frac(), pool_level());
     return ret;
 }
@@ -936,9 +1144,10 @@ chan_select(double timelen)
 void
 chan_cycle(double timeout)
 {
-    static int last_indx = 0;	/* last index searched */
+    int walk;	/* active channels to walk */
+    int cnt;	/* active channels walked */
+    int next;	/* next active channel to walk */
     int i;
-    int j;
 
     /*
      * Prepare for processing the channels
@@ -947,46 +1156,72 @@ chan_cycle(double timeout)
     chan_cycle_timeout = timeout;
 
     /*
-     * perform pre-select processing on channels that need it
+     * perform pre-select processing on active channels that need it
      */
     dbg(2, "chan_cycle", "cycle: %lld, pre-select processing", op_cycle);
-    for (i = 0; i < chanlen; ++i) {
+    walk = active_cnt;
+    for (cnt = 0, i = active; cnt < walk && i >= 0; ++cnt, i = next) {
 
-	/* cycle thru channels starting with last index */
-	j = (i + last_indx) % chanlen;
+	/* note the next channel now, this one may leave the active list */
+	next = link_next[i];
 
 	/*
 	 * check for invalid states
 	 */
-	if (ch[j].common.curstate < 0 || ch[j].common.curstate > LAST_STATE) {
+	if (ch[i].common.curstate < 0 || ch[i].common.curstate > LAST_STATE) {
 	    warn("chan_cycle", "chan[%d]: invalid current state: %d",
-		 j, (int)ch[j].common.curstate);
-	    halt_chan(&(ch[j]));
+		 i, (int)ch[i].common.curstate);
+	    halt_chan(&(ch[i]));
 	    continue;
 	}
-	if (ch[j].common.nxtstate < 0 || ch[j].common.nxtstate > LAST_STATE) {
+	if (ch[i].common.nxtstate < 0 || ch[i].common.nxtstate > LAST_STATE) {
 	    warn("chan_cycle", "chan[%d]: invalid next state: %d",
-		 j, (int)ch[j].common.nxtstate);
-	    halt_chan(&(ch[j]));
+		 i, (int)ch[i].common.nxtstate);
+	    halt_chan(&(ch[i]));
 	    continue;
 	}
 
 	/* cycle processing */
-	switch (ch[j].common.type) {
+	switch (ch[i].common.type) {
 	case TYPE_LISTENER:
-	    listener_pre_select_op(&(ch[j].listener));
+	    listener_pre_select_op(&(ch[i].listener));
 	    break;
 	case TYPE_CLIENT:
-	    client_pre_select_op(&(ch[j].client));
+	    client_pre_select_op(&(ch[i].client));
 	    break;
 	case TYPE_CHAOS:
-	    chaos_pre_select_op(&(ch[j].chaos));
+	    chaos_pre_select_op(&(ch[i].chaos));
 	    break;
 	default:
 	    break;
 	}
+
+	/*
+	 * retire channels with nothing left to do
+	 *
+	 * HALTed channels are dropped, closed channels are freed for reuse.
+	 */
+	if (chan_idle(i)) {
+	    dbg(4, "chan_cycle", "chan[%d]: idle in state: %s, %s",
+		i, STATE_NAME(ch[i].common.curstate),
+		(ch[i].common.curstate == HALT ? "dropped" : "freed"));
+	    unlink_active(i);
+	    if (ch[i].common.curstate != HALT && ch[i].common.nxtstate != HALT) {
+		push_free(i);
+	    }
+	}
     }
 
+    /*
+     * share the pool among the clients waiting to gather
+     */
+    gather_pass();
+
+    /*
+     * collect MSG_ZEROCOPY completions for closed clients
+     */
+    zombie_pass();
+
     /*
      * Update the timeout that may have been altered by calls
      * to need_cycle_before() during the above pre-select operations
@@ -1013,8 +1248,8 @@ chan_cycle(double timeout)
     /*
      * advance start position for next time
      */
-    if (chanlen != 0) {
-	last_indx = (last_indx + 1) % chanlen;
+    if (active >= 0) {
+	active = link_next[active];
     }
 
     /*
@@ -1290,10 +1525,36 @@ chan_close(void)
 void
 free_allchan(void)
 {
+    int i;
+
     if (ch != NULL) {
+	for (i = 0; i < chanlen; ++i) {
+	    if (ch[i].common.cold != NULL) {
+		free(ch[i].common.cold);
+		ch[i].common.cold = NULL;
+	    }
+	}
 	free(ch);
 	ch = NULL;
     }
+    if (link_next != NULL) {
+	free(link_next);
+	link_next = NULL;
+    }
+    if (link_prev != NULL) {
+	free(link_prev);
+	link_prev = NULL;
+    }
+    if (on_list != NULL) {
+	free(on_list);
+	on_list = NULL;
+    }
+    free_gather();
+    free_zombies();
+    chanlen = 0;
+    active = -1;
+    active_cnt = 0;
+    open_clients = 0;
     if (chanindx != NULL) {
     	free(chanindx);
 	chanindx = NULL;
@@ -53,9 +53,13 @@ enum chantype_t {
     TYPE_CLIENT,		/* client data requests via count and binary return */
     TYPE_CHAOS,			/* chaotic source socket via HTTP/1.0 protocol */
     TYPE_SYSTEM			/* system related descriptor */
+      /* NOTE: LAST_TYPE must #define to the last enum value above */
 };
 typedef enum chantype_t chantype;
 
+#  define LAST_TYPE ((int)(TYPE_SYSTEM))	/* highest enum value */
+#  define VALID_TYPE(x) ((int)(x) >= 0 && (int)(x) <= LAST_TYPE)
+
 
 /*
  * channel op cycle
@@ -109,20 +113,46 @@ typedef enum chanstate_e chanstate;
 #  define VALID_STATE(x) ((int)(x) >= 0 && (int)(x) <= LAST_STATE)
 #  define STATE_NAME(x) (VALID_STATE(x) ? state_name[(int)(x)] : "UNKNOWN_STATE")
 
+/*
+ * client states that count against maxclients
+ */
+#  define CLIENT_IS_OPEN(x) \
+    ((x) == OPEN || (x) == READ || (x) == GATHER || (x) == WRITE)
+
+
+/*
+ * channel layout
+ *
+ * The chan array is scanned on every channel cycle, so each entry holds
+ * only the hot elements that the scans need: the common elements below,
+ * plus a pointer to the rest of the channel state.  The rest of the
+ * state (the cold state) is allocated separately when the channel is
+ * given its type, and kept for reuse when the channel is closed.  A
+ * large chaos channel therefore no longer makes every client and
+ * listener entry just as large.
+ */
+
 
 /*
  * listener - listen and accept new client connections
  */
+struct listener_cold_s {
+    u_int64_t count;	/* clients accepted on the channel */
+    double last_op;	/* time of last successful accept operation */
+    char *port;		/* listen port, NULL ==> cfg_random.lavapool */
+    int class;		/* class of clients, 0 ==> classify by address */
+};
+
 struct listener_s {
-    /* must be first 5 - must match common typedef */
+    /* must be first 6 - must match common typedef */
     int indx;		/* channel index */
     chantype type;	/* should be TYPE_LISTENER */
     chanstate curstate;	/* current state of this client */
     chanstate nxtstate;	/* next state of this client */
     int fd;		/* open socket descriptor if >= 0 */
+    double timeout;	/* not used by listeners, always 0.0 */
     /**/
-    u_int64_t count;	/* clients accepted on the channel */
-    double last_op;	/* time of last successful accept operation */
+    struct listener_cold_s *cold;	/* rest of the listener state */
 };
 typedef struct listener_s listener;
 
@@ -130,39 +160,61 @@ typedef struct listener_s listener;
 /*
  * client - request for LavaRnd data
  */
-struct client_s {
-    /* must be first 5 - must match common typedef */
-    int indx;		/* channel index */
-    chantype type;	/* should be TYPE_CLIENT */
-    chanstate curstate;	/* current state of this client */
-    chanstate nxtstate;	/* next state of this client */
-    int fd;		/* open socket descriptor if >= 0 */
-    /**/
+#  define CLIENT_PIPELINE (16)	/* binary request headers we buffer at once */
+#  define CLIENT_BUFLEN (LAVA_PROTO_HELLOLEN + \
+			 CLIENT_PIPELINE*LAVA_PROTO_REQLEN)
+
+struct client_cold_s {
     double open_op;	/* time of when client was opened */
     double last_op;	/* time of last successful accept operation */
     double timelimit;	/* READ+WRITE time in sec if > 0.0 */
-    double timeout;	/* timeout time if opened and > 0.0 */
     long request;	/* request size if GATHER or WRITE */
     long readcnt;	/* total characters read if READ */
     long gathercnt;	/* random octets gathered if GATHER */
     long writecnt;	/* total characters written if WRITE */
-    char readbuf[LAVA_REQBUFLEN + 1];	/* read length request input buffer */
+    char readbuf[CLIENT_BUFLEN + 1];	/* request input buffer */
+    int proto;		/* binary protocol version, 0 ==> decimal request */
+    int minqual;	/* binary request minimum quality */
+    double deadline;	/* binary request deadline if > 0.0 */
+    u_int8_t reply[LAVA_PROTO_REPLEN];	/* binary reply header */
+    int replylen;	/* reply header length, 0 ==> no header */
+    int replycnt;	/* reply header octets written */
+    int stream;		/* TRUE ==> serving a binary stream request */
+    long stream_left;	/* stream octets not yet gathered, <0 ==> no limit */
+    long stream_rate;	/* stream octets per second, 0 ==> no limit */
+    double stream_next;	/* time the next stream reply may be gathered */
+    u_int64_t gather_seq;	/* gather wait order, 0 ==> not yet waiting */
+    long allot;		/* pool octets alloted by the gather pass */
+    int class;		/* client class, index into cfg_lavapool.class[] */
+    int s100;		/* TRUE ==> serve s100 data, not LavaRnd data */
     u_int8_t *random;	/* if != NULL, LavaRnd data to deliver */
+    u_int8_t *resv;	/* if != NULL, reserved pool region to deliver */
+    int zerocopy;	/* 1 ==> MSG_ZEROCOPY on, -1 ==> off, 0 ==> untried */
+    u_int32_t zc_sent;	/* MSG_ZEROCOPY sends made */
+    u_int32_t zc_done;	/* MSG_ZEROCOPY sends the kernel is done with */
+    u_int32_t zc_end;	/* random is in use until zc_done reaches this */
+    struct zc_buf *zc_pend;	/* written buffers the kernel may still use */
+    int zc_pendcnt;	/* number of zc_pend buffers */
 };
-typedef struct client_s client;
 
-
-/*
- * chaos - request and obtain chaotic data via HTTP/1.0 protocol
- */
-struct chaos_s {
-    /* must be first 5 - must match common typedef */
+struct client_s {
+    /* must be first 6 - must match common typedef */
     int indx;		/* channel index */
-    chantype type;	/* should be TYPE_CHAOS */
+    chantype type;	/* should be TYPE_CLIENT */
     chanstate curstate;	/* current state of this client */
     chanstate nxtstate;	/* next state of this client */
     int fd;		/* open socket descriptor if >= 0 */
+    double timeout;	/* timeout time if opened and > 0.0 */
     /**/
+    struct client_cold_s *cold;	/* rest of the client state */
+};
+typedef struct client_s client;
+
+
+/*
+ * chaos - request and obtain chaotic data via HTTP/1.0 protocol
+ */
+struct chaos_cold_s {
     u_int64_t count;	/* LavaRnd octets processed by the channel */
     double last_op;	/* time of last successful read operation */
     pid_t pid;		/* pid of process, 0 ==> driver, no process */
@@ -173,7 +225,30 @@ struct chaos_s {
     union lavacam cam;	/* device state and settings */
     struct opsize siz;	/* how and where to read from device */
     struct lavacam_flag flag;	/* flags set via lavacam_argv() */
+    int frame_fd;	/* readable when a driver frame is ready, -1 ==> fd */
+    u_int8_t *dense;	/* lavacam_extract() buffer, NULL ==> whole frame */
+    int dense_len;	/* length of the dense buffer */
+    u_int8_t *batch;	/* frames gathered for lavarnd, NULL ==> no batch */
+    int batch_len;	/* length of the batch buffer */
+    int batch_used;	/* octets gathered in the batch buffer */
+    int batch_frames;	/* frames gathered in the batch buffer */
+    int batch_max;	/* frames to gather before LavaRnd processing */
+    int batch_auto;	/* TRUE ==> process early, see batch_chaos() */
+    double batch_entropy;	/* est min-entropy of batch, <0 ==> none */
     double next_file;	/* >0 ==> time of next savefile */
+    int source;		/* cfg_lavapool chaos source of this channel */
+};
+
+struct chaos_s {
+    /* must be first 6 - must match common typedef */
+    int indx;		/* channel index */
+    chantype type;	/* should be TYPE_CHAOS */
+    chanstate curstate;	/* current state of this client */
+    chanstate nxtstate;	/* next state of this client */
+    int fd;		/* open socket descriptor if >= 0 */
+    double timeout;	/* not used by chaos channels, always 0.0 */
+    /**/
+    struct chaos_cold_s *cold;	/* rest of the chaos state */
 };
 typedef struct chaos_s chaos;
 
@@ -184,13 +259,15 @@ typedef struct chaos_s chaos;
  * common - common initial elements to all types of channels
  */
 struct common_s {
-    /* must match first 5 of struct listener_s, client_s and chaos_s */
+    /* must match first 6 of struct listener_s, client_s and chaos_s */
     int indx;	/* channel index */
     chantype type;	/* channel type */
     chanstate curstate;	/* current state of this client */
     chanstate nxtstate;	/* next state of this client */
     int fd;	/* open socket descriptor if >= 0 */
+    double timeout;	/* timeout time if > 0.0 */
      /**/
+    void *cold;	/* type specific state or NULL if TYPE_NONE */
 };
 typedef struct common_s common;
 
@@ -218,12 +295,14 @@ typedef union chan_u chan;
  * chan.c - external functions
  */
 extern int32_t chanindx_len;
+extern int32_t open_clients;
 extern const char *const state_name[];
 extern double about_now;
 extern void alloc_chanindx(void);
 extern chan *mk_chan(chantype type);
 extern void halt_chan(chan *ch);
 extern chan *find_chan(chantype type, chanstate state);
+extern chan *prealloc_client_chan(chan *keep, int cnt);
 extern void chan_cycle(double timeout);
 extern void set_chanindx(int indx, int fd);
 extern void clear_chanindx(int indx, int fd);
@@ -240,7 +319,7 @@ extern int listener_select_mask(listener *ch, fd_set * rd, fd_set * wr,
 				fd_set * ex);
 extern void listener_pre_select_op(listener *ch);
 extern chan *mk_listener(listener *ch);
-extern chan *mk_open_listener(void);
+extern chan *mk_open_listener(char *port, int class);
 extern void accept_listener(listener *ch);
 extern void close_listener(listener *ch);
 
@@ -253,8 +332,12 @@ extern int client_select_mask(client *ch, fd_set * rd, fd_set * wr,
 			      fd_set * ex);
 extern void client_pre_select_op(client *ch);
 extern chan *mk_client(client *ch);
-extern chan *mk_open_client(int fd);
+extern chan *mk_open_client(int fd, int class);
 extern void close_client(client *ch);
+extern void gather_pass(void);
+extern void free_gather(void);
+extern void zombie_pass(void);
+extern void free_zombies(void);
 
 
 /*
@@ -262,9 +345,12 @@ extern void close_client(client *ch);
  */
 extern void do_chaos_op(chaos *ch, chancycle cycle);
 extern int chaos_select_mask(chaos *ch, fd_set * rd, fd_set * wr, fd_set * ex);
+extern int chaos_select_fd(chaos *ch);
 extern void chaos_pre_select_op(chaos *ch);
 extern chan *mk_chaos(chaos *ch);
-extern chan *mk_open_chaos(void);
+extern chan *mk_open_chaos(int source);
+extern int open_all_chaos(void);
+extern double check_chaos(void);
 extern void close_chaos(chaos *ch);
 extern int ready_to_frame_dump(chaos *ch);
 
@@ -30,6 +30,8 @@
  */
 
 
+#define _GNU_SOURCE	/* for F_SETPIPE_SZ */
+
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
@@ -38,11 +40,14 @@
 #include <signal.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <fcntl.h>
+#include <pthread.h>
 
 #include "LavaRnd/rawio.h"
 #include "LavaRnd/cfg.h"
 #include "LavaRnd/lavacam.h"
+#include "LavaRnd/lavarnd.h"
 #include "LavaRnd/lavaquality.h"
 #include "LavaRnd/lava_debug.h"
 
@@ -164,6 +169,7 @@ static int willing_to_frame_dump(chaos *ch);
 static double time_to_next_dump(chaos *ch);
 static int frame_dump_if_ready(chaos *ch);
 static int frame_dump(chaos *ch);
+static int batch_chaos(chaos *ch, void *buf, int buflen, double entropy);
 
 
 /*
@@ -173,6 +179,69 @@ static int frame_dump(chaos *ch);
 #define INSANE_FRAME_FIRST_WARN (10)	/* report this many 1st insane frames */
 
 
+/*
+ * chaos sources
+ *
+ * Each cfg_lavapool chaos source is served by its own chaos channel.
+ * The state of a source outlives its channels so that a source that
+ * fails may be reopened while the other sources keep filling the pool.
+ * The wait before a reopen doubles with each failure, up to
+ * CHAOS_RETRY_MAX seconds, and starts over once the source has stayed
+ * open for CHAOS_RETRY_MAX seconds.
+ */
+#define CHAOS_RETRY_MIN (1.0)	/* first wait before reopening a source */
+#define CHAOS_RETRY_MAX (64.0)	/* longest wait before reopening a source */
+#define CHAOS_REPORT (60.0)	/* seconds between source reports */
+#define CHAOS_PIPE_MIN (65536)	/* do not bother to set a pipe this small */
+
+struct chaos_src {
+    int indx;		/* chaos channel serving the source, -1 ==> none */
+    double retry;	/* time to reopen the source if it has no channel */
+    double backoff;	/* wait before the next reopen */
+    double opened;	/* time the source was last opened */
+    double reported;	/* time of last source report */
+    u_int64_t octets;	/* octets the source added to the pool */
+    u_int64_t frames;	/* driver frames read */
+    u_int64_t insane;	/* driver frames rejected as insane */
+    u_int64_t opens;	/* times the source was opened */
+    u_int64_t failures;	/* failed opens, reads and selects */
+};
+static struct chaos_src src[LAVA_MAX_CHAOS];	/* chaos source state */
+static void chaos_src_down(chaos *ch);
+static void report_chaos(int source);
+
+
+/*
+ * frame dump writer
+ *
+ * Frame dumps are written by a writer thread so that a slow disk does
+ * not hold up the channel cycle.  frame_dump() copies the frame and the
+ * file names into a dump job and puts it on a queue of up to
+ * DUMP_QUEUE_MAX jobs waiting for the writer.  When the queue is full
+ * the dump is dropped and the frame is LavaRnd processed instead.
+ */
+#define DUMP_QUEUE_MAX (4)	/* most frame dumps waiting to be written */
+
+struct dump_job {
+    int indx;		/* chaos channel of the frame */
+    int E_flag;		/* TRUE ==> do not dump if savefile is non-empty */
+    char *savefile;	/* file to rename the newfile to */
+    char *newfile;	/* file to write the frame into */
+    u_int8_t *frame;	/* copy of the frame */
+    int len;		/* length of the frame */
+    /* savefile, newfile and the frame follow in the same malloc */
+};
+static struct dump_job *dump_queue[DUMP_QUEUE_MAX];	/* frame dump queue */
+static int dump_head = 0;	/* dump_queue index of the oldest job */
+static int dump_cnt = 0;	/* jobs in the dump_queue */
+static int dump_started = FALSE;	/* TRUE ==> writer thread running */
+static pthread_t dump_thread;	/* frame dump writer thread */
+static pthread_mutex_t dump_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t dump_cond = PTHREAD_COND_INITIALIZER;
+static void *dump_writer(void *arg);
+static void dump_write(struct dump_job *job);
+
+
 /*
  * do_chaos_op - perform the channel type specific operation
  *
@@ -242,7 +311,7 @@ do_chaos_op(chaos *ch, chancycle cycle)
 	    dbg(4, "do_chaos_op",
 	    	   "select-exception close op: chan[%d] state: %s ==> %s",
 		ch->indx, STATE_NAME(ch->curstate), STATE_NAME(ch->nxtstate));
-	    close_chaos(ch);
+	    chaos_force_close(ch);
 	} else {
 	    warn("do_chaos_op",
 	    	 "ignore select-exception op: chan[%d] state: %s ==> %s",
@@ -281,6 +350,40 @@ do_chaos_op(chaos *ch, chancycle cycle)
 }
 
 
+/*
+ * chaos_select_fd - descriptor to select on for a chaos channel
+ *
+ * given:
+ *	ch	chaos channel
+ *
+ * returns:
+ *	descriptor that is readable when the channel has data, or -1
+ *
+ * This is the channel descriptor, unless the driver reports frames
+ * ready on another descriptor.  See lavacam_frame_fd().
+ */
+int
+chaos_select_fd(chaos *ch)
+{
+    /*
+     * firewall
+     */
+    if (ch == NULL) {
+	fatal(10, "chaos_select_fd", "NULL arg");
+	/*NOTREACHED*/
+    }
+
+    /*
+     * use the frame ready descriptor of an open driver, if any
+     */
+    if (ch->fd >= 0 && ch->cold != NULL && ch->cold->driver &&
+	ch->cold->frame_fd >= 0) {
+	return ch->cold->frame_fd;
+    }
+    return ch->fd;
+}
+
+
 /*
  * chaos_select_mask - enable in a select if needed
  *
@@ -299,6 +402,7 @@ int
 chaos_select_mask(chaos *ch, fd_set *rd, fd_set *wr, fd_set *ex)
 {
     int ret = -1;		/* descriptor set or -1 */
+    int fd;			/* descriptor to select on */
 
     /*
      * firewall
@@ -321,33 +425,34 @@ chaos_select_mask(chaos *ch, fd_set *rd, fd_set *wr, fd_set *ex)
     /*
      * set mask as needed
      */
+    fd = chaos_select_fd(ch);
     if (rd != NULL && chaos_read_mask[ch->nxtstate]) {
-	FD_SET(ch->fd, rd);
-	ret = ch->fd;
+	FD_SET(fd, rd);
+	ret = fd;
 	if (dbg_lvl >= 5) {
 	    dbg(5, "chaos_select_mask",
 		"op: chan[%d]  fd: %d  state: %s ==> %s read mask set",
-		ch->indx, ch->fd, STATE_NAME(ch->curstate),
+		ch->indx, fd, STATE_NAME(ch->curstate),
 		STATE_NAME(ch->nxtstate));
     	}
     }
     if (wr != NULL && chaos_write_mask[ch->nxtstate]) {
-	FD_SET(ch->fd, wr);
-	ret = ch->fd;
+	FD_SET(fd, wr);
+	ret = fd;
 	if (dbg_lvl >= 5) {
 	    dbg(5, "chaos_select_mask",
 		"op: chan[%d]  fd: %d  state: %s ==> %s write mask set",
-		ch->indx, ch->fd, STATE_NAME(ch->curstate),
+		ch->indx, fd, STATE_NAME(ch->curstate),
 		STATE_NAME(ch->nxtstate));
     	}
     }
     if (ex != NULL && chaos_exception_mask[ch->nxtstate]) {
-	FD_SET(ch->fd, ex);
-	ret = ch->fd;
+	FD_SET(fd, ex);
+	ret = fd;
 	if (dbg_lvl >= 5) {
 	    dbg(5, "chaos_select_mask",
 		"op: chan[%d]  fd: %d  state: %s ==> %s exception mask set",
-		ch->indx, ch->fd, STATE_NAME(ch->curstate),
+		ch->indx, fd, STATE_NAME(ch->curstate),
 		STATE_NAME(ch->nxtstate));
     	}
     }
@@ -415,6 +520,7 @@ chan *
 mk_chaos(chaos *ch)
 {
     int indx;		/* remembered channel index */
+    struct chaos_cold_s *cold;	/* remembered chaos state */
 
     /*
     * firewall
@@ -424,18 +530,43 @@ mk_chaos(chaos *ch)
 	/*NOTREACHED*/
     }
 
+    /*
+     * allocate the rest of the chaos state if needed
+     */
+    cold = ch->cold;
+    if (cold == NULL) {
+	cold = (struct chaos_cold_s *)malloc(sizeof(*cold));
+	if (cold == NULL) {
+	    fatal(11, "mk_chaos", "chan[%d]: unable to malloc state",
+		  ch->indx);
+	    /*NOTREACHED*/
+	}
+    }
+
     /*
      * clear values
      */
     indx = ch->indx;
     memset(ch, 0, sizeof(*ch));
+    memset(cold, 0, sizeof(*cold));
     ch->indx = indx;
+    ch->cold = cold;
     ch->fd = -1;
-    ch->last_op = -1.0;
-    ch->fast_select = 0;
-    ch->driver = FALSE;
-    ch->driver_type = LAVACAM_ERR_TYPE;
-    ch->next_file = 0.0;
+    ch->cold->last_op = -1.0;
+    ch->cold->fast_select = 0;
+    ch->cold->driver = FALSE;
+    ch->cold->driver_type = LAVACAM_ERR_TYPE;
+    ch->cold->frame_fd = -1;
+    ch->cold->dense = NULL;
+    ch->cold->dense_len = 0;
+    ch->cold->batch = NULL;
+    ch->cold->batch_len = 0;
+    ch->cold->batch_used = 0;
+    ch->cold->batch_frames = 0;
+    ch->cold->batch_max = 1;
+    ch->cold->batch_auto = FALSE;
+    ch->cold->batch_entropy = 0.0;
+    ch->cold->next_file = 0.0;
 
     /*
      * force type
@@ -449,9 +580,9 @@ mk_chaos(chaos *ch)
     ch->nxtstate = OPEN;
     dbg(2, "mk_chaos", "op: chan[%d] now chaos channel: state: %s ==> %s",
 	ch->indx, STATE_NAME(ch->curstate), STATE_NAME(ch->nxtstate));
-    ch->pid = 0;
-    ch->driver = FALSE;
-    ch->driver_type = LAVACAM_ERR_TYPE;
+    ch->cold->pid = 0;
+    ch->cold->driver = FALSE;
+    ch->cold->driver_type = LAVACAM_ERR_TYPE;
     return (chan *)ch;
 }
 
@@ -463,17 +594,31 @@ mk_chaos(chaos *ch)
  * closed chaos channel, or if none is found, we will create a new
  * chaos channel.
  *
+ * given:
+ *	source	cfg_lavapool chaos source to open
+ *
  * returns:
  *	OPEN chaos channel or NULL if error
  *
  * NOTE: This function uses the NULL cmd interface of open_chaos() which
- *	 assumes that cfg_lavapool.chaos contains the command line to use.
+ *	 uses the command line of the channel's chaos source.
+ *
+ * NOTE: A channel that fails to open is left CLOSEd and the source
+ *	 is scheduled to be reopened by check_chaos().
  */
 chan *
-mk_open_chaos(void)
+mk_open_chaos(int source)
 {
     chan *c;			/* channel being opened */
 
+    /*
+     * firewall
+     */
+    if (source < 0 || source >= cfg_lavapool.chaoscnt) {
+	warn("mk_open_chaos", "invalid chaos source: %d", source);
+	return NULL;
+    }
+
     /*
      * find a channel
      *
@@ -500,15 +645,173 @@ mk_open_chaos(void)
 	   STATE_NAME(c->chaos.curstate),  STATE_NAME(c->chaos.nxtstate),
 	   STATE_NAME(OPEN));
     c->chaos.nxtstate = OPEN;
+    c->chaos.cold->source = source;
+    src[source].indx = c->chaos.indx;
 
     open_chaos(&(c->chaos), NULL);
     if (c->chaos.curstate != OPEN) {
+	warn("mk_open_chaos", "chaos[%d]: failed to open: %s",
+	     source, cfg_lavapool.chaos[source].cmd);
+	++src[source].failures;
+	c->chaos.fd = -1;
+	c->chaos.curstate = CLOSE;
+	c->chaos.nxtstate = ALLOCED;
+	chaos_src_down(&(c->chaos));
 	return NULL;
     }
+    ++src[source].opens;
+    src[source].opened = about_now;
+    dbg(1, "mk_open_chaos", "chaos[%d]: open on chan[%d]",
+	source, c->chaos.indx);
     return c;
 }
 
 
+/*
+ * open_all_chaos - open a chaos channel for each chaos source
+ *
+ * returns:
+ *	number of chaos sources opened
+ *
+ * NOTE: A source that fails to open is reopened later by check_chaos().
+ */
+int
+open_all_chaos(void)
+{
+    int opened = 0;	/* chaos sources opened */
+    int i;
+
+    /*
+     * initialize the chaos source state
+     */
+    about_now = right_now();
+    memset(src, 0, sizeof(src));
+    for (i=0; i < LAVA_MAX_CHAOS; ++i) {
+	src[i].indx = -1;
+	src[i].backoff = CHAOS_RETRY_MIN;
+	src[i].reported = about_now;
+    }
+
+    /*
+     * open each source
+     */
+    for (i=0; i < cfg_lavapool.chaoscnt; ++i) {
+	if (mk_open_chaos(i) != NULL) {
+	    ++opened;
+	}
+    }
+    return opened;
+}
+
+
+/*
+ * check_chaos - reopen failed chaos sources and report on all of them
+ *
+ * A chaos source without a channel is reopened once its retry time
+ * has come.  Every CHAOS_REPORT seconds, each source's metrics are
+ * reported at debug level 1.  Exited chaos co-processes are reaped.
+ *
+ * returns:
+ *	seconds until the next reopen attempt, <0 ==> none pending
+ *
+ * NOTE: This function is called once per channel cycle.
+ */
+double
+check_chaos(void)
+{
+    double now;		/* the current time */
+    double next = -1.0;	/* time of the next reopen attempt or <0 */
+    int i;
+
+    /*
+     * reap any chaos co-processes that have exited
+     */
+    while (waitpid(-1, NULL, WNOHANG) > 0) {
+    }
+
+    /*
+     * reopen failed sources when due
+     */
+    now = right_now();
+    for (i=0; i < cfg_lavapool.chaoscnt; ++i) {
+	if (src[i].indx < 0 && src[i].retry <= now) {
+	    dbg(1, "check_chaos", "chaos[%d]: reopening: %s",
+		i, cfg_lavapool.chaos[i].cmd);
+	    (void) mk_open_chaos(i);
+	}
+	if (src[i].indx < 0 && (next < 0.0 || src[i].retry < next)) {
+	    next = src[i].retry;
+	}
+	if (now - src[i].reported >= CHAOS_REPORT) {
+	    report_chaos(i);
+	    src[i].reported = now;
+	}
+    }
+    return ((next < 0.0) ? -1.0 : ((next > now) ? (next - now) : 0.0));
+}
+
+
+/*
+ * report_chaos - report the metrics of a chaos source
+ *
+ * given:
+ *	source	cfg_lavapool chaos source
+ */
+static void
+report_chaos(int source)
+{
+    dbg(1, "report_chaos",
+	"chaos[%d]: %s  octets: %lld  frames: %lld  insane: %lld  "
+	"opens: %lld  failures: %lld",
+	source, ((src[source].indx < 0) ? "down" : "up"),
+	src[source].octets, src[source].frames, src[source].insane,
+	src[source].opens, src[source].failures);
+}
+
+
+/*
+ * chaos_src_down - note that a chaos source no longer has a channel
+ *
+ * The source is scheduled to be reopened by check_chaos().
+ *
+ * given:
+ *	ch	chaos channel that served the source
+ */
+static void
+chaos_src_down(chaos *ch)
+{
+    struct chaos_src *s;	/* chaos source of ch */
+
+    /*
+     * firewall
+     */
+    if (ch->cold->source < 0 || ch->cold->source >= cfg_lavapool.chaoscnt) {
+	return;
+    }
+    s = &src[ch->cold->source];
+    if (s->indx != ch->indx) {
+	return;
+    }
+
+    /*
+     * schedule the reopen
+     */
+    s->indx = -1;
+    if (about_now - s->opened >= CHAOS_RETRY_MAX) {
+	/* the source had been doing well */
+	s->backoff = CHAOS_RETRY_MIN;
+    }
+    s->retry = about_now + s->backoff;
+    dbg(1, "chaos_src_down", "chaos[%d]: down, will reopen in %.1f sec",
+	ch->cold->source, s->backoff);
+    s->backoff *= 2.0;
+    if (s->backoff > CHAOS_RETRY_MAX) {
+	s->backoff = CHAOS_RETRY_MAX;
+    }
+    return;
+}
+
+
 /*
  * open_chaos - open an chaos channel
  *
@@ -528,7 +831,7 @@ mk_open_chaos(void)
  * given:
  *	ch 	chaos channel
  *	cmd	args for command or driver
- *		  or NULL ==> use cfg_lavapool.chaos
+ *		  or NULL ==> use the channel's cfg_lavapool chaos source
  */
 static void
 open_chaos(chaos *ch, char *cmd)
@@ -541,6 +844,7 @@ open_chaos(chaos *ch, char *cmd)
     pid_t pid;			/* forked pid or 0 or error */
     char *driver_name = NULL;	/* name of driver used */
     char *device_name = NULL;	/* name of driver device */
+    int framelen;		/* most octets LavaRnd processed per frame */
     char *p;
     int i;
 
@@ -551,8 +855,9 @@ open_chaos(chaos *ch, char *cmd)
 	fatal(10, "open_chaos", "NULL ch arg");
 	/*NOTREACHED*/
     }
-    if (cmd == NULL) {
-	cmd = cfg_lavapool.chaos;
+    if (cmd == NULL && ch->cold->source >= 0 &&
+	ch->cold->source < cfg_lavapool.chaoscnt) {
+	cmd = cfg_lavapool.chaos[ch->cold->source].cmd;
     }
     if (cmd == NULL) {
 	fatal(10, "open_chaos", "NULL cmd arg and NULL chaos");
@@ -604,8 +909,8 @@ open_chaos(chaos *ch, char *cmd)
 	 */
 	driver_name = argv[1];
 	device_name = argv[2];
-	ch->driver_type = camtype(driver_name);
-	if (ch->driver_type < 0) {
+	ch->cold->driver_type = camtype(driver_name);
+	if (ch->cold->driver_type < 0) {
 	    warn("open_chaos", "unknown driver name: %s", driver_name);
 	    free(cmdline);
 	    return;
@@ -617,12 +922,13 @@ open_chaos(chaos *ch, char *cmd)
 	argc -= 2;
 	argv += 2;
 	argv[0] = arg[0];
-	arg_shift = lavacam_argv(ch->driver_type, argc, argv, &n_cam, &flag);
+	arg_shift = lavacam_argv(ch->cold->driver_type, argc, argv,
+				 &n_cam, &flag);
 	if (arg_shift < 0) {
 	    warn("open_chaos", "invalid driver command line: %s", cmd);
 	    warn("open_chaos", "lavacam_argv error code: %d", arg_shift);
 	    warn("open_chaos", "lavacam_argv driver type: %d",
-		 ch->driver_type);
+		 ch->cold->driver_type);
 	    free(cmdline);
 	    return;
 	}
@@ -644,8 +950,8 @@ open_chaos(chaos *ch, char *cmd)
 	} else {
 	    dbg(1, "open_chaos", "about to open: %s", device_name);
 	}
-	ch->fd = lavacam_open(ch->driver_type, device_name, &o_cam, &n_cam,
-			      &siz, 0, &flag);
+	ch->fd = lavacam_open(ch->cold->driver_type, device_name,
+			      &o_cam, &n_cam, &siz, 0, &flag);
 	if (ch->fd < 0) {
 	    warn("open_chaos", "unable to open %s camera on %s: %d",
 		 driver_name, device_name, ch->fd);
@@ -661,17 +967,110 @@ open_chaos(chaos *ch, char *cmd)
 	/*
 	 * save open information in the chaos structure
 	 */
-	ch->pid = 0;
-	ch->driver = TRUE;
-	memcpy((void *)&ch->cam, (void *)&n_cam, sizeof(ch->cam));
-	memcpy((void *)&ch->siz, (void *)&siz, sizeof(ch->siz));
-	memcpy((void *)&ch->flag, (void *)&flag, sizeof(ch->flag));
+	ch->cold->pid = 0;
+	ch->cold->driver = TRUE;
+	memcpy((void *)&ch->cold->cam, (void *)&n_cam, sizeof(ch->cold->cam));
+	memcpy((void *)&ch->cold->siz, (void *)&siz, sizeof(ch->cold->siz));
+	memcpy((void *)&ch->cold->flag, (void *)&flag, sizeof(ch->cold->flag));
+
+	/*
+	 * select on the descriptor that is readable when a frame is ready
+	 *
+	 * For a mmap camera with a sync thread, this is not the camera
+	 * descriptor.  It lets us sleep in select until the frame has
+	 * been captured, not in lavacam_get_frame().
+	 */
+	ch->cold->frame_fd = lavacam_frame_fd(ch->cold->driver_type, ch->fd);
+	if (ch->cold->frame_fd == ch->fd) {
+	    ch->cold->frame_fd = -1;
+	} else if (ch->cold->frame_fd >= 0) {
+	    dbg(2, "open_chaos", "chan[%d]: fd %d frames ready on fd %d",
+		ch->indx, ch->fd, ch->cold->frame_fd);
+	}
+
+	/*
+	 * allocate the dense buffer if only part of each frame is used
+	 */
+	if (cfg_lavapool.chaos[ch->cold->source].planes <
+		LAVA_MAX_CHAOS_PLANES ||
+	    cfg_lavapool.chaos[ch->cold->source].tiles < 1.0) {
+	    ch->cold->dense_len = ch->cold->siz.chaos_len;
+	    ch->cold->dense = (u_int8_t *)malloc(ch->cold->dense_len);
+	    if (ch->cold->dense == NULL) {
+		warn("open_chaos", "unable to malloc %d octet dense buffer",
+		     ch->cold->dense_len);
+		(void) lavacam_close(ch->cold->driver_type, ch->fd,
+				     &ch->cold->siz, &ch->cold->flag);
+		ch->fd = -1;
+		ch->cold->frame_fd = -1;
+		ch->cold->dense_len = 0;
+		ch->cold->driver = FALSE;
+		free(cmdline);
+		return;
+	    }
+	    dbg(2, "open_chaos", "chan[%d]: using %d low bit-planes of "
+		"%.3f of the tiles", ch->indx,
+		cfg_lavapool.chaos[ch->cold->source].planes,
+		cfg_lavapool.chaos[ch->cold->source].tiles);
+	}
+
+	/*
+	 * allocate the batch buffer if frames are LavaRnd processed together
+	 *
+	 * An auto batch has room for enough frames to reach
+	 * LAVA_CHAOS_BATCH_TARGET octets, so that small frames do not
+	 * each pay for the fixed cost of a lavarnd() call.  See
+	 * batch_chaos() for when an auto batch is processed early.
+	 */
+	framelen = ch->cold->siz.chaos_len;
+	if (ch->cold->dense != NULL) {
+	    framelen = (framelen * cfg_lavapool.chaos[ch->cold->source].planes +
+			LAVA_MAX_CHAOS_PLANES-1) / LAVA_MAX_CHAOS_PLANES;
+	}
+	ch->cold->batch_max = cfg_lavapool.chaos[ch->cold->source].batch;
+	ch->cold->batch_auto = (ch->cold->batch_max == LAVA_CHAOS_BATCH_AUTO);
+	if (ch->cold->batch_auto && framelen > 0) {
+	    ch->cold->batch_max = (LAVA_CHAOS_BATCH_TARGET + framelen-1) /
+				  framelen;
+	    if (ch->cold->batch_max > LAVA_MAX_CHAOS_BATCH) {
+		ch->cold->batch_max = LAVA_MAX_CHAOS_BATCH;
+	    }
+	}
+	if (ch->cold->batch_max > 1) {
+	    ch->cold->batch_len = ch->cold->batch_max * framelen;
+	    ch->cold->batch = (u_int8_t *)malloc(ch->cold->batch_len);
+	    if (ch->cold->batch == NULL) {
+		warn("open_chaos", "unable to malloc %d octet batch buffer",
+		     ch->cold->batch_len);
+		(void) lavacam_close(ch->cold->driver_type, ch->fd,
+				     &ch->cold->siz, &ch->cold->flag);
+		ch->fd = -1;
+		ch->cold->frame_fd = -1;
+		if (ch->cold->dense != NULL) {
+		    free(ch->cold->dense);
+		    ch->cold->dense = NULL;
+		}
+		ch->cold->dense_len = 0;
+		ch->cold->batch_len = 0;
+		ch->cold->driver = FALSE;
+		free(cmdline);
+		return;
+	    }
+	    dbg(2, "open_chaos", "chan[%d]: LavaRnd processing %d frames "
+		"of up to %d octets at a time",
+		ch->indx, ch->cold->batch_max, framelen);
+	} else {
+	    ch->cold->batch_max = 1;
+	}
+	ch->cold->batch_used = 0;
+	ch->cold->batch_frames = 0;
+	ch->cold->batch_entropy = 0.0;
 
 	/*
 	 * set next savefile time
 	 */
 	if (willing_to_frame_dump(ch)) {
-	    ch->next_file = about_now + ch->flag.interval;
+	    ch->cold->next_file = about_now + ch->cold->flag.interval;
 	}
 
     /*
@@ -699,6 +1098,24 @@ open_chaos(chaos *ch, char *cmd)
 	    return;
 	}
 
+#if defined(F_SETPIPE_SZ)
+	/*
+	 * enlarge the pipe so that it holds up to a pool full of data
+	 *
+	 * The chaos process may then write well ahead of us, and each
+	 * fill_pool_from_fd() read takes more data.  A pipe larger than
+	 * the system allows an unprivileged process is halved until it
+	 * fits.  The default pipe size is used if none fits.
+	 */
+	for (i = cfg_lavapool.poolsize; i > CHAOS_PIPE_MIN; i /= 2) {
+	    if (fcntl(pipefd[0], F_SETPIPE_SZ, i) >= 0) {
+		dbg(3, "open_chaos", "chan[%d]: pipe size: %d",
+		    ch->indx, fcntl(pipefd[0], F_GETPIPE_SZ));
+		break;
+	    }
+	}
+#endif /* F_SETPIPE_SZ */
+
 	/*
 	 * fork for a chaos process
 	 */
@@ -753,22 +1170,22 @@ open_chaos(chaos *ch, char *cmd)
 	 */
 	(void) close(pipefd[1]);
 	ch->fd = pipefd[0];
-	ch->driver_type = LAVACAM_ERR_TYPE;
-	ch->driver = FALSE;
+	ch->cold->driver_type = LAVACAM_ERR_TYPE;
+	ch->cold->driver = FALSE;
     }
 
     /*
      * place the information into the channel
      */
     set_chanindx(ch->indx, ch->fd);
-    ch->count = 0;
-    ch->last_op = about_now;
+    ch->cold->count = 0;
+    ch->cold->last_op = about_now;
     dbg(3, "open_chaos", "chan[%d]: state was %s ==> %s, now %s ==> %s",
 			 ch->indx, STATE_NAME(ch->curstate),
 	STATE_NAME(ch->nxtstate), STATE_NAME(OPEN), STATE_NAME(READ));
-    if (ch->driver && driver_name != NULL && device_name != NULL) {
+    if (ch->cold->driver && driver_name != NULL && device_name != NULL) {
 	dbg(3, "open_chaos", "chan[%d]: using driver: %s (%d) on %s",
-	       ch->indx, driver_name, ch->driver_type, device_name);
+	       ch->indx, driver_name, ch->cold->driver_type, device_name);
     } else {
 	dbg(3, "open_chaos", "chan[%d]: using command: %s", ch->indx, cmd);
     }
@@ -805,7 +1222,9 @@ read_chaos(chaos *ch)
     int ret;		/* system call return */
     int skip_frame;	/* TRUE ==> do not LavaRnd process this frame */
     int sanity;		/* <0 ==> frame is insane */
-    int half_x;		/* computed 1/2 value level */
+    void *buf;		/* chaos data to LavaRnd process */
+    int buflen;		/* length of buf */
+    double entropy;	/* est min-entropy of buf */
 
     /*
      * firewall
@@ -832,73 +1251,74 @@ read_chaos(chaos *ch)
     /*
      * fill the pool via chaos driver buffer
      */
-    if (ch->driver == TRUE) {
+    if (ch->cold->driver == TRUE) {
 
 	/*
 	 * get the next frame from the driver
 	 */
 	dbg(4, "read_chaos", "chan[%d]: read frame from driver", ch->indx);
-	ret = lavacam_get_frame(ch->driver_type, ch->fd, &ch->siz);
+	ret = lavacam_get_frame(ch->cold->driver_type, ch->fd, &ch->cold->siz);
 	if (ret < 0) {
 	    dbg(2, "read_chaos",
 		"chan[%d]: lavacam_get_frame error: %d", ch->indx, ret);
 	    chaos_force_close(ch);
 	    return;
 	}
+	++src[ch->cold->source].frames;
 
 	/*
 	 * frame firewall
 	 */
-	if (ch->siz.chaos == NULL) {
+	if (ch->cold->siz.chaos == NULL) {
 	    fatal(12, "read_chaos", "chan[%d]: NULL channel chaos buffer",
 		      ch->indx);
 	    /*NOTREACHED*/
 	}
-	if (ch->siz.chaos_len < 0) {
+	if (ch->cold->siz.chaos_len < 0) {
 	    fatal(13, "read_chaos",
 		      "chan[%d]: neg channel chaos buffer len: %d",
-		      ch->indx, ch->siz.chaos_len);
+		      ch->indx, ch->cold->siz.chaos_len);
 	    /*NOTREACHED*/
 	}
 
 	/*
 	 * frame sanity check
 	 */
-	sanity = lavacam_sanity(&ch->siz);
+	sanity = lavacam_sanity(&ch->cold->siz);
 	if (sanity < 0) {
 
 	    /* skip this insane frame */
 	    skip_frame = TRUE;
+	    ++src[ch->cold->source].insane;
 
 	    /*
 	     * we will warn for the first few insane frames, and
 	     * then report every so many frames
 	     */
-	    if (ch->siz.insane_cnt <= INSANE_FRAME_FIRST_WARN ||
-	        (ch->siz.insane_cnt % INSANE_FRAME_WARN_CNT) == 0) {
-		if (ch->siz.insane_cnt <= INSANE_FRAME_FIRST_WARN) {
+	    if (ch->cold->siz.insane_cnt <= INSANE_FRAME_FIRST_WARN ||
+	        (ch->cold->siz.insane_cnt % INSANE_FRAME_WARN_CNT) == 0) {
+		if (ch->cold->siz.insane_cnt <= INSANE_FRAME_FIRST_WARN) {
 		    warn("read_chaos",
 		         "chan[%d]: %s: frame: %lld insane frame cnt: %lld: %s",
 			 ch->indx,
-			 ((ch->siz.insane_cnt <= INSANE_FRAME_FIRST_WARN) ?
+			 ((ch->cold->siz.insane_cnt <=
+			   INSANE_FRAME_FIRST_WARN) ?
 			  "reporting initial insanity" :
 			  "reporting every so often"),
-			 ch->siz.frame_num, ch->siz.insane_cnt,
+			 ch->cold->siz.frame_num, ch->cold->siz.insane_cnt,
 			 lava_err_name(sanity));
 		}
 		warn("read_chaos", "uncom_fract: %f",
-		     lavacam_uncom_fract(ch->siz.chaos,
-					 ch->siz.chaos_len, ch->siz.top_x,
-					 &half_x));
+		     ch->cold->siz.stats.uncom_fract);
 		warn("read_chaos", "half_x: %d bitdiff_fract: %f",
-		     half_x,
-		     lavacam_bitdiff_fract(ch->siz.prev_frame,
-					   ch->siz.chaos, ch->siz.chaos_len));
+		     ch->cold->siz.stats.half_x,
+		     ch->cold->siz.stats.bitdiff_fract);
 	    	warn("read_chaos",
 		     "configured levels: half_x: %d top_x: %d "
 		     "bitdiff_fract: %f uncom_fract: %f",
-		     ch->siz.half_x, ch->siz.top_x, ch->siz.min_fract,
-		     ch->siz.diff_fract);
+		     ch->cold->siz.half_x, ch->cold->siz.top_x,
+		     ch->cold->siz.diff_fract,
+		     ch->cold->siz.min_fract);
 
 	    /*
 	     * if we are not warning, but we are debugging, then
@@ -908,23 +1328,21 @@ read_chaos(chaos *ch)
 		dbg(2, "read_chaos",
 		       "chan[%d]: frame %lld insane frame cnt: %lld: %s",
 		       ch->indx,
-		       ch->siz.frame_num, ch->siz.insane_cnt,
+		       ch->cold->siz.frame_num, ch->cold->siz.insane_cnt,
 		       lava_err_name(sanity));
 		dbg(2, "read_chaos",
 		       "uncom_fract: %f",
-		       lavacam_uncom_fract(ch->siz.chaos,
-					   ch->siz.chaos_len, ch->siz.top_x,
-					   &half_x));
+		       ch->cold->siz.stats.uncom_fract);
 		dbg(2, "read_chaos",
 		       "half_x: %d bitdiff_fract: %f",
-		       half_x,
-		       lavacam_bitdiff_fract(ch->siz.prev_frame,
-					     ch->siz.chaos, ch->siz.chaos_len));
+		       ch->cold->siz.stats.half_x,
+		       ch->cold->siz.stats.bitdiff_fract);
 	    	dbg(3, "read_chaos",
 		       "min levels: half_x: %d top_x: %d bitdiff_fract: %f "
 		       "uncom_fract: %f",
-		       ch->siz.half_x, ch->siz.top_x, ch->siz.min_fract,
-		       ch->siz.diff_fract);
+		       ch->cold->siz.half_x, ch->cold->siz.top_x,
+		       ch->cold->siz.diff_fract,
+		       ch->cold->siz.min_fract);
 	    }
 
 	/*
@@ -942,9 +1360,39 @@ read_chaos(chaos *ch)
 	     */
 	    if (!skip_frame) {
 		dbg(2, "read_chaos",
-		       "chan[%d]: chaos driver buf: pool level: %u",
-		       ch->indx, pool_level());
-		ret = fill_pool_from_chaos(ch->siz.chaos, ch->siz.chaos_len);
+		       "chan[%d]: chaos driver buf: frame: %lld "
+		       "entropy: %.0f bits pool level: %u",
+		       ch->indx, ch->cold->siz.frame_num,
+		       ch->cold->siz.entropy, pool_level());
+		if (ch->cold->dense != NULL) {
+		    ret = lavacam_extract(&ch->cold->siz,
+				  cfg_lavapool.chaos[ch->cold->source].planes,
+				  cfg_lavapool.chaos[ch->cold->source].tiles,
+					  ch->cold->dense, ch->cold->dense_len,
+					  &entropy);
+		    if (ret < 0) {
+			dbg(2, "read_chaos",
+			       "chan[%d]: lavacam_extract error: %d",
+			       ch->indx, ret);
+			chaos_force_close(ch);
+			return;
+		    }
+		    dbg(3, "read_chaos",
+			   "chan[%d]: dense buf: %d octets entropy: %.0f bits",
+			   ch->indx, ret, entropy);
+		    buf = ch->cold->dense;
+		    buflen = ret;
+		} else {
+		    buf = ch->cold->siz.chaos;
+		    buflen = ch->cold->siz.chaos_len;
+		    entropy = ch->cold->siz.entropy;
+		}
+		if (ch->cold->batch != NULL) {
+		    ret = batch_chaos(ch, buf, buflen, entropy);
+		} else {
+		    ret = fill_pool_from_chaos(buf, buflen, entropy,
+				   cfg_lavapool.chaos[ch->cold->source].rate);
+		}
 
 		if (ret < 0) {
 		    dbg(2, "read_chaos",
@@ -953,6 +1401,7 @@ read_chaos(chaos *ch)
 		    chaos_force_close(ch);
 		    return;
 		}
+		src[ch->cold->source].octets += (u_int64_t)ret;
 	    }
 	}
 
@@ -960,7 +1409,8 @@ read_chaos(chaos *ch)
 	 * release the driver frame
 	 */
 	dbg(5, "read_chaos", "chan[%d]: release frame", ch->indx);
-	ret = lavacam_msync(ch->driver_type, ch->fd, &ch->cam, &ch->siz);
+	ret = lavacam_msync(ch->cold->driver_type, ch->fd,
+			    &ch->cold->cam, &ch->cold->siz);
 	if (ret < 0) {
 	    dbg(2, "read_chaos",
 		"chan[%d]: lavacam_msync error: %d", ch->indx, ret);
@@ -981,6 +1431,7 @@ read_chaos(chaos *ch)
 	    chaos_force_close(ch);
 	    return;
 	}
+	src[ch->cold->source].octets += (u_int64_t)ret;
     }
 
     /*
@@ -997,14 +1448,96 @@ read_chaos(chaos *ch)
     /*
      * accounting
      */
-    ch->last_op = about_now;
-    ch->count += (u_int64_t)ret;
+    ch->cold->last_op = about_now;
+    ch->cold->count += (u_int64_t)ret;
     dbg(4, "read_chaos", "chan[%d]: ret: %d count: %lld, pool level: %u",
-    			 ch->indx, ret, ch->count, pool_level());
+    			 ch->indx, ret, ch->cold->count, pool_level());
     return;
 }
 
 
+/*
+ * batch_chaos - gather chaos data and LavaRnd process a full batch
+ *
+ * given:
+ *	ch 	chaos channel
+ *	buf	chaos data of a sane frame
+ *	buflen	length of buf
+ *	entropy	estimated min-entropy of buf in bits, <0 ==> no estimate
+ *
+ * returns:
+ *	>0 ==> chars added, 0 ==> batch not full or nothing added,
+ *	or <0 ==> error
+ *
+ * The chaos data of batch_max frames is gathered into the batch buffer
+ * and LavaRnd processed with a single fill_pool_from_chaos() call.
+ * The fixed cost of a lavarnd() call is paid once per batch, and the
+ * larger buffer allows more output before the rate reaches its limit.
+ *
+ * The batch entropy estimate is the sum of the frame estimates.  If any
+ * frame in the batch has no estimate, the batch has no estimate.
+ *
+ * The lavarnd() output grows as the square root of its input length at
+ * a given rate, and fill_pool_from_chaos() limits the rate to MAX_ALPHA.
+ * Once a batch has enough entropy for that rate, gathering more frames
+ * only lowers the output per frame.  So an auto batch is processed as
+ * soon as its estimate allows MAX_ALPHA, or at once if it has no estimate.
+ * Frames too poor to yield output on their own are thus pooled until
+ * together they do.
+ */
+static int
+batch_chaos(chaos *ch, void *buf, int buflen, double entropy)
+{
+    int ret;		/* fill_pool_from_chaos() return */
+
+    /*
+     * firewall
+     */
+    if (ch == NULL || ch->cold->batch == NULL || buf == NULL || buflen < 0) {
+	return LAVAERR_BADARG;
+    }
+    if (ch->cold->batch_used + buflen > ch->cold->batch_len) {
+	warn("batch_chaos", "chan[%d]: %d octets will not fit in the batch",
+	     ch->indx, buflen);
+	return LAVAERR_TOOMUCH;
+    }
+
+    /*
+     * gather the frame
+     */
+    memcpy(ch->cold->batch + ch->cold->batch_used, buf, buflen);
+    ch->cold->batch_used += buflen;
+    if (ch->cold->batch_frames == 0 || ch->cold->batch_entropy >= 0.0) {
+	ch->cold->batch_entropy = (entropy < 0.0 ? -1.0 :
+				   ch->cold->batch_entropy + entropy);
+    }
+    if (++ch->cold->batch_frames < ch->cold->batch_max &&
+	(!ch->cold->batch_auto ||
+	 (ch->cold->batch_entropy >= 0.0 &&
+	  lava_entropy_rate(ch->cold->batch_used, ch->cold->batch_entropy) <
+	    MAX_ALPHA))) {
+	dbg(5, "batch_chaos", "chan[%d]: gathered frame %d of %d",
+	    ch->indx, ch->cold->batch_frames, ch->cold->batch_max);
+	return 0;
+    }
+
+    /*
+     * LavaRnd process the full batch
+     */
+    dbg(3, "batch_chaos",
+	"chan[%d]: batch of %d frames: %d octets entropy: %.0f bits",
+	ch->indx, ch->cold->batch_frames, ch->cold->batch_used,
+	ch->cold->batch_entropy);
+    ret = fill_pool_from_chaos(ch->cold->batch, ch->cold->batch_used,
+			       ch->cold->batch_entropy,
+			       cfg_lavapool.chaos[ch->cold->source].rate);
+    ch->cold->batch_used = 0;
+    ch->cold->batch_frames = 0;
+    ch->cold->batch_entropy = 0.0;
+    return ret;
+}
+
+
 /*
  * close_chaos - close a chaos channel
  *
@@ -1046,12 +1579,13 @@ close_chaos(chaos *ch)
     /*
      * device cleanup
      */
-    if (ch->driver) {
+    if (ch->cold->driver) {
 
 	/*
 	 * close down driver interface
 	 */
-	i = lavacam_close(ch->driver_type, ch->fd, &ch->siz, &ch->flag);
+	i = lavacam_close(ch->cold->driver_type, ch->fd,
+			  &ch->cold->siz, &ch->cold->flag);
 	if (i < 0) {
 	    dbg(3, "close_chaos", "chan[%d]: failed to driver close fd %d: %d",
 		   ch->indx, ch->fd, i);
@@ -1062,15 +1596,30 @@ close_chaos(chaos *ch)
 	 */
 	clear_chanindx(ch->indx, ch->fd);
 	ch->fd = -1;
-	ch->pid = 0;
-	ch->driver = FALSE;
-	ch->driver_type = -1;
-	memset((void *)&ch->cam, 0, sizeof(ch->cam));
-	memset((void *)&ch->siz, 0, sizeof(ch->siz));
-	ch->siz.image = NULL;
-	ch->siz.chaos = NULL;
-
-	memset((void *)&ch->flag, 0, sizeof(ch->flag));
+	ch->cold->frame_fd = -1;
+	if (ch->cold->dense != NULL) {
+	    free(ch->cold->dense);
+	    ch->cold->dense = NULL;
+	}
+	ch->cold->dense_len = 0;
+	if (ch->cold->batch != NULL) {
+	    free(ch->cold->batch);
+	    ch->cold->batch = NULL;
+	}
+	ch->cold->batch_len = 0;
+	ch->cold->batch_used = 0;
+	ch->cold->batch_frames = 0;
+	ch->cold->batch_max = 1;
+	ch->cold->batch_auto = FALSE;
+	ch->cold->pid = 0;
+	ch->cold->driver = FALSE;
+	ch->cold->driver_type = -1;
+	memset((void *)&ch->cold->cam, 0, sizeof(ch->cold->cam));
+	memset((void *)&ch->cold->siz, 0, sizeof(ch->cold->siz));
+	ch->cold->siz.image = NULL;
+	ch->cold->siz.chaos = NULL;
+
+	memset((void *)&ch->cold->flag, 0, sizeof(ch->cold->flag));
 
     /*
      * co-process cleanup
@@ -1097,17 +1646,17 @@ close_chaos(chaos *ch)
 	/*
 	 * kill child if using a co-process command
 	 */
-	if (ch->pid > 0) {
+	if (ch->cold->pid > 0) {
 	    errno = 0;
-	    ret =  kill(ch->pid, SIGTERM);
+	    ret =  kill(ch->cold->pid, SIGTERM);
 	    if (ret < 0) {
 		dbg(3, "close_chaos", "chan[%d]: could not kill %d: %s",
-		       ch->indx, (int)(ch->pid), strerror(errno));
+		       ch->indx, (int)(ch->cold->pid), strerror(errno));
 	    } else {
 		dbg(4, "close_chaos", "chan[%d]: killed %d: %s",
-		       ch->indx, (int)ch->pid);
+		       ch->indx, (int)ch->cold->pid);
 	    }
-	    ch->pid = 0;
+	    ch->cold->pid = 0;
 	}
     }
 
@@ -1117,9 +1666,10 @@ close_chaos(chaos *ch)
     dbg(3, "close_chaos", "chan[%d]: state was %s ==> %s, now %s ==> %s",
 			 ch->indx, STATE_NAME(ch->curstate),
 	STATE_NAME(ch->nxtstate), STATE_NAME(CLOSE), STATE_NAME(ALLOCED));
-    ch->last_op = about_now;
+    ch->cold->last_op = about_now;
     ch->curstate = CLOSE;
     ch->nxtstate = ALLOCED;
+    chaos_src_down(ch);
     return;
 }
 
@@ -1140,11 +1690,26 @@ close_chaos(chaos *ch)
 static void
 chaos_force_close(chaos *ch)
 {
+    int i;
+
     /* announce */
     dbg(2, "chaos_force_close", "chan[%d]: will be forced to CLOSE", ch->indx);
+    if (ch->cold->source >= 0 && ch->cold->source < cfg_lavapool.chaoscnt) {
+	warn("chaos_force_close", "chaos[%d]: failed, will reopen: %s",
+	     ch->cold->source, cfg_lavapool.chaos[ch->cold->source].cmd);
+	++src[ch->cold->source].failures;
+    }
 
     /* close */
     close_chaos(ch);
+
+    /* warn if the other sources have failed too */
+    for (i=0; i < cfg_lavapool.chaoscnt; ++i) {
+	if (src[i].indx >= 0) {
+	    return;
+	}
+    }
+    warn("chaos_force_close", "no chaos source is open, pool will not fill");
     return;
 }
 
@@ -1169,8 +1734,8 @@ willing_to_frame_dump(chaos *ch)
      *	2) We have a newfile filename
      *	3) We have a reasonable frame dump interval
      */
-    if (ch->flag.savefile != NULL && ch->flag.newfile != NULL &&
-	ch->flag.interval > 0.0) {
+    if (ch->cold->flag.savefile != NULL && ch->cold->flag.newfile != NULL &&
+	ch->cold->flag.interval > 0.0) {
 	return TRUE;
     }
     return FALSE;
@@ -1195,7 +1760,7 @@ time_to_next_dump(chaos *ch)
     /*
      * case: no schedled frame dump
      */
-    if (ch->next_file <= 0.0) {
+    if (ch->cold->next_file <= 0.0) {
 	/* no dump scheduled */
 	dbg(5, "time_to_next_dump", "no schedled frame dump");
 	return -1.0;
@@ -1204,8 +1769,9 @@ time_to_next_dump(chaos *ch)
     /*
      * case: return the next frame dump time
      */
-    dbg(4, "time_to_next_dump", "next frame dump time: %.3f", ch->next_file);
-    return ch->next_file;
+    dbg(4, "time_to_next_dump", "next frame dump time: %.3f",
+	ch->cold->next_file);
+    return ch->cold->next_file;
 }
 
 
@@ -1229,7 +1795,7 @@ ready_to_frame_dump(chaos *ch)
      * 	2) Enough time has passed since the last dump (or channel open)
      * 	3) We are in the correct state.
      */
-    if (willing_to_frame_dump(ch) && ch->next_file < about_now &&
+    if (willing_to_frame_dump(ch) && ch->cold->next_file < about_now &&
 	(chaos_read_mask[ch->curstate] || chaos_read_mask[ch->nxtstate])) {
 	return TRUE;
     }
@@ -1244,8 +1810,8 @@ ready_to_frame_dump(chaos *ch)
  *	ch 	chaos channel
  *
  * returns:
- * 	TRUE ==> some new frame data was written to disk
- * 	FALSE ==> no new frame data was written to disk
+ * 	TRUE ==> frame was queued to be written to disk
+ * 	FALSE ==> frame was not queued to be written to disk
  */
 static int
 frame_dump_if_ready(chaos *ch)
@@ -1265,8 +1831,8 @@ frame_dump_if_ready(chaos *ch)
 	/* frame dump */
 	skip_frame = frame_dump(ch);
 	if (skip_frame) {
-	    /* dumped a frame & quickly need another for lavapool use */
-	    ch->fast_select = TRUE;
+	    /* queued a frame & quickly need another for lavapool use */
+	    ch->cold->fast_select = TRUE;
 	}
 
 	/*
@@ -1274,47 +1840,193 @@ frame_dump_if_ready(chaos *ch)
 	 * if we were not successful (or -E and frame is non-empty).
 	 * We do not want to be constantly retrying the frame dump.
 	 */
-	ch->next_file = about_now + ch->flag.interval;
+	ch->cold->next_file = about_now + ch->cold->flag.interval;
     }
     return skip_frame;
 }
 
 
 /*
- * frame_dump - dump a frame to a savefile
+ * frame_dump - hand a frame to the writer thread to dump to a savefile
  *
  * given:
  *	ch 	chaos channel
  *
  * returns:
- * 	TRUE ==> some new frame data was written to disk
- * 	FALSE ==> no new frame data was written to disk,
- * 		  OK to LavaRnd process this frame
+ * 	TRUE ==> frame was queued to be written to disk
+ * 	FALSE ==> frame was not queued, OK to LavaRnd process this frame
+ *
+ * The frame and file names are copied, so the frame may be released and
+ * the channel closed while the dump waits to be written.  The writer
+ * thread is started by the first dump.  If it cannot be started, the
+ * dump is written here as before.
+ *
+ * NOTE: A queued frame must not be LavaRnd processed, even if the writer
+ *	 later finds that it will not dump it (see dump_write()).
  */
 static int
 frame_dump(chaos *ch)
 {
-    int framefd;	/* newfile file descriptor */
-    int write_ret;	/* return from raw_write() */
-    struct stat buf;	/* savefile stat for -E checking */
+    struct dump_job *job;	/* frame dump job */
+    size_t savelen;	/* length of savefile including the NUL */
+    size_t newlen;	/* length of newfile including the NUL */
+    sigset_t all;	/* all signals */
+    sigset_t old;	/* signal mask before starting the writer */
+    int ret;		/* pthread_create() return */
 
     /*
      * firewall
      */
-    if (ch->flag.newfile == NULL || ch->flag.savefile == NULL) {
+    if (ch->cold->flag.newfile == NULL || ch->cold->flag.savefile == NULL) {
 	warn("frame_dump", "NULL newfile or savefile string");
 	return FALSE;
     }
+    if (ch->cold->siz.chaos == NULL || ch->cold->siz.chaos_len <= 0) {
+	warn("frame_dump", "chan[%d]: no frame to dump", ch->indx);
+	return FALSE;
+    }
 
     /*
-     * If -E was given, do nothing if the savefile is non-empty
+     * drop the dump if the writer is too far behind
      */
-    if (ch->flag.E_flag &&stat(ch->flag.savefile, &buf) >= 0 &&
-	    buf.st_size > 0) {
-	dbg(4, "frame_dump", "savefile %s exists", ch->flag.savefile);
+    pthread_mutex_lock(&dump_lock);
+    ret = dump_cnt;
+    pthread_mutex_unlock(&dump_lock);
+    if (ret >= DUMP_QUEUE_MAX) {
+	dbg(1, "frame_dump", "chan[%d]: %d frame dumps waiting, dropped dump "
+	    "to %s", ch->indx, ret, ch->cold->flag.savefile);
 	return FALSE;
     }
 
+    /*
+     * copy the frame and the file names into a dump job
+     */
+    savelen = strlen(ch->cold->flag.savefile) + 1;
+    newlen = strlen(ch->cold->flag.newfile) + 1;
+    job = (struct dump_job *)malloc(sizeof(*job) + savelen + newlen +
+				    ch->cold->siz.chaos_len);
+    if (job == NULL) {
+	warn("frame_dump", "chan[%d]: unable to malloc frame dump of %d "
+	     "octets", ch->indx, ch->cold->siz.chaos_len);
+	return FALSE;
+    }
+    job->indx = ch->indx;
+    job->E_flag = ch->cold->flag.E_flag;
+    job->savefile = (char *)(job + 1);
+    job->newfile = job->savefile + savelen;
+    job->frame = (u_int8_t *)(job->newfile + newlen);
+    job->len = ch->cold->siz.chaos_len;
+    memcpy(job->savefile, ch->cold->flag.savefile, savelen);
+    memcpy(job->newfile, ch->cold->flag.newfile, newlen);
+    memcpy(job->frame, ch->cold->siz.chaos, job->len);
+
+    /*
+     * start the writer thread if needed
+     *
+     * The writer blocks all signals so that they are delivered to
+     * the main thread as before.
+     */
+    if (!dump_started) {
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+	ret = pthread_create(&dump_thread, NULL, dump_writer, NULL);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	if (ret != 0) {
+	    warn("frame_dump", "cannot start frame dump writer: %s",
+		 strerror(ret));
+	    dump_write(job);
+	    free(job);
+	    return TRUE;
+	}
+	(void) pthread_detach(dump_thread);
+	dump_started = TRUE;
+	dbg(2, "frame_dump", "started frame dump writer");
+    }
+
+    /*
+     * queue the job for the writer
+     */
+    pthread_mutex_lock(&dump_lock);
+    dump_queue[(dump_head + dump_cnt) % DUMP_QUEUE_MAX] = job;
+    ++dump_cnt;
+    pthread_cond_signal(&dump_cond);
+    pthread_mutex_unlock(&dump_lock);
+    dbg(3, "frame_dump", "chan[%d]: queued frame dump to %s",
+	ch->indx, ch->cold->flag.savefile);
+    return TRUE;
+}
+
+
+/*
+ * dump_writer - frame dump writer thread
+ *
+ * given:
+ *	arg	unused
+ *
+ * returns:
+ *	does not return
+ *
+ * Write the queued frame dumps, oldest first.  The lock is not held
+ * while a dump is written.
+ */
+static void *
+dump_writer(void *arg)
+{
+    struct dump_job *job;	/* frame dump job */
+
+    for (;;) {
+
+	/*
+	 * wait for a job
+	 */
+	pthread_mutex_lock(&dump_lock);
+	while (dump_cnt <= 0) {
+	    pthread_cond_wait(&dump_cond, &dump_lock);
+	}
+	job = dump_queue[dump_head];
+	dump_queue[dump_head] = NULL;
+	dump_head = (dump_head + 1) % DUMP_QUEUE_MAX;
+	--dump_cnt;
+	pthread_mutex_unlock(&dump_lock);
+
+	/*
+	 * write the job
+	 */
+	dump_write(job);
+	free(job);
+    }
+    /*NOTREACHED*/
+    return NULL;
+}
+
+
+/*
+ * dump_write - write a frame dump job to its savefile
+ *
+ * given:
+ *	job	frame dump job
+ *
+ * The frame is written to the newfile, which is then renamed to the
+ * savefile.  A reader of the savefile never sees a partial frame.
+ *
+ * NOTE: If the E_flag was given and the savefile is non-empty, the frame
+ *	 is not dumped.  It is not LavaRnd processed either.
+ */
+static void
+dump_write(struct dump_job *job)
+{
+    int framefd;	/* newfile file descriptor */
+    int write_ret;	/* return from raw_write() */
+    struct stat buf;	/* savefile stat for -E checking */
+
+    /*
+     * If -E was given, do nothing if the savefile is non-empty
+     */
+    if (job->E_flag && stat(job->savefile, &buf) >= 0 && buf.st_size > 0) {
+	dbg(4, "dump_write", "savefile %s exists", job->savefile);
+	return;
+    }
+
     /*
      * open/create the newfile
      *
@@ -1324,102 +2036,78 @@ frame_dump(chaos *ch)
      * in place of any savefile that was created during "race" window.
      */
     errno = 0;
-    framefd = open(ch->flag.newfile,
-		   O_CREAT|O_EXCL|O_WRONLY|O_TRUNC,
+    framefd = open(job->newfile, O_CREAT|O_EXCL|O_WRONLY|O_TRUNC,
 		   S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH);
     if (framefd < 0 && errno == EEXIST) {
 
 	/*
 	 * newfile was left around, remove it and retry the open
 	 */
-	if (unlink(ch->flag.newfile) < 0) {
-	    warn("frame_dump", "found newfile: %s, cannot remove it: %s",
-		  ch->flag.newfile, strerror(errno));
-	    return FALSE;
+	if (unlink(job->newfile) < 0) {
+	    warn("dump_write", "found newfile: %s, cannot remove it: %s",
+		  job->newfile, strerror(errno));
+	    return;
 	} else {
-	    warn("frame_dump", "removed previous newfile: %s",
-		   ch->flag.newfile);
+	    warn("dump_write", "removed previous newfile: %s", job->newfile);
 	    errno = 0;
-	    framefd = open(ch->flag.newfile,
-			   O_CREAT|O_EXCL|O_WRONLY|O_TRUNC,
+	    framefd = open(job->newfile, O_CREAT|O_EXCL|O_WRONLY|O_TRUNC,
 			   S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH);
 	}
     }
     if (framefd < 0) {
-
-	/*
-	 * failed to open frame, so LavaRnd process it instead
-	 */
-	warn("frame_dump", "failed to open/create %s: %s",
-	     ch->flag.newfile, strerror(errno));
-	return FALSE;
+	warn("dump_write", "failed to open/create %s: %s",
+	     job->newfile, strerror(errno));
+	return;
+    }
 
     /*
-     * dump frame to savefile
+     * write frame to newfile
      */
-    } else {
+    write_ret = raw_write(framefd, job->frame, job->len, FALSE);
 
-	/*
-	 * write frame to newfile
-	 */
-	write_ret =
-	  raw_write(framefd, ch->siz.chaos, ch->siz.chaos_len, FALSE);
-
-	/*
-	 * case: raw_write error
-	 */
-	if (write_ret < 0) {
-	    /*
-	     * Even though the raw_write failed, some data might
-	     * have been written.  We will not LavaRnd process
-	     * this frame in case that happened.
-	     */
-	    warn("frame_dump", "bad frame wrote to %s: %s",
-		 ch->flag.newfile, write_ret);
-	    /* try to remove the newfile due to the error */
-	    (void) close(framefd);
-	    errno = 0;
-	    if (unlink(ch->flag.newfile) < 0) {
-		warn("frame_dump", "unable to remove %s: %s",
-		     ch->flag.newfile, strerror(errno));
-	    }
-
-	/*
-	 * case: partial write
-	 */
-	} else if (write_ret != ch->siz.chaos_len) {
+    /*
+     * case: raw_write error
+     */
+    if (write_ret < 0) {
+	warn("dump_write", "bad frame write to %s: %d",
+	     job->newfile, write_ret);
+	/* try to remove the newfile due to the error */
+	(void) close(framefd);
+	errno = 0;
+	if (unlink(job->newfile) < 0) {
+	    warn("dump_write", "unable to remove %s: %s",
+		 job->newfile, strerror(errno));
+	}
 
-	    /*
-	     * Even though all data was not written, some data might
-	     * have been written.  We will not LavaRnd process
-	     * this frame in case that happened.
-	     */
-	    warn("frame_dump", "wrote %d instead of %d octets to %s",
-		 ch->flag.newfile, write_ret, ch->siz.chaos_len);
-	    /* try to remove the newfile due to the error */
-	    (void) close(framefd);
-	    errno = 0;
-	    if (unlink(ch->flag.newfile) < 0) {
-		warn("frame_dump", "cannot to remove %s: %s",
-		     ch->flag.newfile, strerror(errno));
-	    }
+    /*
+     * case: partial write
+     */
+    } else if (write_ret != job->len) {
+	warn("dump_write", "wrote %d instead of %d octets to %s",
+	     write_ret, job->len, job->newfile);
+	/* try to remove the newfile due to the error */
+	(void) close(framefd);
+	errno = 0;
+	if (unlink(job->newfile) < 0) {
+	    warn("dump_write", "cannot to remove %s: %s",
+		 job->newfile, strerror(errno));
+	}
 
-	/*
-	 * move newfile to savefile
-	 */
+    /*
+     * move newfile to savefile
+     */
+    } else {
+	/* chmod 0664 just to be sure */
+	(void) fchmod(framefd, S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH);
+	(void) close(framefd);
+	errno = 0;
+	if (rename(job->newfile, job->savefile) < 0) {
+	    warn("dump_write", "cannot mv %s %s: %s",
+		 job->newfile, job->savefile, strerror(errno));
 	} else {
-	    /* chmod 0664 just to be sure */
-	    (void) fchmod(framefd, S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH);
-	    (void) close(framefd);
-	    errno = 0;
-	    if (rename(ch->flag.newfile, ch->flag.savefile) < 0) {
-		warn("frame_dump", "cannot mv %s %s: %s",
-		     ch->flag.newfile, ch->flag.savefile, strerror(errno));
-	    } else {
-		dbg(2, "frame_dump", "chan[%d]: frame dump to %s",
-		       ch->indx, ch->flag.savefile);
-	    }
+	    dbg(2, "dump_write", "chan[%d]: frame dump to %s",
+		   job->indx, job->savefile);
 	}
     }
-    return TRUE;
+    return;
 }
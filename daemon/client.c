@@ -36,9 +36,14 @@
 #include <ctype.h>
 #include <errno.h>
 #include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 
 #include "LavaRnd/rawio.h"
 #include "LavaRnd/cfg.h"
+#include "LavaRnd/lavaerr.h"
+#include "LavaRnd/lavaquality.h"
 
 #include "chan.h"
 #include "dbg.h"
@@ -49,6 +54,80 @@
 #include <dmalloc.h>
 #endif
 
+/*
+ * MSG_ZEROCOPY - let the kernel send large replies from the client buffer
+ *
+ * The kernel tells us via the socket error queue when it is done with
+ * the pages of a MSG_ZEROCOPY send.  Below ZEROCOPY_MIN octets, the page
+ * pinning and completion notification cost more than a plain copy.
+ *
+ * A reply buffer that was sent with MSG_ZEROCOPY is not freed when the
+ * reply has been written.  It goes on the pending list of the client
+ * until the kernel is done with it.  A client has at most ZEROCOPY_MAXPEND
+ * such buffers; beyond that, replies are copied as usual.
+ *
+ * When a client with pending buffers is closed, the socket and buffers
+ * become a zombie.  The socket is kept open so that the remaining
+ * completions can be collected.  A zombie whose peer does not take the
+ * data within ZEROCOPY_LINGER seconds is reset, and its buffers are
+ * freed ZEROCOPY_GRACE seconds later, once any packets already queued
+ * to the network device have gone out.
+ */
+#if defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY)
+#  include <linux/errqueue.h>
+#  if defined(SO_EE_ORIGIN_ZEROCOPY)
+#    define USE_ZEROCOPY
+#  endif
+#endif
+#define ZEROCOPY_MIN (16384)	/* smallest reply sent with MSG_ZEROCOPY */
+#define ZEROCOPY_MAXPEND (4)	/* most pending buffers per client */
+#define ZEROCOPY_REAP (0.1)	/* seconds between checks for completions */
+#define ZEROCOPY_LINGER (30.0)	/* seconds a zombie may wait for its peer */
+#define ZEROCOPY_GRACE (2.0)	/* seconds after reset before buffers are freed */
+
+/*
+ * zc_buf - written reply buffer that the kernel may still send from
+ */
+struct zc_buf {
+    struct zc_buf *next;	/* next pending buffer or NULL */
+    u_int8_t *buf;		/* malloced reply buffer */
+    u_int32_t end;		/* buffer is free once this many sends are done */
+};
+
+/*
+ * zc_zombie - closed client socket with MSG_ZEROCOPY sends still pending
+ */
+struct zc_zombie {
+    struct zc_zombie *next;	/* next zombie or NULL */
+    int fd;			/* socket, or -1 once reset */
+    u_int32_t sent;		/* MSG_ZEROCOPY sends made */
+    u_int32_t done;		/* MSG_ZEROCOPY sends the kernel is done with */
+    struct zc_buf *pend;	/* buffers the kernel may still send from */
+    double linger;		/* reset the socket after this time */
+    double expire;		/* if > 0.0, free the buffers after this time */
+};
+static struct zc_zombie *zombie = NULL;	/* closed sockets still sending */
+
+/*
+ * A paced stream is sent as about STREAM_HZ replies per second.
+ */
+#define STREAM_HZ (10)
+
+/*
+ * A request with a deadline is answered this long before the deadline,
+ * so that the reply reaches the client in time.
+ */
+#define DEADLINE_SLACK (LAVA_TINY_TIME)
+
+/*
+ * clients waiting in the GATHER state for the current gather pass
+ */
+#define GATHER_CHUNK (64)	/* grow the wait list by this many clients */
+static client **gather_wait = NULL;	/* clients waiting to be gathered */
+static int gather_cnt = 0;		/* clients on the wait list */
+static int gather_max = 0;		/* allocated wait list length */
+static u_int64_t gather_lastseq = 0;	/* last gather sequence issued */
+
 
 /*
  * The client state changes are as follows:
@@ -68,6 +147,9 @@
  *
  *	WRITE	==> WRITE	[write & exception select]
  *	WRITE	==> CLOSE	[write & exception select]
+ *	WRITE	==> READ	[binary protocol, wait for next request]
+ *	WRITE	==> GATHER	[binary protocol, next request already read]
+ *	WRITE	==> GATHER	[binary protocol, next stream reply]
  *
  *	CLOSE   ==> ALLOCED
  *
@@ -161,9 +243,33 @@ int const client_preselect_ready[LAST_STATE+1] = {
  * static functions
  */
 static void read_client(client *ch);
+static void read_binary(client *ch);
+static void next_request(client *ch);
+static void stream_reply(client *ch);
+static void gather_wait_client(client *ch);
+static int gather_fifo_cmp(const void *a, const void *b);
+static int gather_smallest_cmp(const void *a, const void *b);
+static void gather_share(long *need, long *share, long avail);
+static void gather_allot(client **wait, int cnt, long avail);
 static void gather_client(client *ch);
+static void start_reply(client *ch, int qual);
 static void write_client(client *ch);
+static void finish_reply(client *ch);
 static void client_force_close(client *ch);
+static int send_client(client *ch, u_int8_t *buf, int len);
+static int zerocopy_ok(client *ch);
+static u_int32_t reap_zerocopy(int fd, u_int32_t done, u_int32_t sent);
+static struct zc_buf *free_zc_bufs(struct zc_buf *pend, u_int32_t done,
+				   int force, int *p_cnt);
+static void reap_client(client *ch);
+static void drop_random(client *ch);
+
+/*
+ * A reply is sent once both its binary reply header (if any) and
+ * all of its octets have been written.
+ */
+#define REPLY_SENT(ch) ((ch)->cold->replycnt >= (ch)->cold->replylen && \
+			(ch)->cold->writecnt >= (ch)->cold->request)
 
 
 /*
@@ -381,17 +487,55 @@ client_pre_select_op(client *ch)
 	/*NOTREACHED*/
     }
 
+    /*
+     * free the written reply buffers that the kernel is done with
+     */
+    if (ch->cold->zc_pend != NULL) {
+	reap_client(ch);
+	if (ch->cold->zc_pend != NULL) {
+	    need_cycle_before(ch->indx, about_now + ZEROCOPY_REAP);
+	}
+    }
+
+    /*
+     * close a READing client that has exceeded its time limit
+     *
+     * A binary client idle between requests never becomes readable,
+     * so select must wake up in time for us to notice.
+     */
+    if (ch->nxtstate == READ && ch->timeout > 0.0) {
+	if (ch->timeout < about_now) {
+	    dbg(3, "client_pre_select_op", "chan[%d]: "
+		"idle timeout: %.3f < about now: %.3f",
+		ch->indx, ch->timeout, about_now);
+	    client_force_close(ch);
+	    return;
+	}
+	need_cycle_before(ch->indx, ch->timeout);
+    }
+
     /*
      * perform an operation if automatic operation allowed
      */
     if (client_preselect_ready[ch->nxtstate]) {
 
 	/*
-	 * as an optimization, we do not GATHER on an empty pool
+	 * a paced stream waits until its next reply is due
 	 */
-	if (pool_level() == 0 && ch->nxtstate == GATHER) {
+	if (ch->nxtstate == GATHER && ch->cold->stream_next > about_now) {
 	    dbg(4, "client_pre_select_op",
-		"chan[%d]: skip GATHER on an empty pool", ch->indx);
+		"chan[%d]: stream reply due in %.3f sec",
+		ch->indx, ch->cold->stream_next - about_now);
+	    need_cycle_before(ch->indx, ch->cold->stream_next);
+	    return;
+	}
+
+	/*
+	 * GATHERing clients wait for the gather pass, unless they
+	 * want s100 data, which does not come from the pool
+	 */
+	if (ch->nxtstate == GATHER && !ch->cold->s100) {
+	    gather_wait_client(ch);
 	    return;
 	}
 
@@ -414,6 +558,374 @@ client_pre_select_op(client *ch)
 }
 
 
+/*
+ * gather_wait_client - add a GATHERing client to the gather pass wait list
+ *
+ * A client is given a gather sequence number the first time it waits
+ * for a request, so that the oldest request can be found.
+ *
+ * given:
+ *	ch	pointer to a client channel in the GATHER state
+ */
+static void
+gather_wait_client(client *ch)
+{
+    client **p;		/* realloced wait list */
+
+    /*
+     * firewall
+     */
+    if (ch == NULL) {
+	fatal(10, "gather_wait_client", "NULL arg");
+	/*NOTREACHED*/
+    }
+
+    /*
+     * grow the wait list if needed
+     */
+    if (gather_cnt >= gather_max) {
+	p = (client **)realloc(gather_wait,
+			       (gather_max+GATHER_CHUNK) * sizeof(client *));
+	if (p == NULL) {
+	    warn("gather_wait_client", "unable to grow wait list to %d",
+		 gather_max+GATHER_CHUNK);
+	    /* gather the client on its own rather than lose it */
+	    do_client_op(ch, CYCLE_PRESELECT);
+	    return;
+	}
+	gather_wait = p;
+	gather_max += GATHER_CHUNK;
+    }
+
+    /*
+     * add to the wait list
+     */
+    if (ch->cold->gather_seq == 0) {
+	ch->cold->gather_seq = ++gather_lastseq;
+    }
+    ch->cold->allot = 0;
+    gather_wait[gather_cnt++] = ch;
+    dbg(4, "gather_wait_client", "chan[%d]: waiting to gather, seq: %lld",
+	ch->indx, (long long)ch->cold->gather_seq);
+
+    /* answer the request by its deadline even if nothing arrives */
+    need_cycle_before(ch->indx, ch->cold->deadline);
+    return;
+}
+
+
+/*
+ * gather_fifo_cmp - qsort compare of waiting clients, oldest request first
+ *
+ * Waiting clients are grouped by class before any other ordering.
+ */
+static int
+gather_fifo_cmp(const void *a, const void *b)
+{
+    const client *x = *(const client *const *)a;
+    const client *y = *(const client *const *)b;
+
+    if (x->cold->class != y->cold->class) {
+	return x->cold->class - y->cold->class;
+    }
+    if (x->cold->gather_seq < y->cold->gather_seq) {
+	return -1;
+    } else if (x->cold->gather_seq > y->cold->gather_seq) {
+	return 1;
+    }
+    return 0;
+}
+
+
+/*
+ * gather_smallest_cmp - qsort compare of waiting clients, least need first
+ *
+ * Waiting clients are grouped by class before any other ordering.
+ * Requests with the same need are taken oldest first.
+ */
+static int
+gather_smallest_cmp(const void *a, const void *b)
+{
+    const client *x = *(const client *const *)a;
+    const client *y = *(const client *const *)b;
+    long xneed = x->cold->request - x->cold->gathercnt;
+    long yneed = y->cold->request - y->cold->gathercnt;
+
+    if (x->cold->class != y->cold->class) {
+	return x->cold->class - y->cold->class;
+    }
+    if (xneed < yneed) {
+	return -1;
+    } else if (xneed > yneed) {
+	return 1;
+    }
+    return gather_fifo_cmp(a, b);
+}
+
+
+/*
+ * gather_share - share pool octets among classes by weight
+ *
+ * Each class with clients waiting is given a share of the pool octets
+ * in proportion to its weight.  A class that needs less than its share
+ * takes only what it needs, and the rest is shared among the other
+ * classes by weight (weighted max-min fair sharing).  A class with a
+ * large backlog can thus never keep a lightly loaded class from being
+ * served at its weighted rate.
+ *
+ * given:
+ *	need	octets needed by each class, 0 ==> no clients waiting
+ *	share	where to place the octets alloted to each class
+ *	avail	pool octets to share
+ */
+static void
+gather_share(long *need, long *share, long avail)
+{
+    long sumw;		/* sum of the weights of unfilled classes */
+    long part;		/* a class weighted part of what is left */
+    int filled;		/* TRUE ==> a class was filled in this round */
+    int i;
+
+    /*
+     * fill the classes that need less than their weighted part
+     */
+    for (i=0; i < cfg_lavapool.classcnt; ++i) {
+	share[i] = 0;
+    }
+    do {
+	sumw = 0;
+	for (i=0; i < cfg_lavapool.classcnt; ++i) {
+	    if (share[i] < need[i]) {
+		sumw += cfg_lavapool.class[i].weight;
+	    }
+	}
+	if (sumw <= 0 || avail <= 0) {
+	    return;
+	}
+	filled = FALSE;
+	for (i=0; i < cfg_lavapool.classcnt; ++i) {
+	    part = (long)((double)avail *
+			  (double)cfg_lavapool.class[i].weight / (double)sumw);
+	    if (share[i] < need[i] && need[i] - share[i] <= part) {
+		avail -= need[i] - share[i];
+		share[i] = need[i];
+		filled = TRUE;
+	    }
+	}
+    } while (filled);
+
+    /*
+     * the unfilled classes split the rest by weight
+     */
+    part = avail;
+    for (i=0; i < cfg_lavapool.classcnt; ++i) {
+	if (share[i] < need[i]) {
+	    share[i] = (long)((double)part *
+			      (double)cfg_lavapool.class[i].weight /
+			      (double)sumw);
+	    avail -= share[i];
+	}
+    }
+
+    /*
+     * hand out the octets lost to rounding
+     */
+    for (i=0; i < cfg_lavapool.classcnt && avail > 0; ++i) {
+	if (share[i] < need[i]) {
+	    part = need[i] - share[i];
+	    part = (part < avail) ? part : avail;
+	    share[i] += part;
+	    avail -= part;
+	}
+    }
+    return;
+}
+
+
+/*
+ * gather_allot - allot pool octets to the waiting clients of a class
+ *
+ * given:
+ *	wait	waiting clients of the class, in gather policy order
+ *	cnt	number of waiting clients
+ *	avail	pool octets alloted to the class
+ */
+static void
+gather_allot(client **wait, int cnt, long avail)
+{
+    client *ch;			/* client being alloted */
+    long need;			/* octets needed by a client */
+    double total;		/* octets needed by all waiting clients */
+    int i;
+
+    /*
+     * compute the total need if we must share in proportion
+     */
+    total = 0.0;
+    if (cfg_lavapool.gather == LAVA_GATHER_PROPORTIONAL) {
+	for (i=0; i < cnt; ++i) {
+	    total += wait[i]->cold->request - wait[i]->cold->gathercnt;
+	}
+    }
+
+    /*
+     * give each client its proportional share when the class is short
+     */
+    if (total > (double)avail) {
+	long left = avail;	/* octets left after the shares */
+
+	for (i=0; i < cnt; ++i) {
+	    ch = wait[i];
+	    need = ch->cold->request - ch->cold->gathercnt;
+	    if (need > 0) {
+		ch->cold->allot = (long)((double)avail * (double)need / total);
+		left -= ch->cold->allot;
+	    }
+	}
+	avail = left;
+    }
+
+    /*
+     * allot what remains in order
+     */
+    for (i=0; i < cnt && avail > 0; ++i) {
+	ch = wait[i];
+	need = ch->cold->request - ch->cold->gathercnt - ch->cold->allot;
+	if (need > 0) {
+	    need = (need < avail) ? need : avail;
+	    ch->cold->allot += need;
+	    avail -= need;
+	}
+    }
+    return;
+}
+
+
+/*
+ * gather_pass - share the pool among the clients waiting to gather
+ *
+ * The clients that were put on the wait list during the pre-select
+ * operations are served in a single pass.  The pool data on hand is
+ * first shared among the client classes by weight (see gather_share()).
+ * Within each class, it is alloted according to the gather policy
+ * (cfg_lavapool.gather):
+ *
+ *	LAVA_GATHER_FIFO	  oldest request first
+ *	LAVA_GATHER_SMALLEST	  smallest unfilled request first
+ *	LAVA_GATHER_PROPORTIONAL  in proportion to each unfilled request,
+ *				  left over octets go oldest request first
+ *
+ * A client is gathered when it has been alloted some pool data or when
+ * its deadline has been reached.  The other clients wait for the next
+ * pass without touching the pool.
+ *
+ * NOTE: This function is called by chan_cycle() after all pre-select
+ *	 operations have been performed.  No channels are allocated
+ *	 between the pre-select operations and this call, so the wait
+ *	 list pointers into the channel array remain valid.
+ */
+void
+gather_pass(void)
+{
+    client *ch;			/* client being gathered */
+    long need[LAVA_MAX_CLASS];	/* octets needed by each class */
+    long share[LAVA_MAX_CLASS];	/* octets alloted to each class */
+    long total;			/* octets needed by all waiting clients */
+    int start;			/* first waiting client of a class */
+    int i;
+
+    /*
+     * firewall
+     */
+    if (gather_cnt <= 0) {
+	gather_cnt = 0;
+	return;
+    }
+
+    /*
+     * order the wait list by class and policy
+     */
+    if (gather_cnt > 1) {
+	qsort(gather_wait, gather_cnt, sizeof(client *),
+	      (cfg_lavapool.gather == LAVA_GATHER_SMALLEST) ?
+	      gather_smallest_cmp : gather_fifo_cmp);
+    }
+
+    /*
+     * share the pool among the classes
+     */
+    for (i=0; i < LAVA_MAX_CLASS; ++i) {
+	need[i] = 0;
+    }
+    for (i=0; i < gather_cnt; ++i) {
+	ch = gather_wait[i];
+	need[ch->cold->class] += ch->cold->request - ch->cold->gathercnt;
+    }
+    gather_share(need, share, (long)pool_level());
+    for (total=0, i=0; i < LAVA_MAX_CLASS; ++i) {
+	total += need[i];
+    }
+    if (total > (long)pool_level()) {
+	/* tell the fill controller that clients are short of data */
+	pool_short();
+    }
+    dbg(3, "gather_pass", "%d clients waiting, %d octets in the pool",
+	gather_cnt, (int)pool_level());
+
+    /*
+     * allot each class share among its clients
+     */
+    for (start=0, i=1; i <= gather_cnt; ++i) {
+	if (i == gather_cnt ||
+	    gather_wait[i]->cold->class != gather_wait[start]->cold->class) {
+	    ch = gather_wait[start];
+	    dbg(4, "gather_pass", "class %s: %d clients need %ld, alloted %ld",
+		cfg_lavapool.class[ch->cold->class].name, i - start,
+		need[ch->cold->class], share[ch->cold->class]);
+	    gather_allot(gather_wait + start, i - start,
+	    		 share[ch->cold->class]);
+	    start = i;
+	}
+    }
+
+    /*
+     * gather the clients that were alloted data or reached their deadline
+     */
+    for (i=0; i < gather_cnt; ++i) {
+	ch = gather_wait[i];
+	if (ch->nxtstate != GATHER) {
+	    continue;
+	}
+	if (ch->cold->allot > 0 ||
+	    (ch->cold->deadline > 0.0 && ch->cold->deadline <= about_now)) {
+	    dbg(4, "gather_pass", "chan[%d]: alloted %ld of %ld octets",
+		ch->indx, ch->cold->allot,
+		ch->cold->request - ch->cold->gathercnt);
+	    do_client_op(ch, CYCLE_PRESELECT);
+	} else {
+	    dbg(4, "gather_pass", "chan[%d]: nothing alloted", ch->indx);
+	}
+    }
+    gather_cnt = 0;
+    return;
+}
+
+
+/*
+ * free_gather - free the gather pass wait list
+ */
+void
+free_gather(void)
+{
+    if (gather_wait != NULL) {
+	free(gather_wait);
+	gather_wait = NULL;
+    }
+    gather_cnt = 0;
+    gather_max = 0;
+}
+
+
 /*
  * mk_client - make a channel a client channel
  */
@@ -421,6 +933,7 @@ chan *
 mk_client(client *ch)
 {
     int indx;		/* remembered channel index */
+    struct client_cold_s *cold;	/* remembered client state */
 
     /*
      * firewall
@@ -430,12 +943,27 @@ mk_client(client *ch)
 	/*NOTREACHED*/
     }
 
+    /*
+     * allocate the rest of the client state if needed
+     */
+    cold = ch->cold;
+    if (cold == NULL) {
+	cold = (struct client_cold_s *)malloc(sizeof(*cold));
+	if (cold == NULL) {
+	    fatal(11, "mk_client", "chan[%d]: unable to malloc state",
+		  ch->indx);
+	    /*NOTREACHED*/
+	}
+    }
+
     /*
      * clear values
      */
     indx = ch->indx;
     memset(ch, 0, sizeof(*ch));
+    memset(cold, 0, sizeof(*cold));
     ch->indx = indx;
+    ch->cold = cold;
 
     /*
      * force type
@@ -445,7 +973,7 @@ mk_client(client *ch)
     /*
      * force ALLOCED state
      */
-    ch->random = NULL;
+    ch->cold->random = NULL;
     ch->curstate = ALLOCED;
     ch->nxtstate = OPEN;
     dbg(2, "mk_client", "op: chan[%d] now client channel: state: %s ==> %s",
@@ -463,16 +991,18 @@ mk_client(client *ch)
  *
  * given:
  *	fd	open socket to associated with the client
+ *	class	client class, index into cfg_lavapool.class[]
  *
  * returns:
  *	OPEN client channel or NULL if error
  */
 chan *
-mk_open_client(int fd)
+mk_open_client(int fd, int class)
 {
     chan *c;			/* channel being opened */
     client *ch;			/* client channel */
     int indx;			/* remembered channel index */
+    struct client_cold_s *cold;	/* remembered client state */
 
     /*
      * firewall
@@ -481,6 +1011,10 @@ mk_open_client(int fd)
 	warn("mk_open_client", "passed neg descriptor: %d", fd);
 	return NULL;
     }
+    if (class < 0 || class >= cfg_lavapool.classcnt) {
+	warn("mk_open_client", "invalid class: %d", class);
+	class = 0;
+    }
 
     /*
      * find a channel
@@ -505,17 +1039,21 @@ mk_open_client(int fd)
      * clear values
      */
     indx = ch->indx;
-    if (ch->random != NULL) {
-	free(ch->random);
+    cold = ch->cold;
+    if (cold->random != NULL) {
+	free(cold->random);
     }
     memset(ch, 0, sizeof(*ch));
+    memset(cold, 0, sizeof(*cold));
     ch->indx = indx;
+    ch->cold = cold;
     ch->fd = -1;
-    ch->open_op = -1.0;
-    ch->last_op = -1.0;
-    ch->timelimit = 0.0;
+    ch->cold->open_op = -1.0;
+    ch->cold->last_op = -1.0;
+    ch->cold->timelimit = 0.0;
     ch->timeout = -1.0;
-    ch->random = NULL;
+    ch->cold->random = NULL;
+    ch->cold->resv = NULL;
 
     /*
      * force type
@@ -526,23 +1064,27 @@ mk_open_client(int fd)
      * place the information into the channel
      */
     about_now = right_now();
-    ch->open_op = about_now;
-    ch->last_op = ch->open_op;
+    ch->cold->open_op = about_now;
+    ch->cold->last_op = ch->cold->open_op;
     if (cfg_lavapool.timeout > 0.0) {
-	ch->timelimit = cfg_lavapool.timeout;
-	ch->timeout = ch->open_op + cfg_lavapool.timeout;
+	ch->cold->timelimit = cfg_lavapool.timeout;
+	ch->timeout = ch->cold->open_op + cfg_lavapool.timeout;
     } else {
-	ch->timelimit = 0.0;
+	ch->cold->timelimit = 0.0;
 	ch->timeout = 0.0;
     }
     ch->fd = fd;
     set_chanindx(ch->indx, ch->fd);
+    ch->cold->class = class;
+    dbg(3, "mk_open_client", "chan[%d]: class: %s",
+	ch->indx, cfg_lavapool.class[class].name);
     dbg(3, "mk_open_client", "chan[%d]: was %s ==> %s, force %s ==> %s",
     	   c->client.indx,
 	   STATE_NAME(c->client.curstate),  STATE_NAME(c->client.nxtstate),
 	   STATE_NAME(OPEN), STATE_NAME(READ));
     ch->curstate = OPEN;
     ch->nxtstate = READ;
+    ++open_clients;
     return c;
 }
 
@@ -565,6 +1107,9 @@ mk_open_client(int fd)
  * if the read buffer contains non-digits, or if the request count
  * is too large (> maxrequest), then we will move into CLOSE state.
  *
+ * A client that starts with the LAVA_PROTO_MAGIC prefix is handed
+ * to read_binary() instead.
+ *
  * This function does nothing if the channel is HALTed.
  *
  * given:
@@ -579,6 +1124,7 @@ read_client(client *ch)
 {
     int ret;		/* system call return */
     int old_readcnt;	/* read count before read_once() was called */
+    int buflen;		/* size of the request input buffer in use */
     int i;
 
     /*
@@ -617,21 +1163,32 @@ read_client(client *ch)
     /*
      * close if the read buffer is already full
      */
-    if (ch->readcnt >= LAVA_REQBUFLEN) {
+    buflen = ((ch->cold->proto > 0) ? CLIENT_BUFLEN : LAVA_REQBUFLEN);
+    if (ch->cold->readcnt >= buflen) {
 	dbg(3, "read_client", "chan[%d]: read buffer already full: %d >= %d",
-			      ch->indx, ch->readcnt, LAVA_REQBUFLEN);
+			      ch->indx, ch->cold->readcnt, buflen);
 	client_force_close(ch);
 	return;
     }
 
+    /*
+     * MSG_ZEROCOPY completions also make the socket readable
+     */
+    if (ch->cold->zc_pend != NULL) {
+	reap_client(ch);
+    }
+
     /*
      * read what we can
      */
-    old_readcnt = ch->readcnt;
+    old_readcnt = ch->cold->readcnt;
     errno = 0;
-    ret = read_once(ch->fd, ch->readbuf+ch->readcnt,
-    		    LAVA_REQBUFLEN-ch->readcnt, FALSE);
-    if (ret < 0) {
+    ret = read_once(ch->fd, ch->cold->readbuf+ch->cold->readcnt,
+    		    buflen-ch->cold->readcnt, FALSE);
+    if (ret == LAVAERR_NONBLOCK) {
+	dbg(4, "read_client", "chan[%d]: nothing to read yet", ch->indx);
+	return;
+    } else if (ret < 0) {
 	dbg(3, "read_client", "chan[%d]: read error: %s",
 			      ch->indx, strerror(errno));
 	client_force_close(ch);
@@ -642,35 +1199,44 @@ read_client(client *ch)
 	return;
     }
     dbg(3, "read_client", "chan[%d]: read %d readcnt: %d",
-	   ch->indx, ret, ch->readcnt);
-    ch->readcnt += ret;
+	   ch->indx, ret, ch->cold->readcnt);
+    ch->cold->readcnt += ret;
+
+    /*
+     * binary protocol clients are parsed elsewhere
+     */
+    if (ch->cold->proto > 0 || ch->cold->readbuf[0] == LAVA_PROTO_MAGIC[0]) {
+	read_binary(ch);
+	return;
+    }
 
     /*
      * parse the request count chars that we read
      */
-    ch->readbuf[ch->readcnt+ret] = '\0';
-    for (i = old_readcnt; i < ch->readcnt; ++i) {
+    ch->cold->readbuf[ch->cold->readcnt] = '\0';
+    for (i = old_readcnt; i < ch->cold->readcnt; ++i) {
 
 	/*
 	 * stop reading after the first \n or \r or \0
 	 */
-	if (ch->readbuf[i] == '\n' || ch->readbuf[i] == '\r' ||
-	    ch->readbuf[i] == '\0') {
+	if (ch->cold->readbuf[i] == '\n' || ch->cold->readbuf[i] == '\r' ||
+	    ch->cold->readbuf[i] == '\0') {
 
 	    /*
 	     * we have a full read count request, check value
 	     */
-	    ch->readbuf[i] = '\0';
-	    ch->request = strtol(ch->readbuf, NULL, 0);
-	    if (ch->request <= 0) {
+	    ch->cold->readbuf[i] = '\0';
+	    ch->cold->request = strtol(ch->cold->readbuf, NULL, 0);
+	    if (ch->cold->request <= 0) {
 		dbg(3, "read_client", "chan[%d]: "
-		    "request count too small: %d <= 0", ch->indx, ch->request);
+		    "request count too small: %d <= 0",
+		    ch->indx, ch->cold->request);
 		client_force_close(ch);
 		return;
-	    } else if (ch->request > cfg_random.maxrequest) {
+	    } else if (ch->cold->request > cfg_random.maxrequest) {
 		dbg(3, "read_client", "chan[%d]: "
 				      "request count too large: %d > %d",
-		    ch->indx, ch->request, cfg_random.maxrequest);
+		    ch->indx, ch->cold->request, cfg_random.maxrequest);
 		client_force_close(ch);
 		return;
 	    }
@@ -690,9 +1256,9 @@ read_client(client *ch)
 	    /*
 	     * update accounting
 	     */
-	    ch->last_op = about_now;
+	    ch->cold->last_op = about_now;
 	    if (ch->timeout > 0.0) {
-		ch->timelimit -= (about_now - ch->open_op);
+		ch->cold->timelimit -= (about_now - ch->cold->open_op);
 	    }
 	    ch->timeout = 0.0;	/* clear timeout while gathering */
 
@@ -714,16 +1280,17 @@ read_client(client *ch)
 	 * NOTE: Hex numbers such as 0x34 or 0X15 are OK as long as the
 	 *	 x (or X) is in the 2nd char
 	 */
-	} else if (!isascii(ch->readbuf[i]) ||
-		   (i == 1 && isascii(ch->readbuf[1] != 'x' &&
-		   	      isascii(ch->readbuf[1] != 'X')) &&
-		    !isdigit(ch->readbuf[1])) || !isdigit(ch->readbuf[i])) {
+	} else if (!isascii(ch->cold->readbuf[i]) ||
+		   (i == 1 && isascii(ch->cold->readbuf[1] != 'x' &&
+		   	      isascii(ch->cold->readbuf[1] != 'X')) &&
+		    !isdigit(ch->cold->readbuf[1])) ||
+		    !isdigit(ch->cold->readbuf[i])) {
 
 	    /*
 	     * bogus number, close down
 	     */
 	    dbg(3, "read_client", "chan[%d]: non-digits in count: <<%s>>",
-	    			  ch->indx, ch->readbuf);
+	    			  ch->indx, ch->cold->readbuf);
 	    client_force_close(ch);
 	    return;
 	}
@@ -732,9 +1299,9 @@ read_client(client *ch)
     /*
      * look for full request buffer without completion
      */
-    if (ch->readcnt >= LAVA_REQBUFLEN) {
+    if (ch->cold->readcnt >= LAVA_REQBUFLEN) {
 	dbg(3, "read_client", "chan[%d]: read buffer full: %d >= %d",
-			      ch->indx, ch->readcnt, LAVA_REQBUFLEN);
+			      ch->indx, ch->cold->readcnt, LAVA_REQBUFLEN);
 	client_force_close(ch);
 	return;
     }
@@ -754,102 +1321,501 @@ read_client(client *ch)
 
 
 /*
- * gather_client - gather LavaRnd data for a client request
+ * read_binary - process input from a binary protocol client
  *
- * We will allocate and copy in the LavaRnd data requested by the client.
- * If we were able to copy in all of the requested data, then the
- * client will move into the WRITE state.
+ * A binary protocol client opens with the LAVA_PROTO_MAGIC prefix
+ * followed by a protocol version octet.  Once that has been read,
+ * each request header is served in turn by next_request().
  *
- * This function does nothing if the channel is HALTed.
+ * If the prefix does not match, or if the protocol version is not one
+ * that we speak, then we will move into CLOSE state.
  *
  * given:
- *	ch		client channel
- *
- * NOTE: It is assumed that the caller has used select() (perhaps via
- *	 the chan_select() function) to determine that the descriptor
- *	 is readable, otherwise this call may block.
+ *	ch client channel
  */
 static void
-gather_client(client *ch)
+read_binary(client *ch)
 {
-    int ret;		/* function return */
+    int len;		/* magic prefix octets read */
 
     /*
      * firewall
      */
     if (ch == NULL) {
-	fatal(11, "gather_client", "NULL arg");
+	fatal(11, "read_binary", "NULL arg");
 	/*NOTREACHED*/
     }
-    if (ch->type != TYPE_CLIENT) {
-	warn("gather_client", "chan[%d]: expected type %d, found: %d",
-			      ch->indx, TYPE_CLIENT, ch->type);
-	return;
-    }
-    if (ch->curstate == HALT || ch->nxtstate == HALT) {
-	warn("gather_client", "chan[%d]: HALTed, cannot read", ch->indx);
-	return;
-    }
-    if ((int)ch->nxtstate != GATHER) {
-	warn("gather_client", "chan[%d] next state: %s != %s",
-	     ch->indx, STATE_NAME(ch->nxtstate), STATE_NAME(GATHER));
-	return;
-    }
 
     /*
-     * firewall - watch for bogus requests and request states
+     * check the magic prefix and version if we have not already done so
      */
-    if (ch->request <= 0) {
-	warn("gather_client", "chan[%d] request size: %d <= 0",
-			      ch->indx, ch->request);
-	client_force_close(ch);
-	return;
-    }
-    if (ch->random != NULL && ch->gathercnt < 0) {
-	warn("gather_client", "chan[%d] gather count: %d < 0",
-			      ch->indx, ch->gathercnt);
-	client_force_close(ch);
-	return;
-    } else if (ch->random != NULL && ch->gathercnt > ch->request) {
+    if (ch->cold->proto == 0) {
+
+	/*
+	 * what we have read so far must match the magic prefix
+	 */
+	len = ((ch->cold->readcnt < LAVA_PROTO_MAGICLEN) ?
+		ch->cold->readcnt : LAVA_PROTO_MAGICLEN);
+	if (memcmp(ch->cold->readbuf, LAVA_PROTO_MAGIC, len) != 0) {
+	    dbg(3, "read_binary", "chan[%d]: bad magic prefix", ch->indx);
+	    client_force_close(ch);
+	    return;
+	}
+
+	/*
+	 * wait for the rest of the prefix
+	 */
+	if (ch->cold->readcnt < LAVA_PROTO_HELLOLEN) {
+	    ch->curstate = READ;
+	    ch->nxtstate = READ;
+	    return;
+	}
+
+	/*
+	 * we only speak one version of the binary protocol
+	 */
+	if ((u_int8_t)ch->cold->readbuf[LAVA_PROTO_MAGICLEN] !=
+	    LAVA_PROTO_VERSION) {
+	    dbg(3, "read_binary", "chan[%d]: unsupported protocol version: %d",
+	    			  ch->indx,
+				  (u_int8_t)ch->cold->readbuf[LAVA_PROTO_MAGICLEN]);
+	    client_force_close(ch);
+	    return;
+	}
+	ch->cold->proto = LAVA_PROTO_VERSION;
+	ch->cold->readcnt -= LAVA_PROTO_HELLOLEN;
+	memmove(ch->cold->readbuf, ch->cold->readbuf+LAVA_PROTO_HELLOLEN,
+		ch->cold->readcnt);
+	dbg(2, "read_binary", "chan[%d]: binary protocol version %d",
+			      ch->indx, ch->cold->proto);
+    }
+
+    /*
+     * serve the next request if we have all of its header
+     */
+    ch->curstate = READ;
+    next_request(ch);
+    return;
+}
+
+
+/*
+ * next_request - start the next buffered binary protocol request
+ *
+ * If the input buffer holds a complete request header, the header is
+ * removed from the buffer and we move into GATHER state.  Otherwise
+ * we will wait for the rest of the header in READ state.
+ *
+ * A stream request is served by stream_reply() one reply at a time.
+ *
+ * If the request count is too small or too large (> maxrequest), or
+ * if the header is otherwise invalid, then we will move into CLOSE state.
+ *
+ * given:
+ *	ch client channel
+ */
+static void
+next_request(client *ch)
+{
+    u_int8_t *hdr;	/* request header */
+    long request;	/* octets requested */
+    int minqual;	/* minimum acceptable quality */
+    int type;		/* request type */
+    int s100;		/* TRUE ==> serve with s100 data */
+    long msec;		/* deadline in milliseconds, 0 ==> none */
+
+    /*
+     * firewall
+     */
+    if (ch == NULL) {
+	fatal(11, "next_request", "NULL arg");
+	/*NOTREACHED*/
+    }
+
+    /*
+     * wait for more if we do not have a full request header
+     */
+    if (ch->cold->readcnt < LAVA_PROTO_REQLEN) {
+	dbg(3, "next_request", "chan[%d]: state was %s ==> %s, now %s ==> %s",
+			       ch->indx, STATE_NAME(ch->curstate),
+	    STATE_NAME(ch->nxtstate), STATE_NAME(ch->curstate),
+	    STATE_NAME(READ));
+	ch->nxtstate = READ;
+	return;
+    }
+
+    /*
+     * decode and remove the request header
+     */
+    hdr = (u_int8_t *)ch->cold->readbuf;
+    request = ((long)hdr[0] << 24) | ((long)hdr[1] << 16) |
+    	      ((long)hdr[2] << 8) | (long)hdr[3];
+    minqual = hdr[4];
+    type = hdr[5] & ~LAVA_PROTO_S100;
+    s100 = ((hdr[5] & LAVA_PROTO_S100) ? TRUE : FALSE);
+    msec = ((long)hdr[8] << 24) | ((long)hdr[9] << 16) |
+    	   ((long)hdr[10] << 8) | (long)hdr[11];
+    if ((type != LAVA_PROTO_ONCE && type != LAVA_PROTO_STREAM) ||
+        hdr[6] != 0 || hdr[7] != 0 || minqual > (int)LAVA_QUAL_LAVARND) {
+	dbg(3, "next_request", "chan[%d]: invalid request header", ch->indx);
+	client_force_close(ch);
+	return;
+    }
+    ch->cold->readcnt -= LAVA_PROTO_REQLEN;
+    memmove(ch->cold->readbuf, ch->cold->readbuf+LAVA_PROTO_REQLEN,
+	    ch->cold->readcnt);
+
+    /*
+     * check the request count
+     *
+     * The total of a stream request is not limited by maxrequest.
+     */
+    if (type == LAVA_PROTO_ONCE && request <= 0) {
+	dbg(3, "next_request", "chan[%d]: request count too small: %d <= 0",
+			       ch->indx, request);
+	client_force_close(ch);
+	return;
+    } else if (type == LAVA_PROTO_ONCE && request > cfg_random.maxrequest) {
+	dbg(3, "next_request", "chan[%d]: request count too large: %d > %d",
+			       ch->indx, request, cfg_random.maxrequest);
+	client_force_close(ch);
+	return;
+    }
+
+    /*
+     * look for timeout
+     */
+    about_now = right_now();
+    if (ch->timeout > 0.0 && ch->timeout < about_now) {
+	dbg(3, "next_request", "chan[%d]: read timeout: %.3f < about now: %.3f",
+			       ch->indx, ch->timeout, about_now);
+	client_force_close(ch);
+	return;
+    }
+
+    /*
+     * note if the request is to be served with s100 data
+     */
+    ch->cold->s100 = s100;
+
+    /*
+     * a stream request is served one reply at a time
+     */
+    if (type == LAVA_PROTO_STREAM) {
+	ch->cold->minqual = minqual;
+	ch->cold->deadline = 0.0;
+	ch->cold->stream = TRUE;
+	ch->cold->stream_left = ((request > 0) ? request : -1);
+	ch->cold->stream_rate = msec;
+	ch->cold->stream_next = about_now;
+	dbg(2, "next_request", "chan[%d]: stream of %d octets at %d octets/sec",
+			       ch->indx, request, msec);
+	stream_reply(ch);
+	return;
+    }
+
+    /*
+     * setup the request
+     */
+    ch->cold->request = request;
+    ch->cold->minqual = minqual;
+    ch->cold->deadline = 0.0;
+    if (msec > 0) {
+	ch->cold->deadline = about_now + (double)msec/1000.0 - DEADLINE_SLACK;
+	if (ch->cold->deadline < about_now) {
+	    ch->cold->deadline = about_now;
+	}
+    }
+    ch->cold->gathercnt = 0;
+    ch->cold->writecnt = 0;
+    ch->cold->last_op = about_now;
+    ch->timeout = 0.0;	/* clear timeout while gathering */
+
+    /*
+     * we are done reading and are ready to GATHER
+     */
+    dbg(3, "next_request", "chan[%d]: state was %s ==> %s, now %s ==> %s",
+			   ch->indx, STATE_NAME(ch->curstate),
+	STATE_NAME(ch->nxtstate), STATE_NAME(GATHER), STATE_NAME(GATHER));
+    ch->curstate = GATHER;
+    ch->nxtstate = GATHER;
+    return;
+}
+
+
+/*
+ * stream_reply - start the next reply of a binary stream request
+ *
+ * Each reply is at most maxrequest octets.  A paced stream is sent
+ * as about STREAM_HZ replies per second.  The next reply is not
+ * gathered until the client has taken the previous one, so a slow
+ * client slows the stream down rather than having data pile up.
+ *
+ * given:
+ *	ch client channel
+ */
+static void
+stream_reply(client *ch)
+{
+    long len;		/* length of the next reply */
+
+    /*
+     * firewall
+     */
+    if (ch == NULL) {
+	fatal(11, "stream_reply", "NULL arg");
+	/*NOTREACHED*/
+    }
+
+    /*
+     * size the next reply
+     */
+    len = cfg_random.maxrequest;
+    if (ch->cold->stream_rate > 0 && ch->cold->stream_rate / STREAM_HZ < len) {
+	len = ch->cold->stream_rate / STREAM_HZ;
+	if (len <= 0) {
+	    len = 1;
+	}
+    }
+    if (ch->cold->stream_left >= 0 && len > ch->cold->stream_left) {
+	len = ch->cold->stream_left;
+    }
+    if (ch->cold->stream_left > 0) {
+	ch->cold->stream_left -= len;
+    }
+
+    /*
+     * setup the reply
+     */
+    drop_random(ch);
+    ch->cold->request = len;
+    ch->cold->gathercnt = 0;
+    ch->cold->writecnt = 0;
+    ch->cold->replylen = 0;
+    ch->cold->replycnt = 0;
+    ch->cold->last_op = about_now;
+    ch->timeout = 0.0;	/* clear timeout while gathering */
+
+    /*
+     * gather the next reply
+     */
+    dbg(3, "stream_reply", "chan[%d]: state was %s ==> %s, now %s ==> %s",
+			   ch->indx, STATE_NAME(ch->curstate),
+	STATE_NAME(ch->nxtstate), STATE_NAME(GATHER), STATE_NAME(GATHER));
+    ch->curstate = GATHER;
+    ch->nxtstate = GATHER;
+    return;
+}
+
+
+/*
+ * gather_client - gather LavaRnd data for a client request
+ *
+ * We take no more than the pool octets alloted to the client by
+ * gather_pass().  When the allotment covers the entire request, we
+ * reserve it in the pool
+ * and the client moves into the WRITE state without copying the data.
+ * The reply is then sent straight from the pool.  This is not done for
+ * a reply that will be sent with MSG_ZEROCOPY, as the kernel may use
+ * its pages for long after the send: such a reply is copied into a
+ * client buffer instead.
+ *
+ * Otherwise we will allocate and copy in the LavaRnd data requested by
+ * the client.  If we were able to copy in all of the requested data,
+ * then the client will move into the WRITE state.
+ *
+ * A binary protocol request that reaches its deadline first is topped
+ * up with s100 data from expand_pool() and answered with the quality of
+ * that data, provided it is at least the minimum quality requested.
+ * Otherwise it is answered with whatever was gathered so far, with a
+ * quality of LAVA_QUAL_NONE.
+ *
+ * This function does nothing if the channel is HALTed.
+ *
+ * given:
+ *	ch		client channel
+ *
+ * NOTE: It is assumed that the caller has used select() (perhaps via
+ *	 the chan_select() function) to determine that the descriptor
+ *	 is readable, otherwise this call may block.
+ */
+static void
+gather_client(client *ch)
+{
+    int ret;		/* function return */
+    int qual;		/* quality of the reply */
+    long cnt;		/* octets to drain from the pool */
+
+    /*
+     * firewall
+     */
+    if (ch == NULL) {
+	fatal(11, "gather_client", "NULL arg");
+	/*NOTREACHED*/
+    }
+    if (ch->type != TYPE_CLIENT) {
+	warn("gather_client", "chan[%d]: expected type %d, found: %d",
+			      ch->indx, TYPE_CLIENT, ch->type);
+	return;
+    }
+    if (ch->curstate == HALT || ch->nxtstate == HALT) {
+	warn("gather_client", "chan[%d]: HALTed, cannot read", ch->indx);
+	return;
+    }
+    if ((int)ch->nxtstate != GATHER) {
+	warn("gather_client", "chan[%d] next state: %s != %s",
+	     ch->indx, STATE_NAME(ch->nxtstate), STATE_NAME(GATHER));
+	return;
+    }
+
+    /*
+     * firewall - watch for bogus requests and request states
+     */
+    if (ch->cold->request <= 0) {
+	warn("gather_client", "chan[%d] request size: %d <= 0",
+			      ch->indx, ch->cold->request);
+	client_force_close(ch);
+	return;
+    }
+    if (ch->cold->random != NULL && ch->cold->gathercnt < 0) {
+	warn("gather_client", "chan[%d] gather count: %d < 0",
+			      ch->indx, ch->cold->gathercnt);
+	client_force_close(ch);
+	return;
+    } else if (ch->cold->random != NULL &&
+	       ch->cold->gathercnt > ch->cold->request) {
 	warn("gather_client", "chan[%d] gather count: %d > request: %d",
-			      ch->indx, ch->gathercnt, ch->request);
+	     ch->indx, ch->cold->gathercnt, ch->cold->request);
 	client_force_close(ch);
+	return;
+    }
+
+    /*
+     * serve the entire request directly from the pool if we can
+     */
+    if (ch->cold->random == NULL && ch->cold->resv == NULL &&
+	ch->cold->allot >= ch->cold->request &&
+	(ch->cold->request < ZEROCOPY_MIN || !zerocopy_ok(ch))) {
+	ch->cold->resv = reserve_pool(ch->cold->request);
+	if (ch->cold->resv != NULL) {
+	    ch->cold->allot = 0;
+	    ch->cold->gathercnt = ch->cold->request;
+	    ch->cold->last_op = about_now;
+	    dbg(2, "gather_client", "chan[%d]: reserved %d octets in the pool",
+	    			    ch->indx, ch->cold->request);
+	    dbg(3, "gather_client",
+		   "chan[%d]: state was %s ==> %s, now %s ==> %s",
+		   ch->indx, STATE_NAME(ch->curstate),
+		STATE_NAME(ch->nxtstate), STATE_NAME(WRITE), STATE_NAME(WRITE));
+	    start_reply(ch, LAVA_QUAL_LAVARND);
+	    ch->curstate = WRITE;
+	    ch->nxtstate = WRITE;
+
+	    /*
+	     * The socket is almost always writable now.  The reserved
+	     * region is released before write_client() returns: whatever
+	     * the socket does not take is copied into a client buffer.
+	     */
+	    write_client(ch);
+	    if (client_preselect_ready[ch->nxtstate]) {
+		/* we are past the pre-select op, ask for a quick cycle */
+		need_cycle_before(ch->indx, about_now);
+	    }
+	    return;
+	}
     }
 
     /*
      * malloc the random buffer if we do not have one
      */
-    if (ch->random == NULL) {
-	ch->random = (u_int8_t *)malloc(ch->request);
-	if (ch->random == NULL) {
+    if (ch->cold->random == NULL) {
+	ch->cold->random = (u_int8_t *)malloc(ch->cold->request);
+	if (ch->cold->random == NULL) {
 	    warn("gather_client", "chan[%d]: unable to malloc %d octets",
-	    			  ch->indx, ch->request);
+	    			  ch->indx, ch->cold->request);
 	    client_force_close(ch);
 	    return;
 	}
-	ch->gathercnt = 0;
+	ch->cold->gathercnt = 0;
+    }
+
+    /*
+     * an S100 request is served by the s100 expansion generator
+     *
+     * When the s100 data is below the minimum quality, we reply with
+     * no octets, and end the stream if this is a stream request.
+     */
+    if (ch->cold->s100) {
+	qual = expand_pool(ch->cold->random, ch->cold->request,
+			   ((ch->cold->minqual > LAVA_QUAL_S100LOW) ?
+			    ch->cold->minqual : LAVA_QUAL_S100LOW));
+	if (qual < 0) {
+	    dbg(2, "gather_client", "chan[%d]: s100 below quality: %d",
+				    ch->indx, ch->cold->minqual);
+	    ch->cold->request = 0;
+	    ch->cold->stream_left = 0;
+	    qual = LAVA_QUAL_NONE;
+	}
+	ch->cold->gathercnt = ch->cold->request;
+	ch->cold->last_op = about_now;
+	dbg(3, "gather_client",
+	       "chan[%d]: state was %s ==> %s, now %s ==> %s",
+	       ch->indx, STATE_NAME(ch->curstate),
+	    STATE_NAME(ch->nxtstate), STATE_NAME(WRITE), STATE_NAME(WRITE));
+	start_reply(ch, qual);
+	ch->curstate = WRITE;
+	ch->nxtstate = WRITE;
+	return;
     }
 
     /*
      * determine how much LavaRnd data we can/should copy
      */
-    ret = drain_pool(ch->random+ch->gathercnt, ch->request-ch->gathercnt);
+    cnt = ch->cold->request - ch->cold->gathercnt;
+    if (cnt > ch->cold->allot) {
+	cnt = ch->cold->allot;
+    }
+    ch->cold->allot = 0;
+    ret = 0;
+    if (cnt > 0) {
+	ret = drain_pool(ch->cold->random+ch->cold->gathercnt, cnt);
+    }
 
     /*
      * update accounting
      */
-    ch->gathercnt += ret;
-    if (ch->gathercnt == ch->request) {
-	ch->last_op = about_now;
+    ch->cold->gathercnt += ret;
+    qual = LAVA_QUAL_LAVARND;
+    if (ch->cold->gathercnt < ch->cold->request &&
+	ch->cold->deadline > 0.0 && ch->cold->deadline <= about_now) {
+	/* deadline reached, top up or reply with what we have */
+	dbg(2, "gather_client", "chan[%d]: deadline reached after %d of %d",
+				ch->indx, ch->cold->gathercnt,
+				ch->cold->request);
+	qual = expand_pool(ch->cold->random+ch->cold->gathercnt,
+			   ch->cold->request-ch->cold->gathercnt,
+			   ch->cold->minqual);
+	if (qual >= 0) {
+	    dbg(2, "gather_client", "chan[%d]: topped up %d octets, quality %d",
+		ch->indx, ch->cold->request-ch->cold->gathercnt, qual);
+	    ch->cold->gathercnt = ch->cold->request;
+	} else {
+	    ch->cold->request = ch->cold->gathercnt;
+	    qual = LAVA_QUAL_NONE;
+	}
+    }
+    if (ch->cold->gathercnt == ch->cold->request) {
+	ch->cold->last_op = about_now;
 	dbg(3, "gather_client",
 	       "chan[%d]: state was %s ==> %s, now %s ==> %s",
 	       ch->indx, STATE_NAME(ch->curstate),
 	    STATE_NAME(ch->nxtstate), STATE_NAME(WRITE), STATE_NAME(WRITE));
+	start_reply(ch, qual);
 	ch->curstate = WRITE;
 	ch->nxtstate = WRITE;
-    } else if (ch->gathercnt > ch->request) {
+    } else if (ch->cold->gathercnt > ch->cold->request) {
 	warn("gather_client", "chan[%d] gathered too much: %d > request: %d",
-			      ch->indx, ch->gathercnt, ch->request);
+	     ch->indx, ch->cold->gathercnt, ch->cold->request);
 	client_force_close(ch);
     } else if (ch->curstate != GATHER) {
 	dbg(3, "gather_client",
@@ -859,12 +1825,56 @@ gather_client(client *ch)
 	ch->curstate = GATHER;
 	ch->nxtstate = GATHER;
     }
-    if (ch->gathercnt < ch->request) {
+    if (ch->cold->gathercnt < ch->cold->request) {
 	dbg(3, "gather_client", "chan[%d]: gathered %d, need %d more",
-				ch->indx, ret, ch->request-ch->gathercnt);
+	    ch->indx, ret, ch->cold->request-ch->cold->gathercnt);
+	need_cycle_before(ch->indx, ch->cold->deadline);
     } else {
 	dbg(2, "gather_client", "chan[%d]: completed gather of %d octets",
-				ch->indx, ch->request);
+				ch->indx, ch->cold->request);
+    }
+    return;
+}
+
+
+/*
+ * start_reply - prepare to write a reply to a client
+ *
+ * A binary protocol reply starts with a reply header that gives the
+ * number of octets returned and their quality.  Decimal request
+ * replies have no header.
+ *
+ * given:
+ *	ch		client channel
+ *	qual		quality of the octets being returned
+ */
+static void
+start_reply(client *ch, int qual)
+{
+    /*
+     * firewall
+     */
+    if (ch == NULL) {
+	fatal(11, "start_reply", "NULL arg");
+	/*NOTREACHED*/
+    }
+
+    /*
+     * form the reply header if needed
+     */
+    ch->cold->writecnt = 0;
+    ch->cold->replycnt = 0;
+    ch->cold->gather_seq = 0;
+    if (ch->cold->proto > 0) {
+	memset(ch->cold->reply, 0, sizeof(ch->cold->reply));
+	ch->cold->reply[0] = (ch->cold->request >> 24) & 0xff;
+	ch->cold->reply[1] = (ch->cold->request >> 16) & 0xff;
+	ch->cold->reply[2] = (ch->cold->request >> 8) & 0xff;
+	ch->cold->reply[3] = ch->cold->request & 0xff;
+	ch->cold->reply[4] = (u_int8_t)qual;
+	ch->cold->replylen = LAVA_PROTO_REPLEN;
+    } else {
+	ch->cold->replylen = 0;
     }
     return;
 }
@@ -876,6 +1886,13 @@ gather_client(client *ch)
  * We will attempt to write all of the gathered LavaRnd data to the
  * client or until timeout.
  *
+ * Data reserved in the pool is sent directly from the pool.  Should
+ * only part of it be accepted by the socket, the rest is copied into
+ * a buffer.  Either way the pool region is released before we return,
+ * so a slow client never holds up the filling of the pool.
+ *
+ * A binary protocol reply header is written ahead of the data.
+ *
  * This function does nothing if the channel is HALTed.
  *
  * given:
@@ -888,7 +1905,9 @@ gather_client(client *ch)
 static void
 write_client(client *ch)
 {
+    u_int8_t *buf;	/* where the LavaRnd data to deliver resides */
     int ret;		/* system call return */
+    int hdr;		/* reply header octets written */
 
     /*
      * firewall
@@ -906,7 +1925,8 @@ write_client(client *ch)
 	warn("write_client", "chan[%d]: HALTed, cannot read", ch->indx);
 	return;
     }
-    if (ch->random == NULL) {
+    if (ch->cold->random == NULL && ch->cold->resv == NULL &&
+	ch->cold->request > 0) {
 	warn("write_client", "chan[%d]: had a NULL random buffer", ch->indx);
 	return;
     }
@@ -930,10 +1950,10 @@ write_client(client *ch)
     /*
      * close if we have written everything
      */
-    if (ch->writecnt >= ch->request) {
+    if (REPLY_SENT(ch)) {
 	dbg(3, "write_client", "chan[%d]: "
 			       "write cnt: %d >= gather cnt: %d",
-			       ch->indx, ch->writecnt, ch->request);
+	     ch->indx, ch->cold->writecnt, ch->cold->request);
 	client_force_close(ch);
 	return;
     }
@@ -941,17 +1961,25 @@ write_client(client *ch)
     /*
      * write as much as we can
      */
-    errno = 0;
-    ret = write_once(ch->fd, ch->random+ch->writecnt,
-    		     ch->request-ch->writecnt, FALSE);
-    if (ret < 0) {
+    buf = ((ch->cold->random != NULL) ? ch->cold->random : ch->cold->resv);
+    if (buf != NULL) {
+	buf += ch->cold->writecnt;
+    }
+    ret = send_client(ch, buf, ch->cold->request-ch->cold->writecnt);
+    if (ret == LAVAERR_NONBLOCK) {
+	dbg(3, "write_client", "chan[%d]: write would block", ch->indx);
+	if (ch->cold->resv == NULL) {
+	    return;
+	}
+	/* nothing was written, but the pool region must still be released */
+	ret = 0;
+    } else if (ret < 0) {
 	dbg(3, "write_client", "chan[%d]: write error: %s",
 			       ch->indx, strerror(errno));
 	client_force_close(ch);
 	return;
-    }
-    if (ret == 0) {
-	dbg(3, "ch->writecnt", "chan[%d]: write EOF", ch->indx);
+    } else if (ret == 0) {
+	dbg(3, "ch->cold->writecnt", "chan[%d]: write EOF", ch->indx);
 	client_force_close(ch);
 	return;
     }
@@ -959,23 +1987,49 @@ write_client(client *ch)
     /*
      * update accounting
      */
-    ch->writecnt += ret;
+    if (ch->cold->replycnt < ch->cold->replylen) {
+	/* the reply header goes out first */
+	hdr = ch->cold->replylen - ch->cold->replycnt;
+	if (hdr > ret) {
+	    hdr = ret;
+	}
+	ch->cold->replycnt += hdr;
+	ret -= hdr;
+    }
+    ch->cold->writecnt += ret;
     dbg(3, "write_client", "chan[%d]: write %d writecnt: %d",
-    			   ch->indx, ret, ch->writecnt);
+    			   ch->indx, ret, ch->cold->writecnt);
+
+    /*
+     * do not hold a pool region while a slow client reads the rest
+     */
+    if (ch->cold->resv != NULL && ch->cold->random == NULL &&
+	ch->cold->writecnt < ch->cold->request) {
+	ch->cold->random = (u_int8_t *)malloc(ch->cold->request);
+	if (ch->cold->random == NULL) {
+	    warn("write_client", "chan[%d]: unable to malloc %d octets",
+				 ch->indx, ch->cold->request);
+	    client_force_close(ch);
+	    return;
+	}
+	memcpy(ch->cold->random+ch->cold->writecnt,
+	       ch->cold->resv+ch->cold->writecnt,
+	       ch->cold->request-ch->cold->writecnt);
+	dbg(3, "write_client", "chan[%d]: copied %d unsent octets",
+	    ch->indx, ch->cold->request-ch->cold->writecnt);
+    }
+    if (ch->cold->resv != NULL) {
+	release_pool(ch->cold->resv, ch->cold->request);
+	ch->cold->resv = NULL;
+    }
 
     /*
      * update accounting
      */
-    if (ch->writecnt >= ch->request) {
+    if (REPLY_SENT(ch)) {
         /* we have written everything */
-	ch->last_op = about_now;
 	dbg(3, "write_client", "chan[%d]: write complete", ch->indx);
-	dbg(3, "gather_client",
-	       "chan[%d]: state was %s ==> %s, now %s ==> %s",
-	       ch->indx, STATE_NAME(ch->curstate),
-	    STATE_NAME(ch->nxtstate), STATE_NAME(WRITE), STATE_NAME(CLOSE));
-	ch->curstate = WRITE;
-	ch->nxtstate = CLOSE;
+	finish_reply(ch);
     } else if (ch->curstate != WRITE) {
 	/* need to write more */
 	dbg(3, "gather_client",
@@ -989,12 +2043,520 @@ write_client(client *ch)
 }
 
 
+/*
+ * finish_reply - finish with a client whose reply has been written
+ *
+ * A decimal request client is closed.  A binary protocol client is
+ * kept open and moves on to the next reply of its stream, or to its
+ * next request.
+ *
+ * given:
+ *	ch client channel
+ */
+static void
+finish_reply(client *ch)
+{
+    /*
+     * firewall
+     */
+    if (ch == NULL) {
+	fatal(11, "finish_reply", "NULL arg");
+	/*NOTREACHED*/
+    }
+
+    /*
+     * decimal request clients are done
+     */
+    ch->cold->last_op = about_now;
+    if (ch->cold->proto == 0) {
+	dbg(3, "finish_reply", "chan[%d]: state was %s ==> %s, now %s ==> %s",
+			       ch->indx, STATE_NAME(ch->curstate),
+	    STATE_NAME(ch->nxtstate), STATE_NAME(WRITE), STATE_NAME(CLOSE));
+	ch->curstate = WRITE;
+	ch->nxtstate = CLOSE;
+	return;
+    }
+
+    /*
+     * move on to the next reply of a stream that is not yet done
+     */
+    if (ch->cold->stream && ch->cold->stream_left != 0) {
+	if (ch->cold->stream_rate > 0) {
+	    ch->cold->stream_next +=
+	    	(double)ch->cold->request / (double)ch->cold->stream_rate;
+	    if (ch->cold->stream_next < about_now) {
+		/* a slow reader does not earn a later burst */
+		ch->cold->stream_next = about_now;
+	    }
+	}
+	ch->curstate = WRITE;
+	stream_reply(ch);
+	return;
+    }
+    ch->cold->stream = FALSE;
+
+    /*
+     * clear the binary protocol request
+     */
+    drop_random(ch);
+    ch->cold->request = 0;
+    ch->cold->minqual = 0;
+    ch->cold->deadline = 0.0;
+    ch->cold->gathercnt = 0;
+    ch->cold->writecnt = 0;
+    ch->cold->replylen = 0;
+    ch->cold->replycnt = 0;
+
+    /*
+     * restart the time limit for the next request
+     */
+    if (cfg_lavapool.timeout > 0.0) {
+	ch->cold->timelimit = cfg_lavapool.timeout;
+	ch->timeout = about_now + cfg_lavapool.timeout;
+	need_cycle_before(ch->indx, ch->timeout);
+    }
+
+    /*
+     * start the next request
+     */
+    ch->curstate = WRITE;
+    next_request(ch);
+    return;
+}
+
+
+/*
+ * send_client - perform one send of LavaRnd data to a client
+ *
+ * Large sends out of the client buffer use MSG_ZEROCOPY when the
+ * socket supports it.  Everything else, including sends straight out
+ * of a reserved pool region, is a plain sendmsg().
+ *
+ * Any unwritten part of the reply header is sent ahead of buf.
+ *
+ * given:
+ *	ch	client channel
+ *	buf	data to send
+ *	len	length of buf
+ *
+ * returns:
+ *	octets sent, including reply header octets,
+ *	or <0 on error, LAVAERR_NONBLOCK ==> try again later
+ */
+static int
+send_client(client *ch, u_int8_t *buf, int len)
+{
+    struct msghdr msg;	/* sendmsg message */
+    struct iovec iov[2];	/* reply header and data to send */
+    int iovcnt = 0;	/* iov elements in use */
+    int flags = 0;	/* sendmsg flags */
+    int ret;		/* system call return */
+
+    /*
+     * firewall
+     */
+    if (ch == NULL || (buf == NULL && len > 0)) {
+	fatal(11, "send_client", "NULL arg");
+	/*NOTREACHED*/
+    }
+    if (len < 0 || (len == 0 && ch->cold->replycnt >= ch->cold->replylen)) {
+	return LAVAERR_BADARG;
+    }
+
+#if defined(USE_ZEROCOPY)
+    /*
+     * use MSG_ZEROCOPY for large sends from the client buffer, if we can
+     */
+    if (ch->cold->random != NULL && ch->cold->resv == NULL &&
+	len >= ZEROCOPY_MIN && ch->cold->zc_pendcnt < ZEROCOPY_MAXPEND &&
+	zerocopy_ok(ch)) {
+	flags |= MSG_ZEROCOPY;
+    }
+#endif /* USE_ZEROCOPY */
+
+    /*
+     * send what the socket will take
+     */
+    if (ch->cold->replycnt < ch->cold->replylen) {
+	iov[iovcnt].iov_base = ch->cold->reply + ch->cold->replycnt;
+	iov[iovcnt].iov_len = ch->cold->replylen - ch->cold->replycnt;
+	++iovcnt;
+    }
+    if (len > 0) {
+	iov[iovcnt].iov_base = buf;
+	iov[iovcnt].iov_len = len;
+	++iovcnt;
+    }
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
+    do {
+	errno = 0;
+	ret = sendmsg(ch->fd, &msg, flags);
+#if defined(USE_ZEROCOPY)
+	if (ret < 0 && errno == ENOBUFS && (flags & MSG_ZEROCOPY)) {
+	    /* out of locked page budget, just copy this time */
+	    dbg(4, "send_client", "chan[%d]: zerocopy ENOBUFS", ch->indx);
+	    flags &= ~MSG_ZEROCOPY;
+	    errno = EINTR;
+	}
+#endif /* USE_ZEROCOPY */
+    } while (ret < 0 && errno == EINTR);
+    if (ret < 0) {
+	if (errno == EAGAIN || errno == EWOULDBLOCK) {
+	    return LAVAERR_NONBLOCK;
+	}
+	return LAVAERR_IOERR;
+    }
+#if defined(USE_ZEROCOPY)
+    if (flags & MSG_ZEROCOPY) {
+	/* the client buffer is in use until the kernel is done with this send */
+	++ch->cold->zc_sent;
+	ch->cold->zc_end = ch->cold->zc_sent;
+    }
+#endif /* USE_ZEROCOPY */
+    return ret;
+}
+
+
+/*
+ * zerocopy_ok - determine if a client socket can send with MSG_ZEROCOPY
+ *
+ * SO_ZEROCOPY is enabled on the socket the first time we ask.
+ *
+ * given:
+ *	ch	client channel
+ *
+ * returns:
+ *	TRUE ==> MSG_ZEROCOPY may be used, FALSE ==> copy as usual
+ */
+static int
+zerocopy_ok(client *ch)
+{
+    /*
+     * firewall
+     */
+    if (ch == NULL) {
+	fatal(11, "zerocopy_ok", "NULL arg");
+	/*NOTREACHED*/
+    }
+
+#if defined(USE_ZEROCOPY)
+    if (ch->cold->zerocopy == 0 && ch->fd >= 0) {
+	int one = 1;	/* enable SO_ZEROCOPY */
+
+	/* not all sockets (such as unix domain sockets) support this */
+	if (setsockopt(ch->fd, SOL_SOCKET, SO_ZEROCOPY,
+		       &one, sizeof(one)) < 0) {
+	    dbg(4, "zerocopy_ok", "chan[%d]: no SO_ZEROCOPY: %s",
+				  ch->indx, strerror(errno));
+	    ch->cold->zerocopy = -1;
+	} else {
+	    ch->cold->zerocopy = 1;
+	}
+    }
+    return (ch->cold->zerocopy > 0);
+#else /* USE_ZEROCOPY */
+    return FALSE;
+#endif /* USE_ZEROCOPY */
+}
+
+
+/*
+ * reap_zerocopy - collect MSG_ZEROCOPY completions from the error queue
+ *
+ * Each MSG_ZEROCOPY send is numbered by the kernel starting with 0.
+ * A completion reports a range of these numbers that the kernel
+ * is done with.
+ *
+ * given:
+ *	fd	socket with MSG_ZEROCOPY sends
+ *	done	sends the kernel was known to be done with
+ *	sent	sends made on fd
+ *
+ * returns:
+ *	sends the kernel is now known to be done with
+ */
+static u_int32_t
+reap_zerocopy(int fd, u_int32_t done, u_int32_t sent)
+{
+#if defined(USE_ZEROCOPY)
+    struct msghdr msg;		/* error queue message */
+    struct cmsghdr *cmsg;	/* control message */
+    struct sock_extended_err *serr;	/* completion notification */
+    char control[128];		/* control message buffer */
+
+    /*
+     * drain the error queue of all pending notifications
+     */
+    while (fd >= 0 && done != sent) {
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	if (recvmsg(fd, &msg, MSG_ERRQUEUE|MSG_DONTWAIT) < 0) {
+	    break;
+	}
+	for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL;
+	     cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+	    if (cmsg->cmsg_len < CMSG_LEN(sizeof(*serr))) {
+		continue;
+	    }
+	    serr = (struct sock_extended_err *)CMSG_DATA(cmsg);
+	    if (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY || serr->ee_errno != 0) {
+		continue;
+	    }
+	    done += serr->ee_data - serr->ee_info + 1;
+	    dbg(4, "reap_zerocopy", "fd %d: sends %u..%u done%s",
+	    			    fd, serr->ee_info, serr->ee_data,
+				    ((serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) ?
+				    	" (copied)" : ""));
+	}
+    }
+#endif /* USE_ZEROCOPY */
+    return done;
+}
+
+
+/*
+ * free_zc_bufs - free the pending reply buffers that the kernel is done with
+ *
+ * given:
+ *	pend	list of pending buffers
+ *	done	MSG_ZEROCOPY sends the kernel is done with
+ *	force	TRUE ==> free every buffer
+ *	p_cnt	if non-NULL, decremented by the number of buffers freed
+ *
+ * returns:
+ *	list of the buffers still pending
+ */
+static struct zc_buf *
+free_zc_bufs(struct zc_buf *pend, u_int32_t done, int force, int *p_cnt)
+{
+    struct zc_buf **p;		/* link to the buffer being checked */
+    struct zc_buf *zc;		/* buffer being checked */
+
+    for (p = &pend; *p != NULL; ) {
+	zc = *p;
+	if (force || (int32_t)(done - zc->end) >= 0) {
+	    *p = zc->next;
+	    free(zc->buf);
+	    free(zc);
+	    if (p_cnt != NULL) {
+		--(*p_cnt);
+	    }
+	} else {
+	    p = &(zc->next);
+	}
+    }
+    return pend;
+}
+
+
+/*
+ * reap_client - free the client reply buffers that the kernel is done with
+ *
+ * given:
+ *	ch	client channel
+ */
+static void
+reap_client(client *ch)
+{
+    /*
+     * firewall
+     */
+    if (ch == NULL) {
+	fatal(11, "reap_client", "NULL arg");
+	/*NOTREACHED*/
+    }
+
+    /*
+     * collect completions and free what they cover
+     */
+    ch->cold->zc_done = reap_zerocopy(ch->fd, ch->cold->zc_done,
+				      ch->cold->zc_sent);
+    ch->cold->zc_pend = free_zc_bufs(ch->cold->zc_pend, ch->cold->zc_done,
+				     FALSE, &ch->cold->zc_pendcnt);
+    if (ch->cold->zc_pend != NULL) {
+	dbg(4, "reap_client", "chan[%d]: %d buffers, %u sends pending",
+	    ch->indx, ch->cold->zc_pendcnt,
+	    ch->cold->zc_sent - ch->cold->zc_done);
+    }
+    return;
+}
+
+
+/*
+ * drop_random - be done with the client buffer of the current reply
+ *
+ * The buffer is freed, unless the kernel may still send from it
+ * because of MSG_ZEROCOPY.  Then it is kept on the pending list of the
+ * client until reap_client() finds that the kernel is done with it.
+ *
+ * given:
+ *	ch	client channel
+ */
+static void
+drop_random(client *ch)
+{
+    struct zc_buf *zc;		/* pending buffer */
+
+    /*
+     * firewall
+     */
+    if (ch == NULL) {
+	fatal(11, "drop_random", "NULL arg");
+	/*NOTREACHED*/
+    }
+    if (ch->cold->random == NULL) {
+	return;
+    }
+
+    /*
+     * free the buffer if the kernel is done with it
+     */
+    if ((int32_t)(ch->cold->zc_done - ch->cold->zc_end) >= 0) {
+	free(ch->cold->random);
+	ch->cold->random = NULL;
+	return;
+    }
+
+    /*
+     * otherwise keep it until the kernel is done
+     */
+    zc = (struct zc_buf *)malloc(sizeof(struct zc_buf));
+    if (zc == NULL) {
+	/* better to lose the buffer than to reuse memory being sent */
+	warn("drop_random", "chan[%d]: unable to malloc, leaking %d octets",
+			    ch->indx, ch->cold->request);
+	ch->cold->random = NULL;
+	return;
+    }
+    zc->buf = ch->cold->random;
+    zc->end = ch->cold->zc_end;
+    zc->next = ch->cold->zc_pend;
+    ch->cold->zc_pend = zc;
+    ++ch->cold->zc_pendcnt;
+    ch->cold->random = NULL;
+    dbg(4, "drop_random", "chan[%d]: buffer pending until send %u is done",
+			  ch->indx, zc->end);
+    return;
+}
+
+
+/*
+ * zombie_pass - collect the MSG_ZEROCOPY completions of closed clients
+ *
+ * A zombie socket is closed, and its buffers freed, once the kernel is
+ * done with all of its sends.  A zombie that lingers too long is reset,
+ * and its buffers freed a grace period later.
+ *
+ * NOTE: This function is called once per channel cycle.
+ */
+void
+zombie_pass(void)
+{
+    struct zc_zombie **p;	/* link to the zombie being checked */
+    struct zc_zombie *z;	/* zombie being checked */
+    struct linger lin;		/* discard unsent data on close */
+
+    for (p = &zombie; *p != NULL; ) {
+	z = *p;
+
+	/*
+	 * collect completions and free what they cover
+	 */
+	if (z->fd >= 0) {
+	    z->done = reap_zerocopy(z->fd, z->done, z->sent);
+	    z->pend = free_zc_bufs(z->pend, z->done, FALSE, NULL);
+
+	    /*
+	     * close once the kernel is done
+	     */
+	    if (z->pend == NULL) {
+		dbg(3, "zombie_pass", "fd %d: zerocopy done, closing", z->fd);
+		(void) close(z->fd);
+		*p = z->next;
+		free(z);
+		continue;
+	    }
+
+	    /*
+	     * reset a socket whose peer will not take the data
+	     */
+	    if (z->linger <= about_now) {
+		dbg(2, "zombie_pass", "fd %d: reset with %u zerocopy pending",
+		    z->fd, z->sent - z->done);
+		lin.l_onoff = 1;
+		lin.l_linger = 0;
+		(void) setsockopt(z->fd, SOL_SOCKET, SO_LINGER,
+				  &lin, sizeof(lin));
+		(void) close(z->fd);
+		z->fd = -1;
+		z->expire = about_now + ZEROCOPY_GRACE;
+	    }
+	}
+
+	/*
+	 * free the buffers of a reset socket after the grace period
+	 */
+	if (z->fd < 0 && z->expire <= about_now) {
+	    z->pend = free_zc_bufs(z->pend, z->done, TRUE, NULL);
+	    *p = z->next;
+	    free(z);
+	    continue;
+	}
+
+	/*
+	 * check again soon
+	 */
+	if (z->fd >= 0) {
+	    need_cycle_before(-1, ((z->linger < about_now + ZEROCOPY_REAP) ?
+				   z->linger : about_now + ZEROCOPY_REAP));
+	} else {
+	    need_cycle_before(-1, z->expire);
+	}
+	p = &(z->next);
+    }
+    return;
+}
+
+
+/*
+ * free_zombies - reset zombie sockets and free their buffers
+ *
+ * NOTE: This function is only called as lavapool exits.
+ */
+void
+free_zombies(void)
+{
+    struct zc_zombie *z;	/* zombie being freed */
+    struct linger lin;		/* discard unsent data on close */
+
+    while (zombie != NULL) {
+	z = zombie;
+	zombie = z->next;
+	if (z->fd >= 0) {
+	    lin.l_onoff = 1;
+	    lin.l_linger = 0;
+	    (void) setsockopt(z->fd, SOL_SOCKET, SO_LINGER, &lin, sizeof(lin));
+	    (void) close(z->fd);
+	}
+	z->pend = free_zc_bufs(z->pend, z->done, TRUE, NULL);
+	free(z);
+    }
+}
+
+
 /*
  * close_client - close a client channel
  *
  * We will ensure that a client channel is closed.  If the descriptor is
  * open, we will attempt to close it.
  *
+ * If the kernel may still send from reply buffers of the client because
+ * of MSG_ZEROCOPY, the descriptor is shut down for writing, but not
+ * closed: the socket and buffers become a zombie (see zombie_pass()).
+ *
  * On success the channel is left in a CLOSE state.
  *
  * This function does nothing if the channel is not a TYPE_CLIENT type.
@@ -1006,6 +2568,7 @@ write_client(client *ch)
 void
 close_client(client *ch)
 {
+    struct zc_zombie *z;	/* zombie for pending MSG_ZEROCOPY buffers */
     int ret;		/* system call return */
 
     /*
@@ -1025,6 +2588,56 @@ close_client(client *ch)
 	return;
     }
 
+    /*
+     * return the pool region if needed
+     *
+     * A pool region is never sent with MSG_ZEROCOPY, so once the
+     * send call returned, the kernel has its own copy.
+     */
+    if (ch->cold->resv != NULL) {
+	release_pool(ch->cold->resv, ch->cold->request);
+	ch->cold->resv = NULL;
+    }
+
+    /*
+     * be done with the reply buffer and see what the kernel still uses
+     */
+    drop_random(ch);
+    if (ch->cold->zc_pend != NULL && ch->fd >= 0) {
+	reap_client(ch);
+    }
+
+    /*
+     * hand a socket that the kernel still sends from to the zombie list
+     */
+    if (ch->cold->zc_pend != NULL && ch->fd >= 0) {
+	z = (struct zc_zombie *)malloc(sizeof(struct zc_zombie));
+	if (z == NULL) {
+	    /* better to lose the buffers than to reuse memory being sent */
+	    warn("close_client", "chan[%d]: unable to malloc, "
+	    			 "leaking %d buffers", ch->indx,
+				 ch->cold->zc_pendcnt);
+	} else {
+	    dbg(3, "close_client", "chan[%d]: fd %d zombie with %u "
+	    			   "zerocopy sends pending", ch->indx, ch->fd,
+				   ch->cold->zc_sent - ch->cold->zc_done);
+	    (void) shutdown(ch->fd, SHUT_WR);
+	    z->fd = ch->fd;
+	    z->sent = ch->cold->zc_sent;
+	    z->done = ch->cold->zc_done;
+	    z->pend = ch->cold->zc_pend;
+	    z->linger = about_now + ZEROCOPY_LINGER;
+	    z->expire = 0.0;
+	    z->next = zombie;
+	    zombie = z;
+	    need_cycle_before(ch->indx, about_now + ZEROCOPY_REAP);
+	    clear_chanindx(ch->indx, ch->fd);
+	    ch->fd = -1;
+	}
+	ch->cold->zc_pend = NULL;
+	ch->cold->zc_pendcnt = 0;
+    }
+
     /*
      * close descriptor
      */
@@ -1041,21 +2654,16 @@ close_client(client *ch)
 	ch->fd = -1;
     }
 
-    /*
-     * free the allocated data if needed
-     */
-    if (ch->random != NULL) {
-	free(ch->random);
-	ch->random = NULL;
-    }
-
     /*
      * set state
      */
-    ch->last_op = about_now;
+    ch->cold->last_op = about_now;
     dbg(3, "close_client", "chan[%d]: state was %s ==> %s, now %s ==> %s",
 			 ch->indx, STATE_NAME(ch->curstate),
 	STATE_NAME(ch->nxtstate), STATE_NAME(CLOSE), STATE_NAME(ALLOCED));
+    if (CLIENT_IS_OPEN(ch->curstate)) {
+	--open_clients;
+    }
     ch->curstate = CLOSE;
     ch->nxtstate = ALLOCED;
     return;
@@ -110,6 +110,7 @@ main(int argc, char *argv[])
     int use_stderr = 1;			/* 1 => msgs to stderr */
     int fork_mode = 0;			/* 1 =< fork into background */
     double timeout;			/* channel cycle timeout value */
+    double retry;			/* secs to next chaos reopen, <0 ==> none */
     double runtime = 0.0;		/* cleanup & exit after runtime secs */
     double endtime = 0.0;		/* end time of chan loop or 0.0 */
     extern char *optarg;		/* option argument */
@@ -256,21 +257,36 @@ main(int argc, char *argv[])
     alloc_chanindx();
 
     /*
-     * create the initial chaos channel to gather LavaRnd data
+     * create a chaos channel for each chaos source to gather LavaRnd data
+     *
+     * Sources that fail to open now are retried later, but we need
+     * at least one to start.
      */
-    if (mk_open_chaos() == NULL) {
-	fatal(3, "main", "failed to open the initial chaos channel");
+    if (open_all_chaos() <= 0) {
+	fatal(3, "main", "failed to open any initial chaos channel");
 	/*NOTREACHED*/
     }
 
     /*
      * create the initial listener channel to obtain client requests
      */
-    if (mk_open_listener() == NULL) {
+    if (mk_open_listener(NULL, 0) == NULL) {
 	fatal(4, "main", "failed to open the initial listener channel");
 	/*NOTREACHED*/
     }
 
+    /*
+     * create a listener channel for each class port
+     */
+    for (i=1; i < cfg_lavapool.classcnt; ++i) {
+	if (cfg_lavapool.class[i].match == LAVA_CLASS_PORT &&
+	    mk_open_listener(cfg_lavapool.class[i].port, i) == NULL) {
+	    fatal(4, "main", "failed to open the %s class listener on: %s",
+		  cfg_lavapool.class[i].name, cfg_lavapool.class[i].port);
+	    /*NOTREACHED*/
+	}
+    }
+
     /*
      * time to chroot and drop privileges if possible
      */
@@ -284,10 +300,20 @@ main(int argc, char *argv[])
     }
     do {
 
+	/*
+	 * reopen failed chaos sources when due
+	 */
+	retry = check_chaos();
+
 	/*
 	 * determine timeout internal for the channel cycle
+	 *
+	 * We do not wait past the next chaos source reopen.
 	 */
 	timeout = timeout_value();
+	if (retry >= 0.0 && (timeout < 0.0 || retry < timeout)) {
+	    timeout = retry;
+	}
 
 	/*
 	 * perform a as many channel cycle phases as we can
@@ -380,6 +406,11 @@ timeout_value(void)
 {
     double fill_speed;	/* speed, 1.0 ==> fast, 0.0 ==> slow, <0 ==> stop */
 
+    /*
+     * update the fill controller with the last cycle's pool traffic
+     */
+    pool_control(right_now());
+
     /*
      * determine pool filling speed
      */
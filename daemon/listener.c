@@ -30,8 +30,13 @@
  */
 
 
+#define _GNU_SOURCE	/* for accept4() */
+
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
 #include <errno.h>
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -39,6 +44,7 @@
 
 #include "LavaRnd/rawio.h"
 #include "LavaRnd/cfg.h"
+#include "LavaRnd/have/have_accept4.h"
 
 #include "chan.h"
 #include "dbg.h"
@@ -49,6 +55,9 @@
 #endif
 
 
+#define ACCEPT_BATCH (64)	/* max accepts per pass if no maxclients */
+
+
 /*
  * The listen state changes are as follows:
  *
@@ -153,6 +162,7 @@ int const listener_preselect_ready[LAST_STATE + 1] = {
  * static functions
  */
 static void open_listener(listener *ch, char *cmd);
+static int classify_client(listener *ch, struct sockaddr *addr);
 
 
 /*
@@ -386,6 +396,7 @@ chan *
 mk_listener(listener *ch)
 {
     int indx;	/* remembered channel index */
+    struct listener_cold_s *cold;	/* remembered listener state */
 
     /*
      * firewall
@@ -395,14 +406,29 @@ mk_listener(listener *ch)
 	/*NOTREACHED*/
     }
 
+    /*
+     * allocate the rest of the listener state if needed
+     */
+    cold = ch->cold;
+    if (cold == NULL) {
+	cold = (struct listener_cold_s *)malloc(sizeof(*cold));
+	if (cold == NULL) {
+	    fatal(11, "mk_listener", "chan[%d]: unable to malloc state",
+		  ch->indx);
+	    /*NOTREACHED*/
+	}
+    }
+
     /*
      * clear values
      */
     indx = ch->indx;
     memset(ch, 0, sizeof(*ch));
+    memset(cold, 0, sizeof(*cold));
     ch->indx = indx;
+    ch->cold = cold;
     ch->fd = -1;
-    ch->last_op = -1.0;
+    ch->cold->last_op = -1.0;
 
     /*
      * force type
@@ -428,14 +454,21 @@ mk_listener(listener *ch)
  * closed listener channel, or if none is found, we will create a new
  * listener channel.
  *
+ * given:
+ *      port    host:port or /socket/path
+ *                or NULL ==> use cfg_random.lavapool
+ *      class   class of all clients accepted on this port,
+ *                or 0 ==> classify each client by its address
+ *
  * returns:
  *      OPEN listener channel or NULL if error
  *
- * NOTE: This function uses the NULL cmd interface of open_listener() which
- *       assumes that cfg_random.lavapool contains the socket port or path.
+ * NOTE: The port is remembered by the channel, so that the listener
+ *       is reopened on the same port.  It must not be freed while the
+ *       channel is in use.
  */
 chan *
-mk_open_listener(void)
+mk_open_listener(char *port, int class)
 {
     chan *c;	/* channel being opened */
 
@@ -466,6 +499,8 @@ mk_open_listener(void)
 	STATE_NAME(c->listener.curstate), STATE_NAME(c->listener.nxtstate),
 	STATE_NAME(OPEN));
     c->listener.nxtstate = OPEN;
+    c->listener.cold->port = port;
+    c->listener.cold->class = class;
 
     open_listener(&(c->listener), NULL);
     if (c->listener.curstate != OPEN) {
@@ -486,7 +521,7 @@ mk_open_listener(void)
  * given:
  *      ch      listener channel
  *      port    host:port or /socket/path
- *                or NULL ==> use cfg_random.lavapool
+ *                or NULL ==> use the channel port or cfg_random.lavapool
  */
 static void
 open_listener(listener *ch, char *port)
@@ -501,7 +536,7 @@ open_listener(listener *ch, char *port)
 	/*NOTREACHED*/
     }
     if (port == NULL) {
-	port = cfg_random.lavapool;
+	port = (ch->cold->port ? ch->cold->port : cfg_random.lavapool);
     }
     if (port == NULL) {
 	fatal(10, "open_listener", "NULL port arg and NULL lavapool");
@@ -527,13 +562,23 @@ open_listener(listener *ch, char *port)
 	return;
     }
 
+    /*
+     * accept_listener() accepts until the backlog is empty, so the
+     * listening socket must not block
+     */
+    if (noblock_fd(fd) < 0) {
+	warn("open_listener", "unable to non-block listen socket");
+	close(fd);
+	return;
+    }
+
     /*
      * place the information into the channel
      */
     ch->fd = fd;
     set_chanindx(ch->indx, fd);
-    ch->count = 0;
-    ch->last_op = about_now;
+    ch->cold->count = 0;
+    ch->cold->last_op = about_now;
     dbg(3, "open_listener", "chan[%d]: state was %s ==> %s, now %s ==> %s",
 	ch->indx, STATE_NAME(ch->curstate),
 	STATE_NAME(ch->nxtstate), STATE_NAME(OPEN), STATE_NAME(ACCEPT));
@@ -544,19 +589,23 @@ open_listener(listener *ch, char *port)
 
 
 /*
- * accept_listener - accept a connection on a listening socket
+ * accept_listener - accept connections on a listening socket
+ *
+ * We will accept connections on an open TYPE_LISTENER channel (in OPEN or
+ * ACCEPT state).  Each new connection will become an TYPE_CLIENT channel.
  *
- * We will accept a connection on an open TYPE_LISTENER channel (in OPEN or
- * ACCEPT state).  This new connection will become an TYPE_CLIENT channel.
+ * We accept until the listen backlog is empty, or until we have opened
+ * as many clients as cfg_lavapool.maxclients allows (or ACCEPT_BATCH
+ * clients when there is no maximum).  Draining the backlog in one pass
+ * keeps a burst of connections from waiting a full channel cycle each.
  *
  * This function does nothing if the channel is HALTed.
  *
  * given:
  *      ch       listener channel
  *
- * NOTE: It is assumed that the caller has used select() (perhaps via
- *       the chan_select() function) to determine that the descriptor
- *       is readable, otherwise this call may block.
+ * NOTE: The listening socket is non-blocking, so when the backlog
+ *       is empty, accept returns EAGAIN instead of blocking.
  *
  * NOTE: The calling chain is assumed to have previously determined that
  *       there are not too many client chains in existence.  For example,
@@ -564,6 +613,11 @@ open_listener(listener *ch, char *port)
  *       will case the read select mask bits remain cleared (and thus the
  *       chan_select() will not call chan_indx_op() which in turn will not
  *       call do_listener_op() which in turn will not call this function).
+ *
+ * NOTE: Opening a client may grow the chan array, which would move the
+ *       listener channel out from under ch.  We preallocate enough client
+ *       channels for the whole batch before accepting any of them, and
+ *       then use the listener channel where it resides after that.
  */
 void
 accept_listener(listener *ch)
@@ -572,6 +626,8 @@ accept_listener(listener *ch)
     struct sockaddr addr;	/* address of other end of accepted socket */
     socklen_t addrlen;	/* length of address in addr */
     chan *new;	/* new client channel */
+    int room;	/* clients we may accept in this pass */
+    int cnt;	/* clients accepted in this pass */
 
     /*
      * firewall
@@ -597,39 +653,69 @@ accept_listener(listener *ch)
     }
 
     /*
-     * accept a new connection
+     * determine how many clients we may accept
      */
-    memset(&addr, 0, sizeof(addr));
-    memset(&addrlen, 0, sizeof(addrlen));
-    fd = accept(ch->fd, &addr, &addrlen);
-    if (fd < 0) {
-	return;
+    if (cfg_lavapool.maxclients > 0) {
+	room = cfg_lavapool.maxclients - open_clients;
+	if (room <= 0) {
+	    dbg(3, "accept_listener", "chan[%d]: already at maxclients: %d",
+		ch->indx, cfg_lavapool.maxclients);
+	    return;
+	}
+    } else {
+	room = ACCEPT_BATCH;
     }
+    ch = &(prealloc_client_chan((chan *)ch, room)->listener);
 
     /*
-     * make the connection non-blocking
+     * accept new connections until the backlog is empty
      */
-    if (noblock_fd(fd) < 0) {
-	warn("accept_listener", "unable to non-block client socket");
-	close(fd);
-	return;
-    }
+    for (cnt = 0; cnt < room; ++cnt) {
+
+	/*
+	 * accept a new non-blocking connection
+	 */
+	memset(&addr, 0, sizeof(addr));
+	addrlen = sizeof(addr);
+#if defined(HAVE_ACCEPT4)
+	fd = accept4(ch->fd, &addr, &addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+	fd = accept(ch->fd, &addr, &addrlen);
+#endif
+	if (fd < 0) {
+	    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+		dbg(3, "accept_listener", "chan[%d]: accept error: %s",
+		    ch->indx, strerror(errno));
+	    }
+	    break;
+	}
+#if !defined(HAVE_ACCEPT4)
+	if (noblock_fd(fd) < 0) {
+	    warn("accept_listener", "unable to non-block client socket");
+	    close(fd);
+	    continue;
+	}
+	(void) fcntl(fd, F_SETFD, FD_CLOEXEC);
+#endif
 
-    /*
-     * place the information into the client channel
-     */
-    new = mk_open_client(fd);
-    if (new == NULL) {
-	warn("accept_listener", "unable to open a client");
-	close(fd);
-	return;
+	/*
+	 * place the information into the client channel
+	 */
+	new = mk_open_client(fd, classify_client(ch, &addr));
+	if (new == NULL) {
+	    warn("accept_listener", "unable to open a client");
+	    close(fd);
+	    break;
+	}
+	++ch->cold->count;
+	ch->cold->last_op = about_now;
     }
+    dbg(4, "accept_listener", "chan[%d]: accepted %d of %d",
+	ch->indx, cnt, room);
 
     /*
      * place the information into the channel
      */
-    ++ch->count;
-    ch->last_op = about_now;
     if (ch->curstate != ACCEPT) {
 	dbg(3, "accept_listener",
 	    "chan[%d]: state was %s ==> %s, now %s ==> %s",
@@ -642,6 +728,66 @@ accept_listener(listener *ch)
 }
 
 
+/*
+ * classify_client - determine the class of a newly accepted client
+ *
+ * A listener opened for a class port puts all of its clients in that
+ * class.  Otherwise the client is placed in the first class that its
+ * address matches, or in the default class if none match.
+ *
+ * given:
+ *      ch      listener channel that accepted the client
+ *      addr    address of the other end of the accepted socket
+ *
+ * returns:
+ *      client class, index into cfg_lavapool.class[]
+ */
+static int
+classify_client(listener *ch, struct sockaddr *addr)
+{
+    struct lava_class *c;	/* class being checked */
+    u_int32_t in;	/* client IPv4 address, host byte order */
+    int i;
+
+    /*
+     * clients of a class port are in that class
+     */
+    if (ch->cold->class > 0) {
+	return ch->cold->class;
+    }
+
+    /*
+     * find the first class that matches the client
+     */
+    for (i=1; i < cfg_lavapool.classcnt; ++i) {
+	c = &cfg_lavapool.class[i];
+	switch (c->match) {
+	case LAVA_CLASS_UNIX:
+	    if (addr->sa_family == AF_UNIX) {
+		return i;
+	    }
+	    break;
+	case LAVA_CLASS_TCP:
+	    if (addr->sa_family == AF_INET) {
+		return i;
+	    }
+	    break;
+	case LAVA_CLASS_ADDR:
+	    if (addr->sa_family == AF_INET) {
+		in = ntohl(((struct sockaddr_in *)addr)->sin_addr.s_addr);
+		if ((in & c->mask) == c->addr) {
+		    return i;
+		}
+	    }
+	    break;
+	default:
+	    break;
+	}
+    }
+    return 0;
+}
+
+
 /*
  * close_listener - close a listener channel
  *
@@ -698,7 +844,7 @@ close_listener(listener *ch)
     /*
      * set state
      */
-    ch->last_op = about_now;
+    ch->cold->last_op = about_now;
     dbg(3, "close_listener", "chan[%d]: state was %s ==> %s, now %s ==> %s",
 	ch->indx, STATE_NAME(ch->curstate),
 	STATE_NAME(ch->nxtstate), STATE_NAME(CLOSE), STATE_NAME(ALLOCED));
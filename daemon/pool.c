@@ -32,11 +32,16 @@
 #include <stdio.h>
 #include <malloc.h>
 #include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <math.h>
 
 #include "LavaRnd/lavaerr.h"
 #include "LavaRnd/rawio.h"
 #include "LavaRnd/sha1.h"
 #include "LavaRnd/lavarnd.h"
+#include "LavaRnd/s100.h"
+#include "LavaRnd/lavaquality.h"
 
 #include "pool.h"
 #include "dbg.h"
@@ -46,7 +51,6 @@
 #  include <dmalloc.h>
 #endif
 
-#define MAX_ALPHA 8.0		/* highest allowed alpha rate to use */
 #define NORM_ALPHA 1.0		/* normal alpha rate to use */
 
 
@@ -58,6 +62,64 @@ static int32_t poollen = 0;	/* lavapool data in pool, .. pool[poollen-1] */
 static int32_t maxlen = 0;	/* allocated length of pool */
 
 
+/*
+ * reserved pool regions
+ *
+ * A reserved region is LavaRnd data that has been removed from the
+ * pool (it no longer counts in poollen) but is still being sent
+ * to a client directly out of the pool buffer.  Filling operations
+ * may not write into or above the lowest reserved region until
+ * that region has been released.  Regions are held only for the
+ * duration of a send call, never across channel cycles, so filling
+ * always sees the whole pool.
+ */
+#define RESV_CHUNK 8		/* grow the reserved region table by this */
+static int32_t *resv = NULL;	/* start offsets of reserved regions */
+static int resvcnt = 0;		/* number of reserved regions */
+static int resvmax = 0;		/* allocated length of resv[] */
+static int32_t ceiling = 0;	/* fill limit: lowest reserved offset or maxlen */
+
+
+/*
+ * s100 expansion generator
+ *
+ * S100 requests, and requests that reach their deadline before the pool
+ * can fill them, are served with s100 data.  The generator is seeded
+ * with LavaRnd data taken from the pool.  It is reseeded as the pool
+ * fills, once its seed is used up or after it has output EXPAND_RESEED
+ * octets, so that one seed is never stretched over a great deal of data.
+ */
+#define EXPAND_RESEED (1024*1024)	/* output between reseeds */
+static s100shuf expand;		/* s100 generator seeded from the pool */
+static long expand_out = 0;	/* octets output since the last seed */
+
+
+/*
+ * fill controller
+ *
+ * We keep exponentially weighted moving averages (EWMA) of the rates
+ * at which clients drain the pool and chaos fills it.  The fill speed
+ * is chosen from the pool level predicted cfg_lavapool.fill_horizon
+ * seconds ahead at the current drain rate, so that filling speeds up
+ * before a burst of client traffic empties the pool.
+ */
+#define CTL_PUBLISH (10.0)	/* seconds between controller state reports */
+static double ctl_last = 0.0;	/* time of last controller update, 0 ==> none */
+static double ctl_published = 0.0;	/* time of last state report */
+static long ctl_drained = 0;	/* octets drained since the last update */
+static long ctl_filled = 0;	/* octets filled since the last update */
+static int ctl_short = FALSE;	/* TRUE ==> clients were short since update */
+static double drain_ewma = 0.0;	/* EWMA drain rate in octets/sec */
+static double fill_ewma = 0.0;	/* EWMA fill rate in octets/sec */
+static double stall_secs = 0.0;	/* time clients were short of pool data */
+
+
+/*
+ * static functions
+ */
+static void reseed_expand(int need);
+
+
 /*
  * init_pool - initialize the lavapool
  *
@@ -83,6 +145,8 @@ init_pool(u_int32_t size)
     }
     maxlen = size;
     poollen = 0;
+    ceiling = maxlen;
+    resvcnt = 0;
     return;
 }
 
@@ -91,16 +155,20 @@ init_pool(u_int32_t size)
  * fill_pool_from_fd - perform a lavapool filling operation from an open file
  *
  * given:
- *      fd      descriptor containing LavaRnd data
+ *      fd      non-blocking descriptor containing LavaRnd data
  *
  * returns:
- *      chars added or <0 ==> error
+ *      chars added, 0 ==> pool is too full, or <0 ==> error or EOF
+ *
+ * We read until the descriptor has no more data or the pool is full.
+ * Each read may take all that a large pipe holds, so there is no need
+ * to select before each read.
  */
 int
 fill_pool_from_fd(int fd)
 {
     u_int32_t need;	/* max amount of LavaRnd data needed */
-    u_int32_t len;	/* amount of LavaRnd to try to read */
+    u_int32_t total;	/* amount of LavaRnd data read so far */
     int ret;	/* function return call */
 
     /*
@@ -114,25 +182,37 @@ fill_pool_from_fd(int fd)
     /*
      * find a need ...
      */
-    if (poollen >= maxlen) {
+    if (poollen >= ceiling) {
 	dbg(5, "fill_pool_from_fd", "pool is too full: %d", poollen);
 	return 0;
     }
-    need = maxlen - poollen;
+    need = ceiling - poollen;
 
     /*
      * ... and fill it
      */
-    len = ((need > MAXPOOL_IO) ? MAXPOOL_IO : need);
-    dbg(5, "fill_pool_from_fd", "pool level: %d, need: %d, len: %d",
-	poollen, need, len);
-    ret = nilblock_read(fd, pool + poollen, len, FALSE);
-    if (ret > 0) {
-	poollen += ret;
-    }
-    dbg(5, "fill_pool_from_fd", "nilblock_read on %d: %d, pool level: %d",
-	fd, ret, poollen);
-    return ret;
+    dbg(5, "fill_pool_from_fd", "pool level: %d, need: %d", poollen, need);
+    total = 0;
+    do {
+	ret = read(fd, pool + poollen + total, need - total);
+	if (ret > 0) {
+	    total += ret;
+	}
+    } while ((ret > 0 && total < need) || (ret < 0 && errno == EINTR));
+    if (ret == 0 && total == 0) {
+	/* the chaos co-process closed its end of the pipe */
+	dbg(2, "fill_pool_from_fd", "EOF on %d", fd);
+	return LAVAERR_EOF;
+    }
+    if (ret < 0 && total == 0) {
+	return ((errno == EAGAIN) ? LAVAERR_NONBLOCK : LAVAERR_IOERR);
+    }
+    poollen += total;
+    ctl_filled += total;
+    reseed_expand(0);
+    dbg(5, "fill_pool_from_fd", "read on %d: %d, pool level: %d",
+	fd, total, poollen);
+    return total;
 }
 
 
@@ -142,15 +222,28 @@ fill_pool_from_fd(int fd)
  * usage:
  *      buf     buffer of chaos data
  *      buflen  length of chaos buffer
+ *      entropy estimated min-entropy of buf in bits, <0 ==> no estimate
+ *      srcrate rate factor of the chaos source of buf
  *
  * returns:
- *      >0 ==> chars added, 0 ==> pool is too full, or <0 ==> error
+ *      >0 ==> chars added, 0 ==> pool is too full or buf is too poor,
+ *	or <0 ==> error
+ *
+ * Without an entropy estimate, the alpha rate ranges from NORM_ALPHA,
+ * when the pool is filling at normal speed, to MAX_ALPHA at the fastest
+ * speed.  With an estimate, the fastest speed uses the highest rate the
+ * estimate allows, but never above MAX_ALPHA, and normal speed uses
+ * NORM_ALPHA unless the estimate allows less.  A buffer
+ * whose estimate does not allow any output is not used.  The rate is
+ * scaled by the srcrate of the source, but never above what the
+ * estimate allows.
  */
 int
-fill_pool_from_chaos(void *buf, int buflen)
+fill_pool_from_chaos(void *buf, int buflen, double entropy, double srcrate)
 {
     double factor;	/* pool fill rate factor */
     double rate;	/* alpha filling rate */
+    double maxrate;	/* highest rate that the entropy estimate allows */
     int addlen;	/* amount of data added to the pool, <0 ==> error */
 
     /*
@@ -172,23 +265,57 @@ fill_pool_from_chaos(void *buf, int buflen)
 	dbg(5, "fill_pool_from_chaos", "pool is too full: %d", poollen);
 	return 0;
     }
-    rate = MAX_ALPHA * factor + NORM_ALPHA * (1.0 - factor);
+    if (entropy < 0.0) {
+	rate = (MAX_ALPHA * factor + NORM_ALPHA * (1.0 - factor)) * srcrate;
+    } else {
+	maxrate = lava_entropy_rate(buflen, entropy);
+	if (maxrate <= 0.0) {
+	    dbg(1, "fill_pool_from_chaos",
+		"entropy: %.0f bits in %d octets is too low, not used",
+		entropy, buflen);
+	    return 0;
+	}
+
+	/*
+	 * The estimate is not a lower bound: the octet term comes from
+	 * the tally of a single frame, and the bit change term gives
+	 * full marks to any frame where about half the bits change.
+	 * Until there is a conservative estimator, the estimate may only
+	 * lower the rate, never raise it above MAX_ALPHA.
+	 */
+	if (maxrate > MAX_ALPHA) {
+	    maxrate = MAX_ALPHA;
+	}
+	rate = (maxrate * factor +
+		((maxrate < NORM_ALPHA) ? maxrate : NORM_ALPHA) * (1.0 - factor)) *
+	       srcrate;
+	if (rate > maxrate) {
+	    rate = maxrate;
+	}
+	dbg(2, "fill_pool_from_chaos",
+	    "entropy: %.0f bits in %d octets, max rate: %.3f, rate: %.3f",
+	    entropy, buflen, maxrate, rate);
+    }
 
     /*
      * add to the pool if there is room
      */
     dbg(3, "fill_pool_from_chaos", "factor: %.3f, rate: %.3f", factor, rate);
     addlen = lavarnd(cfg_lavapool.prefix, buf, buflen, rate, pool + poollen,
-		     maxlen - poollen);
+		     ceiling - poollen);
     if (addlen < 0) {
 	warn("fill_pool_from_chaos",
 	     "lavarnd(%d,buf,%d,%.3f,pool+%d,%d) error: %d",
-	     cfg_lavapool.prefix, buflen, rate, poollen, maxlen - poollen,
+	     cfg_lavapool.prefix, buflen, rate, poollen, ceiling - poollen,
 	     addlen);
 	return addlen;
     }
     poollen += addlen;
+    ctl_filled += addlen;
     dbg(3, "fill_pool_from_chaos", "added: %d, poollen: %d", addlen, poollen);
+    if (addlen > 0) {
+	reseed_expand(0);
+    }
     return addlen;
 }
 
@@ -236,12 +363,248 @@ drain_pool(u_int8_t * buf, int cnt)
      * perform accounting
      */
     poollen -= cpycnt;
+    ctl_drained += cpycnt;
     dbg(3, "drain_pool", "drained %d octets, pool now has %d", cpycnt,
 	poollen);
     return cpycnt;
 }
 
 
+/*
+ * reserve_pool - reserve LavaRnd data to be sent directly from the pool
+ *
+ * The top cnt octets of the pool are removed from the pool and
+ * reserved for the caller.  Unlike drain_pool(), the data is not copied:
+ * the caller sends it straight out of the pool buffer and then calls
+ * release_pool() to zero the region and return it to the pool.
+ *
+ * Until it is released, no filling operation will write over the
+ * reserved region, or anywhere above it.  The caller must release the
+ * region before it returns to the channel cycle, copying whatever it
+ * could not send, and must not hand the region to anything that
+ * outlives the send call, such as MSG_ZEROCOPY.
+ *
+ * given:
+ *      cnt     amount of data requested
+ *
+ * returns:
+ *      pointer to cnt reserved octets, or NULL if the pool has < cnt octets
+ *
+ * NOTE: Only whole requests are reserved.  If the pool does not
+ *       have cnt octets, the caller should fall back to drain_pool().
+ */
+u_int8_t *
+reserve_pool(int cnt)
+{
+    int32_t *p;	/* realloced reserved region table */
+
+    /*
+     * firewall
+     */
+    if (cnt <= 0) {
+	warn("reserve_pool", "bogus reserve length: %d", cnt);
+	return NULL;
+    }
+    if (cnt > poollen) {
+	dbg(4, "reserve_pool", "pool level: %d < %d", poollen, cnt);
+	return NULL;
+    }
+
+    /*
+     * grow the reserved region table if needed
+     */
+    if (resvcnt >= resvmax) {
+	p = (int32_t *)realloc(resv, (resvmax+RESV_CHUNK) * sizeof(resv[0]));
+	if (p == NULL) {
+	    warn("reserve_pool", "unable to grow reserve table to %d",
+		 resvmax+RESV_CHUNK);
+	    return NULL;
+	}
+	resv = p;
+	resvmax += RESV_CHUNK;
+    }
+
+    /*
+     * reserve the top of the pool
+     *
+     * Because reserve_pool() takes from the top of the pool and
+     * filling cannot go beyond the ceiling, the newest region is
+     * always the lowest reserved region.
+     */
+    poollen -= cnt;
+    ctl_drained += cnt;
+    resv[resvcnt++] = poollen;
+    ceiling = poollen;
+    dbg(3, "reserve_pool", "reserved %d octets at %d, pool now has %d",
+	cnt, poollen, poollen);
+    return pool + poollen;
+}
+
+
+/*
+ * release_pool - zero and release a region obtained from reserve_pool()
+ *
+ * given:
+ *      buf     reserved region returned by reserve_pool()
+ *      cnt     length passed to reserve_pool()
+ */
+void
+release_pool(u_int8_t *buf, int cnt)
+{
+    int32_t off;	/* offset of the region in the pool */
+    int i;
+
+    /*
+     * firewall
+     */
+    if (buf == NULL || pool == NULL) {
+	fatal(11, "release_pool", "NULL arg");
+	/*NOTREACHED*/
+    }
+    off = buf - pool;
+    for (i=0; i < resvcnt; ++i) {
+	if (resv[i] == off) {
+	    break;
+	}
+    }
+    if (i >= resvcnt || cnt <= 0 || off+cnt > maxlen) {
+	warn("release_pool", "not a reserved region: %d octets at %d",
+	     cnt, off);
+	return;
+    }
+
+    /*
+     * zero the sent data so that it never lingers in memory
+     */
+    memset(buf, 0, cnt);
+
+    /*
+     * drop the region and recompute the fill ceiling
+     */
+    resv[i] = resv[--resvcnt];
+    ceiling = maxlen;
+    for (i=0; i < resvcnt; ++i) {
+	if (resv[i] < ceiling) {
+	    ceiling = resv[i];
+	}
+    }
+    dbg(3, "release_pool", "released %d octets at %d, fill ceiling: %d",
+	cnt, off, ceiling);
+    return;
+}
+
+
+/*
+ * expand_pool - fill a buffer with s100 data seeded from the pool
+ *
+ * The data is returned only if it is of at least the minimum quality.
+ * The s100 data quality is LAVA_QUAL_S100HIGH while the generator seed
+ * from the pool is current, LAVA_QUAL_S100MED once the seed is used up
+ * or when the pool held less than a full seed, and LAVA_QUAL_S100LOW
+ * if the pool never had any data to seed with.
+ *
+ * given:
+ *      buf     where to place the s100 data
+ *      cnt     amount of data requested
+ *      minqual minimum acceptable quality (lavaqual)
+ *
+ * returns:
+ *      quality of the s100 data, or <0 ==> below minqual, nothing done
+ */
+int
+expand_pool(u_int8_t *buf, int cnt, int minqual)
+{
+    int qual;	/* quality of the s100 data */
+
+    /*
+     * firewall
+     */
+    if (buf == NULL) {
+	fatal(11, "expand_pool", "NULL arg");
+	/*NOTREACHED*/
+    }
+    if (cnt <= 0) {
+	warn("expand_pool", "bogus expand length: %d", cnt);
+	return -1;
+    }
+
+    /*
+     * reseed if the pool can and we need it, or seed with nothing
+     * if we have never been seeded
+     */
+    reseed_expand(cnt);
+    if (!expand.seeded) {
+	s100_load(&expand, NULL, 0);
+    }
+
+    /*
+     * determine the quality of the data we would return
+     */
+    qual = s100_quality(&expand);
+    if (s100_loadleft(&expand) < cnt && qual > LAVA_QUAL_S100MED) {
+	/* the seed will be used up part way through */
+	qual = LAVA_QUAL_S100MED;
+    }
+    if (qual < minqual) {
+	dbg(3, "expand_pool", "quality: %d < minimum: %d", qual, minqual);
+	return -1;
+    }
+
+    /*
+     * expand
+     */
+    (void) s100_randomcpy(&expand, buf, cnt);
+    expand_out += cnt;
+    dbg(3, "expand_pool", "expanded %d octets of quality %d", cnt, qual);
+    return qual;
+}
+
+
+/*
+ * reseed_expand - seed the s100 expansion generator from the pool if needed
+ *
+ * A full seed is taken from the pool when the generator has only a
+ * partial seed, when the current seed cannot cover the next need octets,
+ * or once EXPAND_RESEED octets have been output on the current seed.
+ * If the generator was never seeded, then whatever the pool holds is used.
+ *
+ * given:
+ *      need    octets about to be output, or 0 ==> none
+ */
+static void
+reseed_expand(int need)
+{
+    u_int8_t seed[sizeof(struct s100_seed)];	/* seed taken from the pool */
+    int len;	/* seed length */
+
+    /*
+     * nothing to do if the seed is still good
+     */
+    if (expand.seeded && expand.seed_len >= (int)sizeof(seed) &&
+	s100_loadleft(&expand) > need && expand_out < EXPAND_RESEED) {
+	return;
+    }
+
+    /*
+     * only a never seeded generator will take a partial seed
+     */
+    len = (poollen < (int32_t)sizeof(seed)) ? poollen : (int)sizeof(seed);
+    if (len <= 0 || (expand.seeded && len < (int)sizeof(seed))) {
+	return;
+    }
+
+    /*
+     * seed from the pool
+     */
+    len = drain_pool(seed, len);
+    s100_load(&expand, seed, len);
+    memset(seed, 0, sizeof(seed));
+    expand_out = 0;
+    dbg(3, "reseed_expand", "seeded s100 generator with %d octets", len);
+    return;
+}
+
+
 /*
  * pool_level - return the amount of data in the pool
  *
@@ -271,6 +634,12 @@ pool_frac(void)
 /*
  * pool_rate_factor - determine the suggested alpha rate for a driver
  *
+ * The fill speed is chosen from the pool level predicted by the fill
+ * controller (see pool_control()).  A predicted level at or below
+ * fastpool fills at the fastest rate, at or above slowpool fills at the
+ * normal rate, and in between at a proportional rate.  When the
+ * fill_horizon is 0, the current pool level is used instead.
+ *
  * returns:
  *      1.0 ==> fill at highest speed,
  *      >0.0 ==> fill at a faster than normal speed,
@@ -280,16 +649,20 @@ pool_frac(void)
 double
 pool_rate_factor(void)
 {
-    if (poollen > maxlen - SHA_DIGESTSIZE) {
+    double level;	/* predicted pool level */
+
+    if (poollen > ceiling - SHA_DIGESTSIZE) {
 	/* pool is too full to fill */
 	return -1.0;
-    } else if (poollen > cfg_lavapool.slowpool) {
+    }
+    level = (double)poollen - drain_ewma * cfg_lavapool.fill_horizon;
+    if (level > (double)cfg_lavapool.slowpool) {
 	/* fill at the normal rate */
 	return 0.0;
-    } else if (poollen > cfg_lavapool.fastpool &&
+    } else if (level > (double)cfg_lavapool.fastpool &&
 	       cfg_lavapool.slowpool > cfg_lavapool.fastpool) {
 	/* fill between fastest and normal rate */
-	return (double)(cfg_lavapool.slowpool - poollen) /
+	return ((double)cfg_lavapool.slowpool - level) /
 	  (double)(cfg_lavapool.slowpool - cfg_lavapool.fastpool);
     } else {
 	/* fill at the fastest rate */
@@ -298,6 +671,81 @@ pool_rate_factor(void)
 }
 
 
+/*
+ * pool_short - note that waiting clients need more than the pool holds
+ *
+ * The time that clients spend short of pool data is reported by
+ * pool_control().
+ */
+void
+pool_short(void)
+{
+    ctl_short = TRUE;
+}
+
+
+/*
+ * pool_control - update the fill controller
+ *
+ * The drain and fill rates since the last update are folded into their
+ * EWMAs.  The weight of a new rate grows with the time since the last
+ * update, with a time constant of fill_horizon seconds (or 1 second if
+ * the fill_horizon is 0).  Every CTL_PUBLISH seconds, the controller
+ * state is reported at debug level 1 for tuning.
+ *
+ * given:
+ *      now     the current time
+ *
+ * NOTE: This function is called once per channel cycle.
+ */
+void
+pool_control(double now)
+{
+    double dt;		/* seconds since the last update */
+    double tau;		/* EWMA time constant */
+    double weight;	/* weight of the new rates */
+
+    /*
+     * firewall - the first call only starts the clock
+     */
+    if (ctl_last <= 0.0 || now <= ctl_last) {
+	if (ctl_last <= 0.0) {
+	    ctl_last = now;
+	    ctl_published = now;
+	}
+	return;
+    }
+
+    /*
+     * update the moving averages
+     */
+    dt = now - ctl_last;
+    tau = (cfg_lavapool.fill_horizon > 0.0) ? cfg_lavapool.fill_horizon : 1.0;
+    weight = 1.0 - exp(-dt / tau);
+    drain_ewma += weight * ((double)ctl_drained / dt - drain_ewma);
+    fill_ewma += weight * ((double)ctl_filled / dt - fill_ewma);
+    if (ctl_short) {
+	stall_secs += dt;
+    }
+    ctl_drained = 0;
+    ctl_filled = 0;
+    ctl_short = FALSE;
+    ctl_last = now;
+
+    /*
+     * publish our state now and then
+     */
+    if (now - ctl_published >= CTL_PUBLISH) {
+	dbg(1, "pool_control",
+	    "level: %d  drain: %.0f/s  fill: %.0f/s  speed: %.3f  "
+	    "stalled: %.3f sec",
+	    poollen, drain_ewma, fill_ewma, pool_rate_factor(), stall_secs);
+	ctl_published = now;
+    }
+    return;
+}
+
+
 /*
  * free_pool - close down and free the lavapool
  */
@@ -308,6 +756,18 @@ free_pool(void)
 	free(pool);
 	pool = NULL;
     }
+    if (resv != NULL) {
+	free(resv);
+	resv = NULL;
+    }
+    resvcnt = 0;
+    resvmax = 0;
     poollen = 0;
     maxlen = 0;
+    ceiling = 0;
+    ctl_last = 0.0;
+    drain_ewma = 0.0;
+    fill_ewma = 0.0;
+    memset(&expand, 0, sizeof(expand));
+    expand_out = 0;
 }
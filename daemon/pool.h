@@ -38,6 +38,7 @@
 
 
 #  define MAXPOOL_IO (65536)	/* max read/write from a pool at one time */
+#  define MAX_ALPHA (8.0)	/* highest allowed alpha rate to use */
 
 
 /*
@@ -45,11 +46,17 @@
  */
 extern void init_pool(u_int32_t size);
 extern int fill_pool_from_fd(int fd);
-extern int fill_pool_from_chaos(void *buf, int buflen);
+extern int fill_pool_from_chaos(void *buf, int buflen, double entropy,
+				double srcrate);
 extern int drain_pool(u_int8_t * buf, int cnt);
+extern u_int8_t *reserve_pool(int cnt);
+extern void release_pool(u_int8_t *buf, int cnt);
+extern int expand_pool(u_int8_t *buf, int cnt, int minqual);
 extern u_int32_t pool_level(void);
 extern double pool_frac(void);
 extern double pool_rate_factor(void);
+extern void pool_short(void);
+extern void pool_control(double now);
 extern void free_pool(void);
 
 
@@ -0,0 +1,12 @@
+/*
+ * cam_videodev.h - where to find videodev.h
+ *
+ * Generated by Makefile, do not edit!
+ */
+
+#if !defined(__CAM_VIDEODEV_H__)
+#define __CAM_VIDEODEV_H__
+
+#include "videodev_2.4.h"
+
+#endif /* __CAM_VIDEODEV_H__ */
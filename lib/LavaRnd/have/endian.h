@@ -0,0 +1,7 @@
+#if !defined(BIG_ENDIAN)
+# define BIG_ENDIAN	4321
+#endif
+#if !defined(LITTLE_ENDIAN)
+# define LITTLE_ENDIAN	1234
+#endif
+#define CALC_BYTE_ORDER	LITTLE_ENDIAN
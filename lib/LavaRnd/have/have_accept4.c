@@ -0,0 +1,45 @@
+/*
+ * have_accept4 - determine if we have the accept4() call
+ *
+ * @(#) $Revision$
+ * @(#) $Id$
+ *
+ * Copyright (c) 2000-2003 by Landon Curt Noll and Simon Cooper.
+ * All Rights Reserved.
+ *
+ * This is open software; you can redistribute it and/or modify it under
+ * the terms of the version 2.1 of the GNU Lesser General Public License
+ * as published by the Free Software Foundation.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General
+ * Public License for more details.
+ *
+ * The file COPYING contains important info about Licenses and Copyrights.
+ * Please read the COPYING file for details about this open software.
+ *
+ * A copy of version 2.1 of the GNU Lesser General Public License is
+ * distributed with calc under the filename COPYING-LGPL.  You should have
+ * received a copy with calc; if not, write to Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * For more information on LavaRnd: http://www.LavaRnd.org
+ *
+ * Share and enjoy! :-)
+ */
+
+#define _GNU_SOURCE	/* accept4() is not POSIX */
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+
+int
+main()
+{
+    (void)accept4(-1, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    exit(0);
+}
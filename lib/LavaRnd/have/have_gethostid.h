@@ -0,0 +1,2 @@
+/* Do not edit - auto generated by Makefile */
+#define HAVE_GETHOSTID /* we have gethostid() call */
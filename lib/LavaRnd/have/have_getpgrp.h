@@ -0,0 +1,2 @@
+/* Do not edit - auto generated by Makefile */
+#define HAVE_GETPGRP /* we have getpgrp() call */
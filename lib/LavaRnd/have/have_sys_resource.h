@@ -0,0 +1,2 @@
+/* Do not edit - auto generated by Makefile */
+#define HAVE_SYS_RESOURCE_H /* we have <sys/resource.h> */
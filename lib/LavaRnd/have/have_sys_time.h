@@ -0,0 +1,2 @@
+/* Do not edit - auto generated by Makefile */
+#define HAVE_SYS_TIME_H /* we have <sys/time.h> */
@@ -0,0 +1,2 @@
+/* Do not edit - auto generated by Makefile */
+#undef HAVE_USTAT_H /* do not have <ustat.h> */
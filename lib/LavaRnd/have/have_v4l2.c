@@ -0,0 +1,69 @@
+/*
+ * have_v4l2 - determine if we can build the Video4Linux2 streaming driver
+ *
+ * @(#) $Revision$
+ * @(#) $Id$
+ *
+ * Copyright (c) 2000-2003 by Landon Curt Noll and Simon Cooper.
+ * All Rights Reserved.
+ *
+ * This is open software; you can redistribute it and/or modify it under
+ * the terms of the version 2.1 of the GNU Lesser General Public License
+ * as published by the Free Software Foundation.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General
+ * Public License for more details.
+ *
+ * The file COPYING contains important info about Licenses and Copyrights.
+ * Please read the COPYING file for details about this open software.
+ *
+ * A copy of version 2.1 of the GNU Lesser General Public License is
+ * distributed with calc under the filename COPYING-LGPL.  You should have
+ * received a copy with calc; if not, write to Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * For more information on LavaRnd: http://www.LavaRnd.org
+ *
+ * Share and enjoy! :-)
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/ioctl.h>
+#include <linux/videodev2.h>
+
+
+int
+main()
+{
+    struct v4l2_capability cap;		/* device capabilities */
+    struct v4l2_format fmt;		/* capture format */
+    struct v4l2_streamparm parm;	/* capture frame rate */
+    struct v4l2_requestbuffers req;	/* streaming buffer request */
+    struct v4l2_buffer buf;		/* streaming buffer */
+    int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;	/* stream type */
+
+    memset(&cap, 0, sizeof(cap));
+    memset(&fmt, 0, sizeof(fmt));
+    memset(&parm, 0, sizeof(parm));
+    memset(&req, 0, sizeof(req));
+    memset(&buf, 0, sizeof(buf));
+    fmt.fmt.pix.pixelformat = V4L2_PIX_FMT_YUYV;
+    parm.parm.capture.timeperframe.denominator = 30;
+    req.memory = V4L2_MEMORY_MMAP;
+    buf.m.offset = 0;
+    (void) ioctl(-1, VIDIOC_QUERYCAP, &cap);
+    (void) ioctl(-1, VIDIOC_S_FMT, &fmt);
+    (void) ioctl(-1, VIDIOC_S_PARM, &parm);
+    (void) ioctl(-1, VIDIOC_REQBUFS, &req);
+    (void) ioctl(-1, VIDIOC_QUERYBUF, &buf);
+    (void) ioctl(-1, VIDIOC_QBUF, &buf);
+    (void) ioctl(-1, VIDIOC_DQBUF, &buf);
+    (void) ioctl(-1, VIDIOC_STREAMON, &type);
+    cap.capabilities = V4L2_CAP_VIDEO_CAPTURE | V4L2_CAP_STREAMING;
+    exit(0);
+}
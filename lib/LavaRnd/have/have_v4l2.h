@@ -0,0 +1,2 @@
+/* Do not edit - auto generated by Makefile */
+#define HAVE_V4L2 /* we have Video4Linux2 streaming */
@@ -0,0 +1,12 @@
+/*
+ * ov511-cam - where to find ov511-ioctl.h
+ *
+ * Generated by Makefile, do not edit!
+ */
+
+#if !defined(__OV511_CAM_H__)
+#define __OV511_CAM_H__
+
+#include "cam_videodev.h"
+
+#endif /* __OV511_CAM_H__ */
@@ -0,0 +1,12 @@
+/*
+ * pwc-cam - where to find pwc-ioctl.h
+ *
+ * Generated by Makefile, do not edit!
+ */
+
+#if !defined(__PWC_CAM_H__)
+#define __PWC_CAM_H__
+
+#include "pwc-ioctl-8.6.h"
+
+#endif /* __PWC_CAM_H__ */
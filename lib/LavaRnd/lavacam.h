@@ -46,6 +46,8 @@
  */
 #include "LavaRnd/pwc_state.h"
 #include "LavaRnd/ov511_state.h"
+#include "LavaRnd/replay_state.h"
+#include "LavaRnd/v4l2_state.h"
 #include "LavaRnd/have/cam_videodev.h"
 
 
@@ -55,9 +57,59 @@
 union lavacam {
     struct pwc_state pwc;	/* pwc - Philips Web Camera */
     struct ov511_state ov511;	/* ov511 - OmniVision OV511 Web Camera */
+    struct replay_state replay;	/* replay - camdump/camdumpdir frame replay */
+    struct v4l2_state v4l2;	/* v4l2 - Video4Linux2 streaming camera */
 };
 
 
+/*
+ * LAVACAM_RING - number of read image buffers
+ *
+ * One buffer holds the frame being read while another holds the previous
+ * sane frame for the sanity check bit difference.
+ */
+#define LAVACAM_RING 2
+
+
+/*
+ * lavacam_stats - frame sanity statistics from a single pass over a frame
+ *
+ * These values are filled in by lavacam_frame_stats().  A statistic that
+ * was not asked for, or that could not be computed, is left at -1.
+ */
+struct lavacam_stats {
+    double uncom_fract;		/* fraction of uncommon octets, <0 ==> none */
+    int half_x;			/* 1/2 level of the octet tally, <0 ==> none */
+    double octet_entropy;	/* min-entropy per octet in bits, <0 ==> none */
+    double bitdiff_fract;	/* fraction of bits changed, <0 ==> none */
+};
+
+/*
+ * lavacam_frame_stats() flags - what statistics to gather
+ */
+#define LAVACAM_STAT_TALLY 0x01	/* uncom_fract, half_x and octet_entropy */
+#define LAVACAM_STAT_DIFF 0x02	/* bitdiff_fract against a previous frame */
+
+/*
+ * lavacam_extract() tiles - a chaos frame is scored and selected by tile
+ *
+ * A tile is LAVACAM_TILE octets, or larger when needed to keep a frame
+ * within LAVACAM_MAX_TILE tiles.
+ */
+#define LAVACAM_TILE 1024	/* octets in an extraction tile */
+#define LAVACAM_MAX_TILE 1024	/* most extraction tiles in a frame */
+
+
+/*
+ * lavacam_sanity() repeat check - fingerprints of recent sane frames
+ *
+ * A fingerprint is the FNV-1 hash of LAVACAM_FP_SAMPLES evenly spaced
+ * 8 octet samples of the chaos frame, or of the whole of a smaller frame.
+ */
+#define LAVACAM_FP_HIST 16	/* sane frame fingerprints remembered */
+#define LAVACAM_FP_SAMPLES 256	/* 8 octet samples in a fingerprint */
+
+
 /*
  * opsize - how and where to read from the camera
  */
@@ -82,11 +134,26 @@ struct opsize {
     int half_x;		/* half_x most common values must be <50% of octets */
     double diff_fract;	/* min fraction of different/same bits between frames */
     /* sanity check previous chaos frame comparison */
-    void *prev_frame;	/* previous chaos frame (initialized to all 0's) */
+    void *prev_frame;	/* previous sane chaos frame, NULL ==> none yet */
+    void *prev_buf;	/* prev_frame copy buffer, NULL ==> no copy needed */
+    u_int64_t fp_hist[LAVACAM_FP_HIST];	/* recent sane frame fingerprints */
+    int fp_cnt;		/* number of fp_hist fingerprints in use */
+    int fp_next;	/* fp_hist index of the next fingerprint to replace */
+    /* read image buffer ring - see lavacam_frame_alloc() */
+    void *ring[LAVACAM_RING];	/* read image buffers, NULL ==> not allocated */
+    int ring_indx;	/* index of the ring buffer being read into */
+    /* mmap frame capture queue - see lavacam_mmap_push() */
+    int mmap_queue[VIDEO_MAX_FRAME];	/* frames queued for capture, in order */
+    int mmap_head;	/* mmap_queue index of the oldest queued frame */
+    int mmap_queued;	/* number of frames queued for capture */
+    int mmap_cur;	/* mmap frame being processed, <0 ==> none */
+    int mmap_held;	/* mmap frame held as prev_frame, <0 ==> none */
     /* camera use fields */
     time_t open_time;		/* opening timestamp in time(2) format */
     u_int64_t frame_num;	/* current frame number generated */
     u_int64_t insane_cnt;	/* number of frames rejected due to insanity */
+    double entropy;	/* est min-entropy bits of sane frame, <0 ==> none */
+    struct lavacam_stats stats;	/* last frame sanity check statistics */
     /* read/mmap frame data */
     int use_read;	/* TRUE ==> using read, FALSE ==> using mmap */
     void *image;	/* pointer to start of read or mmap buffer or NULL */
@@ -118,11 +185,23 @@ struct lavacam_flag {
 };
 
 
+/*
+ * lavacam_sync_func - wait for a mmap frame to be captured
+ *
+ * Given an open camera descriptor and a mmap frame number, return >= 0
+ * once the frame has been captured, or <0 on error.  See
+ * lavacam_sync_start() in camop.c.
+ */
+typedef int (*lavacam_sync_func) (int cam_fd, int frame);
+
+
 /*
  * include each of the camera name_drvr.h driver files here
  */
 #include "LavaRnd/pwc_drvr.h"
 #include "LavaRnd/ov511_drvr.h"
+#include "LavaRnd/replay_drvr.h"
+#include "LavaRnd/v4l2_drvr.h"
 
 
 /*
@@ -170,12 +249,34 @@ extern int lavacam_close(int type, int cam_fd, struct opsize *siz,
 extern int lavacam_get_frame(int type, int cam_fd, struct opsize *siz);
 extern double lavacam_uncom_fract(u_int8_t *frame, int len, int top_x,
 				  int *p_half_lvl);
+extern double lavacam_uncom_entropy(u_int8_t *frame, int len, int top_x,
+				    int *p_half_lvl, double *p_entropy);
 extern double lavacam_bitdiff_fract(u_int8_t *frame1, u_int8_t *frame2,
 				    int len);
+extern int lavacam_frame_stats(u_int8_t *frame, u_int8_t *prev, int len,
+			       int top_x, int flags,
+			       struct lavacam_stats *stats);
 extern int lavacam_sanity(struct opsize *siz);
+extern void lavacam_keep_frame(struct opsize *siz);
+extern int lavacam_extract(struct opsize *siz, int planes, double tiles,
+			   u_int8_t *buf, int buflen, double *p_entropy);
+extern int lavacam_frame_alloc(struct opsize *siz, int lavaoff, int stable);
+extern void lavacam_frame_free(struct opsize *siz);
+extern void lavacam_mmap_init(struct opsize *siz);
+extern int lavacam_mmap_push(struct opsize *siz, int frame);
+extern int lavacam_mmap_pop(struct opsize *siz);
+extern int lavacam_mmap_release(struct opsize *siz);
 extern int lavacam_msync(int type, int cam_fd, union lavacam *cam,
 			 struct opsize *siz);
 extern int lavacam_wait_frame(int type, int cam_fd, double max_wait);
+extern int lavacam_frame_fd(int type, int cam_fd);
+extern int lavacam_poll_frame(int fd, double max_wait);
+extern int lavacam_sync_start(int cam_fd, struct opsize *siz,
+			      lavacam_sync_func sync);
+extern void lavacam_sync_stop(int cam_fd);
+extern int lavacam_sync_fd(int cam_fd);
+extern int lavacam_sync_queue(int cam_fd, int frame);
+extern int lavacam_sync_frame(int cam_fd, int frame, lavacam_sync_func sync);
 extern int chaos_zone(int set, int palette, int frame_size,
 		      int height, int width, int *chaos_offset, int *chaos_len);
 extern const char *palette_name(int set, int palette);
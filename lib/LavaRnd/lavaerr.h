@@ -121,6 +121,7 @@
 #define LAVACAM_ERR_OVERDIFF (-121) /* too few bits similar with prev frame */
 #define LAVACAM_ERR_HALFLVL (-122)  /* top half_x is more than half of frame */
 #define LAVACAM_ERR_PALUNSET (-123) /* pallette has not been set for camera */
+#define LAVACAM_ERR_REPEAT (-124)   /* frame repeats a recent sane frame */
 
 
 #endif /* __LAVARND_LAVAERR_H__ */
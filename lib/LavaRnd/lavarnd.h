@@ -37,6 +37,13 @@
 #  include "sha1.h"
 
 
+/*
+ * entropy driven rates - see lava_entropy_rate()
+ */
+#  define LAVA_ENTROPY_MARGIN (8.0)	/* min-entropy bits per output bit */
+#  define LAVA_MAX_RATE (16.0)		/* highest reasonable rate */
+
+
 /*
  * external functions - lavarnd.c
  */
@@ -50,6 +57,7 @@ extern void *lava_salt_blk_turn(void *salt_arg, int salt_len,
 				void *input, int len, int nway, void *output);
 extern int lava_nway_value(int length, double rate);
 extern int lavarnd_len(int inlen, double rate);
+extern double lava_entropy_rate(int inlen, double entropy);
 extern int lavarnd(int use_salt, void *input, int inlen, double rate,
 		   void *output, int outlen);
 
@@ -60,6 +60,59 @@
 /* NOTE: We pick 20 because 2^64 (max unsigned long long) is 20 digits */
 #define LAVA_REQBUFLEN (20+1+1)	/* longest read of request size + \n + 1 */
 
+/*
+ * lavapool binary protocol
+ *
+ * A client that opens with the LAVA_PROTO_MAGIC octets followed by a
+ * version octet speaks the binary protocol for the rest of the connection.
+ * The connection is kept open and any number of fixed-size requests
+ * may be sent without waiting for the replies.  Replies are returned
+ * in request order.  All multi-octet values are in network byte order.
+ *
+ * request header:
+ *	octets 0-3	octets requested
+ *	octet  4	minimum acceptable quality (lavaqual)
+ *	octet  5	request type: LAVA_PROTO_ONCE, may be or-ed with
+ *			LAVA_PROTO_S100
+ *	octets 6-7	must be zero
+ *	octets 8-11	deadline in milliseconds, 0 ==> no deadline
+ *
+ * stream request header:
+ *	octets 0-3	total octets to stream, 0 ==> no limit
+ *	octet  4	minimum acceptable quality (lavaqual)
+ *	octet  5	request type: LAVA_PROTO_STREAM, may be or-ed with
+ *			LAVA_PROTO_S100
+ *	octets 6-7	must be zero
+ *	octets 8-11	octets per second, 0 ==> as fast as the client reads
+ *
+ * reply header, followed by the reply octets:
+ *	octets 0-3	octets returned
+ *	octet  4	quality of the returned octets (lavaqual)
+ *	octets 5-7	zero
+ *
+ * A request not filled by its deadline is topped up with s100 data when
+ * that is of at least the minimum quality, otherwise only the octets on
+ * hand are returned with a quality of LAVA_QUAL_NONE.
+ *
+ * A request with the LAVA_PROTO_S100 flag is served at once with s100
+ * data from a generator that lavapool seeds from its pool.  It does not
+ * wait for the pool.  If the s100 data is below the minimum quality, the
+ * reply holds no octets and has a quality of LAVA_QUAL_NONE.
+ *
+ * A stream request is answered by a series of replies that together
+ * hold the total octets requested.  A stream without a limit ends
+ * when the client closes the connection.
+ */
+#define LAVA_PROTO_MAGIC "LAVA"	/* binary protocol magic prefix */
+#define LAVA_PROTO_MAGICLEN (4)	/* length of LAVA_PROTO_MAGIC */
+#define LAVA_PROTO_VERSION (1)	/* binary protocol version */
+#define LAVA_PROTO_HELLOLEN (LAVA_PROTO_MAGICLEN+1)	/* magic + version */
+#define LAVA_PROTO_REQLEN (12)	/* binary request header length */
+#define LAVA_PROTO_REPLEN (8)	/* binary reply header length */
+#define LAVA_PROTO_ONCE (0)	/* request type: one reply */
+#define LAVA_PROTO_STREAM (1)	/* request type: stream of replies */
+#define LAVA_PROTO_S100 (0x80)	/* request type flag: serve s100 data */
+
 
 /*
  * external functions and vars
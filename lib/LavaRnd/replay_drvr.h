@@ -0,0 +1,73 @@
+/*
+ * replay_drvr - frame replay definitions and driver interface
+ *
+ * @(#) $Revision: 10.1 $
+ * @(#) $Id: replay_drvr.h,v 10.1 2003/08/18 06:44:37 lavarnd Exp $
+ *
+ * Copyright (c) 2000-2003 by Landon Curt Noll and Simon Cooper.
+ * All Rights Reserved.
+ *
+ * This is open software; you can redistribute it and/or modify it under
+ * the terms of the version 2.1 of the GNU Lesser General Public License
+ * as published by the Free Software Foundation.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General
+ * Public License for more details.
+ *
+ * The file COPYING contains important info about Licenses and Copyrights.
+ * Please read the COPYING file for details about this open software.
+ *
+ * A copy of version 2.1 of the GNU Lesser General Public License is
+ * distributed with calc under the filename COPYING-LGPL.  You should have
+ * received a copy with calc; if not, write to Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * For more information on LavaRnd: http://www.LavaRnd.org
+ *
+ * Share and enjoy! :-)
+ */
+
+#if !defined(__LAVARND_REPLAY_DRVR_H__)
+#  define __LAVARND_REPLAY_DRVR_H__
+
+
+/*
+ * required includes
+ */
+#  include <sys/types.h>
+
+
+/*
+ * replay defines
+ */
+#  define REPLAY_DEF_FPS 30.0		/* default frames per second */
+#  define REPLAY_MAX_FPS 1000000.0	/* maximum frames per second */
+#  define REPLAY_MAX_JITTER 0.999	/* maximum jitter fraction */
+#  define REPLAY_MAX_OPEN 16		/* maximum replays open at once */
+
+/*
+ * external functions
+ */
+extern int replay_get(int cam_fd, union lavacam *u_cam_p);
+extern int replay_set(int cam_fd, union lavacam *u_cam_p);
+extern int replay_LavaRnd(union lavacam *u_cam_p, int model);
+extern int replay_check(union lavacam *u_cam_p);
+extern int replay_print(FILE * stream, int cam_fd,
+		     union lavacam *u_cam_p, struct opsize *siz);
+extern void replay_usage(char *prog, char *typename);
+extern int replay_argv(int argc, char **argv, union lavacam *u_cam_p,
+		    struct lavacam_flag *flag, int model);
+extern int replay_open(char *devname, int model, union lavacam *o_cam,
+		    union lavacam *n_cam, struct opsize *siz, int def,
+		    struct lavacam_flag *flag);
+extern int replay_close(int cam_fd, struct opsize *siz,
+		     struct lavacam_flag *flag);
+extern int replay_get_frame(int cam_fd, struct opsize *siz);
+extern int replay_msync(int cam_fd, union lavacam *u_cam_p,
+			struct opsize *siz);
+extern int replay_wait_frame(int cam_fd, double max_wait);
+
+
+#endif /* __LAVARND_REPLAY_DRVR_H__ */
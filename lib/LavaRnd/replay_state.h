@@ -0,0 +1,92 @@
+/*
+ * replay_state - frame replay settings and state
+ *
+ * @(#) $Revision: 10.1 $
+ * @(#) $Id: replay_state.h,v 10.1 2003/08/18 06:44:37 lavarnd Exp $
+ *
+ * Copyright (c) 2000-2003 by Landon Curt Noll and Simon Cooper.
+ * All Rights Reserved.
+ *
+ * This is open software; you can redistribute it and/or modify it under
+ * the terms of the version 2.1 of the GNU Lesser General Public License
+ * as published by the Free Software Foundation.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General
+ * Public License for more details.
+ *
+ * The file COPYING contains important info about Licenses and Copyrights.
+ * Please read the COPYING file for details about this open software.
+ *
+ * A copy of version 2.1 of the GNU Lesser General Public License is
+ * distributed with calc under the filename COPYING-LGPL.  You should have
+ * received a copy with calc; if not, write to Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * For more information on LavaRnd: http://www.LavaRnd.org
+ *
+ * Share and enjoy! :-)
+ */
+
+#if !defined(__LAVARND_REPLAY_STATE_H__)
+#  define __LAVARND_REPLAY_STATE_H__
+
+
+/*
+ * replay_state - frame replay settings and state
+ *
+ * The replay driver is not a camera.  It plays back frames previously
+ * saved by the camdump or camdumpdir tools so that the chaos path can
+ * be exercised without a webcam.
+ *
+ * NOTE: The mask element tells replay_set() what to set and replay_check()
+ *       what to check.
+ *
+ * NOTE: The order of these elements must be coordinated with the
+ *	 static struct replay_state optimal value(s) in replay_drvr.c.
+ */
+struct replay_state {
+    /* these values are read/write */
+    double fps;		/* frames per second, 0.0 ==> as fast as read */
+    double jitter;	/* random fraction of frame interval variation */
+    int loop;		/* TRUE ==> restart after last frame, FALSE ==> EOF */
+    /* these values are write only */
+    int framelen;	/* octets per frame in a camdump file, 0 ==> unset */
+    /* these values are read only */
+    int frames;		/* number of frames available to replay */
+    int next;		/* index of the next frame to replay */
+    /* special driver/utilities elements */
+    unsigned long mask;	/* bit mask of state values to set/change */
+    /* tmp sanity check into - initialized by default, set by replay_argv() */
+    int tmp_top_x;		/* tmp top_x struct opsize value */
+    double tmp_min_fract;	/* tmp min_fract struct opsize value */
+    int tmp_half_x;		/* tmp half_x struct opsize value */
+    double tmp_diff_fract;	/* tmp diff_fract struct opsize value */
+};
+
+
+/*
+ * state mask - what is set/modify
+ */
+#  define REPLAY_STATE_fps		0x00000001
+#  define REPLAY_STATE_jitter		0x00000002
+#  define REPLAY_STATE_loop		0x00000004
+#  define REPLAY_STATE_framelen		0x00000008
+
+#  define REPLAY_STATE_MASK		0x0000000f
+
+/* the state mask value for a given REPLAY_STATE_name */
+#  define REPLAY_MASK(name) REPLAY_STATE_##name
+
+/* set in variable x, the state mask value for REPLAY_STATE_name */
+#  define REPLAY_SET(x,name) ((x) |= REPLAY_MASK(name))
+
+/* clear in variable x, the state mask value for REPLAY_STATE_name */
+#  define REPLAY_CLEAR(x,name) ((x) &= ~REPLAY_MASK(name))
+
+/* true (non-0) if variable x has the state mask value REPLAY_STATE_name set */
+#  define REPLAY_TEST(x,name) ((x) & REPLAY_MASK(name))
+
+
+#endif /* __LAVARND_REPLAY_STATE_H__ */
@@ -0,0 +1,96 @@
+/*
+ * v4l2_drvr - Video4Linux2 streaming camera definitions and driver interface
+ *
+ * @(#) $Revision$
+ * @(#) $Id$
+ *
+ * Copyright (c) 2000-2003 by Landon Curt Noll and Simon Cooper.
+ * All Rights Reserved.
+ *
+ * This is open software; you can redistribute it and/or modify it under
+ * the terms of the version 2.1 of the GNU Lesser General Public License
+ * as published by the Free Software Foundation.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General
+ * Public License for more details.
+ *
+ * The file COPYING contains important info about Licenses and Copyrights.
+ * Please read the COPYING file for details about this open software.
+ *
+ * A copy of version 2.1 of the GNU Lesser General Public License is
+ * distributed with calc under the filename COPYING-LGPL.  You should have
+ * received a copy with calc; if not, write to Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * For more information on LavaRnd: http://www.LavaRnd.org
+ *
+ * Share and enjoy! :-)
+ */
+
+
+#if !defined(__LAVARND_V4L2_DRVR_H__)
+#  define __LAVARND_V4L2_DRVR_H__
+
+
+/*
+ * required includes
+ */
+#  include <sys/types.h>
+
+#  include "LavaRnd/have/cam_videodev.h"
+
+
+/*
+ * v4l2 defines
+ */
+#  define V4L2_DEF_BUFFERS 4		/* default mmap streaming buffers */
+#  define V4L2_MIN_BUFFERS 2		/* minimum mmap streaming buffers */
+#  define V4L2_MAX_BUFFERS VIDEO_MAX_FRAME  /* maximum mmap streaming buffers */
+#  define V4L2_MAX_FPS 1000		/* maximum frames per second */
+#  define V4L2_MAX_SIZE 65535		/* maximum pixel width & height */
+#  define V4L2_MAX_OPEN 16		/* maximum V4L2 cameras open at once */
+
+/* form a V4L2 fourcc pixel format code from 4 characters */
+#  define V4L2_FOURCC(a,b,c,d) \
+    ((unsigned long)(unsigned char)(a) | \
+     ((unsigned long)(unsigned char)(b) << 8) | \
+     ((unsigned long)(unsigned char)(c) << 16) | \
+     ((unsigned long)(unsigned char)(d) << 24))
+
+/*
+ * v4l2_ioctl_func - how the v4l2 driver calls ioctl(2)
+ *
+ * Every ioctl of the v4l2 driver goes through a function of this type.
+ * By default that function is the system ioctl(2).  A test stand-in may
+ * be installed with v4l2_ioctl_hook() to feed synthetic frames to the
+ * driver without a camera.
+ */
+typedef int (*v4l2_ioctl_func) (int fd, unsigned long request, void *arg);
+
+/*
+ * external functions
+ */
+extern int v4l2_get(int cam_fd, union lavacam *u_cam_p);
+extern int v4l2_set(int cam_fd, union lavacam *u_cam_p);
+extern int v4l2_LavaRnd(union lavacam *u_cam_p, int model);
+extern int v4l2_check(union lavacam *u_cam_p);
+extern int v4l2_print(FILE * stream, int cam_fd,
+		      union lavacam *u_cam_p, struct opsize *siz);
+extern void v4l2_usage(char *prog, char *typename);
+extern int v4l2_argv(int argc, char **argv, union lavacam *u_cam_p,
+		     struct lavacam_flag *flag, int model);
+extern int v4l2_open(char *devname, int model, union lavacam *o_cam,
+		     union lavacam *n_cam, struct opsize *siz, int def,
+		     struct lavacam_flag *flag);
+extern int v4l2_close(int cam_fd, struct opsize *siz,
+		      struct lavacam_flag *flag);
+extern int v4l2_get_frame(int cam_fd, struct opsize *siz);
+extern int v4l2_msync(int cam_fd, union lavacam *u_cam_p,
+		      struct opsize *siz);
+extern int v4l2_wait_frame(int cam_fd, double max_wait);
+extern v4l2_ioctl_func v4l2_ioctl_hook(v4l2_ioctl_func func);
+
+
+#endif /* __LAVARND_V4L2_DRVR_H__ */
@@ -0,0 +1,102 @@
+/*
+ * v4l2_state - Video4Linux2 streaming camera settings and state
+ *
+ * @(#) $Revision$
+ * @(#) $Id$
+ *
+ * Copyright (c) 2000-2003 by Landon Curt Noll and Simon Cooper.
+ * All Rights Reserved.
+ *
+ * This is open software; you can redistribute it and/or modify it under
+ * the terms of the version 2.1 of the GNU Lesser General Public License
+ * as published by the Free Software Foundation.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General
+ * Public License for more details.
+ *
+ * The file COPYING contains important info about Licenses and Copyrights.
+ * Please read the COPYING file for details about this open software.
+ *
+ * A copy of version 2.1 of the GNU Lesser General Public License is
+ * distributed with calc under the filename COPYING-LGPL.  You should have
+ * received a copy with calc; if not, write to Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * For more information on LavaRnd: http://www.LavaRnd.org
+ *
+ * Share and enjoy! :-)
+ */
+
+
+#if !defined(__LAVARND_V4L2_STATE_H__)
+#  define __LAVARND_V4L2_STATE_H__
+
+
+/*
+ * v4l2_state - Video4Linux2 streaming camera settings and state
+ *
+ * NOTE: A pixelformat is a V4L2 fourcc code such as 'Y','U','Y','V'.
+ *	 Only uncompressed pixel formats that have a Video4Linux palette
+ *	 equivalent can be used, see v4l2_palette() in v4l2_drvr.c.
+ *
+ * NOTE: The width, height, pixelformat and buffers of a camera that is
+ *	 streaming cannot be changed by v4l2_set().  They are set by
+ *	 v4l2_open() before streaming starts.
+ *
+ * NOTE: The mask element tells v4l2_set() what to set and v4l2_check()
+ *       what to check.
+ *
+ * NOTE: The order of these elements must be coordinated with the
+ *	 static struct v4l2_state optimal value(s) in v4l2_drvr.c.
+ */
+struct v4l2_state {
+    /* these values are read/write */
+    int width;		/* image width in pixels, 0 ==> driver default */
+    int height;		/* image height in pixels, 0 ==> driver default */
+    unsigned long pixelformat;	/* V4L2 fourcc, 0 ==> driver default */
+    int fps;		/* frames per second, 0 ==> driver default */
+    int buffers;	/* number of mmap streaming buffers */
+    /* these values are read only */
+    int palette;	/* Video4Linux palette equivalent of pixelformat */
+    int bytesperline;	/* octets per line of the image */
+    int sizeimage;	/* octets per frame */
+    unsigned long caps;	/* V4L2 device capabilities */
+    char driver[16];	/* name of the kernel driver */
+    char card[32];	/* name of the camera */
+    /* special driver/utilities elements */
+    unsigned long mask;	/* bit mask of state values to set/change */
+    /* tmp sanity check into - initialized by default, set by v4l2_argv() */
+    int tmp_top_x;		/* tmp top_x struct opsize value */
+    double tmp_min_fract;	/* tmp min_fract struct opsize value */
+    int tmp_half_x;		/* tmp half_x struct opsize value */
+    double tmp_diff_fract;	/* tmp diff_fract struct opsize value */
+};
+
+
+/*
+ * state mask - what is set/modify
+ */
+#  define V4L2_STATE_width		0x00000001
+#  define V4L2_STATE_height		0x00000002
+#  define V4L2_STATE_pixelformat	0x00000004
+#  define V4L2_STATE_fps			0x00000008
+#  define V4L2_STATE_buffers		0x00000010
+
+#  define V4L2_STATE_MASK		0x0000001f
+
+/* the state mask value for a given V4L2_STATE_name */
+#  define V4L2_MASK(name) V4L2_STATE_##name
+
+/* set in variable x, the state mask value for V4L2_STATE_name */
+#  define V4L2_SET(x,name) ((x) |= V4L2_MASK(name))
+
+/* clear in variable x, the state mask value for V4L2_STATE_name */
+#  define V4L2_CLEAR(x,name) ((x) &= ~V4L2_MASK(name))
+
+/* true (non-0) if variable x has the state mask value V4L2_STATE_name set */
+#  define V4L2_TEST(x,name) ((x) & V4L2_MASK(name))
+
+
+#endif /* __LAVARND_V4L2_STATE_H__ */
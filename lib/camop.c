@@ -183,11 +183,18 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <time.h>
+#include <math.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
 
+#include "LavaRnd/rawio.h"
 #include "LavaRnd/lavacam.h"
+#include "LavaRnd/fnv1.h"
 
 
 struct camop {
@@ -255,6 +262,20 @@ static struct camop cam_switch[] = {
      ov511_open, ov511_close,
      ov511_get_frame, ov511_msync, ov511_wait_frame},
 
+    {0, "none", "replay", "Frame_replay", "camdump/camdumpdir frame replay",
+     replay_get, replay_set, replay_LavaRnd,
+     replay_check, replay_print,
+     replay_usage, replay_argv,
+     replay_open, replay_close,
+     replay_get_frame, replay_msync, replay_wait_frame},
+
+    {0, "uvcvideo", "v4l2", "V4L2_stream", "Video4Linux2 streaming camera",
+     v4l2_get, v4l2_set, v4l2_LavaRnd,
+     v4l2_check, v4l2_print,
+     v4l2_usage, v4l2_argv,
+     v4l2_open, v4l2_close,
+     v4l2_get_frame, v4l2_msync, v4l2_wait_frame},
+
     /* MUST be end of list */
     {-1, NULL, NULL, NULL, NULL,
      NULL, NULL, NULL,
@@ -294,11 +315,44 @@ static int onebit[OCTET_CNT] = {
     4, 5, 5, 6, 5, 6, 6, 7, 5, 6, 6, 7, 6, 7, 7, 8
 };
 
+
+/*
+ * lavacam_sync - sync thread state of an open mmap camera
+ *
+ * See lavacam_sync_start().  The frames in queue[] are in the order they
+ * were queued for capture.  The first synced of them have been waited
+ * for by the sync thread, and result[] holds the outcome of each wait.
+ */
+#define LAVACAM_SYNC_MAX 16	/* maximum cameras with a sync thread */
+
+struct lavacam_sync {
+    int inuse;			/* TRUE ==> slot is in use */
+    int cam_fd;			/* open camera descriptor */
+    lavacam_sync_func sync;	/* waits for a mmap frame to be captured */
+    int ready_fd[2];		/* frame ready pipe, one octet per frame */
+    pthread_t thread;		/* the sync thread */
+    pthread_mutex_t lock;	/* guards the elements below */
+    pthread_cond_t cond;	/* signaled when a frame is queued or on stop */
+    int stop;			/* TRUE ==> sync thread must return */
+    int queue[VIDEO_MAX_FRAME];	/* frames queued for capture, in order */
+    int result[VIDEO_MAX_FRAME];	/* sync result of each queued frame */
+    int head;			/* queue index of the oldest queued frame */
+    int queued;			/* number of frames in queue */
+    int synced;			/* number of queued frames waited for */
+};
+static struct lavacam_sync lavacam_sync[LAVACAM_SYNC_MAX];
+static pthread_mutex_t lavacam_sync_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
 /*
  * static functions
  */
 static struct camop *find_camtype(char *type_name);
-static int compar(const void *, const void *);
+static void tally_down(int *tally, int cnt, int i);
+static int popcount64(u_int64_t x);
+static int tile_cmp(const void *a, const void *b);
+static struct lavacam_sync *lavacam_sync_find(int cam_fd);
+static void *lavacam_sync_thread(void *arg);
 
 
 /*
@@ -735,11 +789,16 @@ lavacam_close(int type, int cam_fd, struct opsize *siz,
  *
  * NOTE: This function increments the frame_num struct opsize field
  *       on a successful get.
+ *
+ * NOTE: When reading into a ring of image buffers, and the frame in the
+ *	 current buffer was kept as the previous frame by lavacam_sanity(),
+ *	 this function moves on to the next buffer of the ring before reading.
  */
 int
 lavacam_get_frame(int type, int cam_fd, struct opsize *siz)
 {
     int ret;	/* driver get_frame return */
+    int lavaoff;	/* offset of chaos in image */
 
     /*
      * firewall
@@ -748,6 +807,17 @@ lavacam_get_frame(int type, int cam_fd, struct opsize *siz)
 	return LAVACAM_ERR_ARG;
     }
 
+    /*
+     * do not read over the previous frame
+     */
+    if (siz->use_read && siz->ring[0] != NULL &&
+	siz->prev_frame != NULL && siz->prev_frame == siz->chaos) {
+	lavaoff = (u_int8_t *)siz->chaos - (u_int8_t *)siz->image;
+	siz->ring_indx = (siz->ring_indx + 1) % LAVACAM_RING;
+	siz->image = siz->ring[siz->ring_indx];
+	siz->chaos = (u_int8_t *)siz->image + lavaoff;
+    }
+
     /*
      * read from the camera
      */
@@ -760,82 +830,137 @@ lavacam_get_frame(int type, int cam_fd, struct opsize *siz)
 
 
 /*
- * compar - qsort compare function to sort a set of ints in reverse order
- *
- * given:
- *      ptr_a   point to 1st int
- *      ptr_b   point to 2nd int
+ * popcount64 - number of 1 bits in a 64 bit value
  *
- * returns:
- *      -1 if *ptr_a > *ptr_b,
- *      0 if *ptr_a == *ptr_b,
- *      1 if *ptr_a < *ptr_b
+ * This is the usual parallel bit count.  It needs no table lookups, and
+ * compilers that know of a population count instruction for the target
+ * will often use that instruction in its place.
  */
 static int
-compar(const void *ptr_a, const void *ptr_b)
+popcount64(u_int64_t x)
 {
-    /*
-     * firewall
-     */
-    if (ptr_a == NULL || ptr_b == NULL) {
-	return 0;
-    }
+    x -= (x >> 1) & (u_int64_t)0x5555555555555555ULL;
+    x = (x & (u_int64_t)0x3333333333333333ULL) +
+	((x >> 2) & (u_int64_t)0x3333333333333333ULL);
+    x = (x + (x >> 4)) & (u_int64_t)0x0f0f0f0f0f0f0f0fULL;
+    return (int)((x * (u_int64_t)0x0101010101010101ULL) >> 56);
+}
+
+
+/*
+ * STAT_STRIDE - octets processed by each pass of the lavacam_frame_stats loop
+ */
+#define STAT_STRIDE ((int)sizeof(u_int64_t))
+
+
+/*
+ * tally_down - restore the max heap order of a tally below a given element
+ *
+ * given:
+ *      tally           tally of octet values arranged as a max heap
+ *      cnt             number of elements in the heap
+ *      i               element that may be smaller than its children
+ */
+static void
+tally_down(int *tally, int cnt, int i)
+{
+    int child;		/* larger child of element i */
+    int val;		/* value being moved down the heap */
 
     /*
-     * compare
+     * move the element i value down until it is not smaller than its children
      */
-    if (*((int *)ptr_a) > *((int *)ptr_b)) {
-	return -1;
-    } else if (*((int *)ptr_a) < *((int *)ptr_b)) {
-	return 1;
-    } else {
-	return 0;
+    val = tally[i];
+    while ((child = 2 * i + 1) < cnt) {
+	if (child + 1 < cnt && tally[child + 1] > tally[child]) {
+	    ++child;
+	}
+	if (val >= tally[child]) {
+	    break;
+	}
+	tally[i] = tally[child];
+	i = child;
     }
+    tally[i] = val;
+    return;
 }
 
 
 /*
- * lavacam_uncom_fract - determine the fraction of uncommon octets in a frame
+ * lavacam_frame_stats - gather frame sanity statistics in a single pass
  *
  * given:
  *      frame           pointer to the frame
- *      len             length of frame in octets
+ *      prev            pointer to the previous frame, NULL ==> no bit diff
+ *      len             length of frames in octets
  *      top_x           ignore the top_x common octet values
- *      p_half_x        where to record 1/2 level value (NULL ==> ignore)
+ *      flags           LAVACAM_STAT_TALLY and/or LAVACAM_STAT_DIFF
+ *      stats           where to record the statistics
  *
  * returns:
- *      value from 0.0 to 1.0 giving the faction of octets in the frame
- *	that are uncommon.  0.0 means none of the octets are uncommon all
- *	are in the top_x.  As the return value approaches 0.0, more and
- *	more of the octets are uncommon (i.e., greater portion not in
- *	the top_x).
+ *      0 ==> OK, <0 ==> error
  *
- * The p_half_x, if non-NULL, is where the 1/2 level is recorded.
- * The 1/2 level is the point where the *p_half_x values first exceed
- * 50% of the available octets.
+ * This function reads the frame once.  While it tallies the octet values
+ * for the uncommon octet fraction, the 1/2 level and the octet min-entropy
+ * (see lavacam_uncom_entropy()), it also counts the bits that differ from
+ * the previous frame (see lavacam_bitdiff_fract()).
  *
- * NOTE: Reasonable top_x are between 1 and 255.  A top_x of 0 means
- *       there are no common octets (thus all are uncommon).  A top_x
- *       of 256 means all common (this none are uncommon).
+ * The octet values are tallied into 4 interleaved tallies so that a run
+ * of equal octets does not wait on the increment of the same counter.
+ * The bit difference is counted 64 bits at a time.  Only the most common
+ * tally values needed for the top_x and 1/2 level are put in order.
+ *
+ * NOTE: Statistics not asked for by flags, or not able to be computed,
+ *	 are set to -1 in stats.
  */
-double
-lavacam_uncom_fract(u_int8_t * frame, int len, int top_x, int *p_half_x)
+int
+lavacam_frame_stats(u_int8_t *frame, u_int8_t *prev, int len, int top_x,
+		    int flags, struct lavacam_stats *stats)
 {
+    int sub[4][OCTET_CNT];	/* interleaved tallies of octet values */
     int tally[OCTET_CNT];	/* tally of octet values in frame */
+    int do_tally;		/* TRUE ==> tally octet values */
+    int do_diff;		/* TRUE ==> count bit difference */
+    u_int64_t one_bits;		/* 1 bit difference */
+    u_int64_t word;		/* 64 bits of frame xor previous frame */
+    u_int64_t pword;		/* 64 bits of the previous frame */
+    int cnt;			/* number of tally values in the heap */
+    int sum;			/* sum of the most common tally values */
     int common;			/* number of common octets */
-    double uncom_fract;		/* fraction of uncommon octets */
     int half_len;		/* len/2 */
     int hlvl;			/* used to find half_x value */
     int i;
 
     /*
-     * firewall - no frame means no uncommon octets
+     * firewall
      */
+    if (stats == NULL) {
+	return LAVACAM_ERR_ARG;
+    }
+    stats->uncom_fract = -1.0;
+    stats->half_x = -1;
+    stats->octet_entropy = -1.0;
+    stats->bitdiff_fract = -1.0;
     if (frame == NULL || len < 1) {
-	return 0.0;
+	/* no frame means no uncommon octets and no bits are different */
+	if (flags & LAVACAM_STAT_TALLY) {
+	    stats->uncom_fract = 0.0;
+	    stats->octet_entropy = 0.0;
+	}
+	if (flags & LAVACAM_STAT_DIFF) {
+	    stats->bitdiff_fract = 0.0;
+	}
+	return LAVAERR_OK;
+    }
+    do_tally = ((flags & LAVACAM_STAT_TALLY) != 0);
+    do_diff = ((flags & LAVACAM_STAT_DIFF) != 0);
+    if (do_diff && prev == NULL) {
+	/* missing previous frame means no bits are different */
+	stats->bitdiff_fract = 0.0;
+	do_diff = FALSE;
     }
     /* case: absurd top_x values */
-    if (top_x < 0 ) {
+    if (top_x < 0) {
 	/* no common means all are uncommon */
 	top_x = 0;
     } else if (top_x > OCTET_CNT) {
@@ -844,56 +969,166 @@ lavacam_uncom_fract(u_int8_t * frame, int len, int top_x, int *p_half_x)
     }
 
     /*
-     * tally the octet values
+     * tally the octet values and count the bit difference
      */
-    half_len = len / 2;
-    memset(tally, 0, sizeof(tally));
-    for (i = 0; i < len; ++i) {
-	tally[(int)frame[i]]++;
+    if (do_tally) {
+	memset(sub, 0, sizeof(sub));
+    }
+    one_bits = 0;
+    for (i = 0; i + STAT_STRIDE <= len; i += STAT_STRIDE) {
+	if (do_tally) {
+	    sub[0][frame[i]]++;
+	    sub[1][frame[i + 1]]++;
+	    sub[2][frame[i + 2]]++;
+	    sub[3][frame[i + 3]]++;
+	    sub[0][frame[i + 4]]++;
+	    sub[1][frame[i + 5]]++;
+	    sub[2][frame[i + 6]]++;
+	    sub[3][frame[i + 7]]++;
+	}
+	if (do_diff) {
+	    /* memcpy because frames need not be 64 bit aligned */
+	    memcpy(&word, frame + i, sizeof(word));
+	    memcpy(&pword, prev + i, sizeof(pword));
+	    one_bits += popcount64(word ^ pword);
+	}
+    }
+    for (; i < len; ++i) {
+	if (do_tally) {
+	    sub[0][frame[i]]++;
+	}
+	if (do_diff) {
+	    one_bits += onebit[frame[i] ^ prev[i]];
+	}
+    }
+
+    /*
+     * record the bit difference fraction
+     */
+    if (do_diff) {
+	stats->bitdiff_fract = (double)one_bits /
+			       ((double)len * (double)BITS_PER_OCTET);
+    }
+    if (!do_tally) {
+	return LAVAERR_OK;
     }
 
     /*
-     * sort tally
+     * combine the interleaved tallies into a max heap
      */
-    qsort(tally, OCTET_CNT, sizeof(tally[0]), compar);
+    for (i = 0; i < OCTET_CNT; ++i) {
+	tally[i] = sub[0][i] + sub[1][i] + sub[2][i] + sub[3][i];
+    }
+    for (i = OCTET_CNT / 2 - 1; i >= 0; --i) {
+	tally_down(tally, OCTET_CNT, i);
+    }
+
+    /*
+     * the most common octet value bounds the octet min-entropy
+     *
+     * A frame octet has a min-entropy of -log2(p) bits, where p is the
+     * chance of the most likely octet value.
+     */
+    stats->octet_entropy = -log((double)tally[0] / (double)len) / log(2.0);
 
     /*
-     * determine the fraction of uncommon octets
+     * take the most common tally values, in order, until we have
+     * both the top_x common octets and the half level
      */
+    half_len = len / 2;
+    cnt = OCTET_CNT;
+    sum = 0;
     common = 0;
     hlvl = -1;
-    for (i = 0; i < top_x; ++i) {
-	common += tally[i];
-	if (p_half_x != NULL && hlvl < 0 && common >= half_len) {
+    for (i = 0; i < OCTET_CNT && (i < top_x || hlvl < 0); ++i) {
+	sum += tally[0];
+	tally[0] = tally[--cnt];
+	tally_down(tally, cnt, 0);
+	if (i < top_x) {
+	    common = sum;
+	}
+	if (hlvl < 0 && sum >= half_len) {
 	    hlvl = i;
 	}
     }
-    uncom_fract = (double)(len - common) / (double)len;
+    stats->uncom_fract = (double)(len - common) / (double)len;
+    stats->half_x = hlvl;
+    return LAVAERR_OK;
+}
+
+
+/*
+ * lavacam_uncom_fract - determine the fraction of uncommon octets in a frame
+ *
+ * given:
+ *      frame           pointer to the frame
+ *      len             length of frame in octets
+ *      top_x           ignore the top_x common octet values
+ *      p_half_x        where to record 1/2 level value (NULL ==> ignore)
+ *
+ * returns:
+ *      value from 0.0 to 1.0 giving the faction of octets in the frame
+ *	that are uncommon.  0.0 means none of the octets are uncommon all
+ *	are in the top_x.  As the return value approaches 0.0, more and
+ *	more of the octets are uncommon (i.e., greater portion not in
+ *	the top_x).
+ *
+ * The p_half_x, if non-NULL, is where the 1/2 level is recorded.
+ * The 1/2 level is the point where the *p_half_x values first exceed
+ * 50% of the available octets.
+ *
+ * NOTE: Reasonable top_x are between 1 and 255.  A top_x of 0 means
+ *       there are no common octets (thus all are uncommon).  A top_x
+ *       of 256 means all common (this none are uncommon).
+ */
+double
+lavacam_uncom_fract(u_int8_t * frame, int len, int top_x, int *p_half_x)
+{
+    return lavacam_uncom_entropy(frame, len, top_x, p_half_x, NULL);
+}
+
+
+/*
+ * lavacam_uncom_entropy - uncommon octet fraction and octet min-entropy
+ *
+ * given:
+ *      frame           pointer to the frame
+ *      len             length of frame in octets
+ *      top_x           ignore the top_x common octet values
+ *      p_half_x        where to record 1/2 level value (NULL ==> ignore)
+ *      p_entropy       where to record octet min-entropy (NULL ==> ignore)
+ *
+ * returns:
+ *      value from 0.0 to 1.0 giving the faction of octets in the frame
+ *	that are uncommon, as with lavacam_uncom_fract()
+ *
+ * The p_entropy, if non-NULL, is where the min-entropy per octet, in bits,
+ * is recorded.  It is found from the frequency of the most common octet
+ * value in the same octet value tally that gives the uncommon fraction.
+ * It ranges from 0.0 (all octets are the same) to 8.0.
+ */
+double
+lavacam_uncom_entropy(u_int8_t * frame, int len, int top_x, int *p_half_x,
+		      double *p_entropy)
+{
+    struct lavacam_stats stats;	/* frame statistics */
 
     /*
-     * if we did not find the half level and want to know it, keep looking
+     * tally the frame
      */
-    if (p_half_x != NULL && hlvl < 0) {
-	for (; i < OCTET_CNT; ++i) {
-	    common += tally[i];
-	    if (hlvl < 0 && common >= half_len) {
-		hlvl = i;
-		break;
-	    }
-	}
-    }
+    (void) lavacam_frame_stats(frame, NULL, len, top_x, LAVACAM_STAT_TALLY,
+			       &stats);
 
     /*
-     * save the half level value if we want to know it
+     * return what was asked for
      */
     if (p_half_x != NULL) {
-	*p_half_x = hlvl;
+	*p_half_x = stats.half_x;
     }
-
-    /*
-     * return uncommon fraction
-     */
-    return uncom_fract;
+    if (p_entropy != NULL) {
+	*p_entropy = stats.octet_entropy;
+    }
+    return stats.uncom_fract;
 }
 
 
@@ -911,47 +1146,66 @@ lavacam_uncom_fract(u_int8_t * frame, int len, int top_x, int *p_half_x)
  *         frames are exactly the same.  A value of 1.0 means that one
  *         frame is the bit-wise complement of the other frame (all bits
  *         are different).
- *
- * NOTE: Due to counting bits, the maximum length that is actually
- *       examined is 2^32 bits == 2^29 octets.
  */
 double
 lavacam_bitdiff_fract(u_int8_t * frame1, u_int8_t * frame2, int len)
 {
-    unsigned long one_bits;	/* 1 bit difference */
-    double bitdiff_fract;	/* fraction of different bits */
-    int i;
+    struct lavacam_stats stats;	/* frame statistics */
 
     /*
      * firewall
      */
-    if (len < 1) {
-	/* no length means no bits are different */
-	return 0.0;
-    }
     if (frame1 == NULL || frame2 == NULL) {
 	/* missing frame(s) means no bits are different */
 	return 0.0;
     }
-    /* -3 is because there are 8 (2 to the 3rd power) bits per octet */
-    if (len >= (1L << ((sizeof(one_bits) * BITS_PER_OCTET) - 3))) {
-	/* bit length overflows signed int, reduce length to avoid overflow */
-	len = (1L << ((sizeof(one_bits) * BITS_PER_OCTET) - 3)) - 1;
-    }
 
     /*
      * count bit difference
      */
-    one_bits = 0;
-    for (i = 0; i < len; ++i) {
-	one_bits += onebit[frame1[i] ^ frame2[i]];
+    (void) lavacam_frame_stats(frame1, frame2, len, 0, LAVACAM_STAT_DIFF,
+			       &stats);
+    return stats.bitdiff_fract;
+}
+
+
+/*
+ * frame_fingerprint - fingerprint a chaos frame for the repeat check
+ *
+ * given:
+ *	frame	chaos frame
+ *	len	length of frame in octets
+ *
+ * returns:
+ *	FNV-1 hash of LAVACAM_FP_SAMPLES evenly spaced samples of the frame
+ *
+ * NOTE: A frame no longer than the samples is hashed whole.  Frames that
+ *	 differ only between the samples have the same fingerprint.  For
+ *	 a noisy camera that is as good as identical: LAVACAM_FP_SAMPLES
+ *	 samples will not all match by chance.
+ */
+static u_int64_t
+frame_fingerprint(u_int8_t *frame, int len)
+{
+    u_int8_t sample[LAVACAM_FP_SAMPLES * STAT_STRIDE];	/* frame samples */
+    int stride;			/* octets between samples */
+    int i;
+
+    /*
+     * hash a small frame whole
+     */
+    if (len <= (int)sizeof(sample)) {
+	return fnv1_hash(frame, (u_int32_t)len);
     }
 
     /*
-     * return the bit difference fraction
+     * hash evenly spaced samples of a larger frame
      */
-    bitdiff_fract = (double)one_bits / (double)(len * BITS_PER_OCTET);
-    return bitdiff_fract;
+    stride = len / LAVACAM_FP_SAMPLES;
+    for (i = 0; i < LAVACAM_FP_SAMPLES; ++i) {
+	memcpy(sample + i * STAT_STRIDE, frame + i * stride, STAT_STRIDE);
+    }
+    return fnv1_hash(sample, (u_int32_t)sizeof(sample));
 }
 
 
@@ -970,8 +1224,30 @@ lavacam_bitdiff_fract(u_int8_t * frame1, u_int8_t * frame2, int len)
  * NOTE: This function increments the insane_cnt field of the struct opsize
  *       when a frame is returned as insane.
  *
- * NOTE: This function saves a sane frame into the prev_frame struct opsize
- *       buffer for comparison next time.  Insane frames are not copied.
+ * NOTE: This function keeps a sane frame as the prev_frame of the struct
+ *       opsize for comparison next time (see lavacam_keep_frame()).
+ *	 Insane frames are not kept.
+ *
+ * NOTE: This function sets the entropy field of the struct opsize to an
+ *	 estimate of the min-entropy of a sane frame in bits, or to -1.0
+ *	 when it cannot make one.  The estimate is the smaller of the octet
+ *	 min-entropy, from the octet value tally of the uncommon octet check,
+ *	 and the min-entropy of the bits that change from the previous
+ *	 frame, over the whole chaos segment.  The estimate is made only
+ *	 when both the uncommon octet and previous frame checks are enabled.
+ *	 Insane frames always have an entropy of -1.0.
+ *
+ * NOTE: Both checks are made from one lavacam_frame_stats() pass over the
+ *	 frame.  The statistics are left in the stats field of the struct
+ *	 opsize, for sane and insane frames alike, so that callers may
+ *	 report them without looking at the frame again.
+ *
+ * NOTE: When the previous frame check is enabled, a frame is also
+ *	 rejected when its fingerprint (see frame_fingerprint()) matches
+ *	 one of the last LAVACAM_FP_HIST sane frames.  The previous frame
+ *	 check only catches a camera that repeats its last frame.  This
+ *	 catches a stuck driver that cycles through a few stale buffers,
+ *	 or a source that replays old frames.
  *
  * TODO: Consider other non-CPU intensive tests to further improve
  *       sanity checks.  Also consider a way to dynamically compute the
@@ -981,9 +1257,12 @@ lavacam_bitdiff_fract(u_int8_t * frame1, u_int8_t * frame2, int len)
 int
 lavacam_sanity(struct opsize *siz)
 {
-    double uncom_fract;		/* fraction of uncommon octets */
-    double bitdiff_fract;	/* fraction of different bits */
-    int half_x;			/* half_x most common values <50% of octets */
+    struct lavacam_stats *stats;	/* frame statistics */
+    int flags;			/* which statistics to gather */
+    double diff_entropy;	/* min-entropy per octet of bit changes */
+    u_int64_t fp;		/* frame fingerprint */
+    int ret;			/* lavacam_frame_stats return */
+    int i;
 
     /*
      * firewall
@@ -991,6 +1270,27 @@ lavacam_sanity(struct opsize *siz)
     if (siz == NULL) {
 	return LAVACAM_ERR_ARG;
     }
+    siz->entropy = -1.0;
+    stats = &siz->stats;
+    diff_entropy = -1.0;
+
+    /*
+     * gather what the enabled checks need in one pass over the frame
+     *
+     * We do not compare a frame until there is a previous sane frame.
+     */
+    flags = 0;
+    if (siz->min_fract > 0.0) {
+	flags |= LAVACAM_STAT_TALLY;
+    }
+    if (siz->prev_frame != NULL && siz->diff_fract > 0.0) {
+	flags |= LAVACAM_STAT_DIFF;
+    }
+    ret = lavacam_frame_stats(siz->chaos, siz->prev_frame, siz->chaos_len,
+			      siz->top_x, flags, stats);
+    if (ret < 0) {
+	return ret;
+    }
 
     /*
      * verify that we have enough uncommon octet values
@@ -1000,10 +1300,8 @@ lavacam_sanity(struct opsize *siz)
      * These common octet values typically are not very entropic.  The
      * entroy typically lies in the less common octet values.
      */
-    if (siz->min_fract > 0.0) {
-	uncom_fract = lavacam_uncom_fract(siz->chaos,
-					  siz->chaos_len, siz->top_x, &half_x);
-	if (uncom_fract < siz->min_fract) {
+    if (flags & LAVACAM_STAT_TALLY) {
+	if (stats->uncom_fract < siz->min_fract) {
 	    /*
 	     * The siz->top_x common octet values occupy too many of
 	     * the octets in the frame.  There are not enough
@@ -1021,7 +1319,7 @@ lavacam_sanity(struct opsize *siz)
 	 * half_x most common octet values occupy >=50% of the octets
 	 * in the frame.  So we need to compare siz->half_x with half_x.
 	 */
-	if (half_x < siz->half_x) {
+	if (stats->half_x < siz->half_x) {
 	    /*
 	     * The half_x most common octet values, there they first
 	     * exceed 50% of the octets in the frame, is too low.
@@ -1042,26 +1340,59 @@ lavacam_sanity(struct opsize *siz)
      * If a number of bits are flip-flopping, then successive frames
      * will appear bit-wise complements of each other too many times.
      * Too much similarity is just as bad is too much difference.
-     *
-     * We do not compare the 1st frame because the prev_frame buffer
-     * has not been initialized yet.
      */
-    if (siz->frame_num > 1 && siz->diff_fract > 0.0) {
-	bitdiff_fract = lavacam_bitdiff_fract(siz->chaos, siz->prev_frame,
-					      siz->chaos_len);
-	if (bitdiff_fract < siz->diff_fract) {
+    if (flags & LAVACAM_STAT_DIFF) {
+	if (stats->bitdiff_fract < siz->diff_fract) {
 	    /*
 	     * frame is too similar to the previous frame
 	     */
 	    ++siz->insane_cnt;
 	    return LAVACAM_ERR_OVERSAME;
-	} else if ((1.0 - bitdiff_fract) < siz->diff_fract) {
+	} else if ((1.0 - stats->bitdiff_fract) < siz->diff_fract) {
 	    /*
 	     * frame is too different from the previous frame
 	     */
 	    ++siz->insane_cnt;
 	    return LAVACAM_ERR_OVERDIFF;
 	}
+
+	/*
+	 * a bit that changes with chance p has a min-entropy of
+	 * -log2(max(p, 1-p)) bits
+	 */
+	if (stats->bitdiff_fract > 0.5) {
+	    diff_entropy = -log(stats->bitdiff_fract) / log(2.0);
+	} else {
+	    diff_entropy = -log(1.0 - stats->bitdiff_fract) / log(2.0);
+	}
+	diff_entropy *= (double)BITS_PER_OCTET;
+    }
+
+    /*
+     * verify that the frame does not repeat a recent sane frame
+     *
+     * A stuck driver may hand back a few stale buffers in turn.  Each
+     * differs enough from the one before to pass the previous frame
+     * check above, yet adds nothing new.
+     */
+    fp = 0;
+    if (siz->diff_fract > 0.0) {
+	fp = frame_fingerprint(siz->chaos, siz->chaos_len);
+	for (i = 0; i < siz->fp_cnt; ++i) {
+	    if (siz->fp_hist[i] == fp) {
+		++siz->insane_cnt;
+		return LAVACAM_ERR_REPEAT;
+	    }
+	}
+    }
+
+    /*
+     * estimate the min-entropy of this sane frame
+     */
+    if (stats->octet_entropy >= 0.0 && diff_entropy >= 0.0) {
+	siz->entropy = ((stats->octet_entropy < diff_entropy) ?
+			stats->octet_entropy : diff_entropy) *
+		       (double)siz->chaos_len;
     }
 
     /*
@@ -1069,7 +1400,12 @@ lavacam_sanity(struct opsize *siz)
      * this frame the new previous frame for next time.
      */
     if (siz->diff_fract > 0.0) {
-	memcpy(siz->prev_frame, siz->chaos, siz->chaos_len);
+	lavacam_keep_frame(siz);
+	siz->fp_hist[siz->fp_next] = fp;
+	siz->fp_next = (siz->fp_next + 1) % LAVACAM_FP_HIST;
+	if (siz->fp_cnt < LAVACAM_FP_HIST) {
+	    ++siz->fp_cnt;
+	}
     }
 
     /*
@@ -1080,57 +1416,1058 @@ lavacam_sanity(struct opsize *siz)
 
 
 /*
- * lavacam_msync - release/sync after processing a mmap captured buffer
+ * lavacam_keep_frame - keep the current frame as the previous frame
  *
  * given:
- *      type        type of camera
- *      cam_fd      open camera descriptor
- *      cam         pointer to camera parameters
  *      siz         pointer to operation size and buffer structure
  *
- * returns:
- *      0 ==> OK, <0 ==> error
+ * The current chaos frame becomes the prev_frame of the struct opsize,
+ * ready for the next lavacam_sanity() bit difference check.
+ *
+ * When the frames stay where they are after the next frame is obtained,
+ * prev_frame just points at the current chaos frame and nothing is copied.
+ * This is the case when reading into a ring of image buffers (the next
+ * lavacam_get_frame() reads into another buffer), or when a driver leaves
+ * each frame in its own place in a mmapped region.  Otherwise the frame
+ * is copied into the prev_buf buffer set up by lavacam_frame_alloc().
  */
-int
-lavacam_msync(int type, int cam_fd, union lavacam *cam, struct opsize *siz)
+void
+lavacam_keep_frame(struct opsize *siz)
 {
     /*
      * firewall
      */
-    if (VALID_TYPE(type) || cam_fd < 0 || cam == NULL || siz == NULL) {
-	return LAVACAM_ERR_ARG;
+    if (siz == NULL || siz->chaos == NULL) {
+	return;
     }
 
     /*
-     * mmap the camera
+     * copy only if the next frame will be obtained over this one
      */
-    return cam_switch[type].msync(cam_fd, cam, siz);
+    if (siz->prev_buf != NULL) {
+	memcpy(siz->prev_buf, siz->chaos, siz->chaos_len);
+	siz->prev_frame = siz->prev_buf;
+    } else {
+	siz->prev_frame = siz->chaos;
+    }
+    return;
+}
+
+
+/*
+ * tile_cmp - qsort compare of two lavacam_extract() tile scores
+ */
+static int
+tile_cmp(const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
 }
 
 
 /*
- * lavacam_wait_frame - use select to wait for the next camera frame
+ * lavacam_extract - pack the noisy part of a sane chaos frame densely
  *
  * given:
- *      type        type of camera
- *      cam_fd      open camera descriptor
- *      max_wait    wait for up to this many seconds, <0.0 ==> infinite
+ *      siz         pointer to operation size and buffer structure
+ *      planes      low order bit-planes of each octet to keep, 1 to 8
+ *      tiles       fraction of the frame tiles to keep, >0.0 to 1.0
+ *      buf         where to pack the kept bits
+ *      buflen      length of buf in octets
+ *      p_entropy   where to record the est min-entropy of buf in bits
  *
  * returns:
- *      1 ==> frame is ready, 0 ==> timeout, <0 ==> error
+ *      octets packed into buf, or <0 ==> error
+ *
+ * Not all of a chaos frame is equally chaotic.  The high order bits of
+ * an octet change less than the low order bits, and the flat parts of
+ * an image change less than the rest.  This function keeps only the
+ * low planes bits of each octet, from only the tiles fraction of the
+ * frame tiles that are the least flat, and packs them into buf.  The
+ * tiles are kept in frame order.  LavaRnd processing the smaller buf
+ * takes less hashing for the same entropy.
+ *
+ * A tile is scored by the tally of its most common octet value.  A tile
+ * with a lower score is less flat.  When tiles is 1.0, all tiles are
+ * kept and they are not scored.
+ *
+ * The entropy estimate of buf is the lesser of the frame entropy estimate
+ * in proportion to the bits kept, and the octet min-entropy of buf.
+ * Because the kept bits are the most chaotic, the 1st is cautious.
+ * The *p_entropy is set to -1.0 if the frame has no entropy estimate.
+ *
+ * NOTE: This function must be called after lavacam_sanity() and before
+ *	 lavacam_msync(), while siz->chaos is the current sane frame.
+ *	 A buf of siz->chaos_len octets is always long enough.
  */
 int
-lavacam_wait_frame(int type, int cam_fd, double max_wait)
+lavacam_extract(struct opsize *siz, int planes, double tiles,
+		u_int8_t *buf, int buflen, double *p_entropy)
 {
+    int score[LAVACAM_MAX_TILE];	/* tile scores in frame order */
+    int order[LAVACAM_MAX_TILE];	/* tile scores in increasing order */
+    int tally[OCTET_CNT];	/* tally of octet values in a tile */
+    struct lavacam_stats stats;	/* octet tally of buf */
+    u_int8_t *frame;		/* chaos frame */
+    u_int8_t *tile;		/* start of a tile */
+    u_int8_t *out;		/* next octet of buf to pack */
+    u_int8_t mask;		/* low planes bits of an octet */
+    u_int32_t acc;		/* bits waiting to be packed */
+    int nbits;			/* number of bits waiting in acc */
+    int tile_len;		/* octets in a tile */
+    int ntile;			/* tiles in the frame */
+    int keep;			/* tiles to keep */
+    int ties;			/* tiles to keep whose score is the cutoff */
+    int cutoff;			/* highest score of a kept tile */
+    int kept;			/* octets of the frame kept */
+    int len;			/* octets in this tile */
+    int max;			/* tally of the most common octet in a tile */
+    int i;
+    int j;
+
     /*
      * firewall
      */
-    if (VALID_TYPE(type) || cam_fd < 0) {
+    if (siz == NULL || buf == NULL || p_entropy == NULL) {
+	return LAVACAM_ERR_ARG;
+    }
+    *p_entropy = -1.0;
+    if (planes < 1 || planes > BITS_PER_OCTET || tiles <= 0.0 || tiles > 1.0) {
+	return LAVACAM_ERR_ARG;
+    }
+    frame = (u_int8_t *)siz->chaos;
+    if (frame == NULL || siz->chaos_len <= 0) {
+	return 0;
+    }
+    if (buflen < (siz->chaos_len*planes + BITS_PER_OCTET-1) / BITS_PER_OCTET) {
 	return LAVACAM_ERR_ARG;
     }
 
     /*
-     * wait until the next frame
+     * divide the frame into tiles
      */
-    return cam_switch[type].wait_frame(cam_fd, max_wait);
+    tile_len = (siz->chaos_len + LAVACAM_MAX_TILE-1) / LAVACAM_MAX_TILE;
+    if (tile_len < LAVACAM_TILE) {
+	tile_len = LAVACAM_TILE;
+    }
+    ntile = (siz->chaos_len + tile_len-1) / tile_len;
+    keep = (int)ceil((double)ntile * tiles);
+    if (keep < 1) {
+	keep = 1;
+    } else if (keep > ntile) {
+	keep = ntile;
+    }
+
+    /*
+     * score the tiles and find the score cutoff of the tiles to keep
+     */
+    cutoff = siz->chaos_len;
+    ties = ntile;
+    if (keep < ntile) {
+	for (i = 0; i < ntile; ++i) {
+	    tile = frame + i*tile_len;
+	    len = ((i < ntile-1) ? tile_len : siz->chaos_len - i*tile_len);
+	    memset(tally, 0, sizeof(tally));
+	    for (j = 0; j < len; ++j) {
+		tally[tile[j]]++;
+	    }
+	    max = 0;
+	    for (j = 0; j < OCTET_CNT; ++j) {
+		if (tally[j] > max) {
+		    max = tally[j];
+		}
+	    }
+	    /* a short last tile is scored as if it were full length */
+	    score[i] = (int)((double)max * (double)tile_len / (double)len);
+	    order[i] = score[i];
+	}
+	qsort(order, ntile, sizeof(order[0]), tile_cmp);
+	cutoff = order[keep-1];
+	ties = 0;
+	for (i = keep-1; i >= 0 && order[i] == cutoff; --i) {
+	    ++ties;
+	}
+    }
+
+    /*
+     * pack the low planes bits of the octets of the kept tiles
+     */
+    mask = (u_int8_t)((1 << planes) - 1);
+    out = buf;
+    acc = 0;
+    nbits = 0;
+    kept = 0;
+    for (i = 0; i < ntile; ++i) {
+
+	/* skip tiles that are too flat */
+	if (keep < ntile) {
+	    if (score[i] > cutoff) {
+		continue;
+	    } else if (score[i] == cutoff) {
+		if (ties <= 0) {
+		    continue;
+		}
+		--ties;
+	    }
+	}
+	tile = frame + i*tile_len;
+	len = ((i < ntile-1) ? tile_len : siz->chaos_len - i*tile_len);
+	kept += len;
+
+	/* all planes need no packing */
+	if (planes == BITS_PER_OCTET) {
+	    memcpy(out, tile, len);
+	    out += len;
+	    continue;
+	}
+	for (j = 0; j < len; ++j) {
+	    acc = (acc << planes) | (tile[j] & mask);
+	    nbits += planes;
+	    if (nbits >= BITS_PER_OCTET) {
+		nbits -= BITS_PER_OCTET;
+		*out++ = (u_int8_t)(acc >> nbits);
+	    }
+	}
+    }
+    if (nbits > 0) {
+	*out++ = (u_int8_t)(acc << (BITS_PER_OCTET - nbits));
+    }
+
+    /*
+     * estimate the min-entropy of buf
+     */
+    if (siz->entropy >= 0.0 &&
+	lavacam_frame_stats(buf, NULL, out - buf, 0, LAVACAM_STAT_TALLY,
+			    &stats) == LAVAERR_OK) {
+	*p_entropy = siz->entropy * (double)kept * (double)planes /
+		     ((double)siz->chaos_len * (double)BITS_PER_OCTET);
+	if (stats.octet_entropy * (double)(out - buf) < *p_entropy) {
+	    *p_entropy = stats.octet_entropy * (double)(out - buf);
+	}
+    }
+    return out - buf;
+}
+
+/*
+ * lavacam_frame_alloc - allocate frame buffers for a newly opened camera
+ *
+ * given:
+ *      siz         pointer to operation size and buffer structure
+ *      lavaoff     offset in a read image buffer to chaotic data
+ *      stable      TRUE ==> mmapped frames stay put after the next frame
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ *
+ * The use_read, image_len and chaos_len elements of the struct opsize must
+ * be set before calling this function.  When mmapping, the image and chaos
+ * elements must also be set.
+ *
+ * When reading, this function allocates a ring of LAVACAM_RING image
+ * buffers and sets the image and chaos elements to the first one.
+ * When mmapping a region where the next frame is captured over the
+ * current one (stable == FALSE), this function allocates the prev_buf
+ * buffer that lavacam_keep_frame() copies the previous frame into.
+ *
+ * NOTE: A driver that calls this function must call lavacam_frame_free()
+ *	 in place of freeing a read image buffer.
+ */
+int
+lavacam_frame_alloc(struct opsize *siz, int lavaoff, int stable)
+{
+    int i;
+
+    /*
+     * firewall
+     */
+    if (siz == NULL || siz->chaos_len <= 0 ||
+	(siz->use_read && (lavaoff < 0 || siz->image_len <= 0 ||
+			   lavaoff + siz->chaos_len > siz->image_len))) {
+	return LAVACAM_ERR_ARG;
+    }
+    siz->prev_frame = NULL;
+    siz->prev_buf = NULL;
+    for (i = 0; i < LAVACAM_RING; ++i) {
+	siz->ring[i] = NULL;
+    }
+    siz->ring_indx = 0;
+
+    /*
+     * read setup - a ring of image buffers
+     */
+    if (siz->use_read) {
+	for (i = 0; i < LAVACAM_RING; ++i) {
+	    siz->ring[i] = malloc(siz->image_len);
+	    if (siz->ring[i] == NULL) {
+		lavacam_frame_free(siz);
+		return LAVAERR_MALLOC;
+	    }
+	}
+	siz->image = siz->ring[0];
+	siz->chaos = (u_int8_t *)siz->image + lavaoff;
+
+    /*
+     * mmap setup - copy the previous frame unless the frames stay put
+     */
+    } else if (!stable) {
+	siz->prev_buf = malloc(siz->chaos_len);
+	if (siz->prev_buf == NULL) {
+	    return LAVAERR_MALLOC;
+	}
+    }
+    return LAVAERR_OK;
+}
+
+
+/*
+ * lavacam_frame_free - free frame buffers from lavacam_frame_alloc()
+ *
+ * given:
+ *      siz         pointer to operation size and buffer structure
+ *
+ * When reading, the image and chaos elements are cleared as they point
+ * into the freed ring.  A mmapped region is left for the driver to unmap.
+ */
+void
+lavacam_frame_free(struct opsize *siz)
+{
+    int i;
+
+    /*
+     * firewall
+     */
+    if (siz == NULL) {
+	return;
+    }
+
+    /*
+     * free the read image ring
+     */
+    for (i = 0; i < LAVACAM_RING; ++i) {
+	if (siz->ring[i] != NULL) {
+	    free(siz->ring[i]);
+	    siz->ring[i] = NULL;
+	}
+    }
+    if (siz->use_read) {
+	siz->image = NULL;
+	siz->chaos = NULL;
+    }
+    siz->ring_indx = 0;
+
+    /*
+     * free the previous frame copy
+     */
+    if (siz->prev_buf != NULL) {
+	free(siz->prev_buf);
+	siz->prev_buf = NULL;
+    }
+    siz->prev_frame = NULL;
+    return;
+}
+
+
+/*
+ * lavacam_mmap_init - empty the mmap frame capture queue
+ *
+ * given:
+ *      siz         pointer to operation size and buffer structure
+ *
+ * A mmap driver calls this function before it queues its mmap frames
+ * for capture with lavacam_mmap_push().
+ */
+void
+lavacam_mmap_init(struct opsize *siz)
+{
+    /*
+     * firewall
+     */
+    if (siz == NULL) {
+	return;
+    }
+
+    /*
+     * no frames queued, processed or held
+     */
+    siz->mmap_head = 0;
+    siz->mmap_queued = 0;
+    siz->mmap_cur = -1;
+    siz->mmap_held = -1;
+    return;
+}
+
+
+/*
+ * lavacam_mmap_push - note that a mmap frame was queued for capture
+ *
+ * given:
+ *      siz         pointer to operation size and buffer structure
+ *      frame       mmap frame number given to VIDIOCMCAPTURE
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ *
+ * The V4L mmap drivers capture frames in the order that they are queued
+ * with VIDIOCMCAPTURE.  This function and lavacam_mmap_pop() keep that
+ * order so that a driver waits, with VIDIOCSYNC, for the oldest queued
+ * frame while the camera goes on capturing into the others.
+ */
+int
+lavacam_mmap_push(struct opsize *siz, int frame)
+{
+    /*
+     * firewall
+     */
+    if (siz == NULL || frame < 0 || frame >= VIDEO_MAX_FRAME ||
+	siz->mmap_queued >= VIDEO_MAX_FRAME) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * add the frame to the end of the queue
+     */
+    siz->mmap_queue[(siz->mmap_head + siz->mmap_queued) % VIDEO_MAX_FRAME] =
+      frame;
+    ++siz->mmap_queued;
+    return LAVAERR_OK;
+}
+
+
+/*
+ * lavacam_mmap_pop - remove the oldest mmap frame queued for capture
+ *
+ * given:
+ *      siz         pointer to operation size and buffer structure
+ *
+ * returns:
+ *      >= 0 ==> oldest queued mmap frame number, <0 ==> error
+ *
+ * The frame returned becomes the mmap frame being processed.
+ */
+int
+lavacam_mmap_pop(struct opsize *siz)
+{
+    int frame;		/* oldest queued frame */
+
+    /*
+     * firewall
+     */
+    if (siz == NULL || siz->mmap_queued <= 0) {
+	return LAVACAM_ERR_SYNC;
+    }
+
+    /*
+     * remove the frame from the front of the queue
+     */
+    frame = siz->mmap_queue[siz->mmap_head];
+    siz->mmap_head = (siz->mmap_head + 1) % VIDEO_MAX_FRAME;
+    --siz->mmap_queued;
+    siz->mmap_cur = frame;
+    return frame;
+}
+
+
+/*
+ * lavacam_mmap_release - determine which mmap frame to capture into again
+ *
+ * given:
+ *      siz         pointer to operation size and buffer structure
+ *
+ * returns:
+ *      >= 0 ==> mmap frame to queue for capture, <0 ==> none
+ *
+ * This function is called when the mmap frame being processed is done.
+ * Usually that frame is returned so that it may be queued again.
+ *
+ * However if that frame was kept as the previous frame by lavacam_sanity()
+ * without being copied, then it is held out of the capture queue so that
+ * it stays put for the next bit difference check.  The frame that was
+ * held before it is returned instead, if any.
+ */
+int
+lavacam_mmap_release(struct opsize *siz)
+{
+    int frame;		/* frame to capture into again */
+    int held;		/* frame held before this one */
+
+    /*
+     * firewall
+     */
+    if (siz == NULL || siz->mmap_cur < 0) {
+	return -1;
+    }
+    frame = siz->mmap_cur;
+    siz->mmap_cur = -1;
+
+    /*
+     * hold the frame if it is now the previous frame
+     */
+    if (siz->prev_buf == NULL && siz->prev_frame != NULL &&
+	siz->prev_frame == siz->chaos) {
+	held = siz->mmap_held;
+	siz->mmap_held = frame;
+	frame = held;
+    }
+    return frame;
+}
+
+
+/*
+ * lavacam_msync - release/sync after processing a mmap captured buffer
+ *
+ * given:
+ *      type        type of camera
+ *      cam_fd      open camera descriptor
+ *      cam         pointer to camera parameters
+ *      siz         pointer to operation size and buffer structure
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ */
+int
+lavacam_msync(int type, int cam_fd, union lavacam *cam, struct opsize *siz)
+{
+    /*
+     * firewall
+     */
+    if (VALID_TYPE(type) || cam_fd < 0 || cam == NULL || siz == NULL) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * mmap the camera
+     */
+    return cam_switch[type].msync(cam_fd, cam, siz);
+}
+
+
+/*
+ * lavacam_wait_frame - use poll to wait for the next camera frame
+ *
+ * given:
+ *      type        type of camera
+ *      cam_fd      open camera descriptor
+ *      max_wait    wait for up to this many seconds, <0.0 ==> infinite
+ *
+ * returns:
+ *      1 ==> frame is ready, 0 ==> timeout, <0 ==> error
+ *
+ * NOTE: This function polls the descriptor returned by lavacam_frame_fd().
+ */
+int
+lavacam_wait_frame(int type, int cam_fd, double max_wait)
+{
+    /*
+     * firewall
+     */
+    if (VALID_TYPE(type) || cam_fd < 0) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * wait until the next frame
+     */
+    return cam_switch[type].wait_frame(cam_fd, max_wait);
+}
+
+
+/*
+ * lavacam_frame_fd - descriptor that becomes readable when a frame is ready
+ *
+ * given:
+ *      type        type of camera
+ *      cam_fd      open camera descriptor
+ *
+ * returns:
+ *      descriptor to poll or select on for reading, <0 ==> error
+ *
+ * This is the camera descriptor, unless a sync thread is waiting for the
+ * mmap frames of the camera.  Then it is the read end of the pipe that
+ * the sync thread writes to when a frame has been captured.  See
+ * lavacam_sync_start().
+ *
+ * NOTE: An event loop should poll or select on this descriptor instead
+ *	 of calling lavacam_wait_frame().  Do not read from it.
+ */
+int
+lavacam_frame_fd(int type, int cam_fd)
+{
+    /*
+     * firewall
+     */
+    if (VALID_TYPE(type) || cam_fd < 0) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * return the frame ready descriptor
+     */
+    return lavacam_sync_fd(cam_fd);
+}
+
+
+/*
+ * lavacam_poll_frame - use poll to wait for a descriptor to become readable
+ *
+ * given:
+ *      fd          descriptor from lavacam_frame_fd()
+ *      max_wait    wait for up to this many seconds, <0.0 ==> infinite
+ *
+ * returns:
+ *      1 ==> frame is ready, 0 ==> timeout, <0 ==> error
+ *
+ * The xyz_wait_frame() driver functions call this function.  Unlike
+ * select(), poll() has no FD_SETSIZE limit on the descriptor.
+ *
+ * NOTE: A descriptor that polls with an error or hangup, but not as
+ *	 readable, is returned as LAVACAM_ERR_IOERR.  A streaming V4L2
+ *	 camera does this when it has no buffer queued to fill.
+ */
+int
+lavacam_poll_frame(int fd, double max_wait)
+{
+    struct pollfd pfd;		/* descriptor poll state */
+    int timeout = -1;		/* poll timeout in milliseconds, -1 ==> none */
+    int ret;			/* poll return value */
+    double start = 0.0;		/* pre-poll time */
+    double end;			/* post-poll time */
+    double delay;		/* time spent in poll() */
+
+    /*
+     * firewall
+     */
+    if (fd < 0) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * common poll setup
+     */
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (max_wait >= 0.0) {
+	timeout = (max_wait >= 2147483.0) ?
+		  0x7fffffff : (int)(max_wait * 1000.0 + 0.999);
+	start = right_now();
+	if (start < 0.0) {
+	    return LAVAERR_GETTIME;
+	}
+    }
+
+    /*
+     * wait for the next frame or until we wait too long (if max_wait)
+     */
+    do {
+	/* clear system error code */
+	errno = 0;
+
+	/*
+	 * poll
+	 */
+	ret = poll(&pfd, 1, timeout);
+
+	/*
+	 * adjust poll time based on how long we just waited
+	 */
+	if (ret < 0 && errno == EINTR && max_wait >= 0.0) {
+	    end = right_now();
+	    if (end < 0.0) {
+		return LAVAERR_GETTIME;
+	    }
+	    delay = end - start;
+	    if (delay >= max_wait) {
+		ret = 0;
+		break;
+	    }
+	    timeout = (max_wait - delay >= 2147483.0) ?
+		      0x7fffffff : (int)((max_wait - delay) * 1000.0 + 0.999);
+	}
+    } while (ret < 0 && errno == EINTR);
+
+    /*
+     * return poll status
+     */
+    if (ret < 0) {
+	return LAVACAM_ERR_IOERR;
+    }
+    if (ret > 0 && !(pfd.revents & POLLIN)) {
+	return LAVACAM_ERR_IOERR;
+    }
+    return ret;
+}
+
+
+/*
+ * lavacam_sync_find - find the sync thread state of an open camera
+ *
+ * given:
+ *      cam_fd      open camera descriptor
+ *
+ * returns:
+ *      sync thread state or NULL ==> camera has no sync thread
+ *
+ * NOTE: The caller must hold lavacam_sync_lock.
+ */
+static struct lavacam_sync *
+lavacam_sync_find(int cam_fd)
+{
+    int i;
+
+    for (i = 0; i < LAVACAM_SYNC_MAX; ++i) {
+	if (lavacam_sync[i].inuse && lavacam_sync[i].cam_fd == cam_fd) {
+	    return &lavacam_sync[i];
+	}
+    }
+    return NULL;
+}
+
+
+/*
+ * lavacam_sync_thread - wait for mmap frames on behalf of a camera
+ *
+ * given:
+ *      arg         sync thread state of the camera
+ *
+ * returns:
+ *      NULL
+ *
+ * The frames are waited for in the order they were queued.  One octet
+ * is written to the pipe for each frame that the wait is over for, be
+ * it captured or failed.  After a failed wait this thread stops waiting.
+ */
+static void *
+lavacam_sync_thread(void *arg)
+{
+    struct lavacam_sync *s = (struct lavacam_sync *)arg;	/* our state */
+    int frame;			/* frame to wait for */
+    int indx;			/* queue index of frame */
+    int ret;			/* sync return */
+
+    (void) pthread_mutex_lock(&s->lock);
+    while (!s->stop) {
+
+	/*
+	 * wait for a frame that has been queued but not yet waited for
+	 */
+	if (s->synced >= s->queued) {
+	    (void) pthread_cond_wait(&s->cond, &s->lock);
+	    continue;
+	}
+	indx = (s->head + s->synced) % VIDEO_MAX_FRAME;
+	frame = s->queue[indx];
+
+	/*
+	 * wait for the camera to capture the frame
+	 */
+	(void) pthread_mutex_unlock(&s->lock);
+	ret = s->sync(s->cam_fd, frame);
+	(void) pthread_mutex_lock(&s->lock);
+
+	/*
+	 * note the result and announce it
+	 */
+	s->result[indx] = ret;
+	++s->synced;
+	if (write(s->ready_fd[1], "", 1) != 1 || ret < 0) {
+	    s->stop = TRUE;
+	}
+    }
+    (void) pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+
+/*
+ * lavacam_sync_start - start a thread to wait for the mmap frames of a camera
+ *
+ * given:
+ *      cam_fd      open camera descriptor
+ *      siz         pointer to operation size and buffer structure
+ *      sync        function that waits for a mmap frame to be captured
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ *
+ * A V4L mmap driver waits for a frame with VIDIOCSYNC, and a V4L camera
+ * descriptor need not poll as readable when a mmap frame is captured.
+ * So that an event loop can sleep until a frame is ready, and not in
+ * VIDIOCSYNC, the sync thread does the waiting.  When a frame has been
+ * captured, it writes to a pipe whose read end lavacam_frame_fd() then
+ * returns.
+ *
+ * The frames that siz says are queued for capture are waited for first,
+ * then those given to lavacam_sync_queue() as they are queued again.
+ * The driver obtains each frame, in turn, with lavacam_sync_frame().
+ *
+ * NOTE: The sync function is called in the sync thread.  It may be
+ *	 called while the driver queues another frame.
+ *
+ * NOTE: lavacam_sync_stop() must be called before the mmapped frames
+ *	 are unmapped or the camera is closed.
+ */
+int
+lavacam_sync_start(int cam_fd, struct opsize *siz, lavacam_sync_func sync)
+{
+    struct lavacam_sync *s;	/* sync thread state */
+    int i;
+
+    /*
+     * firewall
+     */
+    if (cam_fd < 0 || siz == NULL || sync == NULL || siz->use_read ||
+	siz->mmap_queued <= 0 || siz->mmap_queued > VIDEO_MAX_FRAME) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * find a free sync thread slot
+     */
+    (void) pthread_mutex_lock(&lavacam_sync_lock);
+    if (lavacam_sync_find(cam_fd) != NULL) {
+	(void) pthread_mutex_unlock(&lavacam_sync_lock);
+	return LAVACAM_ERR_ARG;
+    }
+    for (i = 0, s = NULL; i < LAVACAM_SYNC_MAX; ++i) {
+	if (!lavacam_sync[i].inuse) {
+	    s = &lavacam_sync[i];
+	    break;
+	}
+    }
+    if (s == NULL) {
+	(void) pthread_mutex_unlock(&lavacam_sync_lock);
+	return LAVACAM_ERR_OPEN;
+    }
+
+    /*
+     * setup the frame ready pipe
+     */
+    memset(s, 0, sizeof(s[0]));
+    if (pipe(s->ready_fd) < 0) {
+	(void) pthread_mutex_unlock(&lavacam_sync_lock);
+	return LAVACAM_ERR_OPEN;
+    }
+    for (i = 0; i < 2; ++i) {
+	(void) fcntl(s->ready_fd[i], F_SETFD, FD_CLOEXEC);
+	(void) fcntl(s->ready_fd[i], F_SETFL,
+		     fcntl(s->ready_fd[i], F_GETFL) | O_NONBLOCK);
+    }
+
+    /*
+     * copy the capture queue
+     */
+    s->cam_fd = cam_fd;
+    s->sync = sync;
+    for (i = 0; i < siz->mmap_queued; ++i) {
+	s->queue[i] =
+	  siz->mmap_queue[(siz->mmap_head + i) % VIDEO_MAX_FRAME];
+    }
+    s->queued = siz->mmap_queued;
+
+    /*
+     * start the sync thread
+     */
+    (void) pthread_mutex_init(&s->lock, NULL);
+    (void) pthread_cond_init(&s->cond, NULL);
+    if (pthread_create(&s->thread, NULL, lavacam_sync_thread, s) != 0) {
+	(void) pthread_cond_destroy(&s->cond);
+	(void) pthread_mutex_destroy(&s->lock);
+	(void) close(s->ready_fd[0]);
+	(void) close(s->ready_fd[1]);
+	(void) pthread_mutex_unlock(&lavacam_sync_lock);
+	return LAVACAM_ERR_OPEN;
+    }
+    s->inuse = TRUE;
+    (void) pthread_mutex_unlock(&lavacam_sync_lock);
+    return LAVACAM_ERR_OK;
+}
+
+
+/*
+ * lavacam_sync_stop - stop the sync thread of a camera, if any
+ *
+ * given:
+ *      cam_fd      open camera descriptor
+ *
+ * NOTE: This function waits for the sync thread to return from a
+ *	 frame wait that is in progress.
+ */
+void
+lavacam_sync_stop(int cam_fd)
+{
+    struct lavacam_sync *s;	/* sync thread state */
+
+    /*
+     * find the sync thread, if any
+     */
+    (void) pthread_mutex_lock(&lavacam_sync_lock);
+    s = lavacam_sync_find(cam_fd);
+    if (s == NULL) {
+	(void) pthread_mutex_unlock(&lavacam_sync_lock);
+	return;
+    }
+
+    /*
+     * tell the thread to stop and wait for it
+     */
+    (void) pthread_mutex_lock(&s->lock);
+    s->stop = TRUE;
+    (void) pthread_cond_signal(&s->cond);
+    (void) pthread_mutex_unlock(&s->lock);
+    (void) pthread_join(s->thread, NULL);
+
+    /*
+     * release the sync thread state
+     */
+    (void) pthread_cond_destroy(&s->cond);
+    (void) pthread_mutex_destroy(&s->lock);
+    (void) close(s->ready_fd[0]);
+    (void) close(s->ready_fd[1]);
+    s->inuse = FALSE;
+    (void) pthread_mutex_unlock(&lavacam_sync_lock);
+    return;
+}
+
+
+/*
+ * lavacam_sync_fd - descriptor that becomes readable when a frame is ready
+ *
+ * given:
+ *      cam_fd      open camera descriptor
+ *
+ * returns:
+ *      read end of the sync thread pipe, or cam_fd if no sync thread
+ *
+ * The xyz_wait_frame() driver functions poll this descriptor.
+ */
+int
+lavacam_sync_fd(int cam_fd)
+{
+    struct lavacam_sync *s;	/* sync thread state */
+    int fd;			/* descriptor to poll */
+
+    (void) pthread_mutex_lock(&lavacam_sync_lock);
+    s = lavacam_sync_find(cam_fd);
+    fd = (s == NULL) ? cam_fd : s->ready_fd[0];
+    (void) pthread_mutex_unlock(&lavacam_sync_lock);
+    return fd;
+}
+
+
+/*
+ * lavacam_sync_queue - note that a mmap frame was queued for capture again
+ *
+ * given:
+ *      cam_fd      open camera descriptor
+ *      frame       mmap frame number given to VIDIOCMCAPTURE
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ *
+ * This function does nothing if the camera has no sync thread.
+ */
+int
+lavacam_sync_queue(int cam_fd, int frame)
+{
+    struct lavacam_sync *s;	/* sync thread state */
+    int ret = LAVACAM_ERR_OK;	/* return value */
+
+    /*
+     * firewall
+     */
+    if (frame < 0 || frame >= VIDEO_MAX_FRAME) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * add the frame to the end of the sync thread queue
+     */
+    (void) pthread_mutex_lock(&lavacam_sync_lock);
+    s = lavacam_sync_find(cam_fd);
+    if (s != NULL) {
+	(void) pthread_mutex_lock(&s->lock);
+	if (s->queued >= VIDEO_MAX_FRAME) {
+	    ret = LAVACAM_ERR_SYNC;
+	} else {
+	    s->queue[(s->head + s->queued) % VIDEO_MAX_FRAME] = frame;
+	    ++s->queued;
+	    (void) pthread_cond_signal(&s->cond);
+	}
+	(void) pthread_mutex_unlock(&s->lock);
+    }
+    (void) pthread_mutex_unlock(&lavacam_sync_lock);
+    return ret;
+}
+
+
+/*
+ * lavacam_sync_frame - wait for a mmap frame to be captured
+ *
+ * given:
+ *      cam_fd      open camera descriptor
+ *      frame       oldest mmap frame queued for capture
+ *      sync        function that waits for a mmap frame to be captured
+ *
+ * returns:
+ *      >= 0 ==> frame was captured, <0 ==> error
+ *
+ * If the camera has a sync thread, this function takes the result of
+ * the thread's wait for the frame, waiting for the thread if needed.
+ * Otherwise it calls sync itself.
+ */
+int
+lavacam_sync_frame(int cam_fd, int frame, lavacam_sync_func sync)
+{
+    struct lavacam_sync *s;	/* sync thread state */
+    char octet;			/* frame ready octet */
+    int ret;			/* return value */
+
+    /*
+     * firewall
+     */
+    if (cam_fd < 0 || sync == NULL) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * wait in this thread if there is no sync thread
+     */
+    (void) pthread_mutex_lock(&lavacam_sync_lock);
+    s = lavacam_sync_find(cam_fd);
+    (void) pthread_mutex_unlock(&lavacam_sync_lock);
+    if (s == NULL) {
+	return sync(cam_fd, frame);
+    }
+
+    /*
+     * take the frame ready octet, waiting for it if needed
+     */
+    do {
+	ret = read(s->ready_fd[0], &octet, 1);
+	if (ret < 0 && errno == EAGAIN) {
+	    ret = lavacam_poll_frame(s->ready_fd[0], -1.0);
+	    if (ret < 0) {
+		return LAVACAM_ERR_SYNC;
+	    }
+	    ret = -1;
+	    errno = EINTR;
+	}
+    } while (ret < 0 && errno == EINTR);
+    if (ret != 1) {
+	return LAVACAM_ERR_SYNC;
+    }
+
+    /*
+     * take the result of the oldest frame
+     */
+    (void) pthread_mutex_lock(&s->lock);
+    if (s->synced <= 0 || s->queue[s->head] != frame) {
+	ret = LAVACAM_ERR_SYNC;
+    } else {
+	ret = s->result[s->head];
+	s->head = (s->head + 1) % VIDEO_MAX_FRAME;
+	--s->queued;
+	--s->synced;
+    }
+    (void) pthread_mutex_unlock(&s->lock);
+    return ret;
 }
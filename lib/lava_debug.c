@@ -748,6 +748,8 @@ lava_err_name(int err)
 	return "top half_x is more than half of frame";
     case LAVACAM_ERR_PALUNSET:
 	return "pallette has not been set for camera";
+    case LAVACAM_ERR_REPEAT:
+	return "frame repeats a recent sane frame";
     }
     return "unknown error";
 }
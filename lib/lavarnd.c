@@ -1055,6 +1055,66 @@ lavarnd_len(int inlen, double rate)
 }
 
 
+/*
+ * lava_entropy_rate - highest rate that an input min-entropy estimate allows
+ *
+ * given:
+ *	inlen		length of the input buffer (not counting any salt)
+ *	entropy		estimated min-entropy of the input in bits
+ *
+ * returns:
+ *	highest rate, up to LAVA_MAX_RATE, for which lavarnd() returns
+ *	    no more than 1 bit for every LAVA_ENTROPY_MARGIN bits of
+ *	    estimated min-entropy, or 0.0 ==> input too poor for any output
+ *
+ * The nway value, and thus the lavarnd() output, must be 1 or 5 mod 6.
+ * We find the largest such nway value within the min-entropy budget
+ * and return the rate that lava_nway_value() maps onto that nway value.
+ *
+ * NOTE: The estimate should be a min-entropy, not a Shannon entropy,
+ *	 estimate.  LAVA_ENTROPY_MARGIN is a further safety margin for
+ *	 the estimate being too high.
+ */
+double
+lava_entropy_rate(int inlen, double entropy)
+{
+    double rate;	/* rate to return */
+    int nway;		/* largest nway value within the budget */
+
+    /*
+     * firewall
+     */
+    if (inlen <= 0 || entropy <= 0.0) {
+	return 0.0;
+    }
+
+    /*
+     * determine the largest nway value that is 1 or 5 mod 6 within budget
+     */
+    nway = (int)(entropy / LAVA_ENTROPY_MARGIN /
+		 (double)(SHA_DIGESTSIZE*8));
+    if (nway < 1) {
+	return 0.0;
+    }
+    while (nway % 6 != 1 && nway % 6 != 5) {
+	--nway;
+    }
+
+    /*
+     * nway = sqrt(inlen*rate / SHA_BLOCKSIZE) solved for rate
+     *
+     * Should rounding leave the sqrt just below nway, lava_nway_value()
+     * will round it back up to this nway value.
+     */
+    rate = (double)nway * (double)nway * (double)SHA_BLOCKSIZE /
+	   (double)inlen;
+    if (rate > LAVA_MAX_RATE) {
+	rate = LAVA_MAX_RATE;
+    }
+    return rate;
+}
+
+
 /*
  * lavarnd - Perform the lavarnd process
  *
@@ -59,7 +59,6 @@
 #include "LavaRnd/lavaerr.h"
 
 #include "LavaRnd/have/cam_videodev.h"
-#include "LavaRnd/have/have_pselect.h"
 
 
 /*
@@ -405,6 +404,51 @@ ov511_opsize(int cam_fd, union lavacam *u_cam_p, struct opsize *siz,
 }
 
 
+/*
+ * ov511_frame_base - offset of the start of a frame in the mmapped buffer
+ *
+ * given:
+ *      siz         pointer to operation size and buffer structure
+ *      frame       mmap frame number
+ *
+ * returns:
+ *      offset of frame within siz->image
+ *
+ * The offsets come from the VIDIOCGMBUF ioctl when the driver gives them.
+ */
+static int
+ov511_frame_base(struct opsize *siz, int frame)
+{
+    if (siz->frames < VIDEO_MAX_FRAME && siz->offsets[frame] > 0) {
+	return siz->offsets[frame];
+    }
+    return frame * siz->framesize;
+}
+
+
+/*
+ * ov511_frame_off - offset of chaotic data of a frame in the mmapped buffer
+ *
+ * given:
+ *      siz         pointer to operation size and buffer structure
+ *      frame       mmap frame number
+ *
+ * returns:
+ *      offset of the chaotic data of frame within siz->image
+ *
+ * See ov511_frame_base().
+ *
+ * NOTE: The mmap_lavaoff struct opsize element is the offset of the
+ *	 chaotic data within the last frame.
+ */
+static int
+ov511_frame_off(struct opsize *siz, int frame)
+{
+    return siz->mmap_lavaoff - ov511_frame_base(siz, siz->frames - 1) +
+	   ov511_frame_base(siz, frame);
+}
+
+
 /*
  * ov511_mmap - mmap camera buffer
  *
@@ -421,6 +465,7 @@ ov511_mmap(int cam_fd, union lavacam *u_cam_p, struct opsize *siz)
 {
     struct video_mmap vm;	/* video buffer description */
     void *ret;			/* close return value */
+    int i;
 
     /*
      * firewall
@@ -446,25 +491,48 @@ ov511_mmap(int cam_fd, union lavacam *u_cam_p, struct opsize *siz)
     siz->image = ret;
 
     /*
-     * set mmap image size
+     * queue every mmap frame for capture
+     *
+     * The camera captures into the other frames while one frame is
+     * being processed.  See ov511_get_frame() and ov511_msync().
      */
-    vm.frame = siz->frames - 1;
+    lavacam_mmap_init(siz);
     vm.format = siz->palette;
     vm.height = siz->height;
     vm.width = siz->width;
-    if (ioctl(cam_fd, VIDIOCMCAPTURE, &vm) < 0) {
-	DBG(0);
-	return NULL;
+    for (i = 0; i < siz->frames && i < VIDEO_MAX_FRAME; ++i) {
+	vm.frame = i;
+	if (ioctl(cam_fd, VIDIOCMCAPTURE, &vm) < 0) {
+	    DBG(0);
+	    return NULL;
+	}
+	(void) lavacam_mmap_push(siz, i);
     }
+    return ret;
+}
 
-    /*
-     * sync our first frame
-     */
-    if (ov511_msync(cam_fd, u_cam_p, siz) < 0) {
-	DBG(0);
-	return NULL;
+
+/*
+ * ov511_sync - wait for a mmap frame to be captured
+ *
+ * given:
+ *      cam_fd      open camera descriptor
+ *      frame       mmap frame number queued with VIDIOCMCAPTURE
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ *
+ * NOTE: This function is given to lavacam_sync_start(), and so may be
+ *	 called by the sync thread of the camera.
+ */
+static int
+ov511_sync(int cam_fd, int frame)
+{
+    if (ioctl(cam_fd, VIDIOCSYNC, &frame) < 0) {
+	DBG(LAVACAM_ERR_SYNC);
+	return LAVACAM_ERR_SYNC;
     }
-    return ret;
+    return LAVACAM_ERR_OK;
 }
 
 
@@ -2053,13 +2121,12 @@ ov511_open(char *devname, int model, union lavacam *o_cam_p,
 	    DBG(LAVACAM_ERR_NOREAD);
 	    return LAVACAM_ERR_NOREAD;
 	}
-	siz->image = malloc(siz->image_len);
-	if (siz->image == NULL) {
+	siz->chaos_len = siz->read_lavalen;
+	ret = lavacam_frame_alloc(siz, siz->read_lavaoff, FALSE);
+	if (ret < 0) {
 	    DBG(LAVACAM_ERR_NOREAD);
 	    return LAVACAM_ERR_NOREAD;
 	}
-	siz->chaos = siz->image + siz->read_lavaoff;
-	siz->chaos_len = siz->read_lavalen;
 
     } else {
 
@@ -2077,15 +2144,21 @@ ov511_open(char *devname, int model, union lavacam *o_cam_p,
 	}
 	siz->chaos = siz->image + siz->mmap_lavaoff;
 	siz->chaos_len = siz->mmap_lavalen;
-    }
 
-    /*
-     * allocate and zero previous chaos frame buffer
-     */
-    siz->prev_frame = calloc(1, siz->chaos_len);
-    if (siz->prev_frame == NULL) {
-	DBG(LAVAERR_MALLOC);
-	return LAVAERR_MALLOC;
+	/*
+	 * With 3 or more mmap frames, the frame kept for the sanity check
+	 * is held out of the capture queue and compared in place, while
+	 * the camera still has a frame to capture into.  With fewer, the
+	 * previous frame is copied aside.
+	 */
+	ret = lavacam_frame_alloc(siz, siz->mmap_lavaoff, siz->frames >= 3);
+	if (ret < 0) {
+	    (void)munmap(siz->image, siz->image_len);
+	    siz->image = NULL;
+	    siz->image_len = 0;
+	    DBG(LAVAERR_MALLOC);
+	    return LAVAERR_MALLOC;
+	}
     }
 
     /*
@@ -2108,7 +2181,6 @@ ov511_open(char *devname, int model, union lavacam *o_cam_p,
     if (open_warmup > 0.0) {
 	double now;	/* current time as a double */
 	double end;	/* end of warmup time */
-    	double warmup_delay;	/* sleep between frames */
 
 	/*
 	 * setup timing loop
@@ -2119,7 +2191,6 @@ ov511_open(char *devname, int model, union lavacam *o_cam_p,
 	    return LAVAERR_GETTIME;
 	}
 	end = now + open_warmup;
-	warmup_delay = (double)open_warmup / 1000000.0;
 
 	/*
 	 * read until warm up time is over
@@ -2130,12 +2201,11 @@ ov511_open(char *devname, int model, union lavacam *o_cam_p,
 	     * wait for the next frame
 	     */
 	    if (ov511_wait_frame(cam_fd, end - now) < 0) {
-		if (siz->use_read && siz->image != NULL) {
-		    free(siz->image);
-		} else if (!siz->use_read && siz->image != NULL &&
-			   siz->image_len > 0) {
+		if (!siz->use_read && siz->image != NULL &&
+		    siz->image_len > 0) {
 		    (void)munmap(siz->image, siz->image_len);
 		}
+		lavacam_frame_free(siz);
 		siz->image = NULL;
 		siz->image_len = 0;
 		DBG(LAVACAM_ERR_WARMUP);
@@ -2143,17 +2213,14 @@ ov511_open(char *devname, int model, union lavacam *o_cam_p,
 	    }
 
 	    /*
-	     * read or mmap the next frame and toss it
-	     *
-	     * NOTE: This call is not really needed if mmaping
+	     * read or sync the next frame and toss it
 	     */
-	    if (siz->use_read && ov511_get_frame(cam_fd, siz) < 0) {
-		if (siz->use_read && siz->image != NULL) {
-		    free(siz->image);
-		} else if (!siz->use_read && siz->image != NULL &&
-			   siz->image_len > 0) {
+	    if (ov511_get_frame(cam_fd, siz) < 0) {
+		if (!siz->use_read && siz->image != NULL &&
+		    siz->image_len > 0) {
 		    (void)munmap(siz->image, siz->image_len);
 		}
+		lavacam_frame_free(siz);
 		siz->image = NULL;
 		siz->image_len = 0;
 		DBG(LAVACAM_ERR_WARMUP);
@@ -2173,28 +2240,29 @@ ov511_open(char *devname, int model, union lavacam *o_cam_p,
 	     */
 	    now = right_now();
 	    if (now < 0.0) {
-		if (siz->use_read && siz->image != NULL) {
-		    free(siz->image);
-		} else if (!siz->use_read && siz->image != NULL &&
-			   siz->image_len > 0) {
+		if (!siz->use_read && siz->image != NULL &&
+		    siz->image_len > 0) {
 		    (void)munmap(siz->image, siz->image_len);
 		}
+		lavacam_frame_free(siz);
 		siz->image = NULL;
 		siz->image_len = 0;
 		DBG(LAVAERR_GETTIME);
 		return LAVAERR_GETTIME;
 	    }
-
-	    /*
-	     * sleep a little bit before next frame, if needed
-	     */
-	    if (end > now) {
-	    	usleep((int)(1000000.0 *
-		    ((end-now) > warmup_delay) ? warmup_delay : (end-now)));
-	    }
 	}
     }
 
+    /*
+     * wait for mmap frames in a sync thread
+     *
+     * If the sync thread cannot be started, ov511_get_frame() waits
+     * for each frame itself.
+     */
+    if (!siz->use_read) {
+	(void) lavacam_sync_start(cam_fd, siz, ov511_sync);
+    }
+
     /*
      * return open file descriptor
      */
@@ -2227,29 +2295,17 @@ ov511_close(int cam_fd, struct opsize *siz, struct lavacam_flag *flag)
     }
 
     /*
-     * free read buffer if reading
+     * stop waiting for mmap frames, then munmap if mmapped
      */
-    if (siz->use_read) {
-	if (siz->image != NULL) {
-	    (void)free(siz->image);
-	}
-
-	/*
-	 * or munmap if mmapped
-	 */
-    } else {
-	if (siz->image != NULL && siz->image_len > 0) {
-	    (void)munmap(siz->image, siz->image_len);
-	}
+    lavacam_sync_stop(cam_fd);
+    if (!siz->use_read && siz->image != NULL && siz->image_len > 0) {
+	(void)munmap(siz->image, siz->image_len);
     }
 
     /*
-     * free previous chaos frame
+     * free read buffers and previous chaos frame
      */
-    if (siz->prev_frame != NULL) {
-	(void)free(siz->prev_frame);
-	siz->prev_frame = NULL;
-    }
+    lavacam_frame_free(siz);
 
     /*
      * clear read/mmap frame data
@@ -2294,23 +2350,24 @@ ov511_close(int cam_fd, struct opsize *siz, struct lavacam_flag *flag)
  * returns:
  *      >= 0 ==> chaos octets obtained, < 0 ==> error
  *
- * NOTE: One must call ov511_msync(), if mmapping, prior to calling
- *       this function.  To be on the safe side, always call ov511_msync()
- *       prior to calling this function.
+ * NOTE: One must call ov511_msync(), if mmapping, after processing
+ *       the frame obtained by this function and prior to calling
+ *       this function again.  To be on the safe side, always call
+ *       ov511_msync() after processing a frame.
  *
  * NOTE: To not block, call ov511_wait_frame() (or read select on the
- *       open file descriptor) before calling this function.
+ *       descriptor returned by lavacam_frame_fd()) before calling
+ *       this function.
  *
- * NOTE: To be honest, this function does nothing useful when mmaping.
- *       One can access the mmapped data (via siz->image or siz->chaos)
- *       without calling this function if ov511_msync() and ov511_wait_frame()
- *       are called before accessing the data.  However, there is no
- *       harm in calling this function if mmapping.
+ * NOTE: When mmapping, this function waits for the oldest frame queued
+ *	 for capture and points siz->chaos at it.  The camera goes on
+ *	 capturing into the other queued mmap frames in the meantime.
  */
 int
 ov511_get_frame(int cam_fd, struct opsize *siz)
 {
     int op_ret = 0;	/* read or mmap count */
+    int framenum;	/* which mmap frame we are waiting for */
 
     /*
      * firewall
@@ -2341,6 +2398,33 @@ ov511_get_frame(int cam_fd, struct opsize *siz)
 	    DBG(LAVACAM_ERR_FRAME);
 	    return LAVACAM_ERR_FRAME;
 	}
+
+    /*
+     * or wait for the oldest queued frame if mmapping
+     */
+    } else {
+
+	/*
+	 * the previous frame must be released with ov511_msync() first
+	 */
+	if (siz->mmap_cur >= 0) {
+	    DBG(LAVACAM_ERR_SYNC);
+	    return LAVACAM_ERR_SYNC;
+	}
+
+	/*
+	 * wait for the oldest frame to be captured
+	 */
+	framenum = lavacam_mmap_pop(siz);
+	if (framenum < 0) {
+	    DBG(LAVACAM_ERR_SYNC);
+	    return LAVACAM_ERR_SYNC;
+	}
+	if (lavacam_sync_frame(cam_fd, framenum, ov511_sync) < 0) {
+	    DBG(LAVACAM_ERR_SYNC);
+	    return LAVACAM_ERR_SYNC;
+	}
+	siz->chaos = siz->image + ov511_frame_off(siz, framenum);
     }
 
     /*
@@ -2362,6 +2446,11 @@ ov511_get_frame(int cam_fd, struct opsize *siz)
  *      0 ==> OK, <0 ==> error
  *
  * NOTE: If we a reading, we immediately return OK (0) after doing nothing.
+ *
+ * NOTE: When mmapping, the frame obtained by ov511_get_frame() is queued
+ *	 for capture again, unless lavacam_sanity() kept it as the previous
+ *	 frame.  A kept frame is held until the next frame is kept, and then
+ *	 the held frame is queued instead.
  */
 int
 ov511_msync(int cam_fd, union lavacam *u_cam_p, struct opsize *siz)
@@ -2397,16 +2486,16 @@ ov511_msync(int cam_fd, union lavacam *u_cam_p, struct opsize *siz)
     }
 
     /*
-     * release
+     * determine which frame, if any, to capture into again
      */
-    framenum = cam->frames - 1;
-    if (ioctl(cam_fd, VIDIOCSYNC, &framenum) < 0) {
-	DBG(LAVACAM_ERR_SYNC);
-	return LAVACAM_ERR_SYNC;
+    framenum = lavacam_mmap_release(siz);
+    if (framenum < 0) {
+	/* the frame is held for the next sanity check */
+	return LAVACAM_ERR_OK;
     }
 
     /*
-     * set mmap image size for the next frame
+     * queue the frame for capture
      */
     vm.frame = framenum;
     vm.format = cam->palette;
@@ -2416,12 +2505,17 @@ ov511_msync(int cam_fd, union lavacam *u_cam_p, struct opsize *siz)
 	DBG(LAVACAM_ERR_SYNC);
 	return LAVACAM_ERR_SYNC;
     }
+    (void) lavacam_mmap_push(siz, framenum);
+    if (lavacam_sync_queue(cam_fd, framenum) < 0) {
+	DBG(LAVACAM_ERR_SYNC);
+	return LAVACAM_ERR_SYNC;
+    }
     return LAVACAM_ERR_OK;
 }
 
 
 /*
- * ov511_wait_frame - use select to wait for the next camera frame
+ * ov511_wait_frame - use poll to wait for the next camera frame
  *
  * given:
  *      cam_fd      open camera descriptor
@@ -2429,89 +2523,30 @@ ov511_msync(int cam_fd, union lavacam *u_cam_p, struct opsize *siz)
  *
  * returns:
  *      1 ==> frame is ready, 0 ==> timeout, <0 ==> error
+ *
+ * NOTE: When the camera has a sync thread, this function waits for
+ *	 the thread to report a captured mmap frame.
  */
 int
 ov511_wait_frame(int cam_fd, double max_wait)
 {
-    fd_set rd_set;		/* select mask for reading */
-    struct timeval sel_wait;	/* select time, if >= 0 */
-    int ret;			/* select return value */
-    double start = 0.0;		/* pre-select time */
-    double end;			/* post-select time */
-    double delay;		/* time spent in select() or pselect() */
+    int ret;		/* poll return value */
 
     /*
      * firewall
      */
-    /* NOTE: timeout may be NULL */
     if (cam_fd < 0) {
 	DBG(LAVACAM_ERR_ARG);
 	return LAVACAM_ERR_ARG;
     }
 
-    /*
-     * common select setup
-     */
-    FD_ZERO(&rd_set);
-    FD_SET(cam_fd, &rd_set);
-    if (max_wait >= 0.0) {
-	sel_wait.tv_sec = double_to_tv_sec(max_wait);
-	sel_wait.tv_usec = double_to_tv_usec(max_wait);
-    }
-    /* keep track of time selected in case of signals */
-    if (max_wait >= 0.0) {
-	start = right_now();
-	if (start < 0.0) {
-	    DBG(LAVAERR_GETTIME);
-	    return LAVAERR_GETTIME;
-	}
-    }
-
     /*
      * wait for the next frame or until we wait too long (if max_wait)
      */
-    do {
-	/* clear system error code */
-	errno = 0;
-
-	/*
-	 * select
-	 */
-#if defined(HAVE_PSELECT)
-	if (max_wait >= 0.0) {
-	    ret = pselect(cam_fd + 1, &rd_set, NULL, NULL, &sel_wait, NULL);
-	} else {
-	    ret = pselect(cam_fd + 1, &rd_set, NULL, NULL, NULL, NULL);
-	}
-#else /* HAVE_PSELECT */
-	if (max_wait >= 0.0) {
-	    ret = select(cam_fd + 1, &rd_set, NULL, NULL, &sel_wait);
-	} else {
-	    ret = select(cam_fd + 1, &rd_set, NULL, NULL, NULL);
-	}
-#endif /* HAVE_PSELECT */
-
-	/*
-	 * adjust select time based on how long we just waited
-	 */
-	if (ret < 0 && errno == EINTR && max_wait >= 0.0) {
-	    end = right_now();
-	    if (end < 0.0) {
-		DBG(LAVAERR_GETTIME);
-		return LAVAERR_GETTIME;
-	    }
-	    delay = end - start;
-	    if (delay >= max_wait) {
-		break;
-	    }
-	    sel_wait.tv_sec = double_to_tv_sec(max_wait - delay);
-	    sel_wait.tv_usec = double_to_tv_usec(max_wait - delay);
-	}
-    } while (ret < 0 && errno == EINTR);
-
-    /*
-     * return select status
-     */
+    ret = lavacam_poll_frame(lavacam_sync_fd(cam_fd), max_wait);
+    if (ret < 0) {
+	DBG(ret);
+    }
     return ret;
 }
 
@@ -2541,6 +2576,7 @@ ov511_ioctl(int fd, int request, void *arg)
     case VIDIOCSYNC: name = "VIDIOCSYNC"; break;
     case VIDIOCGFBUF: name = "VIDIOCGFBUF"; break;
     case VIDIOCGUNIT: name = "VIDIOCGUNIT"; break;
+#if defined(OV511IOC_GINTVER)
     case OV511IOC_GINTVER: name = "OV511IOC_GINTVER"; break;
     case OV511IOC_GUSHORT: name = "OV511IOC_GUSHORT"; break;
     case OV511IOC_SUSHORT: name = "OV511IOC_SUSHORT"; break;
@@ -2548,9 +2584,15 @@ ov511_ioctl(int fd, int request, void *arg)
     case OV511IOC_SUINT: name = "OV511IOC_SUINT"; break;
     case OV511IOC_WI2C: name = "OV511IOC_WI2C"; break;
     case OV511IOC_RI2C: name = "OV511IOC_RI2C"; break;
+#endif /* OV511IOC_GINTVER */
     default: name = "((unknown))"; break;
     }
     fprintf(stderr, "ioctl(%d, %s, %p)\n", fd, name, arg);
+    if (request == (int)VIDIOCMCAPTURE) {
+	fprintf(stderr, "\tframe: %d\n", ((struct video_mmap *)arg)->frame);
+    } else if (request == (int)VIDIOCSYNC) {
+	fprintf(stderr, "\tframe: %d\n", *(int *)arg);
+    }
 
 #undef ioctl
     /*
@@ -0,0 +1,1704 @@
+/*
+ * replay_drvr - replay camdump/camdumpdir frames as if from a camera
+ *
+ * @(#) $Revision: 10.1 $
+ * @(#) $Id: replay_drvr.c,v 10.1 2003/08/18 06:44:37 lavarnd Exp $
+ *
+ * Copyright (c) 2000-2003 by Landon Curt Noll and Simon Cooper.
+ * All Rights Reserved.
+ *
+ * This is open software; you can redistribute it and/or modify it under
+ * the terms of the version 2.1 of the GNU Lesser General Public License
+ * as published by the Free Software Foundation.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General
+ * Public License for more details.
+ *
+ * The file COPYING contains important info about Licenses and Copyrights.
+ * Please read the COPYING file for details about this open software.
+ *
+ * A copy of version 2.1 of the GNU Lesser General Public License is
+ * distributed with calc under the filename COPYING-LGPL.  You should have
+ * received a copy with calc; if not, write to Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * For more information on LavaRnd: http://www.LavaRnd.org
+ *
+ * Share and enjoy! :-)
+ */
+
+
+/*
+ * NOTE: This is the raw interface to the frame replay driver.  You should
+ *       be calling the lavacam_*() routines in camop.c instead of directly
+ *       calling these functions.  For example, call lavacam_open() instead
+ *       of replay_open.  See the comment at the top of src/lib/camop.c for
+ *       sample code.  See also some of the tools under src/tool as well.
+ *
+ * The replay driver is not a camera.  Its devname is either:
+ *
+ *	a directory of frame files as written by camdumpdir
+ *	a file of back to back frames as written by camdump
+ *
+ * Each file in a directory is one frame.  Files are replayed in
+ * name order, and files that are not the size of the first file
+ * are ignored.  A camdump file holds no frame boundaries, so the
+ * frame length must be given with -z.  A camdump file is mmapped
+ * unless -M is given.
+ *
+ * Frames are paced by a CLOCK_MONOTONIC timerfd.  The descriptor
+ * returned by replay_open() is that timerfd, so it becomes readable
+ * when the next frame is due just as a camera descriptor would.
+ * Callers may select on it, or call replay_wait_frame().
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <sys/timerfd.h>
+#include <time.h>
+
+#include "LavaRnd/rawio.h"
+#include "LavaRnd/lavacam.h"
+#include "LavaRnd/lavaerr.h"
+
+
+/*
+ * Special replay driver debugging - not related to LavaRnd debugging
+ */
+#if defined(LAVA_REPLAY_DEBUG)
+#  define DBG(c) fprintf(stderr, \
+			  "Error: %s:%d: %d\n", __FILE__, __LINE__, (c))
+#else
+#  define DBG(c)
+#endif
+
+
+/*
+ * LavaRnd optimal values
+ *
+ * Replayed frames were already taken with the camera's optimal values,
+ * so there is nothing to tune here other than the playback.
+ */
+static struct replay_state replay_def = {
+    /* these values are read/write */
+    REPLAY_DEF_FPS,		/* frames per second */
+    0.0,			/* no jitter */
+    TRUE,			/* restart after last frame */
+    /* these values are write only */
+    0,				/* octets per frame in a camdump file */
+    /* these values are read only */
+    0,				/* number of frames available */
+    0,				/* index of the next frame */
+    /* special driver/utilities elements */
+    REPLAY_STATE_MASK,		/* bit mask of state values to set/change */
+    /* tmp sanity check into - initialized by default, set by replay_argv() */
+    0,
+    0.0,
+    0,
+    0.0
+};
+
+
+/*
+ * LavaRnd values for given models
+ */
+struct lava_state {
+    int model;			/* camera model - see struct camop in camop.c */
+    struct replay_state *state;	/* optimal LavaRnd values */
+    double warmup;		/* default seconds to delay during open */
+    int def_top_x;		/* default ignore top_x octets as common */
+    double def_min_fract;	/* default uncommon octet value fraction */
+    int def_half_x;		/* default 1/2 level value */
+    double def_diff_fract;	/* default different/same fraction */
+};
+
+/*
+ * replay settings
+ *
+ * The sanity check values of the camera that took the frames are not
+ * known, so sanity checking is disabled by default.  Give the camera's
+ * values with -X, -x, -2 and -d to check replayed frames as that camera
+ * would.
+ */
+static struct lava_state lava_state[] = {
+    {0, &replay_def, 0.0, 0, 0.0, 0, 0.0},	/* frame replay */
+
+    {-1, NULL, 0.0, 0, 0, 0.0, 0.0}		/* must be last */
+};
+
+#define STATE_COUNT ((int)sizeof(lava_state) / (int)sizeof(lava_state[0]))
+
+
+/*
+ * replay - an open replay
+ *
+ * The struct opsize is copied about by callers, so the state of an
+ * open replay is kept here and found by its descriptor.
+ */
+struct replay {
+    int inuse;			/* TRUE ==> this replay is open */
+    int cam_fd;			/* timerfd returned by replay_open() */
+    int data_fd;		/* open camdump file, <0 ==> none */
+    char *dirname;		/* camdumpdir directory or NULL */
+    char **name;		/* frame file names within dirname or NULL */
+    u_int8_t *map;		/* mmapped camdump file or NULL */
+    size_t maplen;		/* length of map */
+    int framelen;		/* octets per frame */
+    int frames;			/* number of frames */
+    int next;			/* index of next frame to replay */
+    int loop;			/* TRUE ==> restart after last frame */
+    double period;		/* seconds between frames, 0.0 ==> no wait */
+    double jitter;		/* random fraction of period variation */
+    double due;			/* CLOCK_MONOTONIC time of next frame */
+    unsigned short xsubi[3];	/* erand48() jitter state */
+};
+static struct replay replay[REPLAY_MAX_OPEN];
+
+
+/*
+ * static functions
+ */
+static int replay_model(int model);
+static struct replay *replay_find(int cam_fd);
+static double replay_clock(void);
+static int replay_arm(struct replay *r);
+static int replay_scan(struct replay *r, char *dirname);
+static int replay_load(struct replay *r, struct opsize *siz);
+static void replay_free(struct replay *r);
+static void replay_abort(struct replay *r, struct opsize *siz);
+static int name_cmp(const void *a, const void *b);
+
+
+/*
+ * replay_model - determine which LavaRnd value model applies
+ *
+ * given:
+ *      model       camera model number
+ *
+ * returns:
+ *      index into lava_state[] to use, or
+ *            <0 (LAVACAM_ERR_IDENT) ==> error
+ */
+static int
+replay_model(int model)
+{
+    int i;
+
+    /*
+     * look for default state
+     */
+    for (i = 0; i < STATE_COUNT; ++i) {
+	if (model == lava_state[i].model) {
+	    break;
+	}
+    }
+    if (i >= STATE_COUNT || lava_state[i].model < 0) {
+	return LAVACAM_ERR_IDENT;
+    }
+    return i;
+}
+
+
+/*
+ * replay_find - find an open replay by its descriptor
+ *
+ * given:
+ *      cam_fd      open replay descriptor
+ *
+ * returns:
+ *      open replay, or NULL ==> cam_fd is not an open replay
+ */
+static struct replay *
+replay_find(int cam_fd)
+{
+    int i;
+
+    for (i = 0; i < REPLAY_MAX_OPEN; ++i) {
+	if (replay[i].inuse && replay[i].cam_fd == cam_fd) {
+	    return &replay[i];
+	}
+    }
+    return NULL;
+}
+
+
+/*
+ * replay_clock - return the CLOCK_MONOTONIC time as a double
+ *
+ * returns:
+ *      seconds on the monotonic clock, or <0.0 ==> error
+ */
+static double
+replay_clock(void)
+{
+    struct timespec ts;		/* current monotonic time */
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) < 0) {
+	return -1.0;
+    }
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1.0e9;
+}
+
+
+/*
+ * replay_arm - arm the timerfd to become readable when the next frame is due
+ *
+ * given:
+ *      r           open replay
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ *
+ * NOTE: A due time in the past makes the timerfd readable at once.
+ */
+static int
+replay_arm(struct replay *r)
+{
+    struct itimerspec its;	/* absolute one-shot expiration */
+
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = double_to_tv_sec(r->due);
+    its.it_value.tv_nsec = double_to_tv_nsec(r->due);
+    if (its.it_value.tv_nsec >= 1000000000L) {
+	++its.it_value.tv_sec;
+	its.it_value.tv_nsec -= 1000000000L;
+    }
+    if (its.it_value.tv_sec == 0 && its.it_value.tv_nsec == 0) {
+	/* a zero it_value would disarm the timer */
+	its.it_value.tv_nsec = 1;
+    }
+    if (timerfd_settime(r->cam_fd, TFD_TIMER_ABSTIME, &its, NULL) < 0) {
+	DBG(LAVACAM_ERR_IOERR);
+	return LAVACAM_ERR_IOERR;
+    }
+    return LAVACAM_ERR_OK;
+}
+
+
+/*
+ * name_cmp - qsort compare of two frame file names
+ */
+static int
+name_cmp(const void *a, const void *b)
+{
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+
+/*
+ * replay_scan - find the frame files in a camdumpdir directory
+ *
+ * given:
+ *      r           replay being opened
+ *      dirname     directory of frame files
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ *
+ * NOTE: This function sets the dirname, name, frames and framelen
+ *       of the replay.  The frame length is the size of the first
+ *       file in name order.
+ */
+static int
+replay_scan(struct replay *r, char *dirname)
+{
+    DIR *dir;			/* open directory */
+    struct dirent *ent;		/* directory entry */
+    struct stat sbuf;		/* frame file status */
+    char *path;			/* path of a frame file */
+    size_t pathlen;		/* allocated length of path */
+    char **name;		/* realloced frame name list */
+    int maxname = 0;		/* allocated length of name list */
+    int count = 0;		/* file names found */
+    int i;
+    int j;
+
+    /*
+     * collect the names of the files in the directory
+     */
+    dir = opendir(dirname);
+    if (dir == NULL) {
+	DBG(LAVACAM_ERR_OPEN);
+	return (errno == EACCES) ? LAVAERR_PERMOPEN : LAVACAM_ERR_OPEN;
+    }
+    r->dirname = strdup(dirname);
+    if (r->dirname == NULL) {
+	(void) closedir(dir);
+	DBG(LAVAERR_MALLOC);
+	return LAVAERR_MALLOC;
+    }
+    while ((ent = readdir(dir)) != NULL) {
+	if (ent->d_name[0] == '.') {
+	    continue;
+	}
+	if (count >= maxname) {
+	    maxname = (maxname <= 0) ? 256 : maxname * 2;
+	    name = (char **)realloc(r->name, maxname * sizeof(char *));
+	    if (name == NULL) {
+		(void) closedir(dir);
+		DBG(LAVAERR_MALLOC);
+		return LAVAERR_MALLOC;
+	    }
+	    r->name = name;
+	}
+	r->name[count] = strdup(ent->d_name);
+	if (r->name[count] == NULL) {
+	    (void) closedir(dir);
+	    DBG(LAVAERR_MALLOC);
+	    return LAVAERR_MALLOC;
+	}
+	r->frames = ++count;
+    }
+    (void) closedir(dir);
+    if (count <= 0) {
+	DBG(LAVACAM_ERR_NOSIZE);
+	return LAVACAM_ERR_NOSIZE;
+    }
+    qsort(r->name, count, sizeof(char *), name_cmp);
+
+    /*
+     * keep only the regular files that are the size of the first one
+     */
+    pathlen = strlen(dirname) + 1 + 1;
+    for (i = 0; i < count; ++i) {
+	if (strlen(dirname) + 1 + strlen(r->name[i]) + 1 > pathlen) {
+	    pathlen = strlen(dirname) + 1 + strlen(r->name[i]) + 1;
+	}
+    }
+    path = (char *)malloc(pathlen);
+    if (path == NULL) {
+	DBG(LAVAERR_MALLOC);
+	return LAVAERR_MALLOC;
+    }
+    for (i = 0, j = 0; i < count; ++i) {
+	snprintf(path, pathlen, "%s/%s", dirname, r->name[i]);
+	if (stat(path, &sbuf) < 0 || !S_ISREG(sbuf.st_mode) ||
+	    sbuf.st_size <= 0 || sbuf.st_size > 0x7fffffff ||
+	    (r->framelen > 0 && sbuf.st_size != r->framelen)) {
+	    free(r->name[i]);
+	    r->name[i] = NULL;
+	    continue;
+	}
+	r->framelen = (int)sbuf.st_size;
+	r->name[j] = r->name[i];
+	if (i != j) {
+	    r->name[i] = NULL;
+	}
+	++j;
+    }
+    free(path);
+    r->frames = j;
+    if (r->frames <= 0) {
+	DBG(LAVACAM_ERR_NOSIZE);
+	return LAVACAM_ERR_NOSIZE;
+    }
+    return LAVACAM_ERR_OK;
+}
+
+
+/*
+ * replay_load - load the next frame
+ *
+ * given:
+ *      r           open replay
+ *      siz         pointer to operation size and buffer structure
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ */
+static int
+replay_load(struct replay *r, struct opsize *siz)
+{
+    char *path;		/* path of a frame file */
+    size_t pathlen;	/* length of path */
+    off_t offset;	/* offset of the frame in a camdump file */
+    int fd;		/* open frame file */
+    int ret;		/* read return */
+
+    /*
+     * mmapped camdump file
+     */
+    if (r->map != NULL) {
+	siz->chaos = r->map + (size_t)r->next * r->framelen;
+	return LAVACAM_ERR_OK;
+    }
+    if (siz->image == NULL || siz->image_len < r->framelen) {
+	DBG(LAVACAM_ERR_NOSIZE);
+	return LAVACAM_ERR_NOSIZE;
+    }
+
+    /*
+     * read a camdump file
+     */
+    if (r->data_fd >= 0) {
+	offset = (off_t)r->next * r->framelen;
+	do {
+	    ret = pread(r->data_fd, siz->image, r->framelen, offset);
+	} while (ret < 0 && errno == EINTR);
+	if (ret < 0) {
+	    DBG(LAVACAM_ERR_IOERR);
+	    return LAVACAM_ERR_IOERR;
+	}
+	if (ret != r->framelen) {
+	    DBG(LAVACAM_ERR_FRAME);
+	    return LAVACAM_ERR_FRAME;
+	}
+	return LAVACAM_ERR_OK;
+    }
+
+    /*
+     * read a camdumpdir frame file
+     */
+    pathlen = strlen(r->dirname) + 1 + strlen(r->name[r->next]) + 1;
+    path = (char *)malloc(pathlen);
+    if (path == NULL) {
+	DBG(LAVAERR_MALLOC);
+	return LAVAERR_MALLOC;
+    }
+    snprintf(path, pathlen, "%s/%s", r->dirname, r->name[r->next]);
+    fd = open(path, O_RDONLY);
+    free(path);
+    if (fd < 0) {
+	DBG(LAVACAM_ERR_IOERR);
+	return LAVACAM_ERR_IOERR;
+    }
+    ret = raw_read(fd, siz->image, r->framelen, 0);
+    (void) close(fd);
+    if (ret < 0) {
+	DBG(LAVACAM_ERR_IOERR);
+	return LAVACAM_ERR_IOERR;
+    }
+    if (ret != r->framelen) {
+	DBG(LAVACAM_ERR_FRAME);
+	return LAVACAM_ERR_FRAME;
+    }
+    return LAVACAM_ERR_OK;
+}
+
+
+/*
+ * replay_free - release everything held by a replay
+ *
+ * given:
+ *      r           replay to release
+ *
+ * NOTE: The timerfd is not closed by this function.
+ */
+static void
+replay_free(struct replay *r)
+{
+    int i;
+
+    if (r->map != NULL) {
+	(void) munmap(r->map, r->maplen);
+    }
+    if (r->data_fd >= 0) {
+	(void) close(r->data_fd);
+    }
+    if (r->name != NULL) {
+	for (i = 0; i < r->frames; ++i) {
+	    if (r->name[i] != NULL) {
+		free(r->name[i]);
+	    }
+	}
+	free(r->name);
+    }
+    if (r->dirname != NULL) {
+	free(r->dirname);
+    }
+    memset(r, 0, sizeof(r[0]));
+    r->cam_fd = -1;
+    r->data_fd = -1;
+    r->inuse = FALSE;
+}
+
+
+/*
+ * replay_abort - undo a replay_open() that failed after the timerfd was made
+ *
+ * given:
+ *      r           replay being opened
+ *      siz         pointer to operation size and buffer structure
+ */
+static void
+replay_abort(struct replay *r, struct opsize *siz)
+{
+    lavacam_frame_free(siz);
+    siz->image = NULL;
+    siz->image_len = 0;
+    siz->chaos = NULL;
+    siz->chaos_len = 0;
+    (void) close(r->cam_fd);
+    replay_free(r);
+}
+
+
+/*
+ * replay_get - get an open replay's state
+ *
+ * given:
+ *      cam_fd      open replay descriptor
+ *      u_cam_p     pointer to values of the replay
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ *
+ * NOTE: This function will clear out the tmp sanity check values.
+ */
+int
+replay_get(int cam_fd, union lavacam *u_cam_p)
+{
+    struct replay_state *cam;	/* u_cam_p as replay union element */
+    struct replay *r;		/* open replay */
+
+    /*
+     * firewall
+     */
+    if (cam_fd < 0 || u_cam_p == NULL) {
+	DBG(LAVACAM_ERR_ARG);
+	return LAVACAM_ERR_ARG;
+    }
+    r = replay_find(cam_fd);
+    if (r == NULL) {
+	DBG(LAVACAM_ERR_NOCAM);
+	return LAVACAM_ERR_NOCAM;
+    }
+
+    /*
+     * pick out the driver specific union element
+     */
+    cam = &(u_cam_p->replay);
+
+    /*
+     * report the replay state
+     */
+    memset(cam, 0, sizeof(cam[0]));
+    cam->fps = (r->period > 0.0) ? 1.0 / r->period : 0.0;
+    cam->jitter = r->jitter;
+    cam->loop = r->loop;
+    cam->framelen = r->framelen;
+    cam->frames = r->frames;
+    cam->next = r->next;
+    return LAVACAM_ERR_OK;
+}
+
+
+/*
+ * replay_set - set an open replay's state
+ *
+ * given:
+ *      cam_fd      open replay descriptor
+ *      u_cam_p     pointer to new replay setting if mask is non-zero
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ *
+ * NOTE: The tmp sanity check values are ignored by this function.
+ *
+ * NOTE: The frame length of an open replay cannot be changed.
+ */
+int
+replay_set(int cam_fd, union lavacam *u_cam_p)
+{
+    struct replay_state *cam;	/* u_cam_p as replay union element */
+    struct replay *r;		/* open replay */
+
+    /*
+     * firewall
+     */
+    if (cam_fd < 0 || u_cam_p == NULL) {
+	DBG(LAVACAM_ERR_ARG);
+	return LAVACAM_ERR_ARG;
+    }
+    r = replay_find(cam_fd);
+    if (r == NULL) {
+	DBG(LAVACAM_ERR_NOCAM);
+	return LAVACAM_ERR_NOCAM;
+    }
+
+    /*
+     * pick out the driver specific union element
+     */
+    cam = &(u_cam_p->replay);
+
+    /*
+     * set values if the mask allows
+     */
+    if (REPLAY_TEST(cam->mask, framelen) &&
+	cam->framelen > 0 && cam->framelen != r->framelen) {
+	DBG(LAVACAM_ERR_SETPARAM);
+	return LAVACAM_ERR_SETPARAM;
+    }
+    if (REPLAY_TEST(cam->mask, fps)) {
+	r->period = (cam->fps > 0.0) ? 1.0 / cam->fps : 0.0;
+    }
+    if (REPLAY_TEST(cam->mask, jitter)) {
+	r->jitter = cam->jitter;
+    }
+    if (REPLAY_TEST(cam->mask, loop)) {
+	r->loop = cam->loop;
+    }
+    return LAVACAM_ERR_OK;
+}
+
+
+/*
+ * replay_LavaRnd - preset change state with LavaRnd optimal values
+ *
+ * given:
+ *      u_cam_p     pointer to replay state
+ *      model       camera model number
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ *
+ * NOTE: This function will set the tmp sanity check faules to their
+ *       defaults according to the lava_state[] default values.
+ */
+int
+replay_LavaRnd(union lavacam *u_cam_p, int model)
+{
+    int model_indx;
+
+    /*
+     * firewall
+     */
+    if (u_cam_p == NULL) {
+	DBG(LAVACAM_ERR_ARG);
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * look for default state index
+     */
+    model_indx = replay_model(model);
+    if (model_indx < 0) {
+	return model_indx;
+    }
+
+    /*
+     * load the LavaRnd optimal values
+     */
+    memcpy(&(u_cam_p->replay), lava_state[model_indx].state,
+	   sizeof(u_cam_p->replay));
+
+    /*
+     * set the default tmp sanity check values
+     */
+    u_cam_p->replay.tmp_top_x = lava_state[model_indx].def_top_x;
+    u_cam_p->replay.tmp_min_fract = lava_state[model_indx].def_min_fract;
+    u_cam_p->replay.tmp_half_x = lava_state[model_indx].def_half_x;
+    u_cam_p->replay.tmp_diff_fract = lava_state[model_indx].def_diff_fract;
+    return LAVACAM_ERR_OK;
+}
+
+
+/*
+ * replay_check - determine if the replay state change is valid
+ *
+ * given:
+ *      u_cam_p     pointer to replay values to check if mask is non-zero
+ *
+ * returns:
+ *      0 ==> masked values of union are OK, <0 ==> error in masked values
+ */
+int
+replay_check(union lavacam *u_cam_p)
+{
+    struct replay_state *cam;	/* u_cam_p as replay union element */
+
+    /*
+     * firewall
+     */
+    if (u_cam_p == NULL) {
+	DBG(LAVACAM_ERR_ARG);
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * pick out the driver specific union element
+     */
+    cam = &(u_cam_p->replay);
+
+    /*
+     * quick exit if mask is empty
+     */
+    if (cam->mask == 0) {
+	return LAVACAM_ERR_OK;
+    }
+
+    /*
+     * check values if the mask allows
+     */
+    if (REPLAY_TEST(cam->mask, fps)) {
+	if (cam->fps < 0.0 || cam->fps > REPLAY_MAX_FPS) {
+	    DBG(LAVACAM_ERR_RANGE);
+	    return LAVACAM_ERR_RANGE;
+	}
+    }
+    if (REPLAY_TEST(cam->mask, jitter)) {
+	if (cam->jitter < 0.0 || cam->jitter > REPLAY_MAX_JITTER) {
+	    DBG(LAVACAM_ERR_RANGE);
+	    return LAVACAM_ERR_RANGE;
+	}
+    }
+    if (REPLAY_TEST(cam->mask, loop)) {
+	if (cam->loop != TRUE && cam->loop != FALSE) {
+	    DBG(LAVACAM_ERR_RANGE);
+	    return LAVACAM_ERR_RANGE;
+	}
+    }
+    if (REPLAY_TEST(cam->mask, framelen)) {
+	if (cam->framelen < 0) {
+	    DBG(LAVACAM_ERR_RANGE);
+	    return LAVACAM_ERR_RANGE;
+	}
+    }
+
+    /*
+     * all is OK
+     */
+    return LAVACAM_ERR_OK;
+}
+
+
+/*
+ * replay_print - print state of an open replay
+ *
+ * given:
+ *      stream      where to print replay info
+ *      cam_fd      open replay file descriptor
+ *      u_cam_p     pointer to replay state
+ *      siz         pointer to operation size and buffer structure
+ *
+ * returns:
+ *      0 ==> unable to obtain replay information
+ *      1 ==> replay information obtained and printed
+ */
+int
+replay_print(FILE * stream, int cam_fd, union lavacam *u_cam_p,
+	     struct opsize *siz)
+{
+    struct replay *r;		/* open replay */
+
+    /*
+     * firewall
+     */
+    if (stream == NULL || cam_fd < 0 || u_cam_p == NULL || siz == NULL) {
+	DBG(LAVACAM_ERR_ARG);
+	return LAVACAM_ERR_ARG;
+    }
+    r = replay_find(cam_fd);
+    if (r == NULL) {
+	fprintf(stream, "replay_print: not an open replay\n");
+	DBG(LAVACAM_ERR_NOCAM);
+	return LAVACAM_ERR_NOCAM;
+    }
+
+    /*
+     * print the replay source
+     */
+    if (r->dirname != NULL) {
+	fprintf(stream, "\tReplay directory: %s\n", r->dirname);
+    } else if (r->map != NULL) {
+	fprintf(stream, "\tReplay mmapped camdump file\n");
+    } else {
+	fprintf(stream, "\tReplay camdump file\n");
+    }
+    fprintf(stream, "\tFrame length: %d\n", r->framelen);
+    fprintf(stream, "\tFrame count: %d\n", r->frames);
+    fprintf(stream, "\tNext frame: %d\n", r->next);
+
+    /*
+     * print the playback settings
+     */
+    if (r->period > 0.0) {
+	fprintf(stream, "\tFrames per second: %.3f\n", 1.0 / r->period);
+    } else {
+	fprintf(stream, "\tFrames per second: unlimited\n");
+    }
+    fprintf(stream, "\tJitter: %.3f\n", r->jitter);
+    fprintf(stream, "\tLoop: %s\n", r->loop ? "yes" : "no");
+
+    /*
+     * output working sanity check parameters
+     */
+    fprintf(stream, "\ncamera sanity check parameters:\n");
+    fprintf(stream, "\t%d most frequent octet values are considered common\n",
+    		    siz->top_x);
+    fprintf(stream, "\tmax fraction of frame containing common octet "
+    		    "values: %.6f\n",
+    		    1.0 - siz->min_fract);
+    fprintf(stream, "\t%d most common values must be < 1/2 of frame octets\n",
+    		    siz->half_x);
+    fprintf(stream, "\tmin fraction of bits same in next frame: %.6f\n",
+    		    siz->diff_fract);
+    fprintf(stream, "\tmax fraction of bits same in next frame: %.6f\n",
+    		    1.0 - siz->diff_fract);
+
+    /*
+     * output use fields
+     */
+    fprintf(stream, "\ncamera use since this process opened the camera:\n");
+    /* ctime returns a newline, so the next printf should not end in one */
+    fprintf(stream, "\tcamera open time: %s", ctime(&siz->open_time));
+    fprintf(stream, "\tframe count: %lld\n", (long long)siz->frame_num);
+    fprintf(stream, "\tinsane frame count: %lld\n",
+    		    (long long)siz->insane_cnt);
+
+    /*
+     * output opsizes
+     */
+    fprintf(stream, "\ncamera op sizes:\n");
+    if (siz->use_read) {
+	fprintf(stream, "\twill use read I/O\n");
+	fprintf(stream, "\tread image: %d\n", siz->image_len);
+    } else {
+	fprintf(stream, "\twill use mmap I/O\n");
+	fprintf(stream, "\tmmap image: %d\n", siz->image_len);
+    }
+    fprintf(stream, "\tchaos size: %d\n", siz->chaos_len);
+
+    /*
+     * all done
+     */
+    return 1;
+}
+
+
+/*
+ * replay_usage - print an argc/argv usage message
+ *
+ * given:
+ *      prog            program name
+ *      typename        name of camera type
+ */
+void
+replay_usage(char *prog, char *typename)
+{
+    /*
+     * firewall
+     */
+    if (prog == NULL) {
+	prog = "<<__NULL__>>";
+    }
+    if (typename == NULL) {
+	typename = "<<__NULL__>>";
+    }
+
+    /*
+     * print usage message to stderr
+     */
+    fprintf(stderr,
+	    "usage: %s %s {dir|file} [-flags ... args ...]\n"
+	    "\n"
+	    "\tdir\t\tdirectory of frame files written by camdumpdir\n"
+	    "\tfile\t\tfile of frames written by camdump, requires -z\n"
+	    "\n"
+	    "\t-f fps\t\tframes per second, 0 ==> unlimited (def: %.0f)\n"
+	    "\t-j jitter\trandom fraction of frame interval [0.0, %.3f]\n"
+	    "\t-z framelen\toctets per frame in a camdump file (>0)\n"
+	    "\t-o\t\treplay the frames once, do not loop\n"
+	    "\t-v level\tverbose mode, print settings before/after\n"
+	    "\t-T tsec\t\twarm-up/sleep for tsec seconds\n"
+	    "\t-D tsec\t\tframe delay tsec seconds between frames\n"
+	    "\t-M\t\tdisable mmap processing, use reads instead\n"
+	    "\t-L\t\tset LavaRnd entropy optimal mode\n"
+	    "\t-A\t\tUNUSED, frames are already the high entropy part\n"
+	    "\t-E\t\tavoid frame dumping when savefile exists\n"
+	    "\t-X top_x\ttop_x common octets are common octets [0, %d]\n"
+	    "\t-x min_fract\tmin fraction uncommon octets in frame [0.0, 1.0]\n"
+	    "\t-2 half_x\thalf_x common octets occupy <50%% octets [0, %d]\n"
+	    "\t-d min_fract\tmin fraction of diff bits between frames [0.0, 0.5]\n",
+	    prog, typename,
+	    REPLAY_DEF_FPS, REPLAY_MAX_JITTER,
+	    OCTET_CNT, OCTET_CNT/2);
+    return;
+}
+
+
+/*
+ * replay_argv - argc/argv parse, sets a replay's state change and global flags
+ *
+ * given:
+ *      argc        command line argc count
+ *      argv        point to array of command line argument strings
+ *      u_cam_p     pointer to values to be set if mask is non-zero
+ *      flag        flags to set
+ *      model       camera model number
+ *
+ * returns:
+ *      amount of args to skip, <0 ==> error
+ *
+ * NOTE: This function will initialize the tmp sanity check values to
+ *       their defaults according to the lava_state[] default values.
+ *       If -x, -X, -2, -d was given, the tmp sanity check values will be
+ *       modified according to the flag.  Sometime later during the
+ *       replay_open(), these tmp sanity check values will be loaded
+ *       into the working sanity check values in the struct opsize.
+ */
+int
+replay_argv(int argc, char **argv, union lavacam *u_cam_p,
+	    struct lavacam_flag *flag, int model)
+{
+    int tmp;			/* temporary holder of a parsed argument */
+    double dtmp;		/* temporary holder of double/float arg */
+    struct replay_state *cam;	/* u_cam_p as replay union element */
+    char *optarg;		/* option argument */
+    int c;			/* option */
+    int model_indx;		/* default state model index */
+    int i;
+
+    /*
+     * firewall
+     */
+    if (argc <= 0 || argv == NULL || argv[0] == NULL || u_cam_p == NULL ||
+	flag == NULL) {
+	DBG(LAVACAM_ERR_ARG);
+	return LAVACAM_ERR_ARG;
+    }
+    flag->program = argv[0];
+
+    /*
+     * pick out the driver specific union element
+     */
+    cam = &(u_cam_p->replay);
+
+    /*
+     * look for default state index
+     */
+    model_indx = replay_model(model);
+    if (model_indx < 0) {
+	return model_indx;
+    }
+
+    /*
+     * initialize
+     */
+    memcpy(cam, lava_state[model_indx].state, sizeof(cam[0]));
+    flag->D_flag = 0.0;
+    flag->T_flag = -1.0;
+    flag->A_flag = 0;
+    flag->M_flag = 1;
+    flag->v_flag = 0;
+    flag->E_flag = 0;
+    flag->savefile = NULL;
+    flag->newfile = NULL;
+    flag->interval = 0.0;
+    /* set the default tmp sanity check values */
+    cam->tmp_top_x = lava_state[model_indx].def_top_x;
+    cam->tmp_min_fract = lava_state[model_indx].def_min_fract;
+    cam->tmp_half_x = lava_state[model_indx].def_half_x;
+    cam->tmp_diff_fract = lava_state[model_indx].def_diff_fract;
+
+    /*
+     * parse args
+     *
+     * See ov511_argv() for why we do not use getopt().
+     */
+    for (i = 1; i < argc; ++i) {
+
+	/*
+	 * must be a -<char>
+	 */
+	if (argv[i] == NULL) {
+	    fprintf(stderr, "%s: replay_argv[%d] is NULL\n", argv[0], i);
+	    DBG(LAVACAM_ERR_ARG);
+	    return LAVACAM_ERR_ARG;
+	}
+	if (argv[i][0] != '-') {
+	    /* end of -options, stop parsing args */
+	    break;
+	}
+
+	/*
+	 * options that take an argument
+	 */
+	c = (int)argv[i][1];
+	optarg = NULL;
+	if (c != '\0' && strchr("fjzvTDXx2d", c) != NULL) {
+	    if (i < argc - 1) {
+		optarg = argv[++i];
+	    } else {
+		fprintf(stderr,
+			"%s: replay_argv[%d] -%c missing next argument\n",
+			argv[0], i, c);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	}
+
+	/*
+	 * process the -option
+	 */
+	switch (c) {
+	case 'f':
+	    dtmp = (double)atof(optarg);
+	    if (dtmp < 0.0 || dtmp > REPLAY_MAX_FPS) {
+		fprintf(stderr, "%s: fps must be >= 0.0 and <= %.0f\n",
+			flag->program, REPLAY_MAX_FPS);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    cam->fps = dtmp;
+	    REPLAY_SET(cam->mask, fps);
+	    break;
+	case 'j':
+	    dtmp = (double)atof(optarg);
+	    if (dtmp < 0.0 || dtmp > REPLAY_MAX_JITTER) {
+		fprintf(stderr, "%s: jitter must be >= 0.0 and <= %.3f\n",
+			flag->program, REPLAY_MAX_JITTER);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    cam->jitter = dtmp;
+	    REPLAY_SET(cam->mask, jitter);
+	    break;
+	case 'z':
+	    tmp = (int)strtol(optarg, NULL, 0);
+	    if (tmp <= 0) {
+		fprintf(stderr, "%s: framelen must be > 0\n", flag->program);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    cam->framelen = tmp;
+	    REPLAY_SET(cam->mask, framelen);
+	    break;
+	case 'o':
+	    cam->loop = FALSE;
+	    REPLAY_SET(cam->mask, loop);
+	    break;
+	case 'v':
+	    tmp = (int)strtol(optarg, NULL, 0);
+	    if (tmp < 0) {
+		fprintf(stderr, "%s: verbose level must be >= 0\n",
+			flag->program);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    flag->v_flag = tmp;
+	    break;
+	case 'E':
+	    flag->E_flag = 1;
+	    break;
+	case 'T':
+	    dtmp = (double)atof(optarg);
+	    if (dtmp < 0.0) {
+		fprintf(stderr, "%s: warm-up time must be >= 0.0\n",
+			flag->program);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    flag->T_flag = dtmp;
+	    break;
+	case 'D':
+	    dtmp = (double)atof(optarg);
+	    if (dtmp < 0.0) {
+		fprintf(stderr, "%s: delay time must be >= 0.0\n",
+			flag->program);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    flag->D_flag = dtmp;
+	    break;
+	case 'M':
+	    flag->M_flag = 0;
+	    break;
+	case 'L':
+	    tmp = replay_LavaRnd(u_cam_p, model);
+	    if (tmp < 0) {
+		fprintf(stderr, "%s: LavaRnd mode set failed\n",
+			flag->program);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    break;
+	case 'A':
+	    /* replayed frames hold only chaotic data - silently ignore */
+	    break;
+	case 'X':
+	    tmp = (int)strtol(optarg, NULL, 0);
+	    if (tmp < 0 || tmp > OCTET_CNT) {
+		fprintf(stderr, "%s: top_x must be >= 0 and <= %d\n",
+			flag->program, OCTET_CNT);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    cam->tmp_top_x = tmp;
+	    break;
+	case 'x':
+	    dtmp = (double)atof(optarg);
+	    if (dtmp < 0.0 || dtmp > 1.0) {
+		fprintf(stderr, "%s: min_fract must be >= 0.0 and <= 1.0\n",
+			flag->program);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    cam->tmp_min_fract = dtmp;
+	    break;
+	case '2':
+	    tmp = (int)strtol(optarg, NULL, 0);
+	    if (tmp < 0 || tmp > OCTET_CNT / 2) {
+		fprintf(stderr, "%s: half_x must be >= 0 and <= %d\n",
+			flag->program, OCTET_CNT / 2);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    cam->tmp_half_x = tmp;
+	    break;
+	case 'd':
+	    dtmp = (double)atof(optarg);
+	    if (dtmp < 0.0 || dtmp > 0.5) {
+		fprintf(stderr, "%s: diff_fract must be >= 0.0 and <= 0.5\n",
+			flag->program);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    cam->tmp_diff_fract = dtmp;
+	    break;
+	default:
+	    fprintf(stderr,
+		    "%s: replay_argv[%d] -%c is unknown\n", argv[0], i, c);
+	    DBG(LAVACAM_ERR_ARG);
+	    return LAVACAM_ERR_ARG;
+	}
+    }
+
+    /*
+     * parse an optimal savefile/interval argument pair
+     */
+    if (argv[i] != NULL && argv[i + 1] != NULL) {
+
+	/* save the savefile argument */
+	flag->savefile = strdup(argv[i]);
+	if (flag->savefile == NULL) {
+	    DBG(LAVAERR_MALLOC);
+	    return LAVAERR_MALLOC;
+	}
+
+	/* form the savefile.new name */
+	flag->newfile =
+	  (char *)malloc(strlen(flag->savefile) + sizeof(".new"));
+	if (flag->newfile == NULL) {
+	    free(flag->savefile);
+	    flag->savefile = NULL;
+	    DBG(LAVAERR_MALLOC);
+	    return LAVAERR_MALLOC;
+	}
+	snprintf(flag->newfile, strlen(flag->savefile) + sizeof(".new"),
+		 "%s.new", flag->savefile);
+
+	/* note interval */
+	flag->interval = (double)atof(argv[i + 1]);
+	if (flag->interval <= 0.0) {
+	    fprintf(stderr, "%s: interval: %.3f must be >0.0\n",
+		    flag->program, flag->interval);
+	    free(flag->savefile);
+	    flag->savefile = NULL;
+	    free(flag->newfile);
+	    flag->newfile = NULL;
+	    DBG(LAVACAM_ERR_ARG);
+	    return LAVACAM_ERR_ARG;
+	}
+
+	/* skip over these two args */
+	i += 2;
+    }
+
+    /*
+     * return arg adjustment value
+     */
+    return i - 1;
+}
+
+
+/*
+ * replay_open - open a replay, return opening replay state
+ *
+ * given:
+ *      devname     camdumpdir directory or camdump file
+ *      model       camera model number
+ *      o_cam_p     where to place the open replay state
+ *      n_cam_p     is non-NULL, replay settings to use,
+ *                      updated with the final open state if non-NULL
+ *      siz         pointer to operation size and buffer structure to fill in
+ *      def         unused
+ *      flag        flags set via lavacam_argv()
+ *
+ * returns:
+ *      >=0 ==> replay timerfd descriptor, <0 ==> error
+ *
+ * NOTE: The function will also transfer tmp sanity check parameters from
+ *       the union lavacam to the opsize structure.
+ */
+int
+replay_open(char *devname, int model, union lavacam *o_cam_p,
+	    union lavacam *n_cam_p, struct opsize *siz, int def,
+	    struct lavacam_flag *flag)
+{
+    struct replay_state *cam;	/* o_cam_p as replay union element */
+    struct replay_state *set;	/* replay settings to use */
+    struct replay *r;		/* the new replay */
+    struct stat sbuf;		/* devname status */
+    double now;			/* current monotonic time */
+    int model_indx;		/* default state model index */
+    int ret;			/* return code */
+    int i;
+
+    /*
+     * firewall
+     */
+    if (devname == NULL || o_cam_p == NULL || siz == NULL || flag == NULL) {
+	DBG(LAVACAM_ERR_ARG);
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * look for default state index
+     */
+    model_indx = replay_model(model);
+    if (model_indx < 0) {
+	return model_indx;
+    }
+
+    /*
+     * pick out the driver specific union element
+     */
+    cam = &(o_cam_p->replay);
+    if (n_cam_p == NULL) {
+	set = lava_state[model_indx].state;
+    } else {
+	set = &(n_cam_p->replay);
+    }
+
+    /*
+     * find a free replay slot
+     */
+    for (i = 0, r = NULL; i < REPLAY_MAX_OPEN; ++i) {
+	if (!replay[i].inuse) {
+	    r = &replay[i];
+	    break;
+	}
+    }
+    if (r == NULL) {
+	DBG(LAVACAM_ERR_OPEN);
+	return LAVACAM_ERR_OPEN;
+    }
+    memset(r, 0, sizeof(r[0]));
+    r->cam_fd = -1;
+    r->data_fd = -1;
+
+    /*
+     * find the frames to replay
+     */
+    if (stat(devname, &sbuf) < 0) {
+	DBG(LAVACAM_ERR_OPEN);
+	return (errno == EACCES) ? LAVAERR_PERMOPEN : LAVACAM_ERR_OPEN;
+    }
+    if (S_ISDIR(sbuf.st_mode)) {
+
+	/*
+	 * camdumpdir directory of frame files
+	 */
+	ret = replay_scan(r, devname);
+	if (ret < 0) {
+	    replay_free(r);
+	    return ret;
+	}
+
+    } else if (S_ISREG(sbuf.st_mode)) {
+
+	/*
+	 * camdump file of back to back frames
+	 */
+	if (set->framelen <= 0) {
+	    DBG(LAVACAM_ERR_NOSIZE);
+	    return LAVACAM_ERR_NOSIZE;
+	}
+	r->framelen = set->framelen;
+	if (sbuf.st_size > 0x7fffffff) {
+	    /* replay no more than the opsize lengths can hold */
+	    r->frames = 0x7fffffff / r->framelen;
+	} else {
+	    r->frames = (int)(sbuf.st_size / r->framelen);
+	}
+	if (r->frames <= 0) {
+	    DBG(LAVACAM_ERR_NOSIZE);
+	    return LAVACAM_ERR_NOSIZE;
+	}
+	r->data_fd = open(devname, O_RDONLY);
+	if (r->data_fd < 0) {
+	    DBG(LAVACAM_ERR_OPEN);
+	    ret = (errno == EACCES) ? LAVAERR_PERMOPEN : LAVACAM_ERR_OPEN;
+	    replay_free(r);
+	    return ret;
+	}
+	if (flag->M_flag) {
+	    r->maplen = (size_t)r->frames * r->framelen;
+	    r->map = mmap(NULL, r->maplen, PROT_READ, MAP_SHARED,
+	    		  r->data_fd, 0);
+	    if (r->map == MAP_FAILED) {
+		r->map = NULL;
+		DBG(LAVACAM_ERR_NOMMAP);
+		replay_free(r);
+		return LAVACAM_ERR_NOMMAP;
+	    }
+	    (void) madvise(r->map, r->maplen, MADV_SEQUENTIAL);
+	}
+
+    } else {
+	DBG(LAVACAM_ERR_NOCAM);
+	return LAVACAM_ERR_NOCAM;
+    }
+
+    /*
+     * set up the pacing timer
+     */
+    r->cam_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK|TFD_CLOEXEC);
+    if (r->cam_fd < 0) {
+	DBG(LAVACAM_ERR_OPEN);
+	replay_free(r);
+	return LAVACAM_ERR_OPEN;
+    }
+    r->loop = set->loop;
+    r->period = (set->fps > 0.0) ? 1.0 / set->fps : 0.0;
+    r->jitter = set->jitter;
+    r->xsubi[0] = (unsigned short)getpid();
+    r->xsubi[1] = (unsigned short)r->cam_fd;
+    r->xsubi[2] = (unsigned short)time(NULL);
+    now = replay_clock();
+    if (now < 0.0) {
+	(void) close(r->cam_fd);
+	replay_free(r);
+	DBG(LAVAERR_GETTIME);
+	return LAVAERR_GETTIME;
+    }
+    r->due = now;
+    r->inuse = TRUE;
+
+    /*
+     * initialize opsize structure
+     */
+    memset(siz, 0, sizeof(*siz));
+    siz->prev_frame = NULL;
+    siz->image = NULL;
+    siz->chaos = NULL;
+    siz->top_x = set->tmp_top_x;
+    siz->min_fract = set->tmp_min_fract;
+    siz->half_x = set->tmp_half_x;
+    siz->diff_fract = set->tmp_diff_fract;
+    siz->framesize = r->framelen;
+    siz->frames = 1;
+    siz->readsize = r->framelen;
+    siz->read_lavaoff = 0;
+    siz->read_lavalen = r->framelen;
+    if (r->map != NULL) {
+	siz->mmapsize = r->maplen;
+	siz->mmap_lavaoff = 0;
+	siz->mmap_lavalen = r->framelen;
+	siz->use_read = FALSE;
+	siz->image = r->map;
+	siz->image_len = r->maplen;
+	siz->chaos = r->map;
+    } else {
+	siz->use_read = TRUE;
+	siz->image_len = r->framelen;
+    }
+    siz->chaos_len = r->framelen;
+
+    /*
+     * allocate read image buffers
+     *
+     * Frames in a mmapped camdump file stay put, so the sanity check
+     * compares them in place without copying the previous frame.
+     */
+    ret = lavacam_frame_alloc(siz, 0, TRUE);
+    if (ret < 0) {
+	replay_abort(r, siz);
+	DBG(LAVAERR_MALLOC);
+	return LAVAERR_MALLOC;
+    }
+
+    /*
+     * report the opening state
+     */
+    memcpy(cam, set, sizeof(cam[0]));
+    cam->framelen = r->framelen;
+    cam->frames = r->frames;
+    cam->next = r->next;
+    if (n_cam_p != NULL) {
+	n_cam_p->replay.framelen = r->framelen;
+	n_cam_p->replay.frames = r->frames;
+	n_cam_p->replay.next = r->next;
+    }
+
+    /*
+     * the first frame is due now
+     */
+    ret = replay_arm(r);
+    if (ret < 0) {
+	replay_abort(r, siz);
+	return ret;
+    }
+
+    /*
+     * warm up if requested
+     */
+    if (flag->T_flag > 0.0) {
+	lava_sleep(flag->T_flag);
+    } else if (lava_state[model_indx].warmup > 0.0) {
+	lava_sleep(lava_state[model_indx].warmup);
+    }
+
+    /*
+     * return the timerfd
+     */
+    return r->cam_fd;
+}
+
+
+/*
+ * replay_close - close an open replay
+ *
+ * given:
+ *      cam_fd   open replay descriptor
+ *      siz      pointer to operation size and buffer structure
+ *      flag        flags set via lavacam_argv()
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ */
+int
+replay_close(int cam_fd, struct opsize *siz, struct lavacam_flag *flag)
+{
+    struct replay *r;	/* open replay */
+    int ret;		/* close return value */
+
+    /*
+     * firewall
+     */
+    if (cam_fd < 0 || siz == NULL || flag == NULL) {
+	DBG(LAVACAM_ERR_ARG);
+	return LAVACAM_ERR_ARG;
+    }
+    r = replay_find(cam_fd);
+    if (r == NULL) {
+	DBG(LAVACAM_ERR_NOCAM);
+	return LAVACAM_ERR_NOCAM;
+    }
+
+    /*
+     * free read buffers if reading, the mmapped file is released below
+     */
+    lavacam_frame_free(siz);
+    replay_free(r);
+
+    /*
+     * clear read/mmap frame data
+     */
+    siz->image = NULL;
+    siz->image_len = 0;
+    siz->chaos = NULL;
+    siz->chaos_len = 0;
+
+    /*
+     * free savefile/newfile is they are present
+     */
+    if (flag->savefile != NULL) {
+	free(flag->savefile);
+	flag->savefile = NULL;
+    }
+    if (flag->newfile != NULL) {
+	free(flag->newfile);
+	flag->newfile = NULL;
+    }
+    flag->interval = 0.0;
+
+    /*
+     * close the timerfd
+     */
+    ret = close(cam_fd);
+    if (ret < 0) {
+	DBG(LAVACAM_ERR_CLOSE);
+	return LAVACAM_ERR_CLOSE;
+    }
+    return LAVACAM_ERR_OK;
+}
+
+
+/*
+ * replay_get_frame - get the next replayed frame
+ *
+ * given:
+ *      cam_fd   open replay descriptor
+ *      siz      pointer to operation size and buffer structure
+ *
+ * returns:
+ *      >= 0 ==> chaos octets obtained, < 0 ==> error
+ *
+ * NOTE: This function waits until the next frame is due.  To not block,
+ *       call replay_wait_frame() (or read select on the open file
+ *       descriptor) before calling this function.
+ *
+ * NOTE: When not looping, LAVAERR_EOF is returned after the last frame.
+ */
+int
+replay_get_frame(int cam_fd, struct opsize *siz)
+{
+    struct replay *r;		/* open replay */
+    u_int64_t expired;		/* timerfd expiration count */
+    double now;			/* current monotonic time */
+    double step;		/* time until the frame after this one */
+    int ret;			/* read or load return */
+
+    /*
+     * firewall
+     */
+    if (cam_fd < 0 || siz == NULL) {
+	DBG(LAVACAM_ERR_ARG);
+	return LAVACAM_ERR_ARG;
+    }
+    r = replay_find(cam_fd);
+    if (r == NULL) {
+	DBG(LAVACAM_ERR_NOCAM);
+	return LAVACAM_ERR_NOCAM;
+    }
+    if (r->next >= r->frames) {
+	/* replayed once, not looping */
+	DBG(LAVAERR_EOF);
+	return LAVAERR_EOF;
+    }
+
+    /*
+     * wait for the frame to be due
+     */
+    for (;;) {
+	ret = read(cam_fd, &expired, sizeof(expired));
+	if (ret >= 0 || (errno != EINTR && errno != EAGAIN)) {
+	    break;
+	}
+	if (errno == EAGAIN && replay_wait_frame(cam_fd, -1.0) < 0) {
+	    DBG(LAVACAM_ERR_IOERR);
+	    return LAVACAM_ERR_IOERR;
+	}
+    }
+    if (ret != sizeof(expired)) {
+	DBG(LAVACAM_ERR_IOERR);
+	return LAVACAM_ERR_IOERR;
+    }
+
+    /*
+     * load the frame
+     */
+    ret = replay_load(r, siz);
+    if (ret < 0) {
+	return ret;
+    }
+    if (++r->next >= r->frames && r->loop) {
+	r->next = 0;
+    }
+
+    /*
+     * schedule the next frame
+     *
+     * A caller that falls behind does not get a burst of catch-up
+     * frames, just as a camera drops the frames that it was not
+     * asked for.
+     */
+    now = replay_clock();
+    if (now < 0.0) {
+	DBG(LAVAERR_GETTIME);
+	return LAVAERR_GETTIME;
+    }
+    step = r->period;
+    if (step > 0.0 && r->jitter > 0.0) {
+	step *= 1.0 + r->jitter * (2.0 * erand48(r->xsubi) - 1.0);
+    }
+    r->due += step;
+    if (r->due < now) {
+	r->due = now;
+    }
+    ret = replay_arm(r);
+    if (ret < 0) {
+	return ret;
+    }
+
+    /*
+     * report the amount of chaotic data returned
+     */
+    return siz->chaos_len;
+}
+
+
+/*
+ * replay_msync - release/sync after processing a replayed frame
+ *
+ * given:
+ *      cam_fd      open replay descriptor
+ *      u_cam_p     pointer to replay state
+ *      siz         pointer to operation size and buffer structure
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ *
+ * NOTE: There is nothing to release, a mmapped camdump file is read only.
+ */
+int
+replay_msync(int cam_fd, union lavacam *u_cam_p, struct opsize *siz)
+{
+    /*
+     * firewall
+     */
+    if (cam_fd < 0 || u_cam_p == NULL || siz == NULL) {
+	DBG(LAVACAM_ERR_ARG);
+	return LAVACAM_ERR_ARG;
+    }
+    return LAVACAM_ERR_OK;
+}
+
+
+/*
+ * replay_wait_frame - use poll to wait for the next replayed frame
+ *
+ * given:
+ *      cam_fd      open replay descriptor
+ *      max_wait    wait for up to this many seconds, <0.0 ==> infinite
+ *
+ * returns:
+ *      1 ==> frame is ready, 0 ==> timeout, <0 ==> error
+ */
+int
+replay_wait_frame(int cam_fd, double max_wait)
+{
+    int ret;		/* poll return value */
+
+    /*
+     * firewall
+     */
+    if (cam_fd < 0) {
+	DBG(LAVACAM_ERR_ARG);
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * wait for the next frame or until we wait too long (if max_wait)
+     */
+    ret = lavacam_poll_frame(cam_fd, max_wait);
+    if (ret < 0) {
+	DBG(ret);
+    }
+    return ret;
+}
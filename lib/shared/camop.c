@@ -0,0 +1,2473 @@
+/*
+ * camop - generic camera operation to specific camera operation
+ *
+ * @(#) $Revision: 10.2 $
+ * @(#) $Id: camop.c,v 10.2 2003/11/09 22:37:03 lavarnd Exp $
+ *
+ * Copyright (c) 2000-2003 by Landon Curt Noll and Simon Cooper.
+ * All Rights Reserved.
+ *
+ * This is open software; you can redistribute it and/or modify it under
+ * the terms of the version 2.1 of the GNU Lesser General Public License
+ * as published by the Free Software Foundation.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General
+ * Public License for more details.
+ *
+ * The file COPYING contains important info about Licenses and Copyrights.
+ * Please read the COPYING file for details about this open software.
+ *
+ * A copy of version 2.1 of the GNU Lesser General Public License is
+ * distributed with calc under the filename COPYING-LGPL.  You should have
+ * received a copy with calc; if not, write to Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * For more information on LavaRnd: http://www.LavaRnd.org
+ *
+ * Share and enjoy! :-)
+ */
+
+
+/*
+ * Here is the general model for calling the camera op interface as found
+ * in the libLavaRnd_cam.a library.
+ *
+ * This code was taken from the tool camdump, from the src/tool/camdump.c file.
+ *
+ *      char *program;          (* our name *)
+ *      struct lavacam_flag flag;       (* flags set via lavacam_argv() *)
+ *      char *typename;         (* name of camera type *)
+ *      char *devname;          (* camera device name *)
+ *      int arg_shift;          (* argc/argv parse shift value *)
+ *      int type;               (* camera type *)
+ *      union lavacam o_cam;    (* open camera state *)
+ *      union lavacam n_cam;    (* new camera state *)
+ *      struct opsize siz;      (* camera operation size *)
+ *      long long frame;        (* frame number *)
+ *      long long maxlen = -1;  (* maximum length to write, <0 ==> infinite *)
+ *      long long written = 0;  (* amount of data written *)
+ *      int sanity;             (* lavacam_sanity check result *)
+ *
+ *      (*
+ *       * parse args
+ *       *)
+ *      program = argv[0];
+ *      (* find camera type *)
+ *      if (argc < 3) {
+ *          fprintf(stderr,
+ *              "usage: %s cam_type devname [-flags ... args ...]\n", program);
+ *          exit(1);
+ *      }
+ *      typename = argv[1];
+ *      type = camtype(typename);
+ *      if (type < 0) {
+ *          lava_print_camtypes(stderr);
+ *          exit(2);
+ *      }
+ *      devname = argv[2];
+ *      argc -= 2;
+ *      argv += 2;
+ *      argv[0] = program;
+ *      (* parse beyond cam_type and devname *)
+ *      arg_shift = lavacam_argv(type, argc, argv, &n_cam, &flag);
+ *      if (arg_shift < 0) {
+ *          lavacam_usage(type, typename, program, typename);
+ *          exit(3);
+ *      }
+ *      argc -= arg_shift;
+ *      argv += arg_shift;
+ *      (* at this point, argv[1], if argc > 1, is the next arg to parse *)
+ *      if (argc != 2) {
+ *          fprintf(stderr, "%s: expected 1 arg after parameters, found %d\n",
+ *                  program, argc);
+ *          exit(4);
+ *      }
+ *      maxlen = strtoll(argv[1], NULL, 0);     (* <0 ==> infinite pump *)
+ *
+ *      (*
+ *       * open the camera
+ *       *)
+ *      cam_fd = lavacam_open(type, devname, &o_cam, &n_cam, &siz, 0, &flag);
+ *      if (cam_fd < 0) {
+ *          fprintf(stderr, "%s: cannot open %s camera at %s\n",
+ *                  program, typename, devname);
+ *          exit(5);
+ *      }
+ *
+ *      (*
+ *       * pump out data
+ *       *)
+ *      frame = 0;
+ *      for (written = 0;
+ *           (maxlen < 0) || (written < maxlen);
+ *           written += siz.chaos_len) {
+ *
+ *          (*
+ *           * wait for the next frame
+ *           *)
+ *          i = lavacam_wait_frame(type, cam_fd, -1.0);
+ *          if (i < 0) {
+ *              fprintf(stderr, "%s: error while waiting for frame %lld: %d\n",
+ *                  program, frame, i);
+ *              exit(6);
+ *          }
+ *
+ *          (*
+ *           * get the next frame
+ *           *)
+ *          i = lavacam_get_frame(type, cam_fd, &siz);
+ *          if (i < 0) {
+ *              fprintf(stderr, "%s: failed to get frame %lld: %d\n",
+ *                  program, frame, i);
+ *              exit(7);
+ *          }
+ *
+ *          (*
+ *           * write the frame to stdout
+ *           *)
+ *          sanity = lavacam_sanity(&siz);
+ *          if (sanity == LAVACAM_OK) {
+ *              if (maxlen < 0 || written+siz.chaos_len <= maxlen) {
+ *                  i = raw_write(STDOUT, siz.chaos, siz.chaos_len, 0);
+ *              } else {
+ *                  i = raw_write(STDOUT, siz.chaos, (int)(maxlen-written), 0);
+ *              }
+ *              if (i < 0) {
+ *                  fprintf(stderr, "%s: cannot write frame %lld: %d\n",
+ *                      program, frame, i);
+ *                  exit(8);
+ *              } else if (i == 0) {
+ *                  if (flag.v_flag >= 1) {
+ *                      fprintf(stderr, "EOF on write frame: %lld\n", frame);
+ *                  }
+ *                  exit(0);
+ *              }
+ *          } else {
+ *              if (flag.v_flag >= 2) {
+ *                  fprintf(stderr,
+ *                          "ignore frame: %lld fails sanity check: %s\n",
+ *                          frame, lava_err_name(sanity));
+ *              }
+ *          }
+ *
+ *          (*
+ *           * release the frame if mapping
+ *           *)
+ *          i = lavacam_msync(type, cam_fd, &n_cam, &siz);
+ *          if (i < 0) {
+ *              fprintf(stderr, "%s: msync release error frame %lld: %d\n",
+ *                  program, frame, i);
+ *              exit(9);
+ *          }
+ *          ++frame;
+ *
+ *          (*
+ *           * wait, if requested, before the next frame
+ *           *)
+ *          if (flag.D_flag > 0.0) {
+ *              if (flag.v_flag >= 2) {
+ *                  fprintf(stderr, "wait for %.3f seconds\n", flag.D_flag);
+ *              }
+ *              lava_sleep(flag.D_flag);
+ *          }
+ *    }
+ *
+ *    (*
+ *     * close camera
+ *     *)
+ *    (void) lavacam_close(type, cam_fd, &siz);
+ *    return 0;
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <time.h>
+#include <math.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+
+#include "LavaRnd/rawio.h"
+#include "LavaRnd/lavacam.h"
+#include "LavaRnd/fnv1.h"
+
+
+struct camop {
+    int model;		/* model number - (see lava_state in xyz_drvr.c) */
+    char *module;	/* name of Linux module used by the webcam */
+    char *type;		/* webcam type */
+    char *name;		/* short name */
+    char *fullname;	/* full extended name */
+
+    /*
+     * operation functions
+     */
+    /* get camera parameters */
+    int (*get) (int fd, union lavacam * cam);
+    /* set camera parameters */
+    int (*set) (int fd, union lavacam * cam);
+    /* preset change state with LavaRnd entropy optimal values */
+    int (*LavaRnd) (union lavacam * cam, int model);
+
+    /* check camera parameters */
+    int (*check) (union lavacam * cam);
+    /* print camera parameters */
+    int (*print) (FILE * stream, int fd, union lavacam * cam,
+		  struct opsize * siz);
+
+    /* print a usage message for command line setting args */
+    void (*usage) (char *prog, char *typename);
+    /* parse command line args for setting camera values */
+    int (*argv) (int argc, char **argv, union lavacam * cam,
+		 struct lavacam_flag * flag, int model);
+
+    /* open a camera */
+    int (*open) (char *devname, int model, union lavacam * o_cam,
+		 union lavacam * n_cam, struct opsize * siz, int def,
+		 struct lavacam_flag * flag);
+    /* close a camera */
+    int (*close) (int fd, struct opsize * siz, struct lavacam_flag * flag);
+
+    /* get a frame of data */
+    int (*get_frame) (int cam_fd, struct opsize * siz);
+    /* release a mmap processed buffer */
+    int (*msync) (int fd, union lavacam * cam, struct opsize * siz);
+    /* select wait for next frame */
+    int (*wait_frame) (int fd, double max_wait);
+};
+static struct camop cam_switch[] = {
+    {730, "pwc", "pwc730", "Philips_730", "Logitech QuickCam 3000 Pro",
+     pwc_get, pwc_set, pwc_LavaRnd,
+     pwc_check, pwc_print,
+     pwc_usage, pwc_argv,
+     pwc_open, pwc_close,
+     pwc_get_frame, pwc_msync, pwc_wait_frame},
+
+    {740, "pwc", "pwc740", "Philips_740", "Philips 740 camera",
+     pwc_get, pwc_set, pwc_LavaRnd,
+     pwc_check, pwc_print,
+     pwc_usage, pwc_argv,
+     pwc_open, pwc_close,
+     pwc_get_frame, pwc_msync, pwc_wait_frame},
+
+    {513, "ov511", "dsbc100", "DSB-C100", "D-Link DSB-C100 camera",
+     ov511_get, ov511_set, ov511_LavaRnd,
+     ov511_check, ov511_print,
+     ov511_usage, ov511_argv,
+     ov511_open, ov511_close,
+     ov511_get_frame, ov511_msync, ov511_wait_frame},
+
+    {0, "none", "replay", "Frame_replay", "camdump/camdumpdir frame replay",
+     replay_get, replay_set, replay_LavaRnd,
+     replay_check, replay_print,
+     replay_usage, replay_argv,
+     replay_open, replay_close,
+     replay_get_frame, replay_msync, replay_wait_frame},
+
+    {0, "uvcvideo", "v4l2", "V4L2_stream", "Video4Linux2 streaming camera",
+     v4l2_get, v4l2_set, v4l2_LavaRnd,
+     v4l2_check, v4l2_print,
+     v4l2_usage, v4l2_argv,
+     v4l2_open, v4l2_close,
+     v4l2_get_frame, v4l2_msync, v4l2_wait_frame},
+
+    /* MUST be end of list */
+    {-1, NULL, NULL, NULL, NULL,
+     NULL, NULL, NULL,
+     NULL, NULL,
+     NULL, NULL,
+     NULL, NULL,
+     NULL, NULL, NULL}
+};
+
+/*
+ * TYPE_MAX - index of highest cam_switch index that is non-NULL
+ * UNVALID_TYPE(x) - true ==> x is not an valid cam_switch[] index
+ */
+#define TYPE_MAX (((int)sizeof(cam_switch) / (int)sizeof(cam_switch[0])) - 2)
+#define VALID_TYPE(x) ((((x) < 0) && ((x) > TYPE_MAX)) ? 1 : 0)
+
+
+/*
+ * onebit - number of 1 bits in an octet
+ */
+static int onebit[OCTET_CNT] = {
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+    1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
+    1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
+    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+    1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
+    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+    3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
+    1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
+    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+    3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
+    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+    3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
+    3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
+    4, 5, 5, 6, 5, 6, 6, 7, 5, 6, 6, 7, 6, 7, 7, 8
+};
+
+
+/*
+ * lavacam_sync - sync thread state of an open mmap camera
+ *
+ * See lavacam_sync_start().  The frames in queue[] are in the order they
+ * were queued for capture.  The first synced of them have been waited
+ * for by the sync thread, and result[] holds the outcome of each wait.
+ */
+#define LAVACAM_SYNC_MAX 16	/* maximum cameras with a sync thread */
+
+struct lavacam_sync {
+    int inuse;			/* TRUE ==> slot is in use */
+    int cam_fd;			/* open camera descriptor */
+    lavacam_sync_func sync;	/* waits for a mmap frame to be captured */
+    int ready_fd[2];		/* frame ready pipe, one octet per frame */
+    pthread_t thread;		/* the sync thread */
+    pthread_mutex_t lock;	/* guards the elements below */
+    pthread_cond_t cond;	/* signaled when a frame is queued or on stop */
+    int stop;			/* TRUE ==> sync thread must return */
+    int queue[VIDEO_MAX_FRAME];	/* frames queued for capture, in order */
+    int result[VIDEO_MAX_FRAME];	/* sync result of each queued frame */
+    int head;			/* queue index of the oldest queued frame */
+    int queued;			/* number of frames in queue */
+    int synced;			/* number of queued frames waited for */
+};
+static struct lavacam_sync lavacam_sync[LAVACAM_SYNC_MAX];
+static pthread_mutex_t lavacam_sync_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/*
+ * static functions
+ */
+static struct camop *find_camtype(char *type_name);
+static void tally_down(int *tally, int cnt, int i);
+static int popcount64(u_int64_t x);
+static int tile_cmp(const void *a, const void *b);
+static struct lavacam_sync *lavacam_sync_find(int cam_fd);
+static void *lavacam_sync_thread(void *arg);
+
+
+/*
+ * find_camtype - find a camera type in the camop table
+ *
+ * given:
+ *      type_name       type of camera
+ *
+ * returns:
+ *      camera op table pointer or NULL ==> type not found
+ */
+static struct camop *
+find_camtype(char *type_name)
+{
+    struct camop *p;
+
+    /*
+     * firewall
+     */
+    if (type_name == NULL) {
+	return NULL;
+    }
+
+    /*
+     * search the list
+     */
+    for (p = cam_switch; p->type != NULL; ++p) {
+	if (strcmp(type_name, p->type) == 0) {
+	    return p;
+	}
+    }
+    /* not found */
+    return NULL;
+}
+
+
+/*
+ * camtype - determine if the camera type is a valid type
+ *
+ * given:
+ *      type_name       name of the type of camera
+ *
+ * returns:
+ *      >= 0 ==> camera type, <0 ==> error,
+ *      e.g., LAVACAM_ERR_TYPE ==> invalid or unknown type
+ */
+int
+camtype(char *type_name)
+{
+    struct camop *p;
+
+    /*
+     * firewall
+     */
+    if (type_name == NULL) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * look for the type
+     */
+    p = find_camtype(type_name);
+    if (p == NULL) {
+	return LAVACAM_ERR_TYPE;
+    }
+
+    /*
+     * return index
+     */
+    return (p - cam_switch);
+}
+
+
+/*
+ * lavacam_print_types - print the supported camera types
+ *
+ * given:
+ *      stream          where to print camera type list
+ */
+void
+lavacam_print_types(FILE * stream)
+{
+    struct camop *p;
+
+    /*
+     * firewall
+     */
+    if (stream == NULL) {
+	fprintf(stderr, "print_camtypes: NULL arg\n");
+	return;
+    }
+
+    /*
+     * print list
+     */
+    fprintf(stream, "Supported camera types and modules:\n");
+    for (p = cam_switch; p->type != NULL; ++p) {
+	fprintf(stream, "\t%s\t\t%s\tmodule: %s\n",
+		p->type, p->fullname, p->module);
+    }
+    return;
+}
+
+
+/*
+ * lavacam_get - get an open camera's state
+ *
+ * given:
+ *      type    type of camera
+ *      cam_fd  open camera file descriptor
+ *      cam     pointer to camera state
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ */
+int
+lavacam_get(int type, int cam_fd, union lavacam *cam)
+{
+    /*
+     * firewall
+     */
+    if (VALID_TYPE(type) || cam_fd < 0 || cam == NULL) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * get camera parameters
+     */
+    return cam_switch[type].get(cam_fd, cam);
+}
+
+
+/*
+ * lavacam_set - set an open camera's state
+ *
+ * given:
+ *      type    type of camera
+ *      cam_fd  open camera file descriptor
+ *      cam     pointer to camera state change if mask is non-zero
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ */
+int
+lavacam_set(int type, int cam_fd, union lavacam *cam)
+{
+    int check_ret;	/* parameter check return */
+
+    /*
+     * firewall
+     */
+    if (VALID_TYPE(type) || cam_fd < 0 || cam == NULL) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * check values before setting
+     */
+    check_ret = cam_switch[type].check(cam);
+    if (check_ret < 0) {
+	return check_ret;
+    }
+
+    /*
+     * set camera parameters
+     */
+    return cam_switch[type].set(cam_fd, cam);
+}
+
+
+/*
+ * lavacam_LavaRnd - preset change state with LavaRnd entropy optimal values
+ *
+ * given:
+ *      type    type of camera
+ *      cam     pointer to camera state
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ */
+int
+lavacam_LavaRnd(int type, union lavacam *cam)
+{
+    /*
+     * firewall
+     */
+    if (VALID_TYPE(type) || cam == NULL) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * get camera parameters
+     */
+    return cam_switch[type].LavaRnd(cam, cam_switch[type].model);
+}
+
+
+/*
+ * lavacam_check - determine if the camera state change is valid
+ *
+ * given:
+ *      type    type of camera
+ *      cam     pointer to camera state change to be checked
+ *
+ * returns:
+ *      0 ==> masked values of union are OK, <0 ==> error in masked values
+ */
+int
+lavacam_check(int type, union lavacam *cam)
+{
+    /*
+     * firewall
+     */
+    if (VALID_TYPE(type) || cam == NULL) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * set camera parameters
+     */
+    return cam_switch[type].check(cam);
+}
+
+
+/*
+ * lavacam_print - print state of an open camera
+ *
+ * given:
+ *      type    type of camera
+ *      stream  open stream on which to print
+ *      cam_fd  open camera descriptor
+ *      cam     pointer to camera state
+ *      siz     pointer to operation size and buffer structure
+ *
+ * returns:
+ *      0 ==> all masked values are valid, <0 ==> error
+ */
+int
+lavacam_print(int type, FILE * stream, int cam_fd,
+	      union lavacam *cam, struct opsize *siz)
+{
+    /*
+     * firewall
+     */
+    if (stream == NULL || VALID_TYPE(type) || cam_fd < 0 ||
+	cam == NULL || siz == NULL) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * set camera parameters
+     */
+    return cam_switch[type].print(stream, cam_fd, cam, siz);
+}
+
+
+/*
+ * lavacam_usage - print an argc/argv usage message
+ *
+ * given:
+ *      type            type of camera
+ *      prog            name of calling prog
+ *      typename        name of camera type
+ *
+ * NOTE: The typical way to call this function is:
+ *
+ *      ret = lavacam_argv(type, argc, argv, cam);
+ *      if (ret < 0) {
+ *          lavacam_usage(type, argv[0], argv[1]);
+ *      }
+ *      argc -= ret;
+ *      argv += ret;
+ */
+void
+lavacam_usage(int type, char *prog, char *typename)
+{
+    /*
+     * firewall
+     */
+    if (prog == NULL) {
+	fprintf(stderr, "lavacam_usage: called with NULL prog arg\n");
+	return;
+    }
+    if (VALID_TYPE(type)) {
+	fprintf(stderr, "%s: lavacam_usage: invalid type: %d\n", prog, type);
+	return;
+    }
+
+    /*
+     * print usage message
+     */
+    cam_switch[type].usage(prog, typename);
+    return;
+}
+
+
+/*
+ * lavacam_argv - argc/argv parse, sets a cameras state change and global flags
+ *
+ * given:
+ *      type    type of camera
+ *      argc    command line argc count
+ *      argv    point to array of command line argument strings
+ *      cam     pointer to values to be set if mask is non-zero
+ *      flag    flags to set
+ *
+ * returns:
+ *      amount of args to skip, <0 ==> error
+ */
+int
+lavacam_argv(int type, int argc, char **argv, union lavacam *cam,
+	     struct lavacam_flag *flag)
+{
+    int argv_ret;	/* argv parse return */
+    int check_ret;	/* parameter check return */
+
+    /*
+     * firewall
+     */
+    if (VALID_TYPE(type) || argc <= 0 || argv == NULL || argv[0] == NULL ||
+	cam == NULL || flag == NULL) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * parse command line, turn into camera parameters
+     */
+    argv_ret = cam_switch[type].argv(argc, argv, cam, flag,
+				     cam_switch[type].model);
+    if (argv_ret < 0) {
+	return argv_ret;
+    }
+
+    /*
+     * sanity check parameters
+     */
+    check_ret = cam_switch[type].check(cam);
+    if (check_ret < 0) {
+	return check_ret;
+    }
+
+    /*
+     * return argv shift
+     */
+    return argv_ret;
+}
+
+
+/*
+ * lavacam_open - open a camera, verify its type, return opening camera state
+ *
+ * given:
+ *      type        type of camera
+ *      devname     camera device file
+ *      o_cam       where to place the open camera state
+ *      n_cam       is non-NULL, set this new state and channel number
+ *                      updated with the final open state if non-NULL
+ *      siz         pointer to operation size and buffer structure
+ *      def         0 ==> restore saved user settings, 1 ==> keep cur setting
+ *      flag        flags set via lavacam_argv()
+ *
+ * returns:
+ *      >=0 ==> camera file descriptor, <0 ==> error
+ *
+ * NOTE: This function directly sets the open_time struct opsize element
+ *       on a successful open.
+ */
+int
+lavacam_open(int type, char *devname, union lavacam *o_cam,
+	     union lavacam *n_cam, struct opsize *siz,
+	     int def, struct lavacam_flag *flag)
+{
+    int ret;	/* driver open return */
+
+    /*
+     * firewall
+     */
+    if (VALID_TYPE(type) || devname == NULL || o_cam == NULL || flag == NULL) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * open the camera
+     */
+    ret = cam_switch[type].open(devname, cam_switch[type].model,
+				o_cam, n_cam, siz, def, flag);
+    if (ret >= 0) {
+	siz->open_time = time(NULL);
+    }
+    return ret;
+}
+
+
+/*
+ * lavacam_close - close an open camera
+ *
+ * given:
+ *      type        type of camera
+ *      cam_fd      open camera descriptor
+ *      siz         pointer to operation size and buffer structure
+ *      flag        flags set via lavacam_argv()
+ *
+ * returns:
+ *      >=0 ==> camera closed, <0 ==> close
+ */
+int
+lavacam_close(int type, int cam_fd, struct opsize *siz,
+	      struct lavacam_flag *flag)
+{
+    /*
+     * firewall
+     */
+    if (VALID_TYPE(type) || cam_fd < 0 || siz == NULL || flag == NULL) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * close the camera
+     */
+    return cam_switch[type].close(cam_fd, siz, flag);
+}
+
+
+/*
+ * lavacam_read - read from the camera
+ *
+ * given:
+ *      type        type of camera
+ *      cam_fd      open camera descriptor
+ *      siz         pointer to operation size and buffer structure
+ *
+ * returns:
+ *      >= 0 ==> octets read, <0 ==> error
+ *
+ * NOTE: This function increments the frame_num struct opsize field
+ *       on a successful get.
+ *
+ * NOTE: When reading into a ring of image buffers, and the frame in the
+ *	 current buffer was kept as the previous frame by lavacam_sanity(),
+ *	 this function moves on to the next buffer of the ring before reading.
+ */
+int
+lavacam_get_frame(int type, int cam_fd, struct opsize *siz)
+{
+    int ret;	/* driver get_frame return */
+    int lavaoff;	/* offset of chaos in image */
+
+    /*
+     * firewall
+     */
+    if (VALID_TYPE(type) || cam_fd < 0 || siz == NULL) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * do not read over the previous frame
+     */
+    if (siz->use_read && siz->ring[0] != NULL &&
+	siz->prev_frame != NULL && siz->prev_frame == siz->chaos) {
+	lavaoff = (u_int8_t *)siz->chaos - (u_int8_t *)siz->image;
+	siz->ring_indx = (siz->ring_indx + 1) % LAVACAM_RING;
+	siz->image = siz->ring[siz->ring_indx];
+	siz->chaos = (u_int8_t *)siz->image + lavaoff;
+    }
+
+    /*
+     * read from the camera
+     */
+    ret = cam_switch[type].get_frame(cam_fd, siz);
+    if (ret >= 0) {
+	++siz->frame_num;
+    }
+    return ret;
+}
+
+
+/*
+ * popcount64 - number of 1 bits in a 64 bit value
+ *
+ * This is the usual parallel bit count.  It needs no table lookups, and
+ * compilers that know of a population count instruction for the target
+ * will often use that instruction in its place.
+ */
+static int
+popcount64(u_int64_t x)
+{
+    x -= (x >> 1) & (u_int64_t)0x5555555555555555ULL;
+    x = (x & (u_int64_t)0x3333333333333333ULL) +
+	((x >> 2) & (u_int64_t)0x3333333333333333ULL);
+    x = (x + (x >> 4)) & (u_int64_t)0x0f0f0f0f0f0f0f0fULL;
+    return (int)((x * (u_int64_t)0x0101010101010101ULL) >> 56);
+}
+
+
+/*
+ * STAT_STRIDE - octets processed by each pass of the lavacam_frame_stats loop
+ */
+#define STAT_STRIDE ((int)sizeof(u_int64_t))
+
+
+/*
+ * tally_down - restore the max heap order of a tally below a given element
+ *
+ * given:
+ *      tally           tally of octet values arranged as a max heap
+ *      cnt             number of elements in the heap
+ *      i               element that may be smaller than its children
+ */
+static void
+tally_down(int *tally, int cnt, int i)
+{
+    int child;		/* larger child of element i */
+    int val;		/* value being moved down the heap */
+
+    /*
+     * move the element i value down until it is not smaller than its children
+     */
+    val = tally[i];
+    while ((child = 2 * i + 1) < cnt) {
+	if (child + 1 < cnt && tally[child + 1] > tally[child]) {
+	    ++child;
+	}
+	if (val >= tally[child]) {
+	    break;
+	}
+	tally[i] = tally[child];
+	i = child;
+    }
+    tally[i] = val;
+    return;
+}
+
+
+/*
+ * lavacam_frame_stats - gather frame sanity statistics in a single pass
+ *
+ * given:
+ *      frame           pointer to the frame
+ *      prev            pointer to the previous frame, NULL ==> no bit diff
+ *      len             length of frames in octets
+ *      top_x           ignore the top_x common octet values
+ *      flags           LAVACAM_STAT_TALLY and/or LAVACAM_STAT_DIFF
+ *      stats           where to record the statistics
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ *
+ * This function reads the frame once.  While it tallies the octet values
+ * for the uncommon octet fraction, the 1/2 level and the octet min-entropy
+ * (see lavacam_uncom_entropy()), it also counts the bits that differ from
+ * the previous frame (see lavacam_bitdiff_fract()).
+ *
+ * The octet values are tallied into 4 interleaved tallies so that a run
+ * of equal octets does not wait on the increment of the same counter.
+ * The bit difference is counted 64 bits at a time.  Only the most common
+ * tally values needed for the top_x and 1/2 level are put in order.
+ *
+ * NOTE: Statistics not asked for by flags, or not able to be computed,
+ *	 are set to -1 in stats.
+ */
+int
+lavacam_frame_stats(u_int8_t *frame, u_int8_t *prev, int len, int top_x,
+		    int flags, struct lavacam_stats *stats)
+{
+    int sub[4][OCTET_CNT];	/* interleaved tallies of octet values */
+    int tally[OCTET_CNT];	/* tally of octet values in frame */
+    int do_tally;		/* TRUE ==> tally octet values */
+    int do_diff;		/* TRUE ==> count bit difference */
+    u_int64_t one_bits;		/* 1 bit difference */
+    u_int64_t word;		/* 64 bits of frame xor previous frame */
+    u_int64_t pword;		/* 64 bits of the previous frame */
+    int cnt;			/* number of tally values in the heap */
+    int sum;			/* sum of the most common tally values */
+    int common;			/* number of common octets */
+    int half_len;		/* len/2 */
+    int hlvl;			/* used to find half_x value */
+    int i;
+
+    /*
+     * firewall
+     */
+    if (stats == NULL) {
+	return LAVACAM_ERR_ARG;
+    }
+    stats->uncom_fract = -1.0;
+    stats->half_x = -1;
+    stats->octet_entropy = -1.0;
+    stats->bitdiff_fract = -1.0;
+    if (frame == NULL || len < 1) {
+	/* no frame means no uncommon octets and no bits are different */
+	if (flags & LAVACAM_STAT_TALLY) {
+	    stats->uncom_fract = 0.0;
+	    stats->octet_entropy = 0.0;
+	}
+	if (flags & LAVACAM_STAT_DIFF) {
+	    stats->bitdiff_fract = 0.0;
+	}
+	return LAVAERR_OK;
+    }
+    do_tally = ((flags & LAVACAM_STAT_TALLY) != 0);
+    do_diff = ((flags & LAVACAM_STAT_DIFF) != 0);
+    if (do_diff && prev == NULL) {
+	/* missing previous frame means no bits are different */
+	stats->bitdiff_fract = 0.0;
+	do_diff = FALSE;
+    }
+    /* case: absurd top_x values */
+    if (top_x < 0) {
+	/* no common means all are uncommon */
+	top_x = 0;
+    } else if (top_x > OCTET_CNT) {
+	/* all common means none are uncommon */
+	top_x = OCTET_CNT;
+    }
+
+    /*
+     * tally the octet values and count the bit difference
+     */
+    if (do_tally) {
+	memset(sub, 0, sizeof(sub));
+    }
+    one_bits = 0;
+    for (i = 0; i + STAT_STRIDE <= len; i += STAT_STRIDE) {
+	if (do_tally) {
+	    sub[0][frame[i]]++;
+	    sub[1][frame[i + 1]]++;
+	    sub[2][frame[i + 2]]++;
+	    sub[3][frame[i + 3]]++;
+	    sub[0][frame[i + 4]]++;
+	    sub[1][frame[i + 5]]++;
+	    sub[2][frame[i + 6]]++;
+	    sub[3][frame[i + 7]]++;
+	}
+	if (do_diff) {
+	    /* memcpy because frames need not be 64 bit aligned */
+	    memcpy(&word, frame + i, sizeof(word));
+	    memcpy(&pword, prev + i, sizeof(pword));
+	    one_bits += popcount64(word ^ pword);
+	}
+    }
+    for (; i < len; ++i) {
+	if (do_tally) {
+	    sub[0][frame[i]]++;
+	}
+	if (do_diff) {
+	    one_bits += onebit[frame[i] ^ prev[i]];
+	}
+    }
+
+    /*
+     * record the bit difference fraction
+     */
+    if (do_diff) {
+	stats->bitdiff_fract = (double)one_bits /
+			       ((double)len * (double)BITS_PER_OCTET);
+    }
+    if (!do_tally) {
+	return LAVAERR_OK;
+    }
+
+    /*
+     * combine the interleaved tallies into a max heap
+     */
+    for (i = 0; i < OCTET_CNT; ++i) {
+	tally[i] = sub[0][i] + sub[1][i] + sub[2][i] + sub[3][i];
+    }
+    for (i = OCTET_CNT / 2 - 1; i >= 0; --i) {
+	tally_down(tally, OCTET_CNT, i);
+    }
+
+    /*
+     * the most common octet value bounds the octet min-entropy
+     *
+     * A frame octet has a min-entropy of -log2(p) bits, where p is the
+     * chance of the most likely octet value.
+     */
+    stats->octet_entropy = -log((double)tally[0] / (double)len) / log(2.0);
+
+    /*
+     * take the most common tally values, in order, until we have
+     * both the top_x common octets and the half level
+     */
+    half_len = len / 2;
+    cnt = OCTET_CNT;
+    sum = 0;
+    common = 0;
+    hlvl = -1;
+    for (i = 0; i < OCTET_CNT && (i < top_x || hlvl < 0); ++i) {
+	sum += tally[0];
+	tally[0] = tally[--cnt];
+	tally_down(tally, cnt, 0);
+	if (i < top_x) {
+	    common = sum;
+	}
+	if (hlvl < 0 && sum >= half_len) {
+	    hlvl = i;
+	}
+    }
+    stats->uncom_fract = (double)(len - common) / (double)len;
+    stats->half_x = hlvl;
+    return LAVAERR_OK;
+}
+
+
+/*
+ * lavacam_uncom_fract - determine the fraction of uncommon octets in a frame
+ *
+ * given:
+ *      frame           pointer to the frame
+ *      len             length of frame in octets
+ *      top_x           ignore the top_x common octet values
+ *      p_half_x        where to record 1/2 level value (NULL ==> ignore)
+ *
+ * returns:
+ *      value from 0.0 to 1.0 giving the faction of octets in the frame
+ *	that are uncommon.  0.0 means none of the octets are uncommon all
+ *	are in the top_x.  As the return value approaches 0.0, more and
+ *	more of the octets are uncommon (i.e., greater portion not in
+ *	the top_x).
+ *
+ * The p_half_x, if non-NULL, is where the 1/2 level is recorded.
+ * The 1/2 level is the point where the *p_half_x values first exceed
+ * 50% of the available octets.
+ *
+ * NOTE: Reasonable top_x are between 1 and 255.  A top_x of 0 means
+ *       there are no common octets (thus all are uncommon).  A top_x
+ *       of 256 means all common (this none are uncommon).
+ */
+double
+lavacam_uncom_fract(u_int8_t * frame, int len, int top_x, int *p_half_x)
+{
+    return lavacam_uncom_entropy(frame, len, top_x, p_half_x, NULL);
+}
+
+
+/*
+ * lavacam_uncom_entropy - uncommon octet fraction and octet min-entropy
+ *
+ * given:
+ *      frame           pointer to the frame
+ *      len             length of frame in octets
+ *      top_x           ignore the top_x common octet values
+ *      p_half_x        where to record 1/2 level value (NULL ==> ignore)
+ *      p_entropy       where to record octet min-entropy (NULL ==> ignore)
+ *
+ * returns:
+ *      value from 0.0 to 1.0 giving the faction of octets in the frame
+ *	that are uncommon, as with lavacam_uncom_fract()
+ *
+ * The p_entropy, if non-NULL, is where the min-entropy per octet, in bits,
+ * is recorded.  It is found from the frequency of the most common octet
+ * value in the same octet value tally that gives the uncommon fraction.
+ * It ranges from 0.0 (all octets are the same) to 8.0.
+ */
+double
+lavacam_uncom_entropy(u_int8_t * frame, int len, int top_x, int *p_half_x,
+		      double *p_entropy)
+{
+    struct lavacam_stats stats;	/* frame statistics */
+
+    /*
+     * tally the frame
+     */
+    (void) lavacam_frame_stats(frame, NULL, len, top_x, LAVACAM_STAT_TALLY,
+			       &stats);
+
+    /*
+     * return what was asked for
+     */
+    if (p_half_x != NULL) {
+	*p_half_x = stats.half_x;
+    }
+    if (p_entropy != NULL) {
+	*p_entropy = stats.octet_entropy;
+    }
+    return stats.uncom_fract;
+}
+
+
+/*
+ * lavacam_bitdiff_fract - determine faction of bits different in two buffers
+ *
+ * given:
+ *      frame1          pointer to the 1st frame
+ *      frame2          pointer to the 2nd frame
+ *      len             length of frames in octets
+ *
+ * return:
+ *      value from 0.0 to 1.0 giving the faction of bits in frame1 that
+ *         are different than in frame2.  A value of 0.0 means that the
+ *         frames are exactly the same.  A value of 1.0 means that one
+ *         frame is the bit-wise complement of the other frame (all bits
+ *         are different).
+ */
+double
+lavacam_bitdiff_fract(u_int8_t * frame1, u_int8_t * frame2, int len)
+{
+    struct lavacam_stats stats;	/* frame statistics */
+
+    /*
+     * firewall
+     */
+    if (frame1 == NULL || frame2 == NULL) {
+	/* missing frame(s) means no bits are different */
+	return 0.0;
+    }
+
+    /*
+     * count bit difference
+     */
+    (void) lavacam_frame_stats(frame1, frame2, len, 0, LAVACAM_STAT_DIFF,
+			       &stats);
+    return stats.bitdiff_fract;
+}
+
+
+/*
+ * frame_fingerprint - fingerprint a chaos frame for the repeat check
+ *
+ * given:
+ *	frame	chaos frame
+ *	len	length of frame in octets
+ *
+ * returns:
+ *	FNV-1 hash of LAVACAM_FP_SAMPLES evenly spaced samples of the frame
+ *
+ * NOTE: A frame no longer than the samples is hashed whole.  Frames that
+ *	 differ only between the samples have the same fingerprint.  For
+ *	 a noisy camera that is as good as identical: LAVACAM_FP_SAMPLES
+ *	 samples will not all match by chance.
+ */
+static u_int64_t
+frame_fingerprint(u_int8_t *frame, int len)
+{
+    u_int8_t sample[LAVACAM_FP_SAMPLES * STAT_STRIDE];	/* frame samples */
+    int stride;			/* octets between samples */
+    int i;
+
+    /*
+     * hash a small frame whole
+     */
+    if (len <= (int)sizeof(sample)) {
+	return fnv1_hash(frame, (u_int32_t)len);
+    }
+
+    /*
+     * hash evenly spaced samples of a larger frame
+     */
+    stride = len / LAVACAM_FP_SAMPLES;
+    for (i = 0; i < LAVACAM_FP_SAMPLES; ++i) {
+	memcpy(sample + i * STAT_STRIDE, frame + i * stride, STAT_STRIDE);
+    }
+    return fnv1_hash(sample, (u_int32_t)sizeof(sample));
+}
+
+
+/*
+ * lavacam_sanity - perform a sanity check the frame just read
+ *
+ * The purpose of this check is to prevent obvious camera failures
+ * and major flaws from being used to compute LavaRnd values.
+ *
+ * given:
+ *      siz         pointer to operation size and buffer structure
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ *
+ * NOTE: This function increments the insane_cnt field of the struct opsize
+ *       when a frame is returned as insane.
+ *
+ * NOTE: This function keeps a sane frame as the prev_frame of the struct
+ *       opsize for comparison next time (see lavacam_keep_frame()).
+ *	 Insane frames are not kept.
+ *
+ * NOTE: This function sets the entropy field of the struct opsize to an
+ *	 estimate of the min-entropy of a sane frame in bits, or to -1.0
+ *	 when it cannot make one.  The estimate is the smaller of the octet
+ *	 min-entropy, from the octet value tally of the uncommon octet check,
+ *	 and the min-entropy of the bits that change from the previous
+ *	 frame, over the whole chaos segment.  The estimate is made only
+ *	 when both the uncommon octet and previous frame checks are enabled.
+ *	 Insane frames always have an entropy of -1.0.
+ *
+ * NOTE: Both checks are made from one lavacam_frame_stats() pass over the
+ *	 frame.  The statistics are left in the stats field of the struct
+ *	 opsize, for sane and insane frames alike, so that callers may
+ *	 report them without looking at the frame again.
+ *
+ * NOTE: When the previous frame check is enabled, a frame is also
+ *	 rejected when its fingerprint (see frame_fingerprint()) matches
+ *	 one of the last LAVACAM_FP_HIST sane frames.  The previous frame
+ *	 check only catches a camera that repeats its last frame.  This
+ *	 catches a stuck driver that cycles through a few stale buffers,
+ *	 or a source that replays old frames.
+ *
+ * TODO: Consider other non-CPU intensive tests to further improve
+ *       sanity checks.  Also consider a way to dynamically compute the
+ *       top_x, min_fract and diff_fract values for a given camera,
+ *       if that is at all possible.
+ */
+int
+lavacam_sanity(struct opsize *siz)
+{
+    struct lavacam_stats *stats;	/* frame statistics */
+    int flags;			/* which statistics to gather */
+    double diff_entropy;	/* min-entropy per octet of bit changes */
+    u_int64_t fp;		/* frame fingerprint */
+    int ret;			/* lavacam_frame_stats return */
+    int i;
+
+    /*
+     * firewall
+     */
+    if (siz == NULL) {
+	return LAVACAM_ERR_ARG;
+    }
+    siz->entropy = -1.0;
+    stats = &siz->stats;
+    diff_entropy = -1.0;
+
+    /*
+     * gather what the enabled checks need in one pass over the frame
+     *
+     * We do not compare a frame until there is a previous sane frame.
+     */
+    flags = 0;
+    if (siz->min_fract > 0.0) {
+	flags |= LAVACAM_STAT_TALLY;
+    }
+    if (siz->prev_frame != NULL && siz->diff_fract > 0.0) {
+	flags |= LAVACAM_STAT_DIFF;
+    }
+    ret = lavacam_frame_stats(siz->chaos, siz->prev_frame, siz->chaos_len,
+			      siz->top_x, flags, stats);
+    if (ret < 0) {
+	return ret;
+    }
+
+    /*
+     * verify that we have enough uncommon octet values
+     *
+     * It may be usual for a frame to have a some common octet values
+     * (low light level values) and (stuck nearly/fully on values).
+     * These common octet values typically are not very entropic.  The
+     * entroy typically lies in the less common octet values.
+     */
+    if (flags & LAVACAM_STAT_TALLY) {
+	if (stats->uncom_fract < siz->min_fract) {
+	    /*
+	     * The siz->top_x common octet values occupy too many of
+	     * the octets in the frame.  There are not enough
+	     * uncommon octet values.
+	     */
+	    ++siz->insane_cnt;
+	    return LAVACAM_ERR_UNCOMMON;
+	}
+
+	/*
+	 * check the half level
+	 *
+	 * The siz->half_x most common values account for >=50% of the
+	 * octets in the frame.  The half_x value indicates that the
+	 * half_x most common octet values occupy >=50% of the octets
+	 * in the frame.  So we need to compare siz->half_x with half_x.
+	 */
+	if (stats->half_x < siz->half_x) {
+	    /*
+	     * The half_x most common octet values, there they first
+	     * exceed 50% of the octets in the frame, is too low.
+	     * The frame is too dominated by the more common values.
+	     */
+	    ++siz->insane_cnt;
+	    return LAVACAM_ERR_HALFLVL;
+	}
+    }
+
+    /*
+     * verify that frame are not too similar or too different to prev frame
+     *
+     * If a camera is repeating frames, then they will be bit-for-bit
+     * similar if not identical.  If a camera is taking frames too
+     * quickly, or if the camera is being subjected to a constant
+     * light source, then successive frames will be very similar.
+     * If a number of bits are flip-flopping, then successive frames
+     * will appear bit-wise complements of each other too many times.
+     * Too much similarity is just as bad is too much difference.
+     */
+    if (flags & LAVACAM_STAT_DIFF) {
+	if (stats->bitdiff_fract < siz->diff_fract) {
+	    /*
+	     * frame is too similar to the previous frame
+	     */
+	    ++siz->insane_cnt;
+	    return LAVACAM_ERR_OVERSAME;
+	} else if ((1.0 - stats->bitdiff_fract) < siz->diff_fract) {
+	    /*
+	     * frame is too different from the previous frame
+	     */
+	    ++siz->insane_cnt;
+	    return LAVACAM_ERR_OVERDIFF;
+	}
+
+	/*
+	 * a bit that changes with chance p has a min-entropy of
+	 * -log2(max(p, 1-p)) bits
+	 */
+	if (stats->bitdiff_fract > 0.5) {
+	    diff_entropy = -log(stats->bitdiff_fract) / log(2.0);
+	} else {
+	    diff_entropy = -log(1.0 - stats->bitdiff_fract) / log(2.0);
+	}
+	diff_entropy *= (double)BITS_PER_OCTET;
+    }
+
+    /*
+     * verify that the frame does not repeat a recent sane frame
+     *
+     * A stuck driver may hand back a few stale buffers in turn.  Each
+     * differs enough from the one before to pass the previous frame
+     * check above, yet adds nothing new.
+     */
+    fp = 0;
+    if (siz->diff_fract > 0.0) {
+	fp = frame_fingerprint(siz->chaos, siz->chaos_len);
+	for (i = 0; i < siz->fp_cnt; ++i) {
+	    if (siz->fp_hist[i] == fp) {
+		++siz->insane_cnt;
+		return LAVACAM_ERR_REPEAT;
+	    }
+	}
+    }
+
+    /*
+     * estimate the min-entropy of this sane frame
+     */
+    if (stats->octet_entropy >= 0.0 && diff_entropy >= 0.0) {
+	siz->entropy = ((stats->octet_entropy < diff_entropy) ?
+			stats->octet_entropy : diff_entropy) *
+		       (double)siz->chaos_len;
+    }
+
+    /*
+     * This frame is not too similar to the previous frame, so make
+     * this frame the new previous frame for next time.
+     */
+    if (siz->diff_fract > 0.0) {
+	lavacam_keep_frame(siz);
+	siz->fp_hist[siz->fp_next] = fp;
+	siz->fp_next = (siz->fp_next + 1) % LAVACAM_FP_HIST;
+	if (siz->fp_cnt < LAVACAM_FP_HIST) {
+	    ++siz->fp_cnt;
+	}
+    }
+
+    /*
+     * sanity check passed
+     */
+    return LAVAERR_OK;
+}
+
+
+/*
+ * lavacam_keep_frame - keep the current frame as the previous frame
+ *
+ * given:
+ *      siz         pointer to operation size and buffer structure
+ *
+ * The current chaos frame becomes the prev_frame of the struct opsize,
+ * ready for the next lavacam_sanity() bit difference check.
+ *
+ * When the frames stay where they are after the next frame is obtained,
+ * prev_frame just points at the current chaos frame and nothing is copied.
+ * This is the case when reading into a ring of image buffers (the next
+ * lavacam_get_frame() reads into another buffer), or when a driver leaves
+ * each frame in its own place in a mmapped region.  Otherwise the frame
+ * is copied into the prev_buf buffer set up by lavacam_frame_alloc().
+ */
+void
+lavacam_keep_frame(struct opsize *siz)
+{
+    /*
+     * firewall
+     */
+    if (siz == NULL || siz->chaos == NULL) {
+	return;
+    }
+
+    /*
+     * copy only if the next frame will be obtained over this one
+     */
+    if (siz->prev_buf != NULL) {
+	memcpy(siz->prev_buf, siz->chaos, siz->chaos_len);
+	siz->prev_frame = siz->prev_buf;
+    } else {
+	siz->prev_frame = siz->chaos;
+    }
+    return;
+}
+
+
+/*
+ * tile_cmp - qsort compare of two lavacam_extract() tile scores
+ */
+static int
+tile_cmp(const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+
+/*
+ * lavacam_extract - pack the noisy part of a sane chaos frame densely
+ *
+ * given:
+ *      siz         pointer to operation size and buffer structure
+ *      planes      low order bit-planes of each octet to keep, 1 to 8
+ *      tiles       fraction of the frame tiles to keep, >0.0 to 1.0
+ *      buf         where to pack the kept bits
+ *      buflen      length of buf in octets
+ *      p_entropy   where to record the est min-entropy of buf in bits
+ *
+ * returns:
+ *      octets packed into buf, or <0 ==> error
+ *
+ * Not all of a chaos frame is equally chaotic.  The high order bits of
+ * an octet change less than the low order bits, and the flat parts of
+ * an image change less than the rest.  This function keeps only the
+ * low planes bits of each octet, from only the tiles fraction of the
+ * frame tiles that are the least flat, and packs them into buf.  The
+ * tiles are kept in frame order.  LavaRnd processing the smaller buf
+ * takes less hashing for the same entropy.
+ *
+ * A tile is scored by the tally of its most common octet value.  A tile
+ * with a lower score is less flat.  When tiles is 1.0, all tiles are
+ * kept and they are not scored.
+ *
+ * The entropy estimate of buf is the lesser of the frame entropy estimate
+ * in proportion to the bits kept, and the octet min-entropy of buf.
+ * Because the kept bits are the most chaotic, the 1st is cautious.
+ * The *p_entropy is set to -1.0 if the frame has no entropy estimate.
+ *
+ * NOTE: This function must be called after lavacam_sanity() and before
+ *	 lavacam_msync(), while siz->chaos is the current sane frame.
+ *	 A buf of siz->chaos_len octets is always long enough.
+ */
+int
+lavacam_extract(struct opsize *siz, int planes, double tiles,
+		u_int8_t *buf, int buflen, double *p_entropy)
+{
+    int score[LAVACAM_MAX_TILE];	/* tile scores in frame order */
+    int order[LAVACAM_MAX_TILE];	/* tile scores in increasing order */
+    int tally[OCTET_CNT];	/* tally of octet values in a tile */
+    struct lavacam_stats stats;	/* octet tally of buf */
+    u_int8_t *frame;		/* chaos frame */
+    u_int8_t *tile;		/* start of a tile */
+    u_int8_t *out;		/* next octet of buf to pack */
+    u_int8_t mask;		/* low planes bits of an octet */
+    u_int32_t acc;		/* bits waiting to be packed */
+    int nbits;			/* number of bits waiting in acc */
+    int tile_len;		/* octets in a tile */
+    int ntile;			/* tiles in the frame */
+    int keep;			/* tiles to keep */
+    int ties;			/* tiles to keep whose score is the cutoff */
+    int cutoff;			/* highest score of a kept tile */
+    int kept;			/* octets of the frame kept */
+    int len;			/* octets in this tile */
+    int max;			/* tally of the most common octet in a tile */
+    int i;
+    int j;
+
+    /*
+     * firewall
+     */
+    if (siz == NULL || buf == NULL || p_entropy == NULL) {
+	return LAVACAM_ERR_ARG;
+    }
+    *p_entropy = -1.0;
+    if (planes < 1 || planes > BITS_PER_OCTET || tiles <= 0.0 || tiles > 1.0) {
+	return LAVACAM_ERR_ARG;
+    }
+    frame = (u_int8_t *)siz->chaos;
+    if (frame == NULL || siz->chaos_len <= 0) {
+	return 0;
+    }
+    if (buflen < (siz->chaos_len*planes + BITS_PER_OCTET-1) / BITS_PER_OCTET) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * divide the frame into tiles
+     */
+    tile_len = (siz->chaos_len + LAVACAM_MAX_TILE-1) / LAVACAM_MAX_TILE;
+    if (tile_len < LAVACAM_TILE) {
+	tile_len = LAVACAM_TILE;
+    }
+    ntile = (siz->chaos_len + tile_len-1) / tile_len;
+    keep = (int)ceil((double)ntile * tiles);
+    if (keep < 1) {
+	keep = 1;
+    } else if (keep > ntile) {
+	keep = ntile;
+    }
+
+    /*
+     * score the tiles and find the score cutoff of the tiles to keep
+     */
+    cutoff = siz->chaos_len;
+    ties = ntile;
+    if (keep < ntile) {
+	for (i = 0; i < ntile; ++i) {
+	    tile = frame + i*tile_len;
+	    len = ((i < ntile-1) ? tile_len : siz->chaos_len - i*tile_len);
+	    memset(tally, 0, sizeof(tally));
+	    for (j = 0; j < len; ++j) {
+		tally[tile[j]]++;
+	    }
+	    max = 0;
+	    for (j = 0; j < OCTET_CNT; ++j) {
+		if (tally[j] > max) {
+		    max = tally[j];
+		}
+	    }
+	    /* a short last tile is scored as if it were full length */
+	    score[i] = (int)((double)max * (double)tile_len / (double)len);
+	    order[i] = score[i];
+	}
+	qsort(order, ntile, sizeof(order[0]), tile_cmp);
+	cutoff = order[keep-1];
+	ties = 0;
+	for (i = keep-1; i >= 0 && order[i] == cutoff; --i) {
+	    ++ties;
+	}
+    }
+
+    /*
+     * pack the low planes bits of the octets of the kept tiles
+     */
+    mask = (u_int8_t)((1 << planes) - 1);
+    out = buf;
+    acc = 0;
+    nbits = 0;
+    kept = 0;
+    for (i = 0; i < ntile; ++i) {
+
+	/* skip tiles that are too flat */
+	if (keep < ntile) {
+	    if (score[i] > cutoff) {
+		continue;
+	    } else if (score[i] == cutoff) {
+		if (ties <= 0) {
+		    continue;
+		}
+		--ties;
+	    }
+	}
+	tile = frame + i*tile_len;
+	len = ((i < ntile-1) ? tile_len : siz->chaos_len - i*tile_len);
+	kept += len;
+
+	/* all planes need no packing */
+	if (planes == BITS_PER_OCTET) {
+	    memcpy(out, tile, len);
+	    out += len;
+	    continue;
+	}
+	for (j = 0; j < len; ++j) {
+	    acc = (acc << planes) | (tile[j] & mask);
+	    nbits += planes;
+	    if (nbits >= BITS_PER_OCTET) {
+		nbits -= BITS_PER_OCTET;
+		*out++ = (u_int8_t)(acc >> nbits);
+	    }
+	}
+    }
+    if (nbits > 0) {
+	*out++ = (u_int8_t)(acc << (BITS_PER_OCTET - nbits));
+    }
+
+    /*
+     * estimate the min-entropy of buf
+     */
+    if (siz->entropy >= 0.0 &&
+	lavacam_frame_stats(buf, NULL, out - buf, 0, LAVACAM_STAT_TALLY,
+			    &stats) == LAVAERR_OK) {
+	*p_entropy = siz->entropy * (double)kept * (double)planes /
+		     ((double)siz->chaos_len * (double)BITS_PER_OCTET);
+	if (stats.octet_entropy * (double)(out - buf) < *p_entropy) {
+	    *p_entropy = stats.octet_entropy * (double)(out - buf);
+	}
+    }
+    return out - buf;
+}
+
+/*
+ * lavacam_frame_alloc - allocate frame buffers for a newly opened camera
+ *
+ * given:
+ *      siz         pointer to operation size and buffer structure
+ *      lavaoff     offset in a read image buffer to chaotic data
+ *      stable      TRUE ==> mmapped frames stay put after the next frame
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ *
+ * The use_read, image_len and chaos_len elements of the struct opsize must
+ * be set before calling this function.  When mmapping, the image and chaos
+ * elements must also be set.
+ *
+ * When reading, this function allocates a ring of LAVACAM_RING image
+ * buffers and sets the image and chaos elements to the first one.
+ * When mmapping a region where the next frame is captured over the
+ * current one (stable == FALSE), this function allocates the prev_buf
+ * buffer that lavacam_keep_frame() copies the previous frame into.
+ *
+ * NOTE: A driver that calls this function must call lavacam_frame_free()
+ *	 in place of freeing a read image buffer.
+ */
+int
+lavacam_frame_alloc(struct opsize *siz, int lavaoff, int stable)
+{
+    int i;
+
+    /*
+     * firewall
+     */
+    if (siz == NULL || siz->chaos_len <= 0 ||
+	(siz->use_read && (lavaoff < 0 || siz->image_len <= 0 ||
+			   lavaoff + siz->chaos_len > siz->image_len))) {
+	return LAVACAM_ERR_ARG;
+    }
+    siz->prev_frame = NULL;
+    siz->prev_buf = NULL;
+    for (i = 0; i < LAVACAM_RING; ++i) {
+	siz->ring[i] = NULL;
+    }
+    siz->ring_indx = 0;
+
+    /*
+     * read setup - a ring of image buffers
+     */
+    if (siz->use_read) {
+	for (i = 0; i < LAVACAM_RING; ++i) {
+	    siz->ring[i] = malloc(siz->image_len);
+	    if (siz->ring[i] == NULL) {
+		lavacam_frame_free(siz);
+		return LAVAERR_MALLOC;
+	    }
+	}
+	siz->image = siz->ring[0];
+	siz->chaos = (u_int8_t *)siz->image + lavaoff;
+
+    /*
+     * mmap setup - copy the previous frame unless the frames stay put
+     */
+    } else if (!stable) {
+	siz->prev_buf = malloc(siz->chaos_len);
+	if (siz->prev_buf == NULL) {
+	    return LAVAERR_MALLOC;
+	}
+    }
+    return LAVAERR_OK;
+}
+
+
+/*
+ * lavacam_frame_free - free frame buffers from lavacam_frame_alloc()
+ *
+ * given:
+ *      siz         pointer to operation size and buffer structure
+ *
+ * When reading, the image and chaos elements are cleared as they point
+ * into the freed ring.  A mmapped region is left for the driver to unmap.
+ */
+void
+lavacam_frame_free(struct opsize *siz)
+{
+    int i;
+
+    /*
+     * firewall
+     */
+    if (siz == NULL) {
+	return;
+    }
+
+    /*
+     * free the read image ring
+     */
+    for (i = 0; i < LAVACAM_RING; ++i) {
+	if (siz->ring[i] != NULL) {
+	    free(siz->ring[i]);
+	    siz->ring[i] = NULL;
+	}
+    }
+    if (siz->use_read) {
+	siz->image = NULL;
+	siz->chaos = NULL;
+    }
+    siz->ring_indx = 0;
+
+    /*
+     * free the previous frame copy
+     */
+    if (siz->prev_buf != NULL) {
+	free(siz->prev_buf);
+	siz->prev_buf = NULL;
+    }
+    siz->prev_frame = NULL;
+    return;
+}
+
+
+/*
+ * lavacam_mmap_init - empty the mmap frame capture queue
+ *
+ * given:
+ *      siz         pointer to operation size and buffer structure
+ *
+ * A mmap driver calls this function before it queues its mmap frames
+ * for capture with lavacam_mmap_push().
+ */
+void
+lavacam_mmap_init(struct opsize *siz)
+{
+    /*
+     * firewall
+     */
+    if (siz == NULL) {
+	return;
+    }
+
+    /*
+     * no frames queued, processed or held
+     */
+    siz->mmap_head = 0;
+    siz->mmap_queued = 0;
+    siz->mmap_cur = -1;
+    siz->mmap_held = -1;
+    return;
+}
+
+
+/*
+ * lavacam_mmap_push - note that a mmap frame was queued for capture
+ *
+ * given:
+ *      siz         pointer to operation size and buffer structure
+ *      frame       mmap frame number given to VIDIOCMCAPTURE
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ *
+ * The V4L mmap drivers capture frames in the order that they are queued
+ * with VIDIOCMCAPTURE.  This function and lavacam_mmap_pop() keep that
+ * order so that a driver waits, with VIDIOCSYNC, for the oldest queued
+ * frame while the camera goes on capturing into the others.
+ */
+int
+lavacam_mmap_push(struct opsize *siz, int frame)
+{
+    /*
+     * firewall
+     */
+    if (siz == NULL || frame < 0 || frame >= VIDEO_MAX_FRAME ||
+	siz->mmap_queued >= VIDEO_MAX_FRAME) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * add the frame to the end of the queue
+     */
+    siz->mmap_queue[(siz->mmap_head + siz->mmap_queued) % VIDEO_MAX_FRAME] =
+      frame;
+    ++siz->mmap_queued;
+    return LAVAERR_OK;
+}
+
+
+/*
+ * lavacam_mmap_pop - remove the oldest mmap frame queued for capture
+ *
+ * given:
+ *      siz         pointer to operation size and buffer structure
+ *
+ * returns:
+ *      >= 0 ==> oldest queued mmap frame number, <0 ==> error
+ *
+ * The frame returned becomes the mmap frame being processed.
+ */
+int
+lavacam_mmap_pop(struct opsize *siz)
+{
+    int frame;		/* oldest queued frame */
+
+    /*
+     * firewall
+     */
+    if (siz == NULL || siz->mmap_queued <= 0) {
+	return LAVACAM_ERR_SYNC;
+    }
+
+    /*
+     * remove the frame from the front of the queue
+     */
+    frame = siz->mmap_queue[siz->mmap_head];
+    siz->mmap_head = (siz->mmap_head + 1) % VIDEO_MAX_FRAME;
+    --siz->mmap_queued;
+    siz->mmap_cur = frame;
+    return frame;
+}
+
+
+/*
+ * lavacam_mmap_release - determine which mmap frame to capture into again
+ *
+ * given:
+ *      siz         pointer to operation size and buffer structure
+ *
+ * returns:
+ *      >= 0 ==> mmap frame to queue for capture, <0 ==> none
+ *
+ * This function is called when the mmap frame being processed is done.
+ * Usually that frame is returned so that it may be queued again.
+ *
+ * However if that frame was kept as the previous frame by lavacam_sanity()
+ * without being copied, then it is held out of the capture queue so that
+ * it stays put for the next bit difference check.  The frame that was
+ * held before it is returned instead, if any.
+ */
+int
+lavacam_mmap_release(struct opsize *siz)
+{
+    int frame;		/* frame to capture into again */
+    int held;		/* frame held before this one */
+
+    /*
+     * firewall
+     */
+    if (siz == NULL || siz->mmap_cur < 0) {
+	return -1;
+    }
+    frame = siz->mmap_cur;
+    siz->mmap_cur = -1;
+
+    /*
+     * hold the frame if it is now the previous frame
+     */
+    if (siz->prev_buf == NULL && siz->prev_frame != NULL &&
+	siz->prev_frame == siz->chaos) {
+	held = siz->mmap_held;
+	siz->mmap_held = frame;
+	frame = held;
+    }
+    return frame;
+}
+
+
+/*
+ * lavacam_msync - release/sync after processing a mmap captured buffer
+ *
+ * given:
+ *      type        type of camera
+ *      cam_fd      open camera descriptor
+ *      cam         pointer to camera parameters
+ *      siz         pointer to operation size and buffer structure
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ */
+int
+lavacam_msync(int type, int cam_fd, union lavacam *cam, struct opsize *siz)
+{
+    /*
+     * firewall
+     */
+    if (VALID_TYPE(type) || cam_fd < 0 || cam == NULL || siz == NULL) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * mmap the camera
+     */
+    return cam_switch[type].msync(cam_fd, cam, siz);
+}
+
+
+/*
+ * lavacam_wait_frame - use poll to wait for the next camera frame
+ *
+ * given:
+ *      type        type of camera
+ *      cam_fd      open camera descriptor
+ *      max_wait    wait for up to this many seconds, <0.0 ==> infinite
+ *
+ * returns:
+ *      1 ==> frame is ready, 0 ==> timeout, <0 ==> error
+ *
+ * NOTE: This function polls the descriptor returned by lavacam_frame_fd().
+ */
+int
+lavacam_wait_frame(int type, int cam_fd, double max_wait)
+{
+    /*
+     * firewall
+     */
+    if (VALID_TYPE(type) || cam_fd < 0) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * wait until the next frame
+     */
+    return cam_switch[type].wait_frame(cam_fd, max_wait);
+}
+
+
+/*
+ * lavacam_frame_fd - descriptor that becomes readable when a frame is ready
+ *
+ * given:
+ *      type        type of camera
+ *      cam_fd      open camera descriptor
+ *
+ * returns:
+ *      descriptor to poll or select on for reading, <0 ==> error
+ *
+ * This is the camera descriptor, unless a sync thread is waiting for the
+ * mmap frames of the camera.  Then it is the read end of the pipe that
+ * the sync thread writes to when a frame has been captured.  See
+ * lavacam_sync_start().
+ *
+ * NOTE: An event loop should poll or select on this descriptor instead
+ *	 of calling lavacam_wait_frame().  Do not read from it.
+ */
+int
+lavacam_frame_fd(int type, int cam_fd)
+{
+    /*
+     * firewall
+     */
+    if (VALID_TYPE(type) || cam_fd < 0) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * return the frame ready descriptor
+     */
+    return lavacam_sync_fd(cam_fd);
+}
+
+
+/*
+ * lavacam_poll_frame - use poll to wait for a descriptor to become readable
+ *
+ * given:
+ *      fd          descriptor from lavacam_frame_fd()
+ *      max_wait    wait for up to this many seconds, <0.0 ==> infinite
+ *
+ * returns:
+ *      1 ==> frame is ready, 0 ==> timeout, <0 ==> error
+ *
+ * The xyz_wait_frame() driver functions call this function.  Unlike
+ * select(), poll() has no FD_SETSIZE limit on the descriptor.
+ *
+ * NOTE: A descriptor that polls with an error or hangup, but not as
+ *	 readable, is returned as LAVACAM_ERR_IOERR.  A streaming V4L2
+ *	 camera does this when it has no buffer queued to fill.
+ */
+int
+lavacam_poll_frame(int fd, double max_wait)
+{
+    struct pollfd pfd;		/* descriptor poll state */
+    int timeout = -1;		/* poll timeout in milliseconds, -1 ==> none */
+    int ret;			/* poll return value */
+    double start = 0.0;		/* pre-poll time */
+    double end;			/* post-poll time */
+    double delay;		/* time spent in poll() */
+
+    /*
+     * firewall
+     */
+    if (fd < 0) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * common poll setup
+     */
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (max_wait >= 0.0) {
+	timeout = (max_wait >= 2147483.0) ?
+		  0x7fffffff : (int)(max_wait * 1000.0 + 0.999);
+	start = right_now();
+	if (start < 0.0) {
+	    return LAVAERR_GETTIME;
+	}
+    }
+
+    /*
+     * wait for the next frame or until we wait too long (if max_wait)
+     */
+    do {
+	/* clear system error code */
+	errno = 0;
+
+	/*
+	 * poll
+	 */
+	ret = poll(&pfd, 1, timeout);
+
+	/*
+	 * adjust poll time based on how long we just waited
+	 */
+	if (ret < 0 && errno == EINTR && max_wait >= 0.0) {
+	    end = right_now();
+	    if (end < 0.0) {
+		return LAVAERR_GETTIME;
+	    }
+	    delay = end - start;
+	    if (delay >= max_wait) {
+		ret = 0;
+		break;
+	    }
+	    timeout = (max_wait - delay >= 2147483.0) ?
+		      0x7fffffff : (int)((max_wait - delay) * 1000.0 + 0.999);
+	}
+    } while (ret < 0 && errno == EINTR);
+
+    /*
+     * return poll status
+     */
+    if (ret < 0) {
+	return LAVACAM_ERR_IOERR;
+    }
+    if (ret > 0 && !(pfd.revents & POLLIN)) {
+	return LAVACAM_ERR_IOERR;
+    }
+    return ret;
+}
+
+
+/*
+ * lavacam_sync_find - find the sync thread state of an open camera
+ *
+ * given:
+ *      cam_fd      open camera descriptor
+ *
+ * returns:
+ *      sync thread state or NULL ==> camera has no sync thread
+ *
+ * NOTE: The caller must hold lavacam_sync_lock.
+ */
+static struct lavacam_sync *
+lavacam_sync_find(int cam_fd)
+{
+    int i;
+
+    for (i = 0; i < LAVACAM_SYNC_MAX; ++i) {
+	if (lavacam_sync[i].inuse && lavacam_sync[i].cam_fd == cam_fd) {
+	    return &lavacam_sync[i];
+	}
+    }
+    return NULL;
+}
+
+
+/*
+ * lavacam_sync_thread - wait for mmap frames on behalf of a camera
+ *
+ * given:
+ *      arg         sync thread state of the camera
+ *
+ * returns:
+ *      NULL
+ *
+ * The frames are waited for in the order they were queued.  One octet
+ * is written to the pipe for each frame that the wait is over for, be
+ * it captured or failed.  After a failed wait this thread stops waiting.
+ */
+static void *
+lavacam_sync_thread(void *arg)
+{
+    struct lavacam_sync *s = (struct lavacam_sync *)arg;	/* our state */
+    int frame;			/* frame to wait for */
+    int indx;			/* queue index of frame */
+    int ret;			/* sync return */
+
+    (void) pthread_mutex_lock(&s->lock);
+    while (!s->stop) {
+
+	/*
+	 * wait for a frame that has been queued but not yet waited for
+	 */
+	if (s->synced >= s->queued) {
+	    (void) pthread_cond_wait(&s->cond, &s->lock);
+	    continue;
+	}
+	indx = (s->head + s->synced) % VIDEO_MAX_FRAME;
+	frame = s->queue[indx];
+
+	/*
+	 * wait for the camera to capture the frame
+	 */
+	(void) pthread_mutex_unlock(&s->lock);
+	ret = s->sync(s->cam_fd, frame);
+	(void) pthread_mutex_lock(&s->lock);
+
+	/*
+	 * note the result and announce it
+	 */
+	s->result[indx] = ret;
+	++s->synced;
+	if (write(s->ready_fd[1], "", 1) != 1 || ret < 0) {
+	    s->stop = TRUE;
+	}
+    }
+    (void) pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+
+/*
+ * lavacam_sync_start - start a thread to wait for the mmap frames of a camera
+ *
+ * given:
+ *      cam_fd      open camera descriptor
+ *      siz         pointer to operation size and buffer structure
+ *      sync        function that waits for a mmap frame to be captured
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ *
+ * A V4L mmap driver waits for a frame with VIDIOCSYNC, and a V4L camera
+ * descriptor need not poll as readable when a mmap frame is captured.
+ * So that an event loop can sleep until a frame is ready, and not in
+ * VIDIOCSYNC, the sync thread does the waiting.  When a frame has been
+ * captured, it writes to a pipe whose read end lavacam_frame_fd() then
+ * returns.
+ *
+ * The frames that siz says are queued for capture are waited for first,
+ * then those given to lavacam_sync_queue() as they are queued again.
+ * The driver obtains each frame, in turn, with lavacam_sync_frame().
+ *
+ * NOTE: The sync function is called in the sync thread.  It may be
+ *	 called while the driver queues another frame.
+ *
+ * NOTE: lavacam_sync_stop() must be called before the mmapped frames
+ *	 are unmapped or the camera is closed.
+ */
+int
+lavacam_sync_start(int cam_fd, struct opsize *siz, lavacam_sync_func sync)
+{
+    struct lavacam_sync *s;	/* sync thread state */
+    int i;
+
+    /*
+     * firewall
+     */
+    if (cam_fd < 0 || siz == NULL || sync == NULL || siz->use_read ||
+	siz->mmap_queued <= 0 || siz->mmap_queued > VIDEO_MAX_FRAME) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * find a free sync thread slot
+     */
+    (void) pthread_mutex_lock(&lavacam_sync_lock);
+    if (lavacam_sync_find(cam_fd) != NULL) {
+	(void) pthread_mutex_unlock(&lavacam_sync_lock);
+	return LAVACAM_ERR_ARG;
+    }
+    for (i = 0, s = NULL; i < LAVACAM_SYNC_MAX; ++i) {
+	if (!lavacam_sync[i].inuse) {
+	    s = &lavacam_sync[i];
+	    break;
+	}
+    }
+    if (s == NULL) {
+	(void) pthread_mutex_unlock(&lavacam_sync_lock);
+	return LAVACAM_ERR_OPEN;
+    }
+
+    /*
+     * setup the frame ready pipe
+     */
+    memset(s, 0, sizeof(s[0]));
+    if (pipe(s->ready_fd) < 0) {
+	(void) pthread_mutex_unlock(&lavacam_sync_lock);
+	return LAVACAM_ERR_OPEN;
+    }
+    for (i = 0; i < 2; ++i) {
+	(void) fcntl(s->ready_fd[i], F_SETFD, FD_CLOEXEC);
+	(void) fcntl(s->ready_fd[i], F_SETFL,
+		     fcntl(s->ready_fd[i], F_GETFL) | O_NONBLOCK);
+    }
+
+    /*
+     * copy the capture queue
+     */
+    s->cam_fd = cam_fd;
+    s->sync = sync;
+    for (i = 0; i < siz->mmap_queued; ++i) {
+	s->queue[i] =
+	  siz->mmap_queue[(siz->mmap_head + i) % VIDEO_MAX_FRAME];
+    }
+    s->queued = siz->mmap_queued;
+
+    /*
+     * start the sync thread
+     */
+    (void) pthread_mutex_init(&s->lock, NULL);
+    (void) pthread_cond_init(&s->cond, NULL);
+    if (pthread_create(&s->thread, NULL, lavacam_sync_thread, s) != 0) {
+	(void) pthread_cond_destroy(&s->cond);
+	(void) pthread_mutex_destroy(&s->lock);
+	(void) close(s->ready_fd[0]);
+	(void) close(s->ready_fd[1]);
+	(void) pthread_mutex_unlock(&lavacam_sync_lock);
+	return LAVACAM_ERR_OPEN;
+    }
+    s->inuse = TRUE;
+    (void) pthread_mutex_unlock(&lavacam_sync_lock);
+    return LAVACAM_ERR_OK;
+}
+
+
+/*
+ * lavacam_sync_stop - stop the sync thread of a camera, if any
+ *
+ * given:
+ *      cam_fd      open camera descriptor
+ *
+ * NOTE: This function waits for the sync thread to return from a
+ *	 frame wait that is in progress.
+ */
+void
+lavacam_sync_stop(int cam_fd)
+{
+    struct lavacam_sync *s;	/* sync thread state */
+
+    /*
+     * find the sync thread, if any
+     */
+    (void) pthread_mutex_lock(&lavacam_sync_lock);
+    s = lavacam_sync_find(cam_fd);
+    if (s == NULL) {
+	(void) pthread_mutex_unlock(&lavacam_sync_lock);
+	return;
+    }
+
+    /*
+     * tell the thread to stop and wait for it
+     */
+    (void) pthread_mutex_lock(&s->lock);
+    s->stop = TRUE;
+    (void) pthread_cond_signal(&s->cond);
+    (void) pthread_mutex_unlock(&s->lock);
+    (void) pthread_join(s->thread, NULL);
+
+    /*
+     * release the sync thread state
+     */
+    (void) pthread_cond_destroy(&s->cond);
+    (void) pthread_mutex_destroy(&s->lock);
+    (void) close(s->ready_fd[0]);
+    (void) close(s->ready_fd[1]);
+    s->inuse = FALSE;
+    (void) pthread_mutex_unlock(&lavacam_sync_lock);
+    return;
+}
+
+
+/*
+ * lavacam_sync_fd - descriptor that becomes readable when a frame is ready
+ *
+ * given:
+ *      cam_fd      open camera descriptor
+ *
+ * returns:
+ *      read end of the sync thread pipe, or cam_fd if no sync thread
+ *
+ * The xyz_wait_frame() driver functions poll this descriptor.
+ */
+int
+lavacam_sync_fd(int cam_fd)
+{
+    struct lavacam_sync *s;	/* sync thread state */
+    int fd;			/* descriptor to poll */
+
+    (void) pthread_mutex_lock(&lavacam_sync_lock);
+    s = lavacam_sync_find(cam_fd);
+    fd = (s == NULL) ? cam_fd : s->ready_fd[0];
+    (void) pthread_mutex_unlock(&lavacam_sync_lock);
+    return fd;
+}
+
+
+/*
+ * lavacam_sync_queue - note that a mmap frame was queued for capture again
+ *
+ * given:
+ *      cam_fd      open camera descriptor
+ *      frame       mmap frame number given to VIDIOCMCAPTURE
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ *
+ * This function does nothing if the camera has no sync thread.
+ */
+int
+lavacam_sync_queue(int cam_fd, int frame)
+{
+    struct lavacam_sync *s;	/* sync thread state */
+    int ret = LAVACAM_ERR_OK;	/* return value */
+
+    /*
+     * firewall
+     */
+    if (frame < 0 || frame >= VIDEO_MAX_FRAME) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * add the frame to the end of the sync thread queue
+     */
+    (void) pthread_mutex_lock(&lavacam_sync_lock);
+    s = lavacam_sync_find(cam_fd);
+    if (s != NULL) {
+	(void) pthread_mutex_lock(&s->lock);
+	if (s->queued >= VIDEO_MAX_FRAME) {
+	    ret = LAVACAM_ERR_SYNC;
+	} else {
+	    s->queue[(s->head + s->queued) % VIDEO_MAX_FRAME] = frame;
+	    ++s->queued;
+	    (void) pthread_cond_signal(&s->cond);
+	}
+	(void) pthread_mutex_unlock(&s->lock);
+    }
+    (void) pthread_mutex_unlock(&lavacam_sync_lock);
+    return ret;
+}
+
+
+/*
+ * lavacam_sync_frame - wait for a mmap frame to be captured
+ *
+ * given:
+ *      cam_fd      open camera descriptor
+ *      frame       oldest mmap frame queued for capture
+ *      sync        function that waits for a mmap frame to be captured
+ *
+ * returns:
+ *      >= 0 ==> frame was captured, <0 ==> error
+ *
+ * If the camera has a sync thread, this function takes the result of
+ * the thread's wait for the frame, waiting for the thread if needed.
+ * Otherwise it calls sync itself.
+ */
+int
+lavacam_sync_frame(int cam_fd, int frame, lavacam_sync_func sync)
+{
+    struct lavacam_sync *s;	/* sync thread state */
+    char octet;			/* frame ready octet */
+    int ret;			/* return value */
+
+    /*
+     * firewall
+     */
+    if (cam_fd < 0 || sync == NULL) {
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * wait in this thread if there is no sync thread
+     */
+    (void) pthread_mutex_lock(&lavacam_sync_lock);
+    s = lavacam_sync_find(cam_fd);
+    (void) pthread_mutex_unlock(&lavacam_sync_lock);
+    if (s == NULL) {
+	return sync(cam_fd, frame);
+    }
+
+    /*
+     * take the frame ready octet, waiting for it if needed
+     */
+    do {
+	ret = read(s->ready_fd[0], &octet, 1);
+	if (ret < 0 && errno == EAGAIN) {
+	    ret = lavacam_poll_frame(s->ready_fd[0], -1.0);
+	    if (ret < 0) {
+		return LAVACAM_ERR_SYNC;
+	    }
+	    ret = -1;
+	    errno = EINTR;
+	}
+    } while (ret < 0 && errno == EINTR);
+    if (ret != 1) {
+	return LAVACAM_ERR_SYNC;
+    }
+
+    /*
+     * take the result of the oldest frame
+     */
+    (void) pthread_mutex_lock(&s->lock);
+    if (s->synced <= 0 || s->queue[s->head] != frame) {
+	ret = LAVACAM_ERR_SYNC;
+    } else {
+	ret = s->result[s->head];
+	s->head = (s->head + 1) % VIDEO_MAX_FRAME;
+	--s->queued;
+	--s->synced;
+    }
+    (void) pthread_mutex_unlock(&s->lock);
+    return ret;
+}
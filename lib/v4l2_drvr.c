@@ -0,0 +1,2100 @@
+/*
+ * v4l2_drvr - Video4Linux2 streaming camera driver
+ *
+ * @(#) $Revision$
+ * @(#) $Id$
+ *
+ * Copyright (c) 2000-2003 by Landon Curt Noll and Simon Cooper.
+ * All Rights Reserved.
+ *
+ * This is open software; you can redistribute it and/or modify it under
+ * the terms of the version 2.1 of the GNU Lesser General Public License
+ * as published by the Free Software Foundation.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General
+ * Public License for more details.
+ *
+ * The file COPYING contains important info about Licenses and Copyrights.
+ * Please read the COPYING file for details about this open software.
+ *
+ * A copy of version 2.1 of the GNU Lesser General Public License is
+ * distributed with calc under the filename COPYING-LGPL.  You should have
+ * received a copy with calc; if not, write to Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * For more information on LavaRnd: http://www.LavaRnd.org
+ *
+ * Share and enjoy! :-)
+ */
+
+
+
+/*
+ * NOTE: This is the raw interface to the Video4Linux2 camera driver.  You
+ *       should be calling the lavacam_*() routines in camop.c instead of
+ *       directly calling these functions.  For example, call lavacam_open()
+ *       instead of v4l2_open.  See the comment at the top of src/lib/camop.c
+ *       for sample code.  See also some of the tools under src/tool as well.
+ *
+ * The v4l2 driver works with Video4Linux2 capture devices that deliver
+ * uncompressed frames, such as USB Video Class (UVC) webcams under the
+ * uvcvideo module.  Compressed formats such as MJPEG cannot be used as
+ * the chaotic noise of the sensor does not survive the compression.
+ *
+ * Frames are captured with V4L2 mmap streaming.  v4l2_open() asks for
+ * the -B number of buffers with VIDIOC_REQBUFS, mmaps each of them,
+ * queues them all with VIDIOC_QBUF and starts streaming.  v4l2_get_frame()
+ * takes the oldest filled buffer with VIDIOC_DQBUF and points siz->chaos
+ * into it, so the frame is processed where the camera put it without
+ * being copied.  v4l2_msync() queues the buffer again.  The camera goes
+ * on filling the other queued buffers in the meantime.
+ *
+ * With -M, frames are read(2) instead, if the device allows it.
+ *
+ * The camera is opened non-blocking.  v4l2_wait_frame() uses poll(2) to
+ * wait for a filled buffer, and callers may select or poll on the open
+ * camera descriptor themselves.
+ *
+ * Every ioctl of this driver goes through the function installed by
+ * v4l2_ioctl_hook(), which is ioctl(2) unless a test stand-in was
+ * installed.  Buffers are mmapped from the open camera descriptor at
+ * the offset that VIDIOC_QUERYBUF reports, so a stand-in may open a
+ * plain file as the camera and write its synthetic frames there.
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <sys/types.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "LavaRnd/have/have_v4l2.h"
+#if defined(HAVE_V4L2)
+#  include <linux/videodev2.h>
+#endif /* HAVE_V4L2 */
+
+#include "LavaRnd/rawio.h"
+#include "LavaRnd/lavacam.h"
+#include "LavaRnd/lavaerr.h"
+
+
+/*
+ * Special v4l2 driver debugging - not related to LavaRnd debugging
+ */
+#if defined(LAVA_V4L2_DEBUG)
+#  define DBG(c) fprintf(stderr, \
+			  "Error: %s:%d: %d\n", __FILE__, __LINE__, (c))
+#else
+#  define DBG(c)
+#endif
+
+
+/*
+ * LavaRnd optimal values
+ *
+ * A V4L2 camera is used at the size and frame rate it is already set
+ * to, unless -W, -H or -f say otherwise.  YUYV is the uncompressed
+ * format that every UVC webcam offers.
+ */
+static struct v4l2_state v4l2_def = {
+    /* these values are read/write */
+    0,				/* image width in pixels, driver default */
+    0,				/* image height in pixels, driver default */
+    V4L2_FOURCC('Y','U','Y','V'),	/* YUYV pixel format */
+    0,				/* frames per second, driver default */
+    V4L2_DEF_BUFFERS,		/* number of mmap streaming buffers */
+    /* these values are read only */
+    0,				/* Video4Linux palette of pixelformat */
+    0,				/* octets per line of the image */
+    0,				/* octets per frame */
+    0,				/* V4L2 device capabilities */
+    "",				/* name of the kernel driver */
+    "",				/* name of the camera */
+    /* special driver/utilities elements */
+    V4L2_STATE_MASK,		/* bit mask of state values to set/change */
+    /* tmp sanity check into - initialized by default, set by v4l2_argv() */
+    0,
+    0.0,
+    0,
+    0.0
+};
+
+
+/*
+ * LavaRnd values for given models
+ */
+struct lava_state {
+    int model;			/* camera model - see struct camop in camop.c */
+    struct v4l2_state *state;	/* optimal LavaRnd values */
+    double warmup;		/* default seconds to delay during open */
+    int def_top_x;		/* default ignore top_x octets as common */
+    double def_min_fract;	/* default uncommon octet value fraction */
+    int def_half_x;		/* default 1/2 level value */
+    double def_diff_fract;	/* default different/same fraction */
+};
+
+/*
+ * v4l2 camera settings
+ *
+ * The sanity check levels of a given V4L2 camera are not known ahead of
+ * time.  By default only frames that are nearly the same as the previous
+ * frame, as from a stuck camera, are rejected.  Use camsanity to find the
+ * levels of your camera and give them with -X, -x, -2 and -d.
+ *
+ * The warm-up gives the camera's automatic exposure time to settle.
+ */
+static struct lava_state lava_state[] = {
+    {0, &v4l2_def, 2.0, 0, 0.0, 0, 0.01},	/* Video4Linux2 camera */
+
+    {-1, NULL, 0.0, 0, 0, 0.0, 0.0}		/* must be last */
+};
+
+#define STATE_COUNT ((int)sizeof(lava_state) / (int)sizeof(lava_state[0]))
+
+
+/*
+ * v4l2_pixfmt - uncompressed V4L2 pixel formats that may be used
+ *
+ * Each pixel format is mapped to the Video4Linux palette with the same
+ * layout so that chaos_zone() can find the chaotic data in a frame.
+ */
+static struct v4l2_pixfmt {
+    unsigned long pixelformat;	/* V4L2 fourcc pixel format */
+    int palette;		/* Video4Linux palette with the same layout */
+} v4l2_pixfmt[] = {
+    {V4L2_FOURCC('Y','U','Y','V'), VIDEO_PALETTE_YUYV},
+    {V4L2_FOURCC('U','Y','V','Y'), VIDEO_PALETTE_UYVY},
+    {V4L2_FOURCC('G','R','E','Y'), VIDEO_PALETTE_GREY},
+    {V4L2_FOURCC('R','G','B','P'), VIDEO_PALETTE_RGB565},
+    {V4L2_FOURCC('R','G','B','O'), VIDEO_PALETTE_RGB555},
+    {V4L2_FOURCC('R','G','B','3'), VIDEO_PALETTE_RGB24},
+    {V4L2_FOURCC('B','G','R','3'), VIDEO_PALETTE_RGB24},
+    {V4L2_FOURCC('R','G','B','4'), VIDEO_PALETTE_RGB32},
+    {V4L2_FOURCC('B','G','R','4'), VIDEO_PALETTE_RGB32},
+    {V4L2_FOURCC('4','2','2','P'), VIDEO_PALETTE_YUV422P},
+    {V4L2_FOURCC('Y','U','1','2'), VIDEO_PALETTE_YUV420P},
+    {V4L2_FOURCC('Y','V','1','2'), VIDEO_PALETTE_YUV420P},
+    {V4L2_FOURCC('Y','U','V','9'), VIDEO_PALETTE_YUV410P},
+
+    {0, 0}		/* must be last */
+};
+
+
+/*
+ * v4l2cam - an open V4L2 camera
+ *
+ * The struct opsize is copied about by callers, so the streaming
+ * buffers of an open camera are kept here and found by its descriptor.
+ */
+struct v4l2cam {
+    int inuse;			/* TRUE ==> this camera is open */
+    int cam_fd;			/* open camera descriptor */
+    int streaming;		/* TRUE ==> VIDIOC_STREAMON was done */
+    int buffers;		/* number of mmapped streaming buffers */
+    void *start[V4L2_MAX_BUFFERS];	/* mmapped streaming buffers */
+    size_t length[V4L2_MAX_BUFFERS];	/* length of each streaming buffer */
+};
+#if defined(HAVE_V4L2)
+static struct v4l2cam v4l2cam[V4L2_MAX_OPEN];
+#endif /* HAVE_V4L2 */
+
+
+/*
+ * static functions
+ */
+static int v4l2_model(int model);
+static int v4l2_palette(unsigned long pixelformat);
+static char *v4l2_fourcc_str(unsigned long pixelformat, char *buf);
+static int v4l2_sys_ioctl(int fd, unsigned long request, void *arg);
+#if defined(HAVE_V4L2)
+static struct v4l2cam *v4l2_find(int cam_fd);
+static int xioctl(int fd, unsigned long request, void *arg);
+static int v4l2_stream_on(struct v4l2cam *r, int buffers);
+static void v4l2_stream_off(struct v4l2cam *r);
+static void v4l2_abort(struct v4l2cam *r, struct opsize *siz);
+#endif /* HAVE_V4L2 */
+
+
+/*
+ * v4l2_ioctl - where the ioctls of this driver go, see v4l2_ioctl_hook()
+ */
+static v4l2_ioctl_func v4l2_ioctl = v4l2_sys_ioctl;
+
+
+/*
+ * v4l2_model - determine which LavaRnd value model applies
+ *
+ * given:
+ *      model       camera model number
+ *
+ * returns:
+ *      index into lava_state[] to use, or
+ *            <0 (LAVACAM_ERR_IDENT) ==> error
+ */
+static int
+v4l2_model(int model)
+{
+    int i;
+
+    /*
+     * look for default state
+     */
+    for (i = 0; i < STATE_COUNT; ++i) {
+	if (model == lava_state[i].model) {
+	    break;
+	}
+    }
+    if (i >= STATE_COUNT || lava_state[i].model < 0) {
+	return LAVACAM_ERR_IDENT;
+    }
+    return i;
+}
+
+
+/*
+ * v4l2_palette - determine the Video4Linux palette of a V4L2 pixel format
+ *
+ * given:
+ *      pixelformat V4L2 fourcc pixel format
+ *
+ * returns:
+ *      >0 ==> Video4Linux palette, <0 (LAVACAM_ERR_PALETTE) ==> unusable
+ */
+static int
+v4l2_palette(unsigned long pixelformat)
+{
+    struct v4l2_pixfmt *p;
+
+    for (p = v4l2_pixfmt; p->pixelformat != 0; ++p) {
+	if (p->pixelformat == pixelformat) {
+	    return p->palette;
+	}
+    }
+    return LAVACAM_ERR_PALETTE;
+}
+
+
+/*
+ * v4l2_fourcc_str - form the printable name of a V4L2 pixel format
+ *
+ * given:
+ *      pixelformat V4L2 fourcc pixel format
+ *      buf         where to form the name, at least 5 octets long
+ *
+ * returns:
+ *      buf
+ */
+static char *
+v4l2_fourcc_str(unsigned long pixelformat, char *buf)
+{
+    int i;
+
+    for (i = 0; i < 4; ++i) {
+	buf[i] = (char)((pixelformat >> (8 * i)) & 0xff);
+	if (buf[i] < ' ' || buf[i] > '~') {
+	    buf[i] = '?';
+	}
+    }
+    buf[4] = '\0';
+    return buf;
+}
+
+
+/*
+ * v4l2_sys_ioctl - call ioctl(2), the default v4l2_ioctl function
+ */
+static int
+v4l2_sys_ioctl(int fd, unsigned long request, void *arg)
+{
+    return ioctl(fd, request, arg);
+}
+
+
+/*
+ * v4l2_LavaRnd - preset change state with LavaRnd optimal values
+ *
+ * given:
+ *      u_cam_p     pointer to camera state
+ *      model       camera model number
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ *
+ * NOTE: This function will set the tmp sanity check faules to their
+ *       defaults according to the lava_state[] default values.
+ */
+int
+v4l2_LavaRnd(union lavacam *u_cam_p, int model)
+{
+    int model_indx;
+
+    /*
+     * firewall
+     */
+    if (u_cam_p == NULL) {
+	DBG(LAVACAM_ERR_ARG);
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * look for default state index
+     */
+    model_indx = v4l2_model(model);
+    if (model_indx < 0) {
+	return model_indx;
+    }
+
+    /*
+     * load the LavaRnd optimal values
+     */
+    memcpy(&(u_cam_p->v4l2), lava_state[model_indx].state,
+	   sizeof(u_cam_p->v4l2));
+
+    /*
+     * set the default tmp sanity check values
+     */
+    u_cam_p->v4l2.tmp_top_x = lava_state[model_indx].def_top_x;
+    u_cam_p->v4l2.tmp_min_fract = lava_state[model_indx].def_min_fract;
+    u_cam_p->v4l2.tmp_half_x = lava_state[model_indx].def_half_x;
+    u_cam_p->v4l2.tmp_diff_fract = lava_state[model_indx].def_diff_fract;
+    return LAVACAM_ERR_OK;
+}
+
+
+/*
+ * v4l2_check - determine if the camera state change is valid
+ *
+ * given:
+ *      u_cam_p     pointer to camera values to check if mask is non-zero
+ *
+ * returns:
+ *      0 ==> masked values of union are OK, <0 ==> error in masked values
+ */
+int
+v4l2_check(union lavacam *u_cam_p)
+{
+    struct v4l2_state *cam;	/* u_cam_p as v4l2 union element */
+
+    /*
+     * firewall
+     */
+    if (u_cam_p == NULL) {
+	DBG(LAVACAM_ERR_ARG);
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * pick out the driver specific union element
+     */
+    cam = &(u_cam_p->v4l2);
+
+    /*
+     * quick exit if mask is empty
+     */
+    if (cam->mask == 0) {
+	return LAVACAM_ERR_OK;
+    }
+
+    /*
+     * check values if the mask allows
+     */
+    if (V4L2_TEST(cam->mask, width)) {
+	if (cam->width < 0 || cam->width > V4L2_MAX_SIZE) {
+	    DBG(LAVACAM_ERR_RANGE);
+	    return LAVACAM_ERR_RANGE;
+	}
+    }
+    if (V4L2_TEST(cam->mask, height)) {
+	if (cam->height < 0 || cam->height > V4L2_MAX_SIZE) {
+	    DBG(LAVACAM_ERR_RANGE);
+	    return LAVACAM_ERR_RANGE;
+	}
+    }
+    if (V4L2_TEST(cam->mask, pixelformat)) {
+	if (cam->pixelformat != 0 && v4l2_palette(cam->pixelformat) < 0) {
+	    DBG(LAVACAM_ERR_PALETTE);
+	    return LAVACAM_ERR_PALETTE;
+	}
+    }
+    if (V4L2_TEST(cam->mask, fps)) {
+	if (cam->fps < 0 || cam->fps > V4L2_MAX_FPS) {
+	    DBG(LAVACAM_ERR_RANGE);
+	    return LAVACAM_ERR_RANGE;
+	}
+    }
+    if (V4L2_TEST(cam->mask, buffers)) {
+	if (cam->buffers < V4L2_MIN_BUFFERS ||
+	    cam->buffers > V4L2_MAX_BUFFERS) {
+	    DBG(LAVACAM_ERR_RANGE);
+	    return LAVACAM_ERR_RANGE;
+	}
+    }
+
+    /*
+     * all is OK
+     */
+    return LAVACAM_ERR_OK;
+}
+
+
+/*
+ * v4l2_print - print state of an open camera
+ *
+ * given:
+ *      stream      where to print camera info
+ *      cam_fd      open camera file descriptor
+ *      u_cam_p     pointer to camera state
+ *      siz         pointer to operation size and buffer structure
+ *
+ * returns:
+ *      0 ==> unable to obtain camera information
+ *      1 ==> camera information obtained and printed
+ */
+int
+v4l2_print(FILE * stream, int cam_fd, union lavacam *u_cam_p,
+	   struct opsize *siz)
+{
+    struct v4l2_state *cam;	/* u_cam_p as v4l2 union element */
+    char fourcc[4+1];		/* printable pixel format */
+    int ret;			/* v4l2_get() return */
+
+    /*
+     * firewall
+     */
+    if (stream == NULL || cam_fd < 0 || u_cam_p == NULL || siz == NULL) {
+	DBG(LAVACAM_ERR_ARG);
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * obtain camera state
+     */
+    ret = v4l2_get(cam_fd, u_cam_p);
+    if (ret < 0) {
+	fprintf(stream, "v4l2_print: unable to get camera state: %d\n", ret);
+	return 0;
+    }
+    cam = &(u_cam_p->v4l2);
+
+    /*
+     * print camera identity
+     */
+    fprintf(stream, "\tCamera: %s\n", cam->card);
+    fprintf(stream, "\tDriver: %s\n", cam->driver);
+    fprintf(stream, "\tCapabilities: 0x%08lx\n", cam->caps);
+
+    /*
+     * print capture format
+     */
+    fprintf(stream, "\tPixel format: %s\n",
+    		    v4l2_fourcc_str(cam->pixelformat, fourcc));
+    fprintf(stream, "\t%s (%d)\n",
+    		    palette_name(PALLETTE_VIDEO4LINUX, cam->palette),
+		    cam->palette);
+    fprintf(stream, "\tWidth: %d\n", cam->width);
+    fprintf(stream, "\tHeight: %d\n", cam->height);
+    fprintf(stream, "\tOctets per line: %d\n", cam->bytesperline);
+    fprintf(stream, "\tOctets per frame: %d\n", cam->sizeimage);
+    if (cam->fps > 0) {
+	fprintf(stream, "\tFrames per second: %d\n", cam->fps);
+    } else {
+	fprintf(stream, "\tFrames per second: unknown\n");
+    }
+    fprintf(stream, "\tStreaming buffers: %d\n", cam->buffers);
+
+    /*
+     * output working sanity check parameters
+     */
+    fprintf(stream, "\ncamera sanity check parameters:\n");
+    fprintf(stream, "\t%d most frequent octet values are considered common\n",
+    		    siz->top_x);
+    fprintf(stream, "\tmax fraction of frame containing common octet "
+    		    "values: %.6f\n",
+    		    1.0 - siz->min_fract);
+    fprintf(stream, "\t%d most common values must be < 1/2 of frame octets\n",
+    		    siz->half_x);
+    fprintf(stream, "\tmin fraction of bits same in next frame: %.6f\n",
+    		    siz->diff_fract);
+    fprintf(stream, "\tmax fraction of bits same in next frame: %.6f\n",
+    		    1.0 - siz->diff_fract);
+
+    /*
+     * output use fields
+     */
+    fprintf(stream, "\ncamera use since this process opened the camera:\n");
+    /* ctime returns a newline, so the next printf should not end in one */
+    fprintf(stream, "\tcamera open time: %s", ctime(&siz->open_time));
+    fprintf(stream, "\tframe count: %lld\n", (long long)siz->frame_num);
+    fprintf(stream, "\tinsane frame count: %lld\n",
+    		    (long long)siz->insane_cnt);
+
+    /*
+     * output opsizes
+     */
+    fprintf(stream, "\ncamera op sizes:\n");
+    if (siz->use_read) {
+	fprintf(stream, "\twill use read I/O\n");
+	fprintf(stream, "\tread image: %d\n", siz->image_len);
+    } else {
+	fprintf(stream, "\twill use mmap streaming I/O\n");
+	fprintf(stream, "\tmmap buffer: %d\n", siz->image_len);
+	fprintf(stream, "\tmmap buffers: %d\n", siz->frames);
+    }
+    fprintf(stream, "\tchaos size: %d\n", siz->chaos_len);
+
+    /*
+     * all done
+     */
+    return 1;
+}
+
+
+/*
+ * v4l2_usage - print an argc/argv usage message
+ *
+ * given:
+ *      prog            program name
+ *      typename        name of camera type
+ */
+void
+v4l2_usage(char *prog, char *typename)
+{
+    /*
+     * firewall
+     */
+    if (prog == NULL) {
+	prog = "<<__NULL__>>";
+    }
+    if (typename == NULL) {
+	typename = "<<__NULL__>>";
+    }
+
+    /*
+     * print usage message to stderr
+     */
+    fprintf(stderr,
+	    "usage: %s %s devname [-flags ... args ...]\n"
+	    "\n"
+	    "\t-W width\twidth in pixels, 0 ==> as set [0..%d]\n"
+	    "\t-H height\theight in pixels, 0 ==> as set [0..%d]\n"
+	    "\t-P fourcc\tpixel format (def: YUYV), one of:\n"
+	    "\t\t\t    YUYV UYVY GREY RGBP RGBO RGB3 BGR3\n"
+	    "\t\t\t    RGB4 BGR4 422P YU12 YV12 YUV9\n"
+	    "\t-f fps\t\tframes per second, 0 ==> as set [0..%d]\n"
+	    "\t-B buffers\tmmap streaming buffers [%d..%d] (def: %d)\n"
+	    "\t-v level\tverbose mode, print settings before/after\n"
+	    "\t-T tsec\t\twarm-up/sleep for tsec seconds\n"
+	    "\t-D tsec\t\tframe delay tsec seconds between frames\n"
+	    "\t-M\t\tdisable mmap streaming, use reads instead\n"
+	    "\t-L\t\tset LavaRnd entropy optimal mode\n"
+	    "\t-A\t\tprocess all of the image, not just the high entropy part\n"
+	    "\t-E\t\tavoid frame dumping when savefile exists\n"
+	    "\t-X top_x\ttop_x common octets are common octets [0, %d]\n"
+	    "\t-x min_fract\tmin fraction uncommon octets in frame [0.0, 1.0]\n"
+	    "\t-2 half_x\thalf_x common octets occupy <50%% octets [0, %d]\n"
+	    "\t-d min_fract\tmin fraction of diff bits between frames [0.0, 0.5]\n",
+	    prog, typename,
+	    V4L2_MAX_SIZE, V4L2_MAX_SIZE,
+	    V4L2_MAX_FPS,
+	    V4L2_MIN_BUFFERS, V4L2_MAX_BUFFERS, V4L2_DEF_BUFFERS,
+	    OCTET_CNT, OCTET_CNT/2);
+    return;
+}
+
+
+/*
+ * v4l2_argv - argc/argv parse, sets a camera's state change and global flags
+ *
+ * given:
+ *      argc        command line argc count
+ *      argv        point to array of command line argument strings
+ *      u_cam_p     pointer to values to be set if mask is non-zero
+ *      flag        flags to set
+ *      model       camera model number
+ *
+ * returns:
+ *      amount of args to skip, <0 ==> error
+ *
+ * NOTE: This function will initialize the tmp sanity check values to
+ *       their defaults according to the lava_state[] default values.
+ *       If -x, -X, -2, -d was given, the tmp sanity check values will be
+ *       modified according to the flag.  Sometime later during the
+ *       v4l2_open(), these tmp sanity check values will be loaded
+ *       into the working sanity check values in the struct opsize.
+ */
+int
+v4l2_argv(int argc, char **argv, union lavacam *u_cam_p,
+	  struct lavacam_flag *flag, int model)
+{
+    int tmp;			/* temporary holder of a parsed argument */
+    double dtmp;		/* temporary holder of double/float arg */
+    unsigned long fourcc;	/* parsed pixel format */
+    struct v4l2_state *cam;	/* u_cam_p as v4l2 union element */
+    char *optarg;		/* option argument */
+    int c;			/* option */
+    int model_indx;		/* default state model index */
+    int i;
+
+    /*
+     * firewall
+     */
+    if (argc <= 0 || argv == NULL || argv[0] == NULL || u_cam_p == NULL ||
+	flag == NULL) {
+	DBG(LAVACAM_ERR_ARG);
+	return LAVACAM_ERR_ARG;
+    }
+    flag->program = argv[0];
+
+    /*
+     * pick out the driver specific union element
+     */
+    cam = &(u_cam_p->v4l2);
+
+    /*
+     * look for default state index
+     */
+    model_indx = v4l2_model(model);
+    if (model_indx < 0) {
+	return model_indx;
+    }
+
+    /*
+     * initialize
+     */
+    memcpy(cam, lava_state[model_indx].state, sizeof(cam[0]));
+    flag->D_flag = 0.0;
+    flag->T_flag = -1.0;
+    flag->A_flag = 0;
+    flag->M_flag = 1;
+    flag->v_flag = 0;
+    flag->E_flag = 0;
+    flag->savefile = NULL;
+    flag->newfile = NULL;
+    flag->interval = 0.0;
+    /* set the default tmp sanity check values */
+    cam->tmp_top_x = lava_state[model_indx].def_top_x;
+    cam->tmp_min_fract = lava_state[model_indx].def_min_fract;
+    cam->tmp_half_x = lava_state[model_indx].def_half_x;
+    cam->tmp_diff_fract = lava_state[model_indx].def_diff_fract;
+
+    /*
+     * parse args
+     *
+     * See ov511_argv() for why we do not use getopt().
+     */
+    for (i = 1; i < argc; ++i) {
+
+	/*
+	 * must be a -<char>
+	 */
+	if (argv[i] == NULL) {
+	    fprintf(stderr, "%s: v4l2_argv[%d] is NULL\n", argv[0], i);
+	    DBG(LAVACAM_ERR_ARG);
+	    return LAVACAM_ERR_ARG;
+	}
+	if (argv[i][0] != '-') {
+	    /* end of -options, stop parsing args */
+	    break;
+	}
+
+	/*
+	 * options that take an argument
+	 */
+	c = (int)argv[i][1];
+	optarg = NULL;
+	if (c != '\0' && strchr("WHPfBvTDXx2d", c) != NULL) {
+	    if (i < argc - 1) {
+		optarg = argv[++i];
+	    } else {
+		fprintf(stderr,
+			"%s: v4l2_argv[%d] -%c missing next argument\n",
+			argv[0], i, c);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	}
+
+	/*
+	 * process the -option
+	 */
+	switch (c) {
+	case 'W':
+	    tmp = (int)strtol(optarg, NULL, 0);
+	    if (tmp < 0 || tmp > V4L2_MAX_SIZE) {
+		fprintf(stderr, "%s: width must be >= 0 and <= %d\n",
+			flag->program, V4L2_MAX_SIZE);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    cam->width = tmp;
+	    V4L2_SET(cam->mask, width);
+	    break;
+	case 'H':
+	    tmp = (int)strtol(optarg, NULL, 0);
+	    if (tmp < 0 || tmp > V4L2_MAX_SIZE) {
+		fprintf(stderr, "%s: height must be >= 0 and <= %d\n",
+			flag->program, V4L2_MAX_SIZE);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    cam->height = tmp;
+	    V4L2_SET(cam->mask, height);
+	    break;
+	case 'P':
+	    if (strlen(optarg) != 4) {
+		fprintf(stderr, "%s: pixel format must be 4 characters\n",
+			flag->program);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    fourcc = V4L2_FOURCC(optarg[0], optarg[1], optarg[2], optarg[3]);
+	    if (v4l2_palette(fourcc) < 0) {
+		fprintf(stderr, "%s: pixel format %s is not supported\n",
+			flag->program, optarg);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    cam->pixelformat = fourcc;
+	    V4L2_SET(cam->mask, pixelformat);
+	    break;
+	case 'f':
+	    tmp = (int)strtol(optarg, NULL, 0);
+	    if (tmp < 0 || tmp > V4L2_MAX_FPS) {
+		fprintf(stderr, "%s: fps must be >= 0 and <= %d\n",
+			flag->program, V4L2_MAX_FPS);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    cam->fps = tmp;
+	    V4L2_SET(cam->mask, fps);
+	    break;
+	case 'B':
+	    tmp = (int)strtol(optarg, NULL, 0);
+	    if (tmp < V4L2_MIN_BUFFERS || tmp > V4L2_MAX_BUFFERS) {
+		fprintf(stderr, "%s: buffers must be >= %d and <= %d\n",
+			flag->program, V4L2_MIN_BUFFERS, V4L2_MAX_BUFFERS);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    cam->buffers = tmp;
+	    V4L2_SET(cam->mask, buffers);
+	    break;
+	case 'v':
+	    tmp = (int)strtol(optarg, NULL, 0);
+	    if (tmp < 0) {
+		fprintf(stderr, "%s: verbose level must be >= 0\n",
+			flag->program);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    flag->v_flag = tmp;
+	    break;
+	case 'E':
+	    flag->E_flag = 1;
+	    break;
+	case 'T':
+	    dtmp = (double)atof(optarg);
+	    if (dtmp < 0.0) {
+		fprintf(stderr, "%s: warm-up time must be >= 0.0\n",
+			flag->program);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    flag->T_flag = dtmp;
+	    break;
+	case 'D':
+	    dtmp = (double)atof(optarg);
+	    if (dtmp < 0.0) {
+		fprintf(stderr, "%s: delay time must be >= 0.0\n",
+			flag->program);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    flag->D_flag = dtmp;
+	    break;
+	case 'M':
+	    flag->M_flag = 0;
+	    break;
+	case 'L':
+	    tmp = v4l2_LavaRnd(u_cam_p, model);
+	    if (tmp < 0) {
+		fprintf(stderr, "%s: LavaRnd mode set failed\n",
+			flag->program);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    break;
+	case 'A':
+	    flag->A_flag = 1;
+	    break;
+	case 'X':
+	    tmp = (int)strtol(optarg, NULL, 0);
+	    if (tmp < 0 || tmp > OCTET_CNT) {
+		fprintf(stderr, "%s: top_x must be >= 0 and <= %d\n",
+			flag->program, OCTET_CNT);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    cam->tmp_top_x = tmp;
+	    break;
+	case 'x':
+	    dtmp = (double)atof(optarg);
+	    if (dtmp < 0.0 || dtmp > 1.0) {
+		fprintf(stderr, "%s: min_fract must be >= 0.0 and <= 1.0\n",
+			flag->program);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    cam->tmp_min_fract = dtmp;
+	    break;
+	case '2':
+	    tmp = (int)strtol(optarg, NULL, 0);
+	    if (tmp < 0 || tmp > OCTET_CNT / 2) {
+		fprintf(stderr, "%s: half_x must be >= 0 and <= %d\n",
+			flag->program, OCTET_CNT / 2);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    cam->tmp_half_x = tmp;
+	    break;
+	case 'd':
+	    dtmp = (double)atof(optarg);
+	    if (dtmp < 0.0 || dtmp > 0.5) {
+		fprintf(stderr, "%s: diff_fract must be >= 0.0 and <= 0.5\n",
+			flag->program);
+		DBG(LAVACAM_ERR_ARG);
+		return LAVACAM_ERR_ARG;
+	    }
+	    cam->tmp_diff_fract = dtmp;
+	    break;
+	default:
+	    fprintf(stderr,
+		    "%s: v4l2_argv[%d] -%c is unknown\n", argv[0], i, c);
+	    DBG(LAVACAM_ERR_ARG);
+	    return LAVACAM_ERR_ARG;
+	}
+    }
+
+    /*
+     * parse an optimal savefile/interval argument pair
+     */
+    if (argv[i] != NULL && argv[i + 1] != NULL) {
+
+	/* save the savefile argument */
+	flag->savefile = strdup(argv[i]);
+	if (flag->savefile == NULL) {
+	    DBG(LAVAERR_MALLOC);
+	    return LAVAERR_MALLOC;
+	}
+
+	/* form the savefile.new name */
+	flag->newfile =
+	  (char *)malloc(strlen(flag->savefile) + sizeof(".new"));
+	if (flag->newfile == NULL) {
+	    free(flag->savefile);
+	    flag->savefile = NULL;
+	    DBG(LAVAERR_MALLOC);
+	    return LAVAERR_MALLOC;
+	}
+	snprintf(flag->newfile, strlen(flag->savefile) + sizeof(".new"),
+		 "%s.new", flag->savefile);
+
+	/* note interval */
+	flag->interval = (double)atof(argv[i + 1]);
+	if (flag->interval <= 0.0) {
+	    fprintf(stderr, "%s: interval: %.3f must be >0.0\n",
+		    flag->program, flag->interval);
+	    free(flag->savefile);
+	    flag->savefile = NULL;
+	    free(flag->newfile);
+	    flag->newfile = NULL;
+	    DBG(LAVACAM_ERR_ARG);
+	    return LAVACAM_ERR_ARG;
+	}
+
+	/* skip over these two args */
+	i += 2;
+    }
+
+    /*
+     * return arg adjustment value
+     */
+    return i - 1;
+}
+
+
+/*
+ * v4l2_wait_frame - use poll to wait for the next camera frame
+ *
+ * given:
+ *      cam_fd      open camera descriptor
+ *      max_wait    wait for up to this many seconds, <0.0 ==> infinite
+ *
+ * returns:
+ *      1 ==> frame is ready, 0 ==> timeout, <0 ==> error
+ *
+ * NOTE: A streaming V4L2 camera reports POLLERR when it has no buffer
+ *	 queued to fill, which is returned as LAVACAM_ERR_IOERR.
+ */
+int
+v4l2_wait_frame(int cam_fd, double max_wait)
+{
+    int ret;		/* poll return value */
+
+    /*
+     * firewall
+     */
+    if (cam_fd < 0) {
+	DBG(LAVACAM_ERR_ARG);
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * wait for the next frame or until we wait too long (if max_wait)
+     */
+    ret = lavacam_poll_frame(cam_fd, max_wait);
+    if (ret < 0) {
+	DBG(ret);
+    }
+    return ret;
+}
+
+
+/*
+ * v4l2_ioctl_hook - set the function that the v4l2 driver calls for ioctls
+ *
+ * given:
+ *      func        function to call in place of ioctl(2),
+ *                      NULL ==> call ioctl(2)
+ *
+ * returns:
+ *      the function that was being called before
+ *
+ * A test stand-in installed with this function sees every ioctl of
+ * every V4L2 camera, including those made by v4l2_open().  It should be
+ * installed before the camera is opened and kept until it is closed.
+ */
+v4l2_ioctl_func
+v4l2_ioctl_hook(v4l2_ioctl_func func)
+{
+    v4l2_ioctl_func prev;	/* function being called before */
+
+    prev = v4l2_ioctl;
+    v4l2_ioctl = (func == NULL) ? v4l2_sys_ioctl : func;
+    return prev;
+}
+
+
+#if defined(HAVE_V4L2)
+
+/*
+ * v4l2_find - find an open camera by its descriptor
+ *
+ * given:
+ *      cam_fd      open camera descriptor
+ *
+ * returns:
+ *      open camera, or NULL ==> cam_fd is not an open V4L2 camera
+ */
+static struct v4l2cam *
+v4l2_find(int cam_fd)
+{
+    int i;
+
+    for (i = 0; i < V4L2_MAX_OPEN; ++i) {
+	if (v4l2cam[i].inuse && v4l2cam[i].cam_fd == cam_fd) {
+	    return &v4l2cam[i];
+	}
+    }
+    return NULL;
+}
+
+
+/*
+ * xioctl - call the v4l2_ioctl function, retrying if interrupted
+ *
+ * given:
+ *      fd          open camera descriptor
+ *      request     ioctl request
+ *      arg         ioctl argument
+ *
+ * returns:
+ *      ioctl return value, <0 ==> error and errno is set
+ */
+static int
+xioctl(int fd, unsigned long request, void *arg)
+{
+    int ret;		/* ioctl return */
+
+    do {
+	ret = v4l2_ioctl(fd, request, arg);
+    } while (ret < 0 && errno == EINTR);
+    return ret;
+}
+
+
+/*
+ * v4l2_stream_on - set up the mmap streaming buffers and start streaming
+ *
+ * given:
+ *      r           open camera
+ *      buffers     number of streaming buffers to ask for
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ *
+ * NOTE: The camera may give fewer or more buffers than were asked for.
+ *	 On error, the caller should call v4l2_stream_off() to release
+ *	 the buffers that were set up.
+ */
+static int
+v4l2_stream_on(struct v4l2cam *r, int buffers)
+{
+    struct v4l2_requestbuffers req;	/* streaming buffer request */
+    struct v4l2_buffer buf;		/* streaming buffer */
+    enum v4l2_buf_type type;		/* stream type */
+    int i;
+
+    /*
+     * ask for the streaming buffers
+     */
+    memset(&req, 0, sizeof(req));
+    req.count = buffers;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(r->cam_fd, VIDIOC_REQBUFS, &req) < 0) {
+	DBG(LAVACAM_ERR_NOMMAP);
+	return LAVACAM_ERR_NOMMAP;
+    }
+    if (req.count < V4L2_MIN_BUFFERS) {
+	DBG(LAVACAM_ERR_NOMMAP);
+	return LAVACAM_ERR_NOMMAP;
+    }
+    if (req.count > V4L2_MAX_BUFFERS) {
+	/* extra buffers are never queued */
+	req.count = V4L2_MAX_BUFFERS;
+    }
+
+    /*
+     * mmap each buffer
+     */
+    for (i = 0; i < (int)req.count; ++i) {
+	memset(&buf, 0, sizeof(buf));
+	buf.index = i;
+	buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	buf.memory = V4L2_MEMORY_MMAP;
+	if (xioctl(r->cam_fd, VIDIOC_QUERYBUF, &buf) < 0) {
+	    DBG(LAVACAM_ERR_NOMMAP);
+	    return LAVACAM_ERR_NOMMAP;
+	}
+	r->start[i] = mmap(NULL, buf.length, PROT_READ|PROT_WRITE, MAP_SHARED,
+			   r->cam_fd, buf.m.offset);
+	if (r->start[i] == MAP_FAILED) {
+	    r->start[i] = NULL;
+	    DBG(LAVACAM_ERR_NOMMAP);
+	    return LAVACAM_ERR_NOMMAP;
+	}
+	r->length[i] = buf.length;
+	r->buffers = i + 1;
+    }
+
+    /*
+     * queue every buffer for capture
+     */
+    for (i = 0; i < r->buffers; ++i) {
+	memset(&buf, 0, sizeof(buf));
+	buf.index = i;
+	buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	buf.memory = V4L2_MEMORY_MMAP;
+	if (xioctl(r->cam_fd, VIDIOC_QBUF, &buf) < 0) {
+	    DBG(LAVACAM_ERR_SYNC);
+	    return LAVACAM_ERR_SYNC;
+	}
+    }
+
+    /*
+     * start streaming
+     */
+    type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(r->cam_fd, VIDIOC_STREAMON, &type) < 0) {
+	DBG(LAVACAM_ERR_IOERR);
+	return LAVACAM_ERR_IOERR;
+    }
+    r->streaming = TRUE;
+    return LAVACAM_ERR_OK;
+}
+
+
+/*
+ * v4l2_stream_off - stop streaming and release the streaming buffers
+ *
+ * given:
+ *      r           open camera
+ */
+static void
+v4l2_stream_off(struct v4l2cam *r)
+{
+    struct v4l2_requestbuffers req;	/* streaming buffer release */
+    enum v4l2_buf_type type;		/* stream type */
+    int i;
+
+    /*
+     * stop streaming
+     */
+    if (r->streaming) {
+	type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	(void) xioctl(r->cam_fd, VIDIOC_STREAMOFF, &type);
+	r->streaming = FALSE;
+    }
+
+    /*
+     * unmap and release the buffers
+     */
+    if (r->buffers > 0) {
+	for (i = 0; i < r->buffers; ++i) {
+	    if (r->start[i] != NULL) {
+		(void) munmap(r->start[i], r->length[i]);
+		r->start[i] = NULL;
+		r->length[i] = 0;
+	    }
+	}
+	r->buffers = 0;
+	memset(&req, 0, sizeof(req));
+	req.count = 0;
+	req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	req.memory = V4L2_MEMORY_MMAP;
+	(void) xioctl(r->cam_fd, VIDIOC_REQBUFS, &req);
+    }
+    return;
+}
+
+
+/*
+ * v4l2_abort - undo a v4l2_open() that failed after the camera was opened
+ *
+ * given:
+ *      r           camera being opened
+ *      siz         pointer to operation size and buffer structure
+ */
+static void
+v4l2_abort(struct v4l2cam *r, struct opsize *siz)
+{
+    v4l2_stream_off(r);
+    lavacam_frame_free(siz);
+    siz->image = NULL;
+    siz->image_len = 0;
+    siz->chaos = NULL;
+    siz->chaos_len = 0;
+    (void) close(r->cam_fd);
+    memset(r, 0, sizeof(r[0]));
+    r->cam_fd = -1;
+    r->inuse = FALSE;
+}
+
+
+/*
+ * v4l2_get - get an open camera's state
+ *
+ * given:
+ *      cam_fd      open camera descriptor
+ *      u_cam_p     pointer to values of the camera
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ *
+ * NOTE: This function will clear out the tmp sanity check values.
+ */
+int
+v4l2_get(int cam_fd, union lavacam *u_cam_p)
+{
+    struct v4l2_state *cam;	/* u_cam_p as v4l2 union element */
+    struct v4l2cam *r;		/* open camera or NULL */
+    struct v4l2_capability cap;	/* device capabilities */
+    struct v4l2_format fmt;	/* capture format */
+    struct v4l2_streamparm parm;	/* capture frame rate */
+
+    /*
+     * firewall
+     */
+    if (cam_fd < 0 || u_cam_p == NULL) {
+	DBG(LAVACAM_ERR_ARG);
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * pick out the driver specific union element
+     */
+    cam = &(u_cam_p->v4l2);
+    memset(cam, 0, sizeof(cam[0]));
+
+    /*
+     * must be a video capture device
+     */
+    memset(&cap, 0, sizeof(cap));
+    if (xioctl(cam_fd, VIDIOC_QUERYCAP, &cap) < 0) {
+	DBG(LAVACAM_ERR_NOCAM);
+	return LAVACAM_ERR_NOCAM;
+    }
+    cam->caps = cap.capabilities;
+#if defined(V4L2_CAP_DEVICE_CAPS)
+    if (cap.capabilities & V4L2_CAP_DEVICE_CAPS) {
+	cam->caps = cap.device_caps;
+    }
+#endif /* V4L2_CAP_DEVICE_CAPS */
+    if (!(cam->caps & V4L2_CAP_VIDEO_CAPTURE)) {
+	DBG(LAVACAM_ERR_NOCAM);
+	return LAVACAM_ERR_NOCAM;
+    }
+    memcpy(cam->driver, cap.driver, sizeof(cam->driver)-1);
+    memcpy(cam->card, cap.card, sizeof(cam->card)-1);
+
+    /*
+     * get the capture format
+     */
+    memset(&fmt, 0, sizeof(fmt));
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(cam_fd, VIDIOC_G_FMT, &fmt) < 0) {
+	DBG(LAVACAM_ERR_GETPARAM);
+	return LAVACAM_ERR_GETPARAM;
+    }
+    cam->width = fmt.fmt.pix.width;
+    cam->height = fmt.fmt.pix.height;
+    cam->pixelformat = fmt.fmt.pix.pixelformat;
+    cam->bytesperline = fmt.fmt.pix.bytesperline;
+    cam->sizeimage = fmt.fmt.pix.sizeimage;
+    cam->palette = v4l2_palette(cam->pixelformat);
+    if (cam->palette < 0) {
+	/* not usable, see v4l2_set() */
+	cam->palette = 0;
+    }
+
+    /*
+     * get the frame rate, if the camera reports it
+     */
+    memset(&parm, 0, sizeof(parm));
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(cam_fd, VIDIOC_G_PARM, &parm) == 0 &&
+	parm.parm.capture.timeperframe.numerator > 0) {
+	cam->fps = (parm.parm.capture.timeperframe.denominator +
+		    parm.parm.capture.timeperframe.numerator / 2) /
+		   parm.parm.capture.timeperframe.numerator;
+    }
+
+    /*
+     * report the streaming buffers in use
+     */
+    r = v4l2_find(cam_fd);
+    if (r != NULL) {
+	cam->buffers = r->buffers;
+    }
+    return LAVACAM_ERR_OK;
+}
+
+
+/*
+ * v4l2_set - set an open camera's state
+ *
+ * given:
+ *      cam_fd      open camera descriptor
+ *      u_cam_p     pointer to new camera setting if mask is non-zero
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ *
+ * NOTE: The tmp sanity check values are ignored by this function.
+ *
+ * NOTE: A width, height or pixelformat of 0 leaves that value as it is.
+ *	 The camera may adjust the width and height to the nearest size
+ *	 that it supports.  A camera that does not take the pixelformat
+ *	 given is an error.
+ *
+ * NOTE: The frame rate is only set if the camera allows it.
+ *
+ * NOTE: The buffers value is used by v4l2_open().  The format and the
+ *	 number of buffers of a streaming camera cannot be changed.
+ */
+int
+v4l2_set(int cam_fd, union lavacam *u_cam_p)
+{
+    struct v4l2_state *cam;	/* u_cam_p as v4l2 union element */
+    struct v4l2cam *r;		/* open camera or NULL */
+    struct v4l2_format fmt;	/* capture format */
+    struct v4l2_streamparm parm;	/* capture frame rate */
+    int change;			/* TRUE ==> format must change */
+
+    /*
+     * firewall
+     */
+    if (cam_fd < 0 || u_cam_p == NULL) {
+	DBG(LAVACAM_ERR_ARG);
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * pick out the driver specific union element
+     */
+    cam = &(u_cam_p->v4l2);
+
+    /*
+     * get the current capture format
+     */
+    memset(&fmt, 0, sizeof(fmt));
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(cam_fd, VIDIOC_G_FMT, &fmt) < 0) {
+	DBG(LAVACAM_ERR_GETPARAM);
+	return LAVACAM_ERR_GETPARAM;
+    }
+
+    /*
+     * determine if the format must change
+     */
+    change = FALSE;
+    if (V4L2_TEST(cam->mask, width) && cam->width > 0 &&
+	(int)fmt.fmt.pix.width != cam->width) {
+	fmt.fmt.pix.width = cam->width;
+	change = TRUE;
+    }
+    if (V4L2_TEST(cam->mask, height) && cam->height > 0 &&
+	(int)fmt.fmt.pix.height != cam->height) {
+	fmt.fmt.pix.height = cam->height;
+	change = TRUE;
+    }
+    if (V4L2_TEST(cam->mask, pixelformat) && cam->pixelformat != 0 &&
+	fmt.fmt.pix.pixelformat != cam->pixelformat) {
+	fmt.fmt.pix.pixelformat = cam->pixelformat;
+	change = TRUE;
+    }
+
+    /*
+     * a streaming camera keeps its format and buffers
+     */
+    r = v4l2_find(cam_fd);
+    if (r != NULL && r->streaming) {
+	if (change ||
+	    (V4L2_TEST(cam->mask, buffers) && cam->buffers != r->buffers)) {
+	    DBG(LAVACAM_ERR_SETPARAM);
+	    return LAVACAM_ERR_SETPARAM;
+	}
+    }
+
+    /*
+     * set the new format
+     */
+    if (change) {
+	fmt.fmt.pix.field = V4L2_FIELD_ANY;
+	fmt.fmt.pix.bytesperline = 0;
+	fmt.fmt.pix.sizeimage = 0;
+	if (xioctl(cam_fd, VIDIOC_S_FMT, &fmt) < 0) {
+	    DBG(LAVACAM_ERR_SETPARAM);
+	    return LAVACAM_ERR_SETPARAM;
+	}
+	if (V4L2_TEST(cam->mask, pixelformat) && cam->pixelformat != 0 &&
+	    fmt.fmt.pix.pixelformat != cam->pixelformat) {
+	    /* camera does not have the pixel format */
+	    DBG(LAVACAM_ERR_PALETTE);
+	    return LAVACAM_ERR_PALETTE;
+	}
+    }
+
+    /*
+     * set the frame rate if the camera allows it
+     */
+    if (V4L2_TEST(cam->mask, fps) && cam->fps > 0) {
+	memset(&parm, 0, sizeof(parm));
+	parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	if (xioctl(cam_fd, VIDIOC_G_PARM, &parm) == 0 &&
+	    (parm.parm.capture.capability & V4L2_CAP_TIMEPERFRAME)) {
+	    parm.parm.capture.timeperframe.numerator = 1;
+	    parm.parm.capture.timeperframe.denominator = cam->fps;
+	    if (xioctl(cam_fd, VIDIOC_S_PARM, &parm) < 0) {
+		DBG(LAVACAM_ERR_SETPARAM);
+		return LAVACAM_ERR_SETPARAM;
+	    }
+	}
+    }
+    return LAVACAM_ERR_OK;
+}
+
+
+/*
+ * v4l2_open - open a camera, return opening camera state
+ *
+ * given:
+ *      devname     camera device file
+ *      model       camera model number
+ *      o_cam_p     where to place the open camera state
+ *      n_cam_p     is non-NULL, set this new state,
+ *                      updated with the final open state if non-NULL
+ *      siz         pointer to operation size and buffer structure to fill in
+ *      def         unused
+ *      flag        flags set via lavacam_argv()
+ *
+ * returns:
+ *      >=0 ==> camera file descriptor, <0 ==> error
+ *
+ * NOTE: The function will also transfer tmp sanity check parameters from
+ *       the union lavacam to the opsize structure.
+ *
+ * NOTE: When mmap streaming, siz->image and siz->image_len describe the
+ *	 streaming buffer of the last frame obtained.  The buffers are
+ *	 released by v4l2_close().
+ */
+int
+v4l2_open(char *devname, int model, union lavacam *o_cam_p,
+	  union lavacam *n_cam_p, struct opsize *siz, int def,
+	  struct lavacam_flag *flag)
+{
+    struct v4l2_state *cam;	/* o_cam_p as v4l2 union element */
+    struct v4l2_state *set;	/* camera settings to use */
+    union lavacam t_cam;	/* working camera state */
+    struct v4l2cam *r;		/* the newly opened camera */
+    double open_warmup;		/* if >0.0, seconds to warmup camera */
+    int chaos_offset;		/* offset of chaos in a frame */
+    int chaos_len;		/* length of chaos in a frame */
+    int buffers;		/* streaming buffers to ask for */
+    int model_indx;		/* default state model index */
+    int cam_fd;			/* open device file descriptor */
+    int ret;			/* return code */
+    int i;
+
+    /*
+     * firewall
+     */
+    if (devname == NULL || o_cam_p == NULL || siz == NULL || flag == NULL) {
+	DBG(LAVACAM_ERR_ARG);
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * look for default state index
+     */
+    model_indx = v4l2_model(model);
+    if (model_indx < 0) {
+	return model_indx;
+    }
+
+    /*
+     * pick out the driver specific union element
+     */
+    cam = &(o_cam_p->v4l2);
+    if (n_cam_p == NULL) {
+	set = lava_state[model_indx].state;
+    } else {
+	set = &(n_cam_p->v4l2);
+    }
+
+    /*
+     * find a free camera slot
+     */
+    for (i = 0, r = NULL; i < V4L2_MAX_OPEN; ++i) {
+	if (!v4l2cam[i].inuse) {
+	    r = &v4l2cam[i];
+	    break;
+	}
+    }
+    if (r == NULL) {
+	DBG(LAVACAM_ERR_OPEN);
+	return LAVACAM_ERR_OPEN;
+    }
+
+    /*
+     * attempt to open the device
+     */
+    cam_fd = open(devname, O_RDWR|O_NONBLOCK);
+    if (cam_fd < 0) {
+	/* unable to open camera */
+	if (errno == EACCES) {
+	    /* permission denied */
+	    DBG(LAVAERR_PERMOPEN);
+	    return LAVAERR_PERMOPEN;
+	} else {
+	    /* other open failure */
+	    DBG(LAVACAM_ERR_OPEN);
+	    return LAVACAM_ERR_OPEN;
+	}
+    }
+    memset(r, 0, sizeof(r[0]));
+    r->cam_fd = cam_fd;
+    r->inuse = TRUE;
+
+    /*
+     * initialize opsize structure
+     */
+    memset(siz, 0, sizeof(*siz));
+    siz->prev_frame = NULL;
+    siz->image = NULL;
+    siz->chaos = NULL;
+    siz->top_x = set->tmp_top_x;
+    siz->min_fract = set->tmp_min_fract;
+    siz->half_x = set->tmp_half_x;
+    siz->diff_fract = set->tmp_diff_fract;
+
+    /*
+     * fetch the opening camera state
+     */
+    ret = v4l2_get(cam_fd, o_cam_p);
+    if (ret < 0) {
+	/* perhaps device is not a V4L2 capture device */
+	v4l2_abort(r, siz);
+	return ret;
+    }
+    cam->tmp_top_x = set->tmp_top_x;
+    cam->tmp_min_fract = set->tmp_min_fract;
+    cam->tmp_half_x = set->tmp_half_x;
+    cam->tmp_diff_fract = set->tmp_diff_fract;
+
+    /*
+     * set the new camera state, then re-fetch it
+     */
+    memcpy(&t_cam.v4l2, set, sizeof(t_cam.v4l2));
+    ret = v4l2_set(cam_fd, &t_cam);
+    if (ret < 0) {
+	v4l2_abort(r, siz);
+	return ret;
+    }
+    buffers = V4L2_DEF_BUFFERS;
+    if (V4L2_TEST(set->mask, buffers) && set->buffers > 0) {
+	buffers = set->buffers;
+    }
+    ret = v4l2_get(cam_fd, &t_cam);
+    if (ret < 0) {
+	v4l2_abort(r, siz);
+	return ret;
+    }
+    if (t_cam.v4l2.palette <= 0) {
+	/* camera is not set to a pixel format that we can use */
+	v4l2_abort(r, siz);
+	DBG(LAVACAM_ERR_PALETTE);
+	return LAVACAM_ERR_PALETTE;
+    }
+
+    /*
+     * determine location of chaotic data within a frame
+     */
+    ret = chaos_zone(PALLETTE_VIDEO4LINUX, t_cam.v4l2.palette,
+    		     t_cam.v4l2.sizeimage, t_cam.v4l2.height,
+		     t_cam.v4l2.width, &chaos_offset, &chaos_len);
+    if (ret < 0) {
+	v4l2_abort(r, siz);
+	DBG(ret);
+	return ret;
+    }
+    if (flag->A_flag) {
+	/* -A ==> use all the frame */
+	chaos_offset = 0;
+	chaos_len = t_cam.v4l2.sizeimage;
+    }
+    siz->framesize = t_cam.v4l2.sizeimage;
+    siz->palette = t_cam.v4l2.palette;
+    siz->height = t_cam.v4l2.height;
+    siz->width = t_cam.v4l2.width;
+
+    /*
+     * mmap streaming setup
+     */
+    if (flag->M_flag) {
+	if (!(t_cam.v4l2.caps & V4L2_CAP_STREAMING)) {
+	    v4l2_abort(r, siz);
+	    DBG(LAVACAM_ERR_NOMMAP);
+	    return LAVACAM_ERR_NOMMAP;
+	}
+	ret = v4l2_stream_on(r, buffers);
+	if (ret < 0) {
+	    v4l2_abort(r, siz);
+	    return ret;
+	}
+	for (i = 0; i < r->buffers; ++i) {
+	    if ((int)r->length[i] < chaos_offset + chaos_len) {
+		v4l2_abort(r, siz);
+		DBG(LAVACAM_ERR_NOSIZE);
+		return LAVACAM_ERR_NOSIZE;
+	    }
+	}
+	siz->use_read = FALSE;
+	siz->frames = r->buffers;
+	siz->mmapsize = (int)r->length[0];
+	siz->mmap_lavaoff = chaos_offset;
+	siz->mmap_lavalen = chaos_len;
+	siz->image = r->start[0];
+	siz->image_len = (int)r->length[0];
+	siz->chaos = (u_int8_t *)siz->image + chaos_offset;
+	siz->chaos_len = chaos_len;
+	lavacam_mmap_init(siz);
+
+	/*
+	 * With 3 or more buffers, the buffer kept for the sanity check
+	 * is held out of the capture queue and compared in place, while
+	 * the camera still has a buffer to fill.  With fewer, the
+	 * previous frame is copied aside.
+	 */
+	ret = lavacam_frame_alloc(siz, chaos_offset, r->buffers >= 3);
+	if (ret < 0) {
+	    v4l2_abort(r, siz);
+	    DBG(LAVAERR_MALLOC);
+	    return LAVAERR_MALLOC;
+	}
+
+    /*
+     * read setup
+     */
+    } else {
+	if (!(t_cam.v4l2.caps & V4L2_CAP_READWRITE) ||
+	    t_cam.v4l2.sizeimage <= 0) {
+	    v4l2_abort(r, siz);
+	    DBG(LAVACAM_ERR_NOREAD);
+	    return LAVACAM_ERR_NOREAD;
+	}
+	siz->use_read = TRUE;
+	siz->frames = 1;
+	siz->readsize = t_cam.v4l2.sizeimage;
+	siz->read_lavaoff = chaos_offset;
+	siz->read_lavalen = chaos_len;
+	siz->image_len = siz->readsize;
+	siz->chaos_len = chaos_len;
+	ret = lavacam_frame_alloc(siz, chaos_offset, FALSE);
+	if (ret < 0) {
+	    v4l2_abort(r, siz);
+	    DBG(LAVACAM_ERR_NOREAD);
+	    return LAVACAM_ERR_NOREAD;
+	}
+    }
+
+    /*
+     * report the final open state
+     */
+    if (n_cam_p != NULL) {
+	t_cam.v4l2.mask = set->mask;
+	t_cam.v4l2.buffers = r->buffers;
+	t_cam.v4l2.tmp_top_x = set->tmp_top_x;
+	t_cam.v4l2.tmp_min_fract = set->tmp_min_fract;
+	t_cam.v4l2.tmp_half_x = set->tmp_half_x;
+	t_cam.v4l2.tmp_diff_fract = set->tmp_diff_fract;
+	memcpy(&n_cam_p->v4l2, &t_cam.v4l2, sizeof(n_cam_p->v4l2));
+    }
+
+    /*
+     * determine the camera warmup time, if any
+     */
+    if (flag->T_flag > 0.0) {
+
+	/* use the -T flag instead of model default warmup */
+	open_warmup = flag->T_flag;
+
+    } else {
+
+	/* use model default warmup time due to lack of -T flag */
+	open_warmup = lava_state[model_indx].warmup;
+    }
+
+    /*
+     * warm up camera by tossing frames for a period of time if requested
+     */
+    if (open_warmup > 0.0) {
+	double now;	/* current time as a double */
+	double end;	/* end of warmup time */
+
+	/*
+	 * setup timing loop
+	 */
+	now = right_now();
+	if (now < 0.0) {
+	    v4l2_abort(r, siz);
+	    DBG(LAVAERR_GETTIME);
+	    return LAVAERR_GETTIME;
+	}
+	end = now + open_warmup;
+
+	/*
+	 * toss frames until warm up time is over
+	 */
+	while (now < end) {
+
+	    /*
+	     * wait for the next frame
+	     */
+	    ret = v4l2_wait_frame(cam_fd, end - now);
+	    if (ret < 0) {
+		v4l2_abort(r, siz);
+		DBG(LAVACAM_ERR_WARMUP);
+		return LAVACAM_ERR_WARMUP;
+	    }
+
+	    /*
+	     * obtain the next frame, toss it and release it
+	     */
+	    if (ret > 0) {
+		if (v4l2_get_frame(cam_fd, siz) < 0 ||
+		    v4l2_msync(cam_fd, &t_cam, siz) < 0) {
+		    v4l2_abort(r, siz);
+		    DBG(LAVACAM_ERR_WARMUP);
+		    return LAVACAM_ERR_WARMUP;
+		}
+	    }
+
+	    /*
+	     * determine the new now
+	     */
+	    now = right_now();
+	    if (now < 0.0) {
+		v4l2_abort(r, siz);
+		DBG(LAVAERR_GETTIME);
+		return LAVAERR_GETTIME;
+	    }
+	}
+    }
+
+    /*
+     * return open file descriptor
+     */
+    return cam_fd;
+}
+
+
+/*
+ * v4l2_close - close an open camera
+ *
+ * given:
+ *      cam_fd   open camera descriptor
+ *      siz      pointer to operation size and buffer structure
+ *      flag        flags set via lavacam_argv()
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ */
+int
+v4l2_close(int cam_fd, struct opsize *siz, struct lavacam_flag *flag)
+{
+    struct v4l2cam *r;	/* open camera */
+    int ret;		/* close return value */
+
+    /*
+     * firewall
+     */
+    if (cam_fd < 0 || siz == NULL || flag == NULL) {
+	DBG(LAVACAM_ERR_ARG);
+	return LAVACAM_ERR_ARG;
+    }
+    r = v4l2_find(cam_fd);
+    if (r == NULL) {
+	DBG(LAVACAM_ERR_NOCAM);
+	return LAVACAM_ERR_NOCAM;
+    }
+
+    /*
+     * stop streaming and release the streaming buffers
+     */
+    v4l2_stream_off(r);
+    memset(r, 0, sizeof(r[0]));
+    r->cam_fd = -1;
+    r->inuse = FALSE;
+
+    /*
+     * free read buffers and previous chaos frame
+     */
+    lavacam_frame_free(siz);
+
+    /*
+     * clear read/mmap frame data
+     */
+    siz->image = NULL;
+    siz->image_len = 0;
+    siz->chaos = NULL;
+    siz->chaos_len = 0;
+
+    /*
+     * free savefile/newfile is they are present
+     */
+    if (flag->savefile != NULL) {
+	free(flag->savefile);
+	flag->savefile = NULL;
+    }
+    if (flag->newfile != NULL) {
+	free(flag->newfile);
+	flag->newfile = NULL;
+    }
+    flag->interval = 0.0;
+
+    /*
+     * close device
+     */
+    ret = close(cam_fd);
+    if (ret < 0) {
+	DBG(LAVACAM_ERR_CLOSE);
+	return LAVACAM_ERR_CLOSE;
+    }
+    return LAVACAM_ERR_OK;
+}
+
+
+/*
+ * v4l2_get_frame - get the next frame from the camera
+ *
+ * given:
+ *      cam_fd   open camera descriptor
+ *      siz      pointer to operation size and buffer structure
+ *
+ * returns:
+ *      >= 0 ==> chaos octets obtained, < 0 ==> error
+ *
+ * NOTE: One must call v4l2_msync(), if mmap streaming, after processing
+ *       the frame obtained by this function and prior to calling
+ *       this function again.  To be on the safe side, always call
+ *       v4l2_msync() after processing a frame.
+ *
+ * NOTE: This function waits for the next frame.  To not block, call
+ *	 v4l2_wait_frame() (or read select/poll on the open file
+ *	 descriptor) before calling this function.
+ *
+ * NOTE: When mmap streaming, this function takes the oldest filled
+ *	 buffer and points siz->chaos at it.  The camera goes on filling
+ *	 the other queued buffers in the meantime.  A buffer that the
+ *	 camera flagged as bad, that is too short, or whose index is not
+ *	 one of the buffers we mapped, is queued again and LAVACAM_ERR_FRAME
+ *	 is returned.
+ */
+int
+v4l2_get_frame(int cam_fd, struct opsize *siz)
+{
+    struct v4l2cam *r;		/* open camera */
+    struct v4l2_buffer buf;	/* filled streaming buffer */
+    int op_ret;			/* read or ioctl return */
+
+    /*
+     * firewall
+     */
+    if (cam_fd < 0 || siz == NULL) {
+	DBG(LAVACAM_ERR_ARG);
+	return LAVACAM_ERR_ARG;
+    }
+
+    /*
+     * read if reading
+     */
+    if (siz->use_read) {
+
+	/*
+	 * read the data
+	 */
+	if (siz->image == NULL || siz->image_len <= 0) {
+	    DBG(LAVACAM_ERR_NOSIZE);
+	    return LAVACAM_ERR_NOSIZE;
+	}
+	for (;;) {
+	    op_ret = read(cam_fd, siz->image, siz->image_len);
+	    if (op_ret >= 0 || (errno != EINTR && errno != EAGAIN)) {
+		break;
+	    }
+	    if (errno == EAGAIN && v4l2_wait_frame(cam_fd, -1.0) < 0) {
+		DBG(LAVACAM_ERR_IOERR);
+		return LAVACAM_ERR_IOERR;
+	    }
+	}
+	if (op_ret < 0) {
+	    DBG(LAVACAM_ERR_IOERR);
+	    return LAVACAM_ERR_IOERR;
+	}
+	if (op_ret < siz->read_lavaoff + siz->chaos_len) {
+	    DBG(LAVACAM_ERR_FRAME);
+	    return LAVACAM_ERR_FRAME;
+	}
+
+    /*
+     * or take the oldest filled buffer if mmap streaming
+     */
+    } else {
+
+	/*
+	 * the previous buffer must be released with v4l2_msync() first
+	 */
+	if (siz->mmap_cur >= 0) {
+	    DBG(LAVACAM_ERR_SYNC);
+	    return LAVACAM_ERR_SYNC;
+	}
+	r = v4l2_find(cam_fd);
+	if (r == NULL || !r->streaming) {
+	    DBG(LAVACAM_ERR_NOCAM);
+	    return LAVACAM_ERR_NOCAM;
+	}
+
+	/*
+	 * wait for a buffer to be filled
+	 */
+	for (;;) {
+	    memset(&buf, 0, sizeof(buf));
+	    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	    buf.memory = V4L2_MEMORY_MMAP;
+	    op_ret = xioctl(cam_fd, VIDIOC_DQBUF, &buf);
+	    if (op_ret >= 0 || errno != EAGAIN) {
+		break;
+	    }
+	    if (v4l2_wait_frame(cam_fd, -1.0) < 0) {
+		DBG(LAVACAM_ERR_IOERR);
+		return LAVACAM_ERR_IOERR;
+	    }
+	}
+	if (op_ret < 0) {
+	    DBG(LAVACAM_ERR_SYNC);
+	    return LAVACAM_ERR_SYNC;
+	}
+
+	/*
+	 * toss a buffer we did not map, or a bad or short frame
+	 *
+	 * The buffer goes back to the camera, otherwise the camera would
+	 * be left with one less buffer to fill each time.
+	 */
+	if (buf.index >= (unsigned int)r->buffers) {
+	    DBG(LAVACAM_ERR_FRAME);
+	    if (xioctl(cam_fd, VIDIOC_QBUF, &buf) < 0) {
+		DBG(LAVACAM_ERR_SYNC);
+		return LAVACAM_ERR_SYNC;
+	    }
+	    return LAVACAM_ERR_FRAME;
+	}
+	if ((buf.flags & V4L2_BUF_FLAG_ERROR) ||
+	    (buf.bytesused > 0 &&
+	     buf.bytesused < (unsigned int)(siz->mmap_lavaoff+siz->chaos_len))) {
+	    if (xioctl(cam_fd, VIDIOC_QBUF, &buf) < 0) {
+		DBG(LAVACAM_ERR_SYNC);
+		return LAVACAM_ERR_SYNC;
+	    }
+	    DBG(LAVACAM_ERR_FRAME);
+	    return LAVACAM_ERR_FRAME;
+	}
+
+	/*
+	 * process the frame where the camera put it
+	 */
+	siz->mmap_cur = buf.index;
+	siz->image = r->start[buf.index];
+	siz->image_len = (int)r->length[buf.index];
+	siz->chaos = (u_int8_t *)siz->image + siz->mmap_lavaoff;
+    }
+
+    /*
+     * report the amount of chaotic data returned
+     */
+    return siz->chaos_len;
+}
+
+
+/*
+ * v4l2_msync - release/sync after processing a mmap streaming buffer
+ *
+ * given:
+ *      cam_fd      open camera descriptor
+ *      u_cam_p     pointer to camera state
+ *      siz         pointer to operation size and buffer structure
+ *
+ * returns:
+ *      0 ==> OK, <0 ==> error
+ *
+ * NOTE: If we a reading, we immediately return OK (0) after doing nothing.
+ *
+ * NOTE: The buffer obtained by v4l2_get_frame() is queued to be filled
+ *	 again, unless lavacam_sanity() kept it as the previous frame.
+ *	 A kept buffer is held until the next frame is kept, and then
+ *	 the held buffer is queued instead.
+ */
+int
+v4l2_msync(int cam_fd, union lavacam *u_cam_p, struct opsize *siz)
+{
+    struct v4l2_buffer buf;	/* streaming buffer to queue */
+    int framenum;		/* which buffer we are releasing */
+
+    /*
+     * firewall
+     */
+    if (cam_fd < 0 || u_cam_p == NULL || siz == NULL) {
+	DBG(LAVACAM_ERR_ARG);
+	return LAVACAM_ERR_ARG;
+    }
+    if (siz->use_read == TRUE) {
+	/* reading, nothing to do */
+	return LAVACAM_ERR_OK;
+    }
+
+    /*
+     * determine which buffer, if any, to fill again
+     */
+    framenum = lavacam_mmap_release(siz);
+    if (framenum < 0) {
+	/* the buffer is held for the next sanity check */
+	return LAVACAM_ERR_OK;
+    }
+
+    /*
+     * queue the buffer to be filled
+     */
+    memset(&buf, 0, sizeof(buf));
+    buf.index = framenum;
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(cam_fd, VIDIOC_QBUF, &buf) < 0) {
+	DBG(LAVACAM_ERR_SYNC);
+	return LAVACAM_ERR_SYNC;
+    }
+    return LAVACAM_ERR_OK;
+}
+
+#else /* HAVE_V4L2 */
+
+/*
+ * Without <linux/videodev2.h> there is no V4L2 camera to talk to.
+ */
+
+int
+v4l2_get(int cam_fd, union lavacam *u_cam_p)
+{
+    DBG(LAVACAM_ERR_NOCAM);
+    return LAVACAM_ERR_NOCAM;
+}
+
+int
+v4l2_set(int cam_fd, union lavacam *u_cam_p)
+{
+    DBG(LAVACAM_ERR_NOCAM);
+    return LAVACAM_ERR_NOCAM;
+}
+
+int
+v4l2_open(char *devname, int model, union lavacam *o_cam_p,
+	  union lavacam *n_cam_p, struct opsize *siz, int def,
+	  struct lavacam_flag *flag)
+{
+    DBG(LAVACAM_ERR_NOCAM);
+    return LAVACAM_ERR_NOCAM;
+}
+
+int
+v4l2_close(int cam_fd, struct opsize *siz, struct lavacam_flag *flag)
+{
+    DBG(LAVACAM_ERR_NOCAM);
+    return LAVACAM_ERR_NOCAM;
+}
+
+int
+v4l2_get_frame(int cam_fd, struct opsize *siz)
+{
+    DBG(LAVACAM_ERR_NOCAM);
+    return LAVACAM_ERR_NOCAM;
+}
+
+int
+v4l2_msync(int cam_fd, union lavacam *u_cam_p, struct opsize *siz)
+{
+    DBG(LAVACAM_ERR_NOCAM);
+    return LAVACAM_ERR_NOCAM;
+}
+
+#endif /* HAVE_V4L2 */
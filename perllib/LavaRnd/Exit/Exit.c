@@ -0,0 +1,512 @@
+/*
+ * This file was generated automatically by ExtUtils::ParseXS version 3.45 from the
+ * contents of Exit.xs. Do not edit this file, edit Exit.xs instead.
+ *
+ *    ANY CHANGES MADE HERE WILL BE LOST!
+ *
+ */
+
+#line 1 "Exit.xs"
+/*
+ * Copyright (c) 2000-2003 by Landon Curt Noll and Simon Cooper.
+ * All Rights Reserved.
+ *
+ * This is open software; you can redistribute it and/or modify it under
+ * the terms of the version 2.1 of the GNU Lesser General Public License
+ * as published by the Free Software Foundation.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General
+ * Public License for more details.
+ *
+ * The file COPYING contains important info about Licenses and Copyrights.
+ * Please read the COPYING file for details about this open software.
+ *
+ * A copy of version 2.1 of the GNU Lesser General Public License is
+ * distributed with calc under the filename COPYING-LGPL.  You should have
+ * received a copy with calc; if not, write to Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * For more information on LavaRnd: http://www.LavaRnd.org
+ *
+ * Share and enjoy! :-)
+ */
+
+#include "EXTERN.h"
+#include "perl.h"
+#include "XSUB.h"
+
+#include "ppport.h"
+
+#include <sys/types.h>
+#include "LavaRnd/random.h"
+#include "LavaRnd/random_libc.h"
+
+#line 47 "Exit.c"
+#ifndef PERL_UNUSED_VAR
+#  define PERL_UNUSED_VAR(var) if (0) var = var
+#endif
+
+#ifndef dVAR
+#  define dVAR		dNOOP
+#endif
+
+
+/* This stuff is not part of the API! You have been warned. */
+#ifndef PERL_VERSION_DECIMAL
+#  define PERL_VERSION_DECIMAL(r,v,s) (r*1000000 + v*1000 + s)
+#endif
+#ifndef PERL_DECIMAL_VERSION
+#  define PERL_DECIMAL_VERSION \
+	  PERL_VERSION_DECIMAL(PERL_REVISION,PERL_VERSION,PERL_SUBVERSION)
+#endif
+#ifndef PERL_VERSION_GE
+#  define PERL_VERSION_GE(r,v,s) \
+	  (PERL_DECIMAL_VERSION >= PERL_VERSION_DECIMAL(r,v,s))
+#endif
+#ifndef PERL_VERSION_LE
+#  define PERL_VERSION_LE(r,v,s) \
+	  (PERL_DECIMAL_VERSION <= PERL_VERSION_DECIMAL(r,v,s))
+#endif
+
+/* XS_INTERNAL is the explicit static-linkage variant of the default
+ * XS macro.
+ *
+ * XS_EXTERNAL is the same as XS_INTERNAL except it does not include
+ * "STATIC", ie. it exports XSUB symbols. You probably don't want that
+ * for anything but the BOOT XSUB.
+ *
+ * See XSUB.h in core!
+ */
+
+
+/* TODO: This might be compatible further back than 5.10.0. */
+#if PERL_VERSION_GE(5, 10, 0) && PERL_VERSION_LE(5, 15, 1)
+#  undef XS_EXTERNAL
+#  undef XS_INTERNAL
+#  if defined(__CYGWIN__) && defined(USE_DYNAMIC_LOADING)
+#    define XS_EXTERNAL(name) __declspec(dllexport) XSPROTO(name)
+#    define XS_INTERNAL(name) STATIC XSPROTO(name)
+#  endif
+#  if defined(__SYMBIAN32__)
+#    define XS_EXTERNAL(name) EXPORT_C XSPROTO(name)
+#    define XS_INTERNAL(name) EXPORT_C STATIC XSPROTO(name)
+#  endif
+#  ifndef XS_EXTERNAL
+#    if defined(HASATTRIBUTE_UNUSED) && !defined(__cplusplus)
+#      define XS_EXTERNAL(name) void name(pTHX_ CV* cv __attribute__unused__)
+#      define XS_INTERNAL(name) STATIC void name(pTHX_ CV* cv __attribute__unused__)
+#    else
+#      ifdef __cplusplus
+#        define XS_EXTERNAL(name) extern "C" XSPROTO(name)
+#        define XS_INTERNAL(name) static XSPROTO(name)
+#      else
+#        define XS_EXTERNAL(name) XSPROTO(name)
+#        define XS_INTERNAL(name) STATIC XSPROTO(name)
+#      endif
+#    endif
+#  endif
+#endif
+
+/* perl >= 5.10.0 && perl <= 5.15.1 */
+
+
+/* The XS_EXTERNAL macro is used for functions that must not be static
+ * like the boot XSUB of a module. If perl didn't have an XS_EXTERNAL
+ * macro defined, the best we can do is assume XS is the same.
+ * Dito for XS_INTERNAL.
+ */
+#ifndef XS_EXTERNAL
+#  define XS_EXTERNAL(name) XS(name)
+#endif
+#ifndef XS_INTERNAL
+#  define XS_INTERNAL(name) XS(name)
+#endif
+
+/* Now, finally, after all this mess, we want an ExtUtils::ParseXS
+ * internal macro that we're free to redefine for varying linkage due
+ * to the EXPORT_XSUB_SYMBOLS XS keyword. This is internal, use
+ * XS_EXTERNAL(name) or XS_INTERNAL(name) in your code if you need to!
+ */
+
+#undef XS_EUPXS
+#if defined(PERL_EUPXS_ALWAYS_EXPORT)
+#  define XS_EUPXS(name) XS_EXTERNAL(name)
+#else
+   /* default to internal */
+#  define XS_EUPXS(name) XS_INTERNAL(name)
+#endif
+
+#ifndef PERL_ARGS_ASSERT_CROAK_XS_USAGE
+#define PERL_ARGS_ASSERT_CROAK_XS_USAGE assert(cv); assert(params)
+
+/* prototype to pass -Wmissing-prototypes */
+STATIC void
+S_croak_xs_usage(const CV *const cv, const char *const params);
+
+STATIC void
+S_croak_xs_usage(const CV *const cv, const char *const params)
+{
+    const GV *const gv = CvGV(cv);
+
+    PERL_ARGS_ASSERT_CROAK_XS_USAGE;
+
+    if (gv) {
+        const char *const gvname = GvNAME(gv);
+        const HV *const stash = GvSTASH(gv);
+        const char *const hvname = stash ? HvNAME(stash) : NULL;
+
+        if (hvname)
+	    Perl_croak_nocontext("Usage: %s::%s(%s)", hvname, gvname, params);
+        else
+	    Perl_croak_nocontext("Usage: %s(%s)", gvname, params);
+    } else {
+        /* Pants. I don't think that it should be possible to get here. */
+	Perl_croak_nocontext("Usage: CODE(0x%" UVxf ")(%s)", PTR2UV(cv), params);
+    }
+}
+#undef  PERL_ARGS_ASSERT_CROAK_XS_USAGE
+
+#define croak_xs_usage        S_croak_xs_usage
+
+#endif
+
+/* NOTE: the prototype of newXSproto() is different in versions of perls,
+ * so we define a portable version of newXSproto()
+ */
+#ifdef newXS_flags
+#define newXSproto_portable(name, c_impl, file, proto) newXS_flags(name, c_impl, file, proto, 0)
+#else
+#define newXSproto_portable(name, c_impl, file, proto) (PL_Sv=(SV*)newXS(name, c_impl, file), sv_setpv(PL_Sv, proto), (CV*)PL_Sv)
+#endif /* !defined(newXS_flags) */
+
+#if PERL_VERSION_LE(5, 21, 5)
+#  define newXS_deffile(a,b) Perl_newXS(aTHX_ a,b,file)
+#else
+#  define newXS_deffile(a,b) Perl_newXS_deffile(aTHX_ a,b)
+#endif
+
+#line 191 "Exit.c"
+
+XS_EUPXS(XS_LavaRnd__Exit_random8); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_LavaRnd__Exit_random8)
+{
+    dVAR; dXSARGS;
+    if (items != 0)
+       croak_xs_usage(cv,  "");
+    {
+	U8	RETVAL;
+	dXSTARG;
+#line 46 "Exit.xs"
+	RETVAL = (U8)random8();
+
+#line 205 "Exit.c"
+	XSprePUSH;
+	PUSHu((UV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_LavaRnd__Exit_random16); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_LavaRnd__Exit_random16)
+{
+    dVAR; dXSARGS;
+    if (items != 0)
+       croak_xs_usage(cv,  "");
+    {
+	U16	RETVAL;
+	dXSTARG;
+#line 58 "Exit.xs"
+	RETVAL = (U16)random16();
+
+#line 225 "Exit.c"
+	XSprePUSH;
+	PUSHu((UV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_LavaRnd__Exit_random32); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_LavaRnd__Exit_random32)
+{
+    dVAR; dXSARGS;
+    if (items != 0)
+       croak_xs_usage(cv,  "");
+    {
+	U32	RETVAL;
+	dXSTARG;
+#line 70 "Exit.xs"
+	RETVAL = (U32)random32();
+
+#line 245 "Exit.c"
+	XSprePUSH;
+	PUSHu((UV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_LavaRnd__Exit_random_data); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_LavaRnd__Exit_random_data)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "len");
+    {
+	int	len = (int)SvIV(ST(0))
+;
+#line 83 "Exit.xs"
+	long retlen;		/* quant of random data obtained, <0 ==> err */
+	U8 *buf;		/* pointer to len octets */
+	SV *ret;		/* scalar of random data to return */
+
+#line 267 "Exit.c"
+	SV *	RETVAL;
+#line 88 "Exit.xs"
+	/* firewall - len sanity check */
+#if defined(EXTRA_DEBUG)
+	fprintf(stderr, "len: %d\n", len);
+#endif
+    	if (len <= 0) {
+#if defined(EXTRA_DEBUG)
+	    fprintf(stderr, "len <= 0\n");
+	    XSRETURN_UNDEF;
+#else
+	    /* module interface only allows return of random data */
+	    /* simulate exit :=) */
+	    exit(100);
+#endif
+	}
+
+	/* allocate the random scalar */
+	ret = newSV(len);
+
+	/* find where the actual memory block resides */
+	buf = SvPVX(ret);
+	if (buf == NULL) {
+#if defined(EXTRA_DEBUG)
+	    fprintf(stderr, "DEBUG: buf == NULL\n");
+	    XSRETURN_UNDEF;
+#else
+	    /* module interface only allows return of random data */
+	    /* simulate exit :=) */
+	    exit(100);
+#endif
+	}
+
+	/* make the scalar a valid memory block */
+	SvPOK_on(ret);
+	SvCUR_set(ret, len);
+
+	/* load the memory block with random data */
+	retlen = randomcpy(buf, len);
+	if (retlen != len) {
+	    /* this should never happen - but just in case it does ... */
+#if defined(EXTRA_DEBUG)
+	    fprintf(stderr, "DEBUG: retlen:%d != len:%d\n", retlen, len);
+	    XSRETURN_UNDEF;
+#else
+	    /* module interface only allows return of random data */
+	    /* simulate exit :=) */
+	    exit(100);
+#endif
+	}
+
+	/* return the scalar */
+	RETVAL = ret;
+
+#line 322 "Exit.c"
+	RETVAL = sv_2mortal(RETVAL);
+	ST(0) = RETVAL;
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_LavaRnd__Exit_drandom); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_LavaRnd__Exit_drandom)
+{
+    dVAR; dXSARGS;
+    if (items != 0)
+       croak_xs_usage(cv,  "");
+    {
+	double	RETVAL;
+	dXSTARG;
+#line 150 "Exit.xs"
+	RETVAL = (double)drandom();
+
+#line 342 "Exit.c"
+	XSprePUSH;
+	PUSHn((double)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_LavaRnd__Exit_dcrandom); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_LavaRnd__Exit_dcrandom)
+{
+    dVAR; dXSARGS;
+    if (items != 0)
+       croak_xs_usage(cv,  "");
+    {
+	double	RETVAL;
+	dXSTARG;
+#line 162 "Exit.xs"
+	RETVAL = (double)dcrandom();
+
+#line 362 "Exit.c"
+	XSprePUSH;
+	PUSHn((double)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_LavaRnd__Exit_random_val); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_LavaRnd__Exit_random_val)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "beyond");
+    {
+	U32	beyond = (unsigned long)SvUV(ST(0))
+;
+	U32	RETVAL;
+	dXSTARG;
+#line 175 "Exit.xs"
+	RETVAL = (U32)random_val(beyond);
+
+#line 384 "Exit.c"
+	XSprePUSH;
+	PUSHu((UV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_LavaRnd__Exit_random_coin); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_LavaRnd__Exit_random_coin)
+{
+    dVAR; dXSARGS;
+    if (items != 0)
+       croak_xs_usage(cv,  "");
+    {
+	bool	RETVAL;
+#line 187 "Exit.xs"
+	RETVAL = (bool)((random8() & 0x08) ? 1 : 0);
+
+#line 403 "Exit.c"
+	ST(0) = boolSV(RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_LavaRnd__Exit_lavarnd_errno); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_LavaRnd__Exit_lavarnd_errno)
+{
+    dVAR; dXSARGS;
+    PERL_UNUSED_VAR(cv); /* -W */
+    PERL_UNUSED_VAR(items); /* -W */
+    {
+#line 199 "Exit.xs"
+    	SV *arg;
+
+#line 420 "Exit.c"
+	SV *	RETVAL;
+#line 202 "Exit.xs"
+	switch (items) {
+	case 0:
+	    RETVAL = newSViv(lavarnd_errno);
+	    break;
+	case 1:
+	    if (!SvOK(ST(0))) {
+		XSRETURN_UNDEF;
+	    }
+	    RETVAL = newSViv(lavarnd_errno);
+	    lavarnd_errno = SvIVx(ST(0));
+	    break;
+	default:
+	    XSRETURN_UNDEF;
+	}
+
+#line 438 "Exit.c"
+	RETVAL = sv_2mortal(RETVAL);
+	ST(0) = RETVAL;
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_LavaRnd__Exit_lastop_errno); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_LavaRnd__Exit_lastop_errno)
+{
+    dVAR; dXSARGS;
+    if (items != 0)
+       croak_xs_usage(cv,  "");
+    {
+	SV *	RETVAL;
+#line 227 "Exit.xs"
+	RETVAL = newSViv(lastop_errno);
+	SvIOK_only(RETVAL);
+
+#line 458 "Exit.c"
+	RETVAL = sv_2mortal(RETVAL);
+	ST(0) = RETVAL;
+    }
+    XSRETURN(1);
+}
+
+#ifdef __cplusplus
+extern "C"
+#endif
+XS_EXTERNAL(boot_LavaRnd__Exit); /* prototype to pass -Wmissing-prototypes */
+XS_EXTERNAL(boot_LavaRnd__Exit)
+{
+#if PERL_VERSION_LE(5, 21, 5)
+    dVAR; dXSARGS;
+#else
+    dVAR; dXSBOOTARGSXSAPIVERCHK;
+#endif
+#if PERL_VERSION_LE(5, 8, 999) /* PERL_VERSION_LT is 5.33+ */
+    char* file = __FILE__;
+#else
+    const char* file = __FILE__;
+#endif
+
+    PERL_UNUSED_VAR(file);
+
+    PERL_UNUSED_VAR(cv); /* -W */
+    PERL_UNUSED_VAR(items); /* -W */
+#if PERL_VERSION_LE(5, 21, 5)
+    XS_VERSION_BOOTCHECK;
+#  ifdef XS_APIVERSION_BOOTCHECK
+    XS_APIVERSION_BOOTCHECK;
+#  endif
+#endif
+
+        (void)newXSproto_portable("LavaRnd::Exit::random8", XS_LavaRnd__Exit_random8, file, "");
+        (void)newXSproto_portable("LavaRnd::Exit::random16", XS_LavaRnd__Exit_random16, file, "");
+        (void)newXSproto_portable("LavaRnd::Exit::random32", XS_LavaRnd__Exit_random32, file, "");
+        (void)newXSproto_portable("LavaRnd::Exit::random_data", XS_LavaRnd__Exit_random_data, file, "$");
+        (void)newXSproto_portable("LavaRnd::Exit::drandom", XS_LavaRnd__Exit_drandom, file, "");
+        (void)newXSproto_portable("LavaRnd::Exit::dcrandom", XS_LavaRnd__Exit_dcrandom, file, "");
+        (void)newXSproto_portable("LavaRnd::Exit::random_val", XS_LavaRnd__Exit_random_val, file, "$");
+        (void)newXSproto_portable("LavaRnd::Exit::random_coin", XS_LavaRnd__Exit_random_coin, file, "");
+        (void)newXSproto_portable("LavaRnd::Exit::lavarnd_errno", XS_LavaRnd__Exit_lavarnd_errno, file, ";$");
+        (void)newXSproto_portable("LavaRnd::Exit::lastop_errno", XS_LavaRnd__Exit_lastop_errno, file, "");
+#if PERL_VERSION_LE(5, 21, 5)
+#  if PERL_VERSION_GE(5, 9, 0)
+    if (PL_unitcheckav)
+        call_list(PL_scopestack_ix, PL_unitcheckav);
+#  endif
+    XSRETURN_YES;
+#else
+    Perl_xs_boot_epilog(aTHX_ ax);
+#endif
+}
+
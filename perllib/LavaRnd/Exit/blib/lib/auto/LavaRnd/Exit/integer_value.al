@@ -0,0 +1,40 @@
+# NOTE: Derived from blib/lib/LavaRnd/Exit.pm.
+# Changes made here will be lost when autosplit is run again.
+# See AutoSplit.pm.
+package LavaRnd::Exit;
+
+#line 416 "blib/lib/LavaRnd/Exit.pm (autosplit into blib/lib/auto/LavaRnd/Exit/integer_value.al)"
+# integer_value - get the integer value of a scalar
+#
+# given:
+#	$value	scalar whose integer value will be extracted, if only integer
+#
+# returns:
+#	integer value or
+#	undef ==> scalar contained some non-integer
+#
+sub integer_value($)
+{
+    my ($str) = @_;	# get arg
+
+    # firewall
+    #
+    return undef if ! defined $str;
+
+    # strip leading and trailing whitespace and a trailing .0's
+    #
+    $str =~ s/^\s+//;
+    $str =~ s/\s+$//;
+    $str =~ s/\.0*$//;
+    return undef if ($str eq '');
+
+    # return integer value or undef
+    #
+    if ($str =~ /^[+-]?\d+$/) {
+	return $str;
+    }
+    return undef;
+}
+
+# end of LavaRnd::Exit::integer_value
+1;
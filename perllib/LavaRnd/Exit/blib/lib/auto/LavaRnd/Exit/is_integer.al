@@ -0,0 +1,36 @@
+# NOTE: Derived from blib/lib/LavaRnd/Exit.pm.
+# Changes made here will be lost when autosplit is run again.
+# See AutoSplit.pm.
+package LavaRnd::Exit;
+
+#line 449 "blib/lib/LavaRnd/Exit.pm (autosplit into blib/lib/auto/LavaRnd/Exit/is_integer.al)"
+# is_integer - determine if a scalar is just an integer value
+#
+# given:
+#	$value	scalar to test for integer value
+#
+# returns:
+#	TRUE ==> scalar is an integer
+#	FALSE ==> scalar is NOT an integer
+#
+sub is_integer($)
+{
+    my ($str) = @_;	# get arg
+
+    # firewall
+    #
+    return undef if ! defined $str;
+
+    # strip leading and trailing whitespace and a trailing .0's
+    #
+    $str =~ s/^\s+//;
+    $str =~ s/\s+$//;
+    $str =~ s/\.0*$//;
+
+    # determine of the arg an integer
+    #
+    return (($str ne '') && ($str =~ /^[+-]?\d+$/));
+}
+
+# end of LavaRnd::Exit::is_integer
+1;
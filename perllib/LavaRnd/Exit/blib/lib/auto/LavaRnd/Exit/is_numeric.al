@@ -0,0 +1,43 @@
+# NOTE: Derived from blib/lib/LavaRnd/Exit.pm.
+# Changes made here will be lost when autosplit is run again.
+# See AutoSplit.pm.
+package LavaRnd::Exit;
+
+#line 286 "blib/lib/LavaRnd/Exit.pm (autosplit into blib/lib/auto/LavaRnd/Exit/is_numeric.al)"
+# is_numeric - determine if a scalar is just a numeric value
+#
+# given:
+#	$value	scalar to test for numerical value
+#
+# returns:
+#	TRUE ==> scalar is numeric
+#	FALSE ==> scalar is NOT numeric
+#
+sub is_numeric($)
+{
+    my ($str) = @_;	# get arg
+    my $num;		# numeric part of $str, if any
+    my $unparsed;	# non-numeric part of $str, if any
+
+    # firewall
+    #
+    return undef if ! defined $str;
+
+    # strip leading and trailing whitespace
+    #
+    $str =~ s/^\s+//;
+    $str =~ s/\s+$//;
+    return undef if ($str eq '');
+
+    # try to convert to a number
+    #
+    $! = 0;
+    ($num, $unparsed) = strtod($str);
+
+    # determine of the arg was numeric
+    #
+    return (($unparsed == 0) && $! == 0);
+}
+
+# end of LavaRnd::Exit::is_numeric
+1;
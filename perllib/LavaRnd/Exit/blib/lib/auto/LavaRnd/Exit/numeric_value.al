@@ -0,0 +1,46 @@
+# NOTE: Derived from blib/lib/LavaRnd/Exit.pm.
+# Changes made here will be lost when autosplit is run again.
+# See AutoSplit.pm.
+package LavaRnd::Exit;
+
+#line 247 "blib/lib/LavaRnd/Exit.pm (autosplit into blib/lib/auto/LavaRnd/Exit/numeric_value.al)"
+# numeric_value - get the numeric value of a scalar
+#
+# given:
+#	$value	scalar whose numeric value will be extracted, if only numeric
+#
+# returns:
+#	numeric value or
+#	undef ==> scalar contained some non-numeric data
+#
+sub numeric_value($)
+{
+    my ($str) = @_;	# get arg
+    my $num;		# numeric part of $str, if any
+    my $unparsed;	# non-numeric part of $str, if any
+
+    # firewall
+    #
+    return undef if ! defined $str;
+
+    # strip leading and trailing whitespace
+    #
+    $str =~ s/^\s+//;
+    $str =~ s/\s+$//;
+    return undef if ($str eq '');
+
+    # try to convert to a number
+    #
+    $! = 0;
+    ($num, $unparsed) = strtod($str);
+
+    # return numeric value or undef
+    #
+    if (($unparsed != 0) || $!) {
+        return undef;
+    }
+    return $num;
+}
+
+# end of LavaRnd::Exit::numeric_value
+1;
@@ -0,0 +1,54 @@
+# NOTE: Derived from blib/lib/LavaRnd/Exit.pm.
+# Changes made here will be lost when autosplit is run again.
+# See AutoSplit.pm.
+package LavaRnd::Exit;
+
+#line 525 "blib/lib/LavaRnd/Exit.pm (autosplit into blib/lib/auto/LavaRnd/Exit/range_crandom.al)"
+# range_crandom - return a integer value in the closed interval [$low, $high]
+#
+# given:
+#	$low		lowest possible random value
+#	$high		do not return beyond this value
+#
+# returns:
+#	[$low, $high]
+#
+# NOTE: If $low >= $high, then the $low value is always returned.
+#
+sub range_crandom($$)
+{
+    my ($low, $high) = @_;	# get args
+    my $bottom;			# bottom of range
+    my $range;			# size of range to return in
+
+    # firewall - args must be defined
+    #
+    if (!defined $low || !defined $high) {
+       return $low;
+    }
+
+    # firewall - args must be numeric
+    #
+    $bottom = integer_value($low);
+    $high = integer_value($high);
+    if (!defined $bottom) {
+       return $low;
+    }
+    if (!defined $high) {
+       return $bottom;
+    }
+
+    # firewall - bottom of range must be below beyond range
+    #
+    $range = $high - $bottom + 1;
+    if ($range <= 0) {
+       return $bottom;
+    }
+
+    # return value in closed interval
+    #
+    return $bottom + random_val($range);
+}
+
+1;
+# end of LavaRnd::Exit::range_crandom
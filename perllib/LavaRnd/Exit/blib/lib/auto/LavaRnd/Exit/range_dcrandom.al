@@ -0,0 +1,54 @@
+# NOTE: Derived from blib/lib/LavaRnd/Exit.pm.
+# Changes made here will be lost when autosplit is run again.
+# See AutoSplit.pm.
+package LavaRnd::Exit;
+
+#line 369 "blib/lib/LavaRnd/Exit.pm (autosplit into blib/lib/auto/LavaRnd/Exit/range_dcrandom.al)"
+# range_dcrandom - return a floating value in the closed interval [$low, $high]
+#
+# given:
+#	$low		lowest possible random value
+#	$high		do not return beyond this value
+#
+# returns:
+#	[$low, $high]
+#
+# NOTE: If $low >= $high, then the $low value is always returned.
+#
+sub range_dcrandom($$)
+{
+    my ($low, $high) = @_;	# get args
+    my $bottom;			# bottom of range
+    my $range;			# size of range to return in
+
+    # firewall - args must be defined
+    #
+    if (!defined $low || !defined $high) {
+       return $low;
+    }
+
+    # firewall - args must be numeric
+    #
+    $bottom = numeric_value($low);
+    $high = numeric_value($high);
+    if (!defined $bottom) {
+       return $low;
+    }
+    if (!defined $high) {
+       return $bottom;
+    }
+
+    # firewall - bottom of range must be below beyond range
+    #
+    $range = $high - $bottom;
+    if ($range <= 0) {
+       return $bottom;
+    }
+
+    # return value in closed interval
+    #
+    return $bottom + ($range * dcrandom());
+}
+
+# end of LavaRnd::Exit::range_dcrandom
+1;
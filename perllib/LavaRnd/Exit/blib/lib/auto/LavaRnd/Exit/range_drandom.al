@@ -0,0 +1,54 @@
+# NOTE: Derived from blib/lib/LavaRnd/Exit.pm.
+# Changes made here will be lost when autosplit is run again.
+# See AutoSplit.pm.
+package LavaRnd::Exit;
+
+#line 322 "blib/lib/LavaRnd/Exit.pm (autosplit into blib/lib/auto/LavaRnd/Exit/range_drandom.al)"
+# range_drandom - return a floating value in the open interval [$low, $beyond)
+#
+# given:
+#	$low		lowest possible random value
+#	$beyond		return up to but not including this value
+#
+# returns:
+#	[$low, $beyond)
+#
+# NOTE: If $low >= $beyond, then the $low value is always returned.
+#
+sub range_drandom($$)
+{
+    my ($low, $beyond) = @_;	# get args
+    my $bottom;			# bottom of range
+    my $range;			# size of range to return in
+
+    # firewall - args must be defined
+    #
+    if (!defined $low || !defined $beyond) {
+       return $low;
+    }
+
+    # firewall - args must be numeric
+    #
+    $bottom = numeric_value($low);
+    $beyond = numeric_value($beyond);
+    if (!defined $bottom) {
+       return $low;
+    }
+    if (!defined $beyond) {
+       return $bottom;
+    }
+
+    # firewall - bottom of range must be below beyond range
+    #
+    $range = $beyond - $bottom;
+    if ($range <= 0) {
+       return $bottom;
+    }
+
+    # return value in open interval
+    #
+    return $bottom + ($range * drandom());
+}
+
+# end of LavaRnd::Exit::range_drandom
+1;
@@ -474,7 +474,7 @@ main(int argc, char *argv[])
 	/*
 	 * same current frame for next cycle - simulate lavacam_sanity() action
 	 */
-	memcpy(siz.prev_frame, siz.chaos, siz.chaos_len);
+	lavacam_keep_frame(&siz);
 
 	/*
 	 * release the frame if mapping
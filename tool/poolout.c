@@ -40,9 +40,15 @@
 #include "LavaRnd/random_libc.h"
 #include "LavaRnd/lava_debug.h"
 #include "LavaRnd/cleanup.h"
+#include "LavaRnd/rawio.h"
+#include "LavaRnd/cfg.h"
+#include "LavaRnd/fetchlava.h"
+#include "LavaRnd/lavaquality.h"
 
 char *program;	/* our name */
 
+static void stream_out(long total, long rate, int verbose);
+
 
 int
 main(int argc, char *argv[])
@@ -57,6 +63,7 @@ main(int argc, char *argv[])
     long usec;	/* microsecond pause between cycles */
     long ret;	/* randomcpy return count */
     int verbose;	/* 1 ==> verbose output */
+    long rate;	/* -s stream rate in octets/sec, <0 ==> no stream */
     extern int optind;	/* argv index of the next arg */
     int i;
 
@@ -65,12 +72,19 @@ main(int argc, char *argv[])
      */
     program = argv[0];
     verbose = 0;
+    rate = -1;
     ret = 0;
-    while ((i = getopt(argc, argv, "v")) != -1) {
+    while ((i = getopt(argc, argv, "vs:")) != -1) {
 	switch (i) {
 	case 'v':
 	    verbose = 1;
 	    break;
+	case 's':
+	    rate = strtol(optarg, NULL, 0);
+	    if (rate < 0) {
+		ret = -1;
+	    }
+	    break;
 	default:
 	    ret = -1;
 	    break;
@@ -79,8 +93,11 @@ main(int argc, char *argv[])
     argc -= optind - 1;
     argv += optind - 1;
     if (argc != 4 || ret != 0) {
-	fprintf(stderr, "usage: %s [-v] len cycles usec-pause\n\n", program);
+	fprintf(stderr, "usage: %s [-v] [-s rate] len cycles usec-pause\n\n",
+		program);
 	fprintf(stderr, "\t-v\t\tverbose msgs to stderr\n");
+	fprintf(stderr, "\t-s rate\t\tstream len*cycles octets at rate "
+			"octets/sec (0 ==> no limit)\n");
 	fprintf(stderr, "\tlen\t\tcycle output length in octets\n");
 	fprintf(stderr, "\tcyles\t\ttotal output cycles\n");
 	fprintf(stderr, "\tusec-pause\tmicrosecond pause between cycles\n");
@@ -107,6 +124,15 @@ main(int argc, char *argv[])
 		len, cycle_cnt, ((double)usec / 1000000.0));
     }
 
+    /*
+     * stream if requested
+     */
+    if (rate >= 0) {
+	stream_out(len * cycle_cnt, rate, verbose);
+	lava_dormant();
+	return 0;
+    }
+
     /*
      * allocate output buffer
      */
@@ -217,3 +243,138 @@ main(int argc, char *argv[])
      */
     return 0;
 }
+
+
+/*
+ * stream_out - output data from a single lavapool stream request
+ *
+ * Rather than making a lavapool request for each cycle, we ask
+ * lavapool, via the binary protocol, to stream all of the data
+ * over one connection.
+ *
+ * given:
+ *	total		total octets to output
+ *	rate		octets per second, 0 ==> as fast as we can output
+ *	verbose		1 ==> verbose output
+ *
+ * NOTE: This function exits on error.
+ */
+static void
+stream_out(long total, long rate, int verbose)
+{
+    u_int8_t hdr[LAVA_PROTO_HELLOLEN + LAVA_PROTO_REQLEN];	/* request */
+    u_int8_t reply[LAVA_PROTO_REPLEN];	/* reply header */
+    u_int8_t *buf;	/* reply data */
+    long len;		/* reply length */
+    long left;		/* octets left to output */
+    int fd;		/* connection to lavapool */
+    int ret;		/* I/O return */
+
+    /*
+     * firewall
+     */
+    if (total > 0xffffffffL || rate > 0xffffffffL) {
+	fprintf(stderr, "%s: stream total or rate too large\n", program);
+	exit(10);
+    }
+
+    /*
+     * connect to lavapool
+     */
+    ret = preload_cfg(LAVA_RANDOM_CFG);
+    if (ret < 0) {
+	fprintf(stderr, "%s: lavapool config file load error: %d\n",
+		program, ret);
+	exit(11);
+    }
+    fd = lava_connect(cfg_random.lavapool);
+    if (fd < 0) {
+	fprintf(stderr, "%s: cannot connect to lavapool: %s\n",
+		program, cfg_random.lavapool);
+	exit(12);
+    }
+
+    /*
+     * request the stream
+     */
+    memset(hdr, 0, sizeof(hdr));
+    memcpy(hdr, LAVA_PROTO_MAGIC, LAVA_PROTO_MAGICLEN);
+    hdr[LAVA_PROTO_MAGICLEN] = LAVA_PROTO_VERSION;
+    buf = hdr + LAVA_PROTO_HELLOLEN;
+    buf[0] = (total >> 24) & 0xff;
+    buf[1] = (total >> 16) & 0xff;
+    buf[2] = (total >> 8) & 0xff;
+    buf[3] = total & 0xff;
+    buf[4] = LAVA_QUAL_LAVARND;
+    buf[5] = LAVA_PROTO_STREAM;
+    buf[8] = (rate >> 24) & 0xff;
+    buf[9] = (rate >> 16) & 0xff;
+    buf[10] = (rate >> 8) & 0xff;
+    buf[11] = rate & 0xff;
+    if (raw_write(fd, hdr, sizeof(hdr), FALSE) != sizeof(hdr)) {
+	fprintf(stderr, "%s: stream request write error\n", program);
+	exit(13);
+    }
+    if (verbose) {
+	fprintf(stderr, "streaming %ld octets at %ld octets/sec\n",
+		total, rate);
+    }
+
+    /*
+     * output each reply
+     */
+    buf = (u_int8_t *) malloc(cfg_random.maxrequest);
+    if (buf == NULL) {
+	fprintf(stderr, "%s: failed to malloc %d octets\n",
+		program, cfg_random.maxrequest);
+	exit(14);
+    }
+    for (left = total; left > 0; left -= len) {
+
+	/*
+	 * read the reply
+	 */
+	if (raw_read(fd, reply, sizeof(reply), FALSE) != sizeof(reply)) {
+	    fprintf(stderr, "%s: stream ended with %ld octets left\n",
+		    program, left);
+	    exit(15);
+	}
+	len = ((long)reply[0] << 24) | ((long)reply[1] << 16) |
+	      ((long)reply[2] << 8) | (long)reply[3];
+	if (len <= 0 || len > cfg_random.maxrequest || len > left) {
+	    fprintf(stderr, "%s: bad stream reply length: %ld\n",
+		    program, len);
+	    exit(16);
+	}
+	if (raw_read(fd, buf, len, FALSE) != len) {
+	    fprintf(stderr, "%s: stream ended with %ld octets left\n",
+		    program, left);
+	    exit(15);
+	}
+	if (verbose) {
+	    fprintf(stderr, "stream reply of %ld octets, quality %d\n",
+		    len, reply[4]);
+	}
+
+	/*
+	 * output random data
+	 */
+	clearerr(stdout);
+	(void)fwrite(buf, sizeof(u_int8_t), len, stdout);
+	if (feof(stdout)) {
+	    fprintf(stderr, "%s: EOF in output\n", program);
+	    exit(8);
+	} else if (ferror(stdout)) {
+	    fprintf(stderr, "%s: stdout error: %s\n",
+		    program, strerror(errno));
+	    exit(9);
+	}
+    }
+
+    /*
+     * cleanup
+     */
+    free(buf);
+    (void)close(fd);
+    return;
+}
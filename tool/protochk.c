@@ -0,0 +1,237 @@
+/*
+ * protochk - check pipelined lavapool binary protocol requests
+ *
+ * @(#) $Revision: 10.1 $
+ * @(#) $Id: protochk.c,v 10.1 2003/08/18 06:44:37 lavarnd Exp $
+ *
+ * Copyright (c) 2000-2003 by Landon Curt Noll and Simon Cooper.
+ * All Rights Reserved.
+ *
+ * This is open software; you can redistribute it and/or modify it under
+ * the terms of the version 2.1 of the GNU Lesser General Public License
+ * as published by the Free Software Foundation.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General
+ * Public License for more details.
+ *
+ * The file COPYING contains important info about Licenses and Copyrights.
+ * Please read the COPYING file for details about this open software.
+ *
+ * A copy of version 2.1 of the GNU Lesser General Public License is
+ * distributed with calc under the filename COPYING-LGPL.  You should have
+ * received a copy with calc; if not, write to Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * For more information on LavaRnd: http://www.LavaRnd.org
+ *
+ * Share and enjoy! :-)
+ */
+
+/*
+ * The binary protocol hello and a series of requests that mix the
+ * LAVA_PROTO_S100 flag are sent to lavapool in a single write, so that
+ * lavapool finds the request headers back to back in its input buffer.
+ * Each reply must have the requested length and a quality that
+ * matches the flag of its own request:
+ *
+ *	LAVA_PROTO_S100 requests	LAVA_QUAL_S100LOW .. LAVA_QUAL_S100HIGH
+ *	plain requests			LAVA_QUAL_LAVARND
+ *
+ * A plain request answered with s100 data, or an s100 request answered
+ * with LavaRnd data, means that lavapool took the flag of one request
+ * from the header of another.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "LavaRnd/lavaerr.h"
+#include "LavaRnd/rawio.h"
+#include "LavaRnd/cfg.h"
+#include "LavaRnd/fetchlava.h"
+#include "LavaRnd/lavaquality.h"
+
+#define PROTOCHK_DEF_LEN (32)	/* default octets per request */
+
+/*
+ * requests sent back to back, in order
+ *
+ * Each flag follows a request without it, and the other way around,
+ * so that a flag read from the neighbouring header always shows.
+ */
+static int flags[] = {
+    LAVA_PROTO_S100, 0, 0, LAVA_PROTO_S100, 0, LAVA_PROTO_S100
+};
+#define PROTOCHK_REQS ((int)(sizeof(flags)/sizeof(flags[0])))
+#define PROTOCHK_WRITE (LAVA_PROTO_HELLOLEN + PROTOCHK_REQS*LAVA_PROTO_REQLEN)
+
+static char *program;	/* our name */
+
+
+int
+main(int argc, char *argv[])
+{
+    u_int8_t req[PROTOCHK_WRITE];	/* hello and every request */
+    u_int8_t reply[LAVA_PROTO_REPLEN];	/* reply header */
+    u_int8_t *buf;	/* request header or reply data */
+    char *cfg_file = LAVA_RANDOM_CFG;	/* config file */
+    long len;		/* octets per request */
+    long replylen;	/* reply length */
+    int qual;		/* reply quality */
+    int verbose;	/* 1 ==> verbose output */
+    int errors;		/* replies that were wrong */
+    int fd;		/* connection to lavapool */
+    int ret;		/* I/O return */
+    extern char *optarg;	/* option argument */
+    extern int optind;	/* argv index of the next arg */
+    int i;
+
+    /*
+     * parse args
+     */
+    program = argv[0];
+    verbose = 0;
+    ret = 0;
+    while ((i = getopt(argc, argv, "vr:")) != -1) {
+	switch (i) {
+	case 'v':
+	    verbose = 1;
+	    break;
+	case 'r':
+	    cfg_file = optarg;
+	    break;
+	default:
+	    ret = -1;
+	    break;
+	}
+    }
+    argc -= optind - 1;
+    argv += optind - 1;
+    if (argc > 2 || ret != 0) {
+	fprintf(stderr, "usage: %s [-v] [-r cfg.random] [len]\n\n", program);
+	fprintf(stderr, "\t-v\t\tverbose msgs to stderr\n");
+	fprintf(stderr, "\t-r cfg.random\tlavapool config file "
+			"(def: %s)\n", LAVA_RANDOM_CFG);
+	fprintf(stderr, "\tlen\t\toctets per request (def: %d)\n",
+		PROTOCHK_DEF_LEN);
+	exit(1);
+    }
+    len = PROTOCHK_DEF_LEN;
+    if (argc == 2) {
+	len = strtol(argv[1], NULL, 0);
+    }
+
+    /*
+     * connect to lavapool
+     */
+    ret = preload_cfg(cfg_file);
+    if (ret < 0) {
+	fprintf(stderr, "%s: lavapool config file load error: %d\n",
+		program, ret);
+	exit(2);
+    }
+    if (len <= 0 || len > cfg_random.maxrequest) {
+	fprintf(stderr, "%s: len: %ld must be > 0 and <= %d\n",
+		program, len, cfg_random.maxrequest);
+	exit(3);
+    }
+    fd = lava_connect(cfg_random.lavapool);
+    if (fd < 0) {
+	fprintf(stderr, "%s: cannot connect to lavapool: %s\n",
+		program, cfg_random.lavapool);
+	exit(4);
+    }
+
+    /*
+     * send the hello and every request with a single write
+     */
+    memset(req, 0, sizeof(req));
+    memcpy(req, LAVA_PROTO_MAGIC, LAVA_PROTO_MAGICLEN);
+    req[LAVA_PROTO_MAGICLEN] = LAVA_PROTO_VERSION;
+    for (i=0; i < PROTOCHK_REQS; ++i) {
+	buf = req + LAVA_PROTO_HELLOLEN + i*LAVA_PROTO_REQLEN;
+	buf[0] = (len >> 24) & 0xff;
+	buf[1] = (len >> 16) & 0xff;
+	buf[2] = (len >> 8) & 0xff;
+	buf[3] = len & 0xff;
+	buf[4] = (flags[i] ? LAVA_QUAL_S100LOW : LAVA_QUAL_LAVARND);
+	buf[5] = LAVA_PROTO_ONCE | flags[i];
+    }
+    if (raw_write(fd, req, sizeof(req), FALSE) != sizeof(req)) {
+	fprintf(stderr, "%s: request write error\n", program);
+	exit(5);
+    }
+
+    /*
+     * check each reply, in request order
+     */
+    buf = (u_int8_t *) malloc(len);
+    if (buf == NULL) {
+	fprintf(stderr, "%s: failed to malloc %ld octets\n", program, len);
+	exit(6);
+    }
+    errors = 0;
+    for (i=0; i < PROTOCHK_REQS; ++i) {
+
+	/*
+	 * read the reply
+	 */
+	if (raw_read(fd, reply, sizeof(reply), FALSE) != sizeof(reply)) {
+	    fprintf(stderr, "%s: connection ended before reply %d\n",
+		    program, i);
+	    exit(7);
+	}
+	replylen = ((long)reply[0] << 24) | ((long)reply[1] << 16) |
+		   ((long)reply[2] << 8) | (long)reply[3];
+	qual = reply[4];
+	if (replylen < 0 || replylen > len) {
+	    fprintf(stderr, "%s: reply %d: bad length: %ld\n",
+		    program, i, replylen);
+	    exit(8);
+	}
+	if (replylen > 0 && raw_read(fd, buf, replylen, FALSE) != replylen) {
+	    fprintf(stderr, "%s: connection ended in reply %d\n",
+		    program, i);
+	    exit(7);
+	}
+	if (verbose) {
+	    fprintf(stderr, "reply %d: %s request, %ld octets, quality %d\n",
+		    i, (flags[i] ? "s100" : "plain"), replylen, qual);
+	}
+
+	/*
+	 * the reply must be whole and match the flag of its request
+	 */
+	if (replylen != len) {
+	    fprintf(stderr, "%s: reply %d: %ld octets != %ld requested\n",
+		    program, i, replylen, len);
+	    ++errors;
+	} else if (flags[i] &&
+		   (qual < LAVA_QUAL_S100LOW || qual > LAVA_QUAL_S100HIGH)) {
+	    fprintf(stderr, "%s: reply %d: s100 request got quality %d\n",
+		    program, i, qual);
+	    ++errors;
+	} else if (!flags[i] && qual != LAVA_QUAL_LAVARND) {
+	    fprintf(stderr, "%s: reply %d: plain request got quality %d\n",
+		    program, i, qual);
+	    ++errors;
+	}
+    }
+
+    /*
+     * cleanup
+     */
+    free(buf);
+    (void)close(fd);
+    if (errors > 0) {
+	fprintf(stderr, "%s: %d of %d pipelined replies were wrong\n",
+		program, errors, PROTOCHK_REQS);
+	exit(9);
+    }
+    printf("%s: %d pipelined replies OK\n", program, PROTOCHK_REQS);
+    return 0;
+}
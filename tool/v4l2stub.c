@@ -0,0 +1,467 @@
+/*
+ * v4l2stub - run camsanity over a stand-in V4L2 camera
+ *
+ * @(#) $Revision: 10.1 $
+ * @(#) $Id: v4l2stub.c,v 10.1 2003/08/18 06:44:37 lavarnd Exp $
+ *
+ * Copyright (c) 2000-2003 by Landon Curt Noll and Simon Cooper.
+ * All Rights Reserved.
+ *
+ * This is open software; you can redistribute it and/or modify it under
+ * the terms of the version 2.1 of the GNU Lesser General Public License
+ * as published by the Free Software Foundation.
+ *
+ * This software is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General
+ * Public License for more details.
+ *
+ * The file COPYING contains important info about Licenses and Copyrights.
+ * Please read the COPYING file for details about this open software.
+ *
+ * A copy of version 2.1 of the GNU Lesser General Public License is
+ * distributed with calc under the filename COPYING-LGPL.  You should have
+ * received a copy with calc; if not, write to Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307, USA.
+ *
+ * For more information on LavaRnd: http://www.LavaRnd.org
+ *
+ * Share and enjoy! :-)
+ */
+
+/*
+ * The stand-in is installed with v4l2_ioctl_hook() and answers the
+ * ioctls of the v4l2 driver as a YUYV camera would.  The driver opens
+ * a plain file as the camera and mmaps its streaming buffers from it,
+ * so each buffer is a page aligned region of that file.  Frames of
+ * pseudo-random noise are written into a buffer as it is dequeued.
+ *
+ * camsanity is compiled with main renamed to camsanity_main and is
+ * run, as the v4l2 camera type, over the file.  Along the way the
+ * stand-in checks that the driver never queues a buffer twice and
+ * never holds more than STUB_HELD buffers out of the capture queue,
+ * so that a buffer the driver forgets to queue again is caught.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <fcntl.h>
+
+#include "LavaRnd/have/have_v4l2.h"
+#if defined(HAVE_V4L2)
+#  include <linux/videodev2.h>
+#endif /* HAVE_V4L2 */
+
+#include "LavaRnd/rawio.h"
+#include "LavaRnd/lavacam.h"
+#include "LavaRnd/lavaerr.h"
+
+#define STUB_MAX_BUFFERS 8	/* most streaming buffers we will give */
+#define STUB_HELD 2		/* most buffers the driver may hold at once */
+#define STUB_WIDTH 320		/* default width in pixels */
+#define STUB_HEIGHT 240		/* default height in pixels */
+#define STUB_FPS 30		/* default frames per second */
+
+extern int camsanity_main(int argc, char *argv[]);
+
+#if defined(HAVE_V4L2)
+
+/*
+ * stub - state of the stand-in camera
+ */
+static struct stub {
+    struct v4l2_pix_format pix;	/* capture format */
+    int fps;			/* frames per second */
+    int buffers;		/* streaming buffers given, 0 ==> none */
+    off_t stride;		/* page aligned file space of each buffer */
+    int queued[STUB_MAX_BUFFERS];	/* TRUE ==> buffer is queued */
+    int fifo[STUB_MAX_BUFFERS];	/* queued buffers, oldest first */
+    int head;			/* fifo index of the oldest queued buffer */
+    int cnt;			/* number of queued buffers */
+    int held;			/* buffers dequeued and not yet queued */
+    int held_max;		/* most buffers held at once */
+    int streaming;		/* TRUE ==> VIDIOC_STREAMON was done */
+    long long frames;		/* frames dequeued */
+    int errors;			/* driver misuses seen */
+    u_int8_t *frame;		/* frame of noise to write */
+    u_int64_t seed;		/* noise generator state */
+} stub;
+
+static int stub_ioctl(int fd, unsigned long request, void *arg);
+static void stub_format(struct v4l2_pix_format *pix);
+static int stub_dqbuf(int fd, struct v4l2_buffer *buf);
+
+#endif /* HAVE_V4L2 */
+
+
+int
+main(int argc, char *argv[])
+{
+    char **args;	/* camsanity argv */
+    char *devname;	/* file that stands in for the camera */
+    int fd;		/* open devname */
+    int ret;		/* camsanity return */
+    int i;
+
+    /*
+     * parse args
+     */
+    if (argc < 5) {
+	fprintf(stderr,
+		"usage: %s file dir count top_x [-flags ... args ...]\n",
+		argv[0]);
+	exit(1);
+    }
+    devname = argv[1];
+#if !defined(HAVE_V4L2)
+    fprintf(stderr, "%s: no Video4Linux2 support, nothing to test\n",
+	    argv[0]);
+    exit(0);
+#else /* HAVE_V4L2 */
+
+    /*
+     * create the file that stands in for the camera
+     */
+    fd = open(devname, O_RDWR|O_CREAT|O_TRUNC, 0600);
+    if (fd < 0) {
+	fprintf(stderr, "%s: cannot create %s: %s\n",
+		argv[0], devname, strerror(errno));
+	exit(2);
+    }
+    (void) close(fd);
+
+    /*
+     * setup the stand-in camera
+     */
+    memset(&stub, 0, sizeof(stub));
+    stub.pix.width = STUB_WIDTH;
+    stub.pix.height = STUB_HEIGHT;
+    stub.pix.pixelformat = V4L2_PIX_FMT_YUYV;
+    stub_format(&stub.pix);
+    stub.fps = STUB_FPS;
+    stub.stride = sysconf(_SC_PAGESIZE);
+    stub.seed = 0x4c617661526e6421ULL;
+    (void) v4l2_ioctl_hook(stub_ioctl);
+
+    /*
+     * run camsanity as: camsanity v4l2 file dir count top_x [-flags ...]
+     */
+    args = (char **)malloc((argc + 2) * sizeof(char *));
+    if (args == NULL) {
+	fprintf(stderr, "%s: cannot allocate %d args\n", argv[0], argc + 2);
+	(void) unlink(devname);
+	exit(3);
+    }
+    args[0] = argv[0];
+    args[1] = "v4l2";
+    for (i = 1; i < argc; ++i) {
+	args[i+1] = argv[i];
+    }
+    args[argc+1] = NULL;
+    ret = camsanity_main(argc + 1, args);
+
+    /*
+     * report
+     */
+    (void) v4l2_ioctl_hook(NULL);
+    (void) unlink(devname);
+    free(args);
+    if (stub.frame != NULL) {
+	free(stub.frame);
+    }
+    printf("%s: %lld frames, at most %d buffers held, %d errors\n",
+	   argv[0], stub.frames, stub.held_max, stub.errors);
+    if (ret != 0 || stub.errors > 0 || stub.frames <= 0) {
+	fprintf(stderr, "%s: FAILED\n", argv[0]);
+	exit(4);
+    }
+    exit(0);
+#endif /* HAVE_V4L2 */
+}
+
+
+#if defined(HAVE_V4L2)
+
+/*
+ * stub_format - fill in the derived values of a YUYV capture format
+ *
+ * given:
+ *      pix         capture format with width and height set
+ *
+ * NOTE: The size is kept within what a webcam might offer, and any
+ *	 pixel format other than YUYV is changed to YUYV, as a camera
+ *	 would do.
+ */
+static void
+stub_format(struct v4l2_pix_format *pix)
+{
+    if (pix->width < 16) {
+	pix->width = 16;
+    } else if (pix->width > 1920) {
+	pix->width = 1920;
+    }
+    if (pix->height < 16) {
+	pix->height = 16;
+    } else if (pix->height > 1080) {
+	pix->height = 1080;
+    }
+    pix->pixelformat = V4L2_PIX_FMT_YUYV;
+    pix->field = V4L2_FIELD_NONE;
+    pix->bytesperline = pix->width * 2;
+    pix->sizeimage = pix->bytesperline * pix->height;
+    pix->colorspace = V4L2_COLORSPACE_SRGB;
+    return;
+}
+
+
+/*
+ * stub_ioctl - answer a v4l2 driver ioctl as a camera would
+ *
+ * given:
+ *      fd          the open file standing in for the camera
+ *      request     ioctl request
+ *      arg         ioctl argument
+ *
+ * returns:
+ *      0 ==> OK, -1 ==> error and errno is set
+ */
+static int
+stub_ioctl(int fd, unsigned long request, void *arg)
+{
+    struct v4l2_capability *cap;	/* VIDIOC_QUERYCAP arg */
+    struct v4l2_format *fmt;		/* VIDIOC_G_FMT, VIDIOC_S_FMT arg */
+    struct v4l2_streamparm *parm;	/* VIDIOC_G_PARM, VIDIOC_S_PARM arg */
+    struct v4l2_requestbuffers *req;	/* VIDIOC_REQBUFS arg */
+    struct v4l2_buffer *buf;		/* VIDIOC_*BUF arg */
+    off_t stride;			/* page aligned buffer size */
+    int i;
+
+    /*
+     * firewall
+     */
+    if (arg == NULL) {
+	errno = EFAULT;
+	return -1;
+    }
+
+    switch (request) {
+    case VIDIOC_QUERYCAP:
+	cap = (struct v4l2_capability *)arg;
+	memset(cap, 0, sizeof(cap[0]));
+	strncpy((char *)cap->driver, "v4l2stub", sizeof(cap->driver)-1);
+	strncpy((char *)cap->card, "LavaRnd V4L2 stand-in",
+		sizeof(cap->card)-1);
+	cap->capabilities = V4L2_CAP_VIDEO_CAPTURE | V4L2_CAP_STREAMING;
+	return 0;
+
+    case VIDIOC_G_FMT:
+    case VIDIOC_S_FMT:
+	fmt = (struct v4l2_format *)arg;
+	if (fmt->type != V4L2_BUF_TYPE_VIDEO_CAPTURE) {
+	    errno = EINVAL;
+	    return -1;
+	}
+	if (request == VIDIOC_S_FMT) {
+	    if (stub.buffers > 0) {
+		errno = EBUSY;
+		return -1;
+	    }
+	    stub_format(&fmt->fmt.pix);
+	    stub.pix = fmt->fmt.pix;
+	}
+	fmt->fmt.pix = stub.pix;
+	return 0;
+
+    case VIDIOC_G_PARM:
+    case VIDIOC_S_PARM:
+	parm = (struct v4l2_streamparm *)arg;
+	if (parm->type != V4L2_BUF_TYPE_VIDEO_CAPTURE) {
+	    errno = EINVAL;
+	    return -1;
+	}
+	if (request == VIDIOC_S_PARM &&
+	    parm->parm.capture.timeperframe.numerator > 0) {
+	    stub.fps = parm->parm.capture.timeperframe.denominator /
+		       parm->parm.capture.timeperframe.numerator;
+	}
+	memset(&parm->parm, 0, sizeof(parm->parm));
+	parm->parm.capture.capability = V4L2_CAP_TIMEPERFRAME;
+	parm->parm.capture.timeperframe.numerator = 1;
+	parm->parm.capture.timeperframe.denominator = stub.fps;
+	return 0;
+
+    case VIDIOC_REQBUFS:
+	req = (struct v4l2_requestbuffers *)arg;
+	if (req->type != V4L2_BUF_TYPE_VIDEO_CAPTURE ||
+	    req->memory != V4L2_MEMORY_MMAP) {
+	    errno = EINVAL;
+	    return -1;
+	}
+	if (stub.streaming) {
+	    errno = EBUSY;
+	    return -1;
+	}
+	if (req->count > STUB_MAX_BUFFERS) {
+	    req->count = STUB_MAX_BUFFERS;
+	}
+	stride = sysconf(_SC_PAGESIZE);
+	stride = ((stub.pix.sizeimage + stride - 1) / stride) * stride;
+	if (ftruncate(fd, stride * req->count) < 0) {
+	    return -1;
+	}
+	stub.buffers = req->count;
+	stub.stride = stride;
+	memset(stub.queued, 0, sizeof(stub.queued));
+	stub.head = 0;
+	stub.cnt = 0;
+	stub.held = 0;
+	return 0;
+
+    case VIDIOC_QUERYBUF:
+    case VIDIOC_QBUF:
+	buf = (struct v4l2_buffer *)arg;
+	if (buf->type != V4L2_BUF_TYPE_VIDEO_CAPTURE ||
+	    buf->memory != V4L2_MEMORY_MMAP ||
+	    buf->index >= (unsigned int)stub.buffers) {
+	    errno = EINVAL;
+	    return -1;
+	}
+	if (request == VIDIOC_QUERYBUF) {
+	    buf->length = stub.pix.sizeimage;
+	    buf->m.offset = buf->index * stub.stride;
+	    buf->flags = V4L2_BUF_FLAG_MAPPED |
+			 (stub.queued[buf->index] ? V4L2_BUF_FLAG_QUEUED : 0);
+	    return 0;
+	}
+	if (stub.queued[buf->index]) {
+	    fprintf(stderr, "v4l2stub: buffer %u queued twice\n", buf->index);
+	    ++stub.errors;
+	    errno = EINVAL;
+	    return -1;
+	}
+	stub.queued[buf->index] = TRUE;
+	stub.fifo[(stub.head + stub.cnt) % STUB_MAX_BUFFERS] = buf->index;
+	++stub.cnt;
+	if (stub.streaming) {
+	    --stub.held;
+	}
+	return 0;
+
+    case VIDIOC_DQBUF:
+	return stub_dqbuf(fd, (struct v4l2_buffer *)arg);
+
+    case VIDIOC_STREAMON:
+	if (stub.buffers <= 0 || *(int *)arg != V4L2_BUF_TYPE_VIDEO_CAPTURE) {
+	    errno = EINVAL;
+	    return -1;
+	}
+	stub.streaming = TRUE;
+	stub.held = stub.buffers - stub.cnt;
+	return 0;
+
+    case VIDIOC_STREAMOFF:
+	/* every buffer comes back from the camera */
+	stub.streaming = FALSE;
+	for (i = 0; i < STUB_MAX_BUFFERS; ++i) {
+	    stub.queued[i] = FALSE;
+	}
+	stub.head = 0;
+	stub.cnt = 0;
+	stub.held = 0;
+	return 0;
+
+    default:
+	break;
+    }
+    errno = ENOTTY;
+    return -1;
+}
+
+
+/*
+ * stub_dqbuf - dequeue the oldest queued buffer holding a new frame
+ *
+ * given:
+ *      fd          the open file standing in for the camera
+ *      buf         VIDIOC_DQBUF arg
+ *
+ * returns:
+ *      0 ==> OK, -1 ==> error and errno is set
+ */
+static int
+stub_dqbuf(int fd, struct v4l2_buffer *buf)
+{
+    u_int64_t x;	/* noise generator state */
+    int indx;		/* buffer to dequeue */
+    u_int32_t i;
+
+    /*
+     * firewall
+     */
+    if (!stub.streaming || buf->type != V4L2_BUF_TYPE_VIDEO_CAPTURE ||
+	buf->memory != V4L2_MEMORY_MMAP) {
+	errno = EINVAL;
+	return -1;
+    }
+    if (stub.cnt <= 0) {
+	errno = EAGAIN;
+	return -1;
+    }
+    if (stub.frame == NULL) {
+	stub.frame = (u_int8_t *)malloc(stub.pix.sizeimage);
+	if (stub.frame == NULL) {
+	    errno = ENOMEM;
+	    return -1;
+	}
+    }
+
+    /*
+     * fill the oldest queued buffer with a frame of noise
+     */
+    indx = stub.fifo[stub.head];
+    x = stub.seed;
+    for (i = 0; i < stub.pix.sizeimage; ++i) {
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	stub.frame[i] = (u_int8_t)(x >> 32);
+    }
+    stub.seed = x;
+    if (pwrite(fd, stub.frame, stub.pix.sizeimage,
+	       indx * stub.stride) != (ssize_t)stub.pix.sizeimage) {
+	errno = EIO;
+	return -1;
+    }
+
+    /*
+     * hand it to the driver
+     */
+    stub.head = (stub.head + 1) % STUB_MAX_BUFFERS;
+    --stub.cnt;
+    stub.queued[indx] = FALSE;
+    if (++stub.held > stub.held_max) {
+	stub.held_max = stub.held;
+    }
+    if (stub.held > STUB_HELD) {
+	fprintf(stderr, "v4l2stub: driver holds %d buffers > %d\n",
+		stub.held, STUB_HELD);
+	++stub.errors;
+    }
+    memset(buf, 0, sizeof(buf[0]));
+    buf->index = indx;
+    buf->type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf->memory = V4L2_MEMORY_MMAP;
+    buf->bytesused = stub.pix.sizeimage;
+    buf->length = stub.pix.sizeimage;
+    buf->m.offset = indx * stub.stride;
+    buf->flags = V4L2_BUF_FLAG_MAPPED | V4L2_BUF_FLAG_DONE;
+    buf->field = V4L2_FIELD_NONE;
+    buf->sequence = (u_int32_t)stub.frames++;
+    return 0;
+}
+
+#endif /* HAVE_V4L2 */